@@ -0,0 +1,697 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       bench_organizer.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    End-to-end benchmark of organizer_plan() and organizer_execute() on
+    synthetic directories. Generates a tree (N files, weighted extension
+    mix, a share of names that collide with files already in their
+    category, optional subdirectories), times each phase and reports files
+    per second, then repeats the run under ptrace to count the system
+    calls each phase makes per file.
+
+ Usage:
+    make bench
+    ./bin/bench_organizer [-n FILES] [--ext SPEC] [--collisions RATE]
+                          [--subdirs N] [--subdir-share RATE] [-r]
+                          [--backend serial|uring] [--order readdir|inode]
+                          [-j JOBS] [--iterations N]
+                          [--seed N] [--no-syscalls] [--generate DIR]
+
+    SPEC is a comma-separated list of EXT:WEIGHT ("none" for names without
+    an extension), e.g. "jpg:30,pdf:20,xyz:5,none:5".
+
+ Notes:
+    - Phases: "scan" reads the target directory once with the scanner,
+      "classify" runs the name classifier over the scanned names,
+      "resolve" is the rest of organizer_plan() (category lookups and
+      collision resolution), "execute" is organizer_execute() (mkdir and
+      rename). Times are the best of --iterations runs on a fresh tree;
+      the page cache is warm.
+    - Scan and classify cover the target directory only; with -r the
+      subdirectories are part of "resolve".
+    - Syscall counts come from a separate traced run (ptrace, Linux only),
+      so tracing overhead never shows up in the timings.
+    - --generate DIR only creates the tree, for use with the real binary.
+    - Trees are generated under $TMPDIR (default /tmp) and removed after
+      each run.
+
+==========================================================================================================
+*/
+
+#define _DEFAULT_SOURCE         /* syscall(), __WALL, mkdtemp */
+#define _XOPEN_SOURCE 700       /* nftw */
+
+#include "classifier.h"
+#include "logger.h"
+#include "organizer.h"
+#include "scanner.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <signal.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#endif
+
+#define DEFAULT_EXT_SPEC \
+    "jpg:20,png:10,pdf:15,txt:10,docx:5,mp3:5,mp4:5,zip:5,c:5,py:5,xyz:5,none:10"
+#define MAX_EXTENSIONS 64
+
+/* Phases of one organizer run, in order. */
+enum { PHASE_SCAN, PHASE_CLASSIFY, PHASE_RESOLVE, PHASE_PLAN, PHASE_EXECUTE, PHASE_COUNT };
+
+static const char *const PHASE_NAMES[PHASE_COUNT] = {
+    "scan", "classify", "resolve", "plan", "execute",
+};
+
+typedef struct {
+    char ext[16];     /* "" for names without an extension */
+    unsigned weight;
+} ExtensionWeight;
+
+typedef struct {
+    size_t files;
+    double collision_rate;
+    unsigned subdirs;
+    double subdir_share;
+    ExtensionWeight exts[MAX_EXTENSIONS];
+    size_t ext_count;
+    unsigned total_weight;
+    unsigned iterations;
+    uint64_t seed;
+    bool count_syscalls;
+    const char *generate_dir;
+    OrganizerConfig config;
+} BenchOptions;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static const char *get_extension(const char *name)
+{
+    const char *dot = strrchr(name, '.');
+    if (!dot || dot == name) {
+        return NULL;
+    }
+    return dot + 1;
+}
+
+/* xorshift64*: reproducible trees for a given --seed. */
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * UINT64_C(0x2545F4914F6CDD1D);
+}
+
+static double next_unit(uint64_t *state)
+{
+    return (double)(next_random(state) >> 11) / (double)(UINT64_C(1) << 53);
+}
+
+static int parse_ext_spec(const char *spec, BenchOptions *options)
+{
+    options->ext_count = 0;
+    options->total_weight = 0;
+
+    while (*spec) {
+        const char *colon = strchr(spec, ':');
+        size_t len = colon ? (size_t)(colon - spec) : 0;
+        if (!colon || len == 0 || len >= sizeof(options->exts[0].ext) ||
+            options->ext_count == MAX_EXTENSIONS) {
+            return -1;
+        }
+
+        char *end;
+        unsigned long weight = strtoul(colon + 1, &end, 10);
+        if (end == colon + 1 || (*end != ',' && *end != '\0') || weight > 1000000) {
+            return -1;
+        }
+
+        ExtensionWeight *entry = &options->exts[options->ext_count++];
+        memcpy(entry->ext, spec, len);
+        entry->ext[len] = '\0';
+        if (strcmp(entry->ext, "none") == 0) {
+            entry->ext[0] = '\0';
+        }
+        entry->weight = (unsigned)weight;
+        options->total_weight += (unsigned)weight;
+        spec = *end ? end + 1 : end;
+    }
+    return options->total_weight > 0 ? 0 : -1;
+}
+
+static const char *pick_extension(const BenchOptions *options, uint64_t *rng)
+{
+    unsigned roll = (unsigned)(next_random(rng) % options->total_weight);
+    for (size_t i = 0; i < options->ext_count; ++i) {
+        if (roll < options->exts[i].weight) {
+            return options->exts[i].ext;
+        }
+        roll -= options->exts[i].weight;
+    }
+    return options->exts[options->ext_count - 1].ext;
+}
+
+static int create_empty(const char *path)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return errno == EEXIST ? 0 : -1;
+    }
+    close(fd);
+    return 0;
+}
+
+/*
+ * Fill 'root' with the configured files. A colliding file gets a twin of
+ * the same name in its category directory, so planning must pick a
+ * suffixed destination for it.
+ */
+static int generate_tree(const char *root, const BenchOptions *options)
+{
+    uint64_t rng = options->seed ? options->seed : 1;
+    char path[4096];
+
+    for (unsigned d = 0; d < options->subdirs; ++d) {
+        snprintf(path, sizeof(path), "%s/dir%04u", root, d);
+        if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+            return -1;
+        }
+    }
+
+    for (size_t i = 0; i < options->files; ++i) {
+        const char *ext = pick_extension(options, &rng);
+        char name[64];
+        snprintf(name, sizeof(name), "file%07zu%s%s", i, ext[0] ? "." : "", ext);
+
+        if (options->subdirs > 0 && next_unit(&rng) < options->subdir_share) {
+            snprintf(path, sizeof(path), "%s/dir%04u/%s", root,
+                     (unsigned)(next_random(&rng) % options->subdirs), name);
+        } else {
+            snprintf(path, sizeof(path), "%s/%s", root, name);
+        }
+        if (create_empty(path) != 0) {
+            return -1;
+        }
+
+        if (next_unit(&rng) < options->collision_rate) {
+            const char *category = classifier_category_for_extension(get_extension(name));
+            snprintf(path, sizeof(path), "%s/%s", root, category);
+            if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+                return -1;
+            }
+            snprintf(path, sizeof(path), "%s/%s/%s", root, category, name);
+            if (create_empty(path) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    (void)st; (void)flag; (void)ftw;
+    return remove(path) != 0 ? -1 : 0;
+}
+
+static void remove_tree(const char *root)
+{
+    nftw(root, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+}
+
+/* New, empty tree root under $TMPDIR; returns NULL on failure. */
+static char *make_tree(const BenchOptions *options)
+{
+    const char *tmp = getenv("TMPDIR");
+    char template[4096];
+    snprintf(template, sizeof(template), "%s/organizer-bench-XXXXXX", tmp && tmp[0] ? tmp : "/tmp");
+
+    char *root = mkdtemp(template);
+    if (!root || generate_tree(root, options) != 0) {
+        fprintf(stderr, "Error: cannot generate tree in '%s': %s\n", template, strerror(errno));
+        if (root) {
+            remove_tree(root);
+        }
+        return NULL;
+    }
+    return strdup(root);
+}
+
+/* Keeps the classification loop from being optimized away. */
+static volatile size_t bench_sink;
+
+/* A scanned name copied out of the scanner, with the length it reported. */
+typedef struct {
+    char name[64];
+    size_t len;
+} ScannedName;
+
+/* Scan the target directory once; returns the entry count, -1 on failure. */
+static long time_scan_and_classify(const char *root, double *scan, double *classify)
+{
+    *scan = *classify = 0;
+    int fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    /* Names are copied out so classification is timed on its own. */
+    size_t capacity = 1024, count = 0;
+    ScannedName *names = malloc(capacity * sizeof(*names));
+
+    DirScanner scanner;
+    double start = now_seconds();
+    if (!names || dir_scanner_open(&scanner, fd, root, 0) != 0) {
+        free(names);
+        close(fd);
+        return -1;
+    }
+    const ScanEntry *batch;
+    long n;
+    while ((n = dir_scanner_next_batch(&scanner, &batch)) > 0) {
+        for (long i = 0; i < n; ++i) {
+            if (count == capacity) {
+                ScannedName *grown = realloc(names, 2 * capacity * sizeof(*names));
+                if (!grown) {
+                    n = -1;
+                    break;
+                }
+                names = grown;
+                capacity *= 2;
+            }
+            ScannedName *copy = &names[count++];
+            snprintf(copy->name, sizeof(copy->name), "%s", batch[i].name);
+            copy->len = batch[i].name_len < sizeof(copy->name)
+                        ? batch[i].name_len : sizeof(copy->name) - 1;
+        }
+    }
+    dir_scanner_close(&scanner);
+    *scan = now_seconds() - start;
+
+    size_t checksum = 0;
+    start = now_seconds();
+    for (size_t i = 0; i < count; ++i) {
+        checksum += (size_t)classifier_category_for_name(names[i].name, names[i].len)[0];
+    }
+    *classify = now_seconds() - start;
+    bench_sink = checksum;
+
+    free(names);
+    close(fd);
+    return n < 0 ? -1 : (long)count;
+}
+
+/* One timed run on a fresh tree; 'times' is indexed by phase. */
+static int timed_run(const BenchOptions *options, double *times)
+{
+    char *root = make_tree(options);
+    if (!root) {
+        return -1;
+    }
+
+    OrganizerConfig config = options->config;
+    config.target_dir = root;
+
+    int result = time_scan_and_classify(root, &times[PHASE_SCAN], &times[PHASE_CLASSIFY]) < 0;
+
+    OrganizerPlan plan;
+    double start = now_seconds();
+    result |= organizer_plan(&config, &plan) != 0;
+    times[PHASE_PLAN] = now_seconds() - start;
+
+    start = now_seconds();
+    result |= organizer_execute(&config, &plan) != 0;
+    times[PHASE_EXECUTE] = now_seconds() - start;
+    organizer_plan_free(&plan);
+
+    double resolve = times[PHASE_PLAN] - times[PHASE_SCAN] - times[PHASE_CLASSIFY];
+    times[PHASE_RESOLVE] = resolve > 0 ? resolve : 0;
+
+    remove_tree(root);
+    free(root);
+    return result ? -1 : 0;
+}
+
+/* ---- Syscall counting ---------------------------------------------------------------- */
+
+#ifdef __linux__
+
+/* Invalid syscall number the traced child uses to mark phase boundaries. */
+#define PHASE_MARKER 0x7f00
+
+/* Traced phases: setup, plan, execute, teardown. */
+enum { TRACE_SETUP, TRACE_PLAN, TRACE_EXECUTE, TRACE_TEARDOWN, TRACE_PHASES };
+
+typedef struct {
+    long nr;
+    const char *name;
+} SyscallClass;
+
+static const SyscallClass SYSCALL_CLASSES[] = {
+    { SYS_getdents64, "getdents64" },
+#ifdef SYS_newfstatat
+    { SYS_newfstatat, "fstatat" },
+#endif
+    { SYS_statx, "statx" },
+    { SYS_openat, "openat" },
+    { SYS_close, "close" },
+    { SYS_mkdirat, "mkdirat" },
+#ifdef SYS_renameat
+    { SYS_renameat, "renameat" },
+#endif
+    { SYS_renameat2, "renameat2" },
+    { SYS_io_uring_enter, "io_uring_enter" },
+    { SYS_write, "write" },
+    { SYS_futex, "futex" },
+};
+
+#define CLASS_COUNT (sizeof(SYSCALL_CLASSES) / sizeof(SYSCALL_CLASSES[0]))
+
+typedef struct {
+    unsigned long total;
+    unsigned long by_class[CLASS_COUNT + 1]; /* last: everything else */
+} SyscallCounts;
+
+static void count_syscall(SyscallCounts *counts, long nr)
+{
+    size_t k = 0;
+    while (k < CLASS_COUNT && SYSCALL_CLASSES[k].nr != nr) {
+        ++k;
+    }
+    counts->by_class[k]++;
+    counts->total++;
+}
+
+/* Follow the child and all its threads until they are gone. */
+static int trace_child(pid_t child, SyscallCounts *counts)
+{
+    int status;
+    if (waitpid(child, &status, 0) != child || !WIFSTOPPED(status)) {
+        return -1;
+    }
+    ptrace(PTRACE_SETOPTIONS, child, 0,
+           PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL);
+    ptrace(PTRACE_SYSCALL, child, 0, 0);
+
+    int phase = TRACE_SETUP;
+    int child_status = -1;
+    for (;;) {
+        pid_t tid = waitpid(-1, &status, __WALL);
+        if (tid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break; /* ECHILD: every thread has exited */
+        }
+        if (WIFEXITED(status) || WIFSIGNALED(status)) {
+            if (tid == child) {
+                child_status = status;
+            }
+            continue;
+        }
+
+        int deliver = 0;
+        int sig = WSTOPSIG(status);
+        if (sig == (SIGTRAP | 0x80)) {
+            struct __ptrace_syscall_info info; /* glibc name */
+            if (ptrace(PTRACE_GET_SYSCALL_INFO, tid, sizeof(info), &info) > 0 &&
+                info.op == PTRACE_SYSCALL_INFO_ENTRY) {
+                if (info.entry.nr == PHASE_MARKER) {
+                    phase += phase < TRACE_TEARDOWN;
+                } else {
+                    count_syscall(&counts[phase], (long)info.entry.nr);
+                }
+            }
+        } else if (sig != SIGTRAP && sig != SIGSTOP) {
+            deliver = sig; /* clone events and new threads' first stop are ours */
+        }
+        ptrace(PTRACE_SYSCALL, tid, 0, deliver);
+    }
+    return child_status;
+}
+
+static int traced_run(const BenchOptions *options, SyscallCounts *counts)
+{
+    char *root = make_tree(options);
+    if (!root) {
+        return -1;
+    }
+
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+        OrganizerConfig config = options->config;
+        config.target_dir = root;
+        OrganizerPlan plan;
+
+        ptrace(PTRACE_TRACEME, 0, 0, 0);
+        raise(SIGSTOP);
+        syscall(PHASE_MARKER);
+        int rc = organizer_plan(&config, &plan);
+        syscall(PHASE_MARKER);
+        rc |= organizer_execute(&config, &plan);
+        syscall(PHASE_MARKER);
+        organizer_plan_free(&plan);
+        _exit(rc != 0);
+    }
+
+    int status = child > 0 ? trace_child(child, counts) : -1;
+    remove_tree(root);
+    free(root);
+    if (status < 0 || counts[TRACE_PLAN].total == 0) {
+        fprintf(stderr, "Warning: syscall tracing unavailable\n");
+        return -1;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+static void report_syscalls(const BenchOptions *options)
+{
+    SyscallCounts counts[TRACE_PHASES];
+    memset(counts, 0, sizeof(counts));
+    if (traced_run(options, counts) != 0) {
+        return;
+    }
+
+    double files = (double)options->files;
+    printf("\n%-16s %10s %10s\n", "syscalls/file", "plan", "execute");
+    printf("%-16s %10.3f %10.3f\n", "total",
+           counts[TRACE_PLAN].total / files, counts[TRACE_EXECUTE].total / files);
+    for (size_t k = 0; k <= CLASS_COUNT; ++k) {
+        unsigned long plan = counts[TRACE_PLAN].by_class[k];
+        unsigned long execute = counts[TRACE_EXECUTE].by_class[k];
+        if (plan + execute > 0) {
+            printf("  %-14s %10.3f %10.3f\n", k < CLASS_COUNT ? SYSCALL_CLASSES[k].name : "other",
+                   plan / files, execute / files);
+        }
+    }
+}
+
+#else /* !__linux__ */
+
+static void report_syscalls(const BenchOptions *options)
+{
+    (void)options;
+    printf("\nsyscall counting needs Linux (ptrace)\n");
+}
+
+#endif
+
+/* ---- Driver -------------------------------------------------------------------------- */
+
+static void print_usage(const char *progname)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "\n"
+            "Options:\n"
+            "  -n FILES            Files to generate (default 20000)\n"
+            "  --ext SPEC          Extension mix, EXT:WEIGHT,... (\"none\": no extension)\n"
+            "  --collisions RATE   Share of files whose name is already taken (default 0.1)\n"
+            "  --subdirs N         Subdirectories to create (default 0)\n"
+            "  --subdir-share RATE Share of files placed in subdirectories (default 0.5)\n"
+            "  -r, --recursive     Organize the subdirectories too\n"
+            "  --backend NAME      Execute backend: serial (default) or uring\n"
+            "  --order NAME        Move order: readdir (default) or inode\n"
+            "  -j, --jobs N        Worker threads (default 1)\n"
+            "  --iterations N      Timed runs; the best is reported (default 3)\n"
+            "  --seed N            Generator seed (default 1)\n"
+            "  --no-syscalls       Skip the traced run\n"
+            "  --generate DIR      Only create the tree in DIR\n",
+            progname);
+}
+
+static int parse_rate(const char *text, double *out)
+{
+    char *end;
+    double value = strtod(text, &end);
+    if (end == text || *end != '\0' || !(value >= 0.0 && value <= 1.0)) {
+        return -1;
+    }
+    *out = value;
+    return 0;
+}
+
+static int parse_count(const char *text, unsigned long max, unsigned long *out)
+{
+    char *end;
+    errno = 0;
+    unsigned long value = strtoul(text, &end, 10);
+    if (errno != 0 || end == text || *end != '\0' || text[0] == '-' || value > max) {
+        return -1;
+    }
+    *out = value;
+    return 0;
+}
+
+static int parse_options(int argc, char **argv, BenchOptions *options)
+{
+    memset(options, 0, sizeof(*options));
+    options->files = 20000;
+    options->collision_rate = 0.1;
+    options->subdir_share = 0.5;
+    options->iterations = 3;
+    options->seed = 1;
+    options->count_syscalls = true;
+    options->config.backend = ORGANIZER_BACKEND_SERIAL;
+    options->config.jobs = 1;
+    parse_ext_spec(DEFAULT_EXT_SPEC, options);
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        unsigned long number;
+        int rc = 0;
+
+        if (strcmp(arg, "-r") == 0 || strcmp(arg, "--recursive") == 0) {
+            options->config.recursive = true;
+            continue;
+        } else if (strcmp(arg, "--no-syscalls") == 0) {
+            options->count_syscalls = false;
+            continue;
+        } else if (!value) {
+            rc = -1;
+        } else if (strcmp(arg, "-n") == 0) {
+            rc = parse_count(value, 100000000, &number);
+            options->files = number;
+        } else if (strcmp(arg, "--ext") == 0) {
+            rc = parse_ext_spec(value, options);
+        } else if (strcmp(arg, "--collisions") == 0) {
+            rc = parse_rate(value, &options->collision_rate);
+        } else if (strcmp(arg, "--subdirs") == 0) {
+            rc = parse_count(value, 10000, &number);
+            options->subdirs = (unsigned)number;
+        } else if (strcmp(arg, "--subdir-share") == 0) {
+            rc = parse_rate(value, &options->subdir_share);
+        } else if (strcmp(arg, "--backend") == 0) {
+            options->config.backend = strcmp(value, "uring") == 0
+                                      ? ORGANIZER_BACKEND_URING : ORGANIZER_BACKEND_SERIAL;
+            rc = strcmp(value, "uring") == 0 || strcmp(value, "serial") == 0 ? 0 : -1;
+        } else if (strcmp(arg, "--order") == 0) {
+            options->config.order = strcmp(value, "inode") == 0
+                                    ? ORGANIZER_ORDER_INODE : ORGANIZER_ORDER_READDIR;
+            rc = strcmp(value, "inode") == 0 || strcmp(value, "readdir") == 0 ? 0 : -1;
+        } else if (strcmp(arg, "-j") == 0 || strcmp(arg, "--jobs") == 0) {
+            rc = parse_count(value, 1024, &number) != 0 || number == 0 ? -1 : 0;
+            options->config.jobs = (unsigned)number;
+        } else if (strcmp(arg, "--iterations") == 0) {
+            rc = parse_count(value, 1000, &number) != 0 || number == 0 ? -1 : 0;
+            options->iterations = (unsigned)number;
+        } else if (strcmp(arg, "--seed") == 0) {
+            rc = parse_count(value, (unsigned long)-1, &number);
+            options->seed = number;
+        } else if (strcmp(arg, "--generate") == 0) {
+            options->generate_dir = value;
+        } else {
+            rc = -1;
+        }
+
+        if (rc != 0) {
+            fprintf(stderr, "Error: invalid option '%s'\n", arg);
+            return -1;
+        }
+        ++i;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    if (parse_options(argc, argv, &options) != 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (options.generate_dir) {
+        if ((mkdir(options.generate_dir, 0755) != 0 && errno != EEXIST) ||
+            generate_tree(options.generate_dir, &options) != 0) {
+            fprintf(stderr, "Error: cannot generate tree in '%s': %s\n",
+                    options.generate_dir, strerror(errno));
+            return 1;
+        }
+        return 0;
+    }
+
+    /* Per-move log lines would dominate every timing. */
+    logger_set_level(LOG_LEVEL_WARN);
+
+    printf("Organizing %zu files (%.0f%% collisions, %u subdirectories%s), "
+           "backend %s, %s order, %u job(s)\n",
+           options.files, options.collision_rate * 100, options.subdirs,
+           options.config.recursive ? ", recursive" : "",
+           options.config.backend == ORGANIZER_BACKEND_URING ? "uring" : "serial",
+           options.config.order == ORGANIZER_ORDER_INODE ? "inode" : "readdir",
+           options.config.jobs);
+
+    double best[PHASE_COUNT];
+    for (unsigned it = 0; it < options.iterations; ++it) {
+        double times[PHASE_COUNT];
+        if (timed_run(&options, times) != 0) {
+            fprintf(stderr, "Error: run %u failed\n", it + 1);
+            return 1;
+        }
+        for (size_t p = 0; p < PHASE_COUNT; ++p) {
+            best[p] = it == 0 || times[p] < best[p] ? times[p] : best[p];
+        }
+    }
+
+    printf("\n%-16s %10s %12s\n", "phase", "ms", "files/s");
+    for (size_t p = 0; p < PHASE_COUNT; ++p) {
+        double rate = best[p] > 0 ? (double)options.files / best[p] : 0;
+        printf("%-16s %10.2f %12.0f\n", PHASE_NAMES[p], best[p] * 1e3, rate);
+    }
+    double total = best[PHASE_PLAN] + best[PHASE_EXECUTE];
+    printf("%-16s %10.2f %12.0f\n", "total", total * 1e3,
+           total > 0 ? (double)options.files / total : 0);
+
+    if (options.count_syscalls) {
+        report_syscalls(&options);
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       arena.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Bump allocator for the many small, same-lifetime strings a run produces
+    (scanned names, directory prefixes, planned destinations). Allocation is
+    a pointer increment; everything is released at once by arena_free().
+
+ Usage:
+    Arena arena = {0};                       // or arena_init(&arena)
+    char *name = arena_strndup(&arena, entry->name, entry->name_len);
+    ...
+    arena_free(&arena);
+
+ Notes:
+    - A zero-initialized Arena is empty and ready to use.
+    - Not thread-safe: give each worker its own arena and join them later
+      with arena_adopt().
+
+==========================================================================================================
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock *blocks; /* newest first */
+    char *cursor;       /* free space in the newest block */
+    size_t remaining;
+} Arena;
+
+/**
+ * Initialize an empty arena.
+ */
+void arena_init(Arena *arena);
+
+/**
+ * Allocate 'size' bytes aligned for any object type.
+ *
+ * @return  Pointer valid until arena_free(), or NULL on allocation failure.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * Copy the first 'len' bytes of 's' and NUL-terminate the copy.
+ *
+ * @return  The copy, or NULL on allocation failure.
+ */
+char *arena_strndup(Arena *arena, const char *s, size_t len);
+
+/**
+ * Concatenate 'a' and 'b' into one NUL-terminated string.
+ *
+ * @return  The result, or NULL on allocation failure.
+ */
+char *arena_concat(Arena *arena, const char *a, const char *b);
+
+/**
+ * Move every allocation of 'src' into 'dst' without copying; 'src' is left
+ * empty.
+ */
+void arena_adopt(Arena *dst, Arena *src);
+
+/**
+ * Release every allocation at once and leave the arena empty.
+ */
+void arena_free(Arena *arena);
+
+#endif /* ARENA_H */
@@ -0,0 +1,132 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       checkpoint.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Progress checkpoints of long runs, kept in a small memory-mapped file:
+    where in the journal the run started, how much of the journal it had
+    written and how many moves it had completed. A run that dies leaves
+    its last checkpoint behind, and --resume continues from it.
+
+ Usage:
+    Checkpoint checkpoint;
+    checkpoint_open(&checkpoint, "run.checkpoint");
+    if (checkpoint_resumable(&checkpoint, &target_st, &journal_st)) {
+        ... checkpoint.previous.run_offset, checkpoint.previous.moves ...
+    }
+    checkpoint_begin(&checkpoint, &target_st, &journal_st, run_offset, moves);
+    ... per move: if (checkpoint_tick(&checkpoint)) { flush journal; checkpoint_save(...); }
+    checkpoint_finish(&checkpoint);
+    checkpoint_close(&checkpoint);
+
+ Notes:
+    - The file is one CheckpointRecord, mapped shared, so a checkpoint is a
+      handful of stores into the page cache: it survives the process being
+      killed at any point. msync(MS_ASYNC) is issued every
+      CHECKPOINT_INTERVAL moves and a synchronous one at begin and finish,
+      so a power loss may fall back to an older checkpoint, never a
+      foreign one.
+    - checkpoint_tick() is one relaxed atomic add; workers of a parallel run
+      may call it concurrently, and whoever crosses an interval saves.
+    - The record is host-endian: a checkpoint is read back by the machine
+      that wrote it.
+
+==========================================================================================================
+*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "thread_pool.h"
+
+/** Completed moves between two checkpoints. */
+#define CHECKPOINT_INTERVAL 4096u
+
+typedef enum {
+    CHECKPOINT_EMPTY = 0,  /* new file, nothing recorded yet */
+    CHECKPOINT_RUNNING,    /* a run started and has not finished */
+    CHECKPOINT_DONE        /* the last run reached its end */
+} CheckpointStatus;
+
+/** On-disk layout. */
+typedef struct {
+    char magic[8];           /* "FOCKPT1\n" */
+    uint32_t status;         /* CheckpointStatus */
+    uint32_t reserved;
+    uint64_t target_dev;     /* identity of the organized directory */
+    uint64_t target_ino;
+    uint64_t journal_dev;    /* identity of the journal */
+    uint64_t journal_ino;
+    uint64_t run_offset;     /* journal offset of the RUN record the run started with */
+    uint64_t journal_offset; /* journal bytes written at the last checkpoint */
+    uint64_t moves;          /* moves completed at the last checkpoint */
+    uint64_t sequence;       /* checkpoints saved by the run */
+} CheckpointRecord;
+
+typedef struct {
+    int fd;
+    CheckpointRecord *record;  /* the mapped file */
+    CheckpointRecord previous; /* what the file held when opened */
+    uint64_t base_moves;       /* moves completed before this process started */
+    uint64_t moves;            /* moves completed by this process */
+    PoolMutex lock;            /* serializes checkpoint_save() */
+} Checkpoint;
+
+/**
+ * Open (creating if needed) and map the checkpoint file at 'path'; its
+ * current contents are copied to checkpoint->previous.
+ *
+ * @return  0 on success, -1 on failure (errno set; EINVAL if the file is
+ *          not a checkpoint file).
+ */
+int checkpoint_open(Checkpoint *checkpoint, const char *path);
+
+/**
+ * True if the file holds an unfinished run on the directory 'target'
+ * that journalled into 'journal'.
+ */
+bool checkpoint_resumable(const Checkpoint *checkpoint, const struct stat *target,
+                          const struct stat *journal);
+
+/**
+ * Start recording a run whose first journal record is at 'run_offset',
+ * with 'moves' moves already completed (by the run being resumed).
+ *
+ * @return  0 on success, -1 on failure (errno set).
+ */
+int checkpoint_begin(Checkpoint *checkpoint, const struct stat *target,
+                     const struct stat *journal, uint64_t run_offset, uint64_t moves);
+
+/**
+ * Count one completed move. Returns true once every CHECKPOINT_INTERVAL
+ * moves, when the caller should flush the journal and checkpoint_save().
+ */
+bool checkpoint_tick(Checkpoint *checkpoint);
+
+/**
+ * Record the moves counted so far and 'journal_offset', the journal size
+ * after a flush.
+ */
+void checkpoint_save(Checkpoint *checkpoint, uint64_t journal_offset);
+
+/**
+ * Mark the run finished; a later --resume then has nothing to continue.
+ *
+ * @return  0 on success, -1 on failure (errno set).
+ */
+int checkpoint_finish(Checkpoint *checkpoint, uint64_t journal_offset);
+
+/** Unmap and close the file. */
+void checkpoint_close(Checkpoint *checkpoint);
+
+#endif /* CHECKPOINT_H */
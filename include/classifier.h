@@ -0,0 +1,87 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       classifier.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Extension-to-category classifier for the File Organizer Tool. Maps a file
+    extension (e.g. "jpg", "PDF") to the name of its category directory, and
+    optionally the first bytes of a file (magic numbers) for files whose
+    extension is missing or unknown.
+
+ Usage:
+    const char *category = classifier_category_for_extension("JPG"); // "Images"
+    category = classifier_category_for_name("IMG_0042.JPG", 12);     // "Images"
+    category = classifier_category_for_header(header, 16);           // "%PDF-..." -> "Documents"
+
+ Notes:
+    - Lookups are O(1): the built-in table is a compile-time perfect hash.
+    - Matching is ASCII case-insensitive and never copies the extension.
+    - Every category name has a single address, so callers may compare
+      categories by pointer.
+
+==========================================================================================================
+*/
+
+#ifndef CLASSIFIER_H
+#define CLASSIFIER_H
+
+#include <stddef.h>
+
+/**
+ * Number of distinct categories the classifier can return.
+ */
+size_t classifier_category_count(void);
+
+/**
+ * Category by index, in [0, classifier_category_count()). The returned
+ * pointer is the same one classifier_category_for_extension() returns.
+ */
+const char *classifier_category_at(size_t index);
+
+/**
+ * Category used for files whose extension is missing or unknown.
+ */
+const char *classifier_default_category(void);
+
+/**
+ * Classify a file by extension.
+ *
+ * @param ext  Extension without the leading dot, or NULL if the file has none.
+ * @return     Category directory name; never NULL.
+ */
+const char *classifier_category_for_extension(const char *ext);
+
+/**
+ * Classify a file by its whole name, as
+ * classifier_category_for_extension() on the part after the last dot
+ * (none for a leading dot). Only the last few bytes are read.
+ *
+ * @param name  File name; need not be NUL-terminated.
+ * @param len   Length of 'name' in bytes.
+ * @return      Category directory name; never NULL.
+ */
+const char *classifier_category_for_name(const char *name, size_t len);
+
+/**
+ * Number of leading bytes classifier_category_for_header() looks at.
+ */
+#define CLASSIFIER_HEADER_SIZE 16
+
+/**
+ * Classify a file by its first bytes.
+ *
+ * @param header  Start of the file.
+ * @param len     Bytes available in 'header' (may be less than
+ *                CLASSIFIER_HEADER_SIZE for short files).
+ * @return        Category directory name, or the default category if no
+ *                known signature matches; never NULL.
+ */
+const char *classifier_category_for_header(const unsigned char *header, size_t len);
+
+#endif /* CLASSIFIER_H */
@@ -0,0 +1,87 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       crossdev.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Moves between file systems, where rename() fails with EXDEV: the file is
+    copied (reflink, then in-kernel copy, then buffered copy as a last
+    resort), verified and flushed, and only then is the source unlinked.
+
+ Usage:
+    CrossDevMove moves[2] = {
+        { base_fd, "movie.mkv", video_fd, "movie.mkv", 0 },
+        { base_fd, "song.mp3",  audio_fd, "song.mp3",  0 },
+    };
+    crossdev_move_batch(moves, 2, 4, NULL);   // moves[i].error: 0 or an errno value
+
+ Notes:
+    - Copy methods, in order: FICLONE (shares extents; works across bind
+      mounts of one file system), copy_file_range, sendfile, pread/pwrite.
+      A method that fails before copying anything falls through to the next.
+    - The destination is created with O_EXCL, so nothing is overwritten.
+      Mode, owner (best effort) and timestamps are copied; extended
+      attributes are not. Symlinks are recreated, not followed.
+    - A copy is kept only if the source did not change while it was copied
+      and the destination has the source's size; the destination file and
+      directory are fsync()ed before the source goes away. Any failure
+      removes the partial destination and leaves the source in place.
+    - Files of CROSSDEV_CHUNK_THRESHOLD bytes or more are copied as
+      CROSSDEV_CHUNK_SIZE chunks on all workers; smaller files are copied
+      whole, one per worker at a time.
+    - Not available on Windows: moves fail with ENOSYS.
+
+==========================================================================================================
+*/
+
+#ifndef CROSSDEV_H
+#define CROSSDEV_H
+
+#include <stddef.h>
+
+#include "throttle.h"
+
+/** Files at least this large are split into chunks copied in parallel. */
+#define CROSSDEV_CHUNK_THRESHOLD (64u << 20)
+
+/** Bytes per chunk of a large file. */
+#define CROSSDEV_CHUNK_SIZE (16u << 20)
+
+/** Default number of copy workers of a batch. */
+#define CROSSDEV_DEFAULT_JOBS 4u
+
+typedef struct {
+    int src_dir_fd;        /* descriptor the source name is relative to (or AT_FDCWD) */
+    const char *src_name;
+    int dst_dir_fd;        /* directory the copy is created in (or AT_FDCWD) */
+    const char *dst_name;
+    int error;             /* set by the move: 0, or an errno value */
+} CrossDevMove;
+
+/**
+ * Move one entry to another file system.
+ *
+ * @return  0 on success, -1 with errno set (the source is left in place).
+ */
+int crossdev_move(int src_dir_fd, const char *src_name, int dst_dir_fd, const char *dst_name);
+
+/**
+ * Copy one entry the same way, keeping the source.
+ *
+ * @return  0 on success, -1 with errno set (nothing is left behind).
+ */
+int crossdev_copy(int src_dir_fd, const char *src_name, int dst_dir_fd, const char *dst_name);
+
+/**
+ * Move every entry of 'moves' with up to 'jobs' copy workers (0 selects
+ * CROSSDEV_DEFAULT_JOBS) and store each outcome in its 'error' field.
+ * Copied bytes are paced by 'throttle' (may be NULL).
+ */
+void crossdev_move_batch(CrossDevMove *moves, size_t count, unsigned jobs, Throttle *throttle);
+
+#endif /* CROSSDEV_H */
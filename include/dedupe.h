@@ -0,0 +1,67 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       dedupe.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Content comparison for duplicate detection: decides, for a batch of
+    (kept file, candidate) pairs, which candidates are byte-identical to
+    the file they collided with.
+
+ Usage:
+    DedupePair pairs[1] = { { images_fd, "photo.jpg", base_fd, "new/photo.jpg" } };
+    dedupe_compare_batch(pairs, 1, 4);
+    if (pairs[0].result == DEDUPE_IDENTICAL) { ... }
+
+ Notes:
+    - Sizes are compared first; only files whose size matches are read.
+      Every file is read once for its 64-bit XXH64 hash (1 MiB streaming
+      reads on the workers, a file shared by several pairs is hashed once),
+      and pairs with equal hashes are confirmed byte by byte, so a hash
+      collision can never make a file look like a duplicate.
+    - Two names of one inode are identical without being read.
+    - Only regular files are compared; symlinks and special files never
+      match.
+    - Not available on Windows: every pair is reported DEDUPE_FAILED.
+
+==========================================================================================================
+*/
+
+#ifndef DEDUPE_H
+#define DEDUPE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Default number of hashing workers of a batch. */
+#define DEDUPE_DEFAULT_JOBS 4u
+
+typedef enum {
+    DEDUPE_DIFFERENT = 0,
+    DEDUPE_IDENTICAL,
+    DEDUPE_FAILED         /* a file could not be read; treat as different */
+} DedupeResult;
+
+typedef struct {
+    int kept_dir_fd;      /* file the candidate would be a duplicate of */
+    const char *kept_name;
+    int dir_fd;           /* candidate */
+    const char *name;
+
+    DedupeResult result;  /* set by the comparison */
+    uint64_t kept_size;   /* the kept file as compared, to recheck it later */
+    int64_t kept_mtime_ns;
+} DedupePair;
+
+/**
+ * Compare every pair with up to 'jobs' workers (0 selects
+ * DEDUPE_DEFAULT_JOBS) and store each outcome in its 'result' field.
+ */
+void dedupe_compare_batch(DedupePair *pairs, size_t count, unsigned jobs);
+
+#endif /* DEDUPE_H */
@@ -0,0 +1,175 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       journal.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-15
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Append-only binary journal of what a run changed: one record per created
+    category directory, per completed move and per duplicate removed by
+    --dedupe. organizer_undo() replays it backwards; journal_export_jsonl()
+    turns it into one JSON object per line.
+
+ Usage:
+    Journal journal;
+    journal_open(&journal, "moves.journal");
+    journal_begin_run(&journal, "/home/me/Downloads");
+    journal_record_move(&journal, "", "a.jpg", "Images", "a.jpg");
+    journal_close(&journal);
+
+ Notes:
+    - File layout: the 8-byte magic "FOJRNL1\n", then records of
+      [type:1][src_len:2][dst_len:2][src][NUL][dst][NUL], lengths little
+      endian. A run starts with a RUN record naming its target directory
+      (absolute); later records are relative to it.
+    - Several runs may append to one journal; undo reverts them newest first.
+    - Records are buffered and written every JOURNAL_WRITE_RECORDS records
+      (and on every flush), with an fsync every JOURNAL_SYNC_BYTES and on
+      close. A killed process loses at most the records of its last batch;
+      a power loss may lose what was not synced yet. A truncated last
+      record is ignored when the journal is read.
+    - journal_record_*() may be called from several threads.
+    - Keep the journal outside the directory being organized.
+
+==========================================================================================================
+*/
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "thread_pool.h"
+
+/** Bytes written between two fsync() calls. */
+#define JOURNAL_SYNC_BYTES ((size_t)8 * 1024 * 1024)
+
+/** Records buffered before they are written to the file. */
+#define JOURNAL_WRITE_RECORDS 64u
+
+typedef enum {
+    JOURNAL_RECORD_RUN = 'R',   /* src: absolute target directory */
+    JOURNAL_RECORD_MKDIR = 'D', /* src: created category directory */
+    JOURNAL_RECORD_MOVE = 'M',  /* src: original path, dst: category/name */
+    JOURNAL_RECORD_DROP = 'X',  /* src: removed duplicate, dst: category/name of the copy kept */
+    JOURNAL_RECORD_LINK = 'L'   /* src: removed duplicate, dst: category/name linked in its place */
+} JournalRecordType;
+
+typedef struct {
+    int fd;
+    char *buffer;
+    size_t used;
+    unsigned pending; /* records in the buffer */
+    size_t unsynced;  /* bytes written since the last fsync() */
+    uint64_t size;    /* bytes in the file, buffered records excluded */
+    int error;        /* first errno hit, sticky */
+    PoolMutex lock;
+} Journal;
+
+/** A parsed record; strings point into the loaded journal. */
+typedef struct {
+    JournalRecordType type;
+    const char *base;  /* target directory of the run the record belongs to */
+    const char *src;
+    const char *dst;   /* "" for RUN and MKDIR records */
+} JournalEntry;
+
+typedef struct {
+    char *data;
+    size_t size;
+    JournalEntry *entries;
+    size_t count;
+} JournalReader;
+
+/**
+ * Open (creating if needed) a journal for appending.
+ *
+ * @return  0 on success, -1 on failure (errno set; EINVAL if the file is
+ *          not a journal).
+ */
+int journal_open(Journal *journal, const char *path);
+
+/**
+ * Start the records of a run on 'target_dir'.
+ *
+ * @return  0 on success, -1 on failure (errno set).
+ */
+int journal_begin_run(Journal *journal, const char *target_dir);
+
+/** Record that category directory 'category' was created. */
+void journal_record_mkdir(Journal *journal, const char *category);
+
+/**
+ * Record a completed move of 'src_dir' + 'src_name' to 'category'/'dst_name'.
+ * 'src_dir' is "" or ends in '/'.
+ */
+void journal_record_move(Journal *journal, const char *src_dir, const char *src_name,
+                         const char *category, const char *dst_name);
+
+/**
+ * Record that 'src_dir' + 'src_name' was removed as a duplicate of
+ * 'category'/'kept_name' (JOURNAL_RECORD_DROP), or replaced by the hard
+ * link 'category'/'kept_name' to an identical file (JOURNAL_RECORD_LINK).
+ */
+void journal_record_duplicate(Journal *journal, JournalRecordType type,
+                              const char *src_dir, const char *src_name,
+                              const char *category, const char *kept_name);
+
+/**
+ * Write what is buffered (a long-running process calls this between
+ * batches); the periodic fsync still applies.
+ *
+ * @return  0 on success, -1 on failure (errno set).
+ */
+int journal_flush(Journal *journal);
+
+/**
+ * Size of the journal file as far as this process wrote it: the offset
+ * the next flushed record lands at. Records still buffered do not count,
+ * so call journal_flush() first for an offset covering every record.
+ */
+uint64_t journal_size(Journal *journal);
+
+/**
+ * Write and fsync what is buffered, then close.
+ *
+ * @return  0 if every record reached the file, -1 otherwise (errno set).
+ */
+int journal_close(Journal *journal);
+
+/**
+ * Read a whole journal into memory.
+ *
+ * @return  0 on success, -1 on failure (errno set; EINVAL if the file is
+ *          not a journal).
+ */
+int journal_load(JournalReader *reader, const char *path);
+
+/**
+ * Read the records of a journal from byte 'offset' on (a journal_size()
+ * taken just before a journal_begin_run(), so the first record read is a
+ * RUN record); 0 reads them all.
+ *
+ * @return  0 on success, -1 on failure (errno set; EINVAL if the file is
+ *          not a journal, is shorter than 'offset' or 'offset' is not at a
+ *          RUN record).
+ */
+int journal_load_from(JournalReader *reader, const char *path, uint64_t offset);
+
+/** Release a loaded journal. */
+void journal_reader_free(JournalReader *reader);
+
+/**
+ * Print a journal as JSON Lines, one object per record.
+ *
+ * @return  0 on success, -1 on failure (errno set).
+ */
+int journal_export_jsonl(const char *path, FILE *out);
+
+#endif /* JOURNAL_H */
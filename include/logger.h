@@ -4,7 +4,7 @@
  File:       logger.h
  Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
  Created:    2025-11-29
- Updated:    2025-11-29
+ Updated:    2026-10-14
  License:    MIT License (see LICENSE file for details)
 ==========================================================================================================
 
@@ -15,10 +15,17 @@
  Usage:
     - Call logger_set_level() once during initialization.
     - Use logger_log(level, fmt, ...) for all log messages.
+    - Optionally call logger_start_async() to hand output to a background
+      thread, and logger_stop_async() before exiting.
 
  Notes:
     - The implementation writes ERROR/WARN to stderr, INFO/DEBUG to stdout.
-    - The current implementation is simple but can be extended (e.g., file logging).
+    - In async mode messages are formatted into per-thread ring buffers and
+      written by a flusher thread; ERROR messages are on the terminal
+      before logger_log() returns, and pending output is drained at exit
+      and on fatal signals.
+    - logger_set_timing(true) makes the logger account for the time spent
+      in logger_log(), so callers can tell slow output from slow work.
 
 ==========================================================================================================
 */
@@ -27,6 +34,8 @@
 #define LOGGER_H
 
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 /**
  * Log severity levels.
@@ -49,4 +58,31 @@ void logger_set_level(LogLevel level);
  */
 void logger_log(LogLevel level, const char *fmt, ...);
 
+/**
+ * Turn accounting of logger_log() time on or off (default off). While on,
+ * every message that passes the level filter costs two clock reads.
+ */
+void logger_set_timing(bool enabled);
+
+/**
+ * Messages written, and nanoseconds spent in logger_log() writing them,
+ * while timing was on. Totals are process-wide and only ever grow.
+ */
+void logger_timing(uint64_t *messages, uint64_t *ns);
+
+/**
+ * Switch to asynchronous output.
+ *
+ * @return  0 on success, -1 if unsupported or the flusher thread could not
+ *          be started (logging then stays synchronous).
+ */
+int logger_start_async(void);
+
+/**
+ * Write everything still queued and return to synchronous output. Call it
+ * once no other thread is logging; it also runs at exit(). Does nothing if
+ * async mode is not active.
+ */
+void logger_stop_async(void);
+
 #endif /* LOGGER_H */
@@ -0,0 +1,64 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       metadata.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Metadata fetching for size and age rules. Asks the kernel for the
+    requested fields only (statx with STATX_SIZE and/or STATX_MTIME on
+    Linux), one entry at a time or as a batch through io_uring.
+
+ Usage:
+    RuleMeta meta;
+    if (metadata_stat(dir_fd, "movie.mkv", RULE_FIELD_SIZE, &meta) == 0) {
+        ... meta.size ...
+    }
+
+    MetaRequest requests[2] = { { "a.mp4", RULE_FIELD_SIZE, 0, {0} },
+                                { "b.log", RULE_FIELD_MTIME, 0, {0} } };
+    metadata_stat_batch(dir_fd, requests, 2, 256);
+
+ Notes:
+    - statx() is called with AT_STATX_DONT_SYNC: network file systems
+      answer from their attribute cache instead of a server round trip;
+      local ones ignore the flag.
+    - Without statx (older kernels or C libraries, other systems) the
+      fields come from fstatat().
+
+==========================================================================================================
+*/
+
+#ifndef METADATA_H
+#define METADATA_H
+
+#include <stddef.h>
+
+#include "rules.h"
+
+typedef struct {
+    const char *name;  /* relative to the directory descriptor */
+    unsigned fields;   /* RuleField mask to fetch */
+    int status;        /* 0, or -1 if the fields could not be fetched */
+    RuleMeta meta;
+} MetaRequest;
+
+/**
+ * Fetch the 'fields' (RuleField mask) of 'name', relative to 'dir_fd'.
+ *
+ * @return  0 on success, -1 on failure (errno set).
+ */
+int metadata_stat(int dir_fd, const char *name, unsigned fields, RuleMeta *meta);
+
+/**
+ * Fill every request, 'queue_depth' statx calls in flight at a time when
+ * io_uring is available.
+ */
+void metadata_stat_batch(int dir_fd, MetaRequest *requests, size_t count,
+                         unsigned queue_depth);
+
+#endif /* METADATA_H */
@@ -0,0 +1,77 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       name_set.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Open-addressing hash set of file names. Used to track which names are taken
+    inside a directory so collision resolution needs no file system probes.
+
+ Usage:
+    NameSet set;
+    name_set_init(&set);
+    NameSetEntry *e = name_set_insert(&set, "photo.jpg");
+    if (name_set_find(&set, "photo.jpg")) { ... }
+    name_set_free(&set);
+
+ Notes:
+    - Keys are copied on insertion and released by name_set_free().
+    - Entry pointers are invalidated by the next insertion.
+
+==========================================================================================================
+*/
+
+#ifndef NAME_SET_H
+#define NAME_SET_H
+
+#include <stddef.h>
+
+#include "arena.h"
+
+/**
+ * A taken name. 'next_suffix' is the first "_N" suffix worth trying the next
+ * time a file with exactly this name needs a unique variant (0 = start at 1).
+ */
+typedef struct {
+    char *name;
+    size_t hash;
+    unsigned next_suffix;
+} NameSetEntry;
+
+typedef struct {
+    NameSetEntry *slots;
+    size_t capacity; /* power of two, or 0 */
+    size_t count;
+    Arena keys;      /* storage of every 'name' */
+} NameSet;
+
+/**
+ * Initialize an empty set.
+ */
+void name_set_init(NameSet *set);
+
+/**
+ * Release all keys and storage held by the set.
+ */
+void name_set_free(NameSet *set);
+
+/**
+ * Look up a name.
+ *
+ * @return  The matching entry, or NULL if the name is not in the set.
+ */
+NameSetEntry *name_set_find(const NameSet *set, const char *name);
+
+/**
+ * Insert a name (copied) unless it is already present.
+ *
+ * @return  The new or existing entry, or NULL on allocation failure.
+ */
+NameSetEntry *name_set_insert(NameSet *set, const char *name);
+
+#endif /* NAME_SET_H */
@@ -4,7 +4,7 @@
  File:       organizer.h
  Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
  Created:    2025-11-29
- Updated:    2025-11-29
+ Updated:    2026-10-14
  License:    MIT License (see LICENSE file for details)
 ==========================================================================================================
 
@@ -14,7 +14,15 @@
 
  Usage:
     - Configure an OrganizerConfig instance.
-    - Call organizer_run(&config) from main().
+    - Call organizer_run(&config) from main(), or
+    - Call organizer_plan() to inspect the moves, then organizer_execute()
+      and organizer_plan_free().
+    - Call organizer_undo() to revert runs recorded in a journal.
+    - Embedders that organize one directory over and over create an
+      OrganizerContext once and call organizer_context_run() (or
+      organizer_context_run_names() with the names that arrived) per batch.
+    - Point config.stats at a zeroed OrganizerStats to collect counters and
+      timings.
 
  Notes:
     - This module is intentionally independent of CLI parsing.
@@ -27,6 +35,129 @@
 #define ORGANIZER_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "rules.h"
+#include "throttle.h"
+
+/** Default ceiling for planned work buffered between the pipeline stages. */
+#define ORGANIZER_DEFAULT_MAX_MEM ((size_t)64 << 20)
+
+/**
+ * How the execute phase issues its metadata system calls.
+ */
+typedef enum {
+    /** One mkdir()/rename() at a time. */
+    ORGANIZER_BACKEND_SERIAL = 0,
+
+    /** Batched io_uring submissions (Linux); falls back to serial if unsupported. */
+    ORGANIZER_BACKEND_URING
+} OrganizerBackend;
+
+/**
+ * Order in which the execute phase applies the moves of a plan.
+ */
+typedef enum {
+    /** The order the entries were read from the directory (hash order on ext4/XFS). */
+    ORGANIZER_ORDER_READDIR = 0,
+
+    /**
+     * Grouped by destination category, then by source inode number, so each
+     * category directory's blocks stay hot and the source directory's inode
+     * table is walked once, front to back.
+     */
+    ORGANIZER_ORDER_INODE
+} OrganizerOrder;
+
+/**
+ * What happens to a file whose name collides with a byte-identical file.
+ */
+typedef enum {
+    /** Nothing special: it is moved under a "_N" name like any collision. */
+    ORGANIZER_DEDUPE_OFF = 0,
+
+    /** The duplicate is deleted; the identical file already in place stays. */
+    ORGANIZER_DEDUPE_DROP,
+
+    /** The "_N" name becomes a hard link to the identical file; the duplicate is deleted. */
+    ORGANIZER_DEDUPE_LINK
+} OrganizerDedupe;
+
+/**
+ * Phases of a run, as timed in OrganizerStats.phase_ns.
+ */
+typedef enum {
+    /** Reading source directories. */
+    ORGANIZER_PHASE_SCAN = 0,
+
+    /** Categorizing entries, including type/size stats and header reads. */
+    ORGANIZER_PHASE_CLASSIFY,
+
+    /** Category lookups and collision-free destination names. */
+    ORGANIZER_PHASE_RESOLVE,
+
+    /** Creating category directories and moving files (or logging them). */
+    ORGANIZER_PHASE_EXECUTE,
+
+    ORGANIZER_PHASE_COUNT
+} OrganizerPhase;
+
+/**
+ * Classes of system calls (and logging) timed in OrganizerStats.
+ */
+typedef enum {
+    ORGANIZER_SYSCALL_READDIR = 0,  /**< opening and reading directories (getdents64) */
+    ORGANIZER_SYSCALL_STAT,         /**< stat/fstatat */
+    ORGANIZER_SYSCALL_OPEN,         /**< opening category directories */
+    ORGANIZER_SYSCALL_READ,         /**< header reads (open + read + close per file) */
+    ORGANIZER_SYSCALL_MKDIR,        /**< synchronous mkdir */
+    ORGANIZER_SYSCALL_RENAME,       /**< synchronous rename */
+    ORGANIZER_SYSCALL_URING,        /**< io_uring submit and wait (batched mkdir/rename) */
+    ORGANIZER_SYSCALL_COPY,         /**< cross-file-system moves (copy, flush, unlink) per file */
+    ORGANIZER_SYSCALL_HASH,         /**< duplicate checks (stat, hash, compare) per candidate */
+    ORGANIZER_SYSCALL_LOG,          /**< time spent inside logger_log() */
+    ORGANIZER_SYSCALL_COUNT
+} OrganizerSyscall;
+
+/**
+ * Counters and timers of organizer runs. Every field is added to, never
+ * reset, so one struct can accumulate several runs (or every batch of
+ * organizer_watch()); zero it before the first. With several workers the
+ * timers are summed over threads and may exceed the wall time.
+ */
+typedef struct {
+    uint64_t scanned;     /**< entries read from source directories */
+    uint64_t skipped;     /**< entries left in place (not regular files, unreadable, unchanged) */
+    uint64_t planned;     /**< moves planned */
+    uint64_t moved;       /**< files moved */
+    uint64_t collisions;  /**< moves whose name was taken and got a numeric suffix */
+    uint64_t mkdirs;      /**< category directories created */
+    uint64_t duplicates;  /**< identical files dropped or linked instead of moved */
+    uint64_t errors;      /**< entries, moves and directories that failed */
+
+    /** Wall time of the organizer_run/plan/execute calls (watch: of its batches). */
+    uint64_t total_ns;
+
+    /** Nanoseconds per phase. */
+    uint64_t phase_ns[ORGANIZER_PHASE_COUNT];
+
+    /** Calls and nanoseconds per system call class. */
+    uint64_t syscalls[ORGANIZER_SYSCALL_COUNT];
+    uint64_t syscall_ns[ORGANIZER_SYSCALL_COUNT];
+} OrganizerStats;
+
+/**
+ * A category kept outside the target directory, e.g. on another disk.
+ */
+typedef struct {
+    /** Category name as produced by the classifier or the rules ("Video"). */
+    const char *category;
+
+    /** Absolute path of the directory used as that category's folder. */
+    const char *path;
+} OrganizerDestination;
 
 /**
  * Configuration for the file organizer.
@@ -35,19 +166,290 @@ typedef struct {
     /** Target directory to organize. */
     const char *target_dir;
 
-    /** If true, only print planned operations without modifying the file system. */
+    /**
+     * If true, only print planned operations. The run is read-only: nothing
+     * is created, renamed or written (no journal, no state file). Missing
+     * category directories and collision suffixes are simulated in memory,
+     * so the printed destinations are the ones a real run would pick.
+     */
     bool dry_run;
 
     /** If true, print verbose diagnostic output. */
     bool verbose;
+
+    /** Directory read buffer in bytes (getdents64 on Linux); 0 selects the default. */
+    size_t scan_buffer_size;
+
+    /** Execute phase backend. */
+    OrganizerBackend backend;
+
+    /** Order of the moves in the execute phase; applies to each executed chunk. */
+    OrganizerOrder order;
+
+    /** io_uring queue depth (operations in flight); 0 selects the default. */
+    unsigned queue_depth;
+
+    /**
+     * Worker threads; 0 or 1 runs single-threaded. Work is partitioned by
+     * destination category, so at most one worker per category is busy.
+     */
+    unsigned jobs;
+
+    /**
+     * If true, also organize files in subdirectories (into the top-level
+     * category directories). Directory symlinks are not followed.
+     */
+    bool recursive;
+
+    /**
+     * If set, created category directories and completed moves are
+     * appended to this journal file, for organizer_undo().
+     */
+    const char *journal_path;
+
+    /**
+     * If set, organizer_run() keeps incremental state in this file: a run
+     * on a directory unchanged since the last one does nothing, and only
+     * entries new since then are examined. Ignored with 'recursive', since
+     * the target directory's timestamps say nothing about subdirectories.
+     */
+    const char *state_path;
+
+    /**
+     * If set (together with journal_path), organizer_run() checkpoints its
+     * progress into this file every CHECKPOINT_INTERVAL moves: the journal
+     * offset the run started at, the journal bytes written and the moves
+     * completed. The file says whether the run finished.
+     */
+    const char *checkpoint_path;
+
+    /**
+     * If true and checkpoint_path holds an unfinished run on this directory
+     * with this journal, continue it: the category folders that run created
+     * are not read again, since the journal already names everything it put
+     * there. Moves into them refuse to replace an existing file, so names
+     * moved after the last journal flush are never overwritten. Without an
+     * unfinished run this is an ordinary run.
+     */
+    bool resume;
+
+    /**
+     * If true, files whose extension is missing or unknown are classified
+     * by their first bytes (magic numbers). Files the extension table knows
+     * are never opened.
+     */
+    bool sniff;
+
+    /**
+     * If set, user rules are tried before the built-in extension table;
+     * files no rule matches are classified as usual.
+     */
+    const RuleSet *rules;
+
+    /**
+     * If set, counters and timings are added to it. Timing costs a few
+     * clock reads per file and also turns on logger timing.
+     */
+    OrganizerStats *stats;
+
+    /**
+     * Categories whose folder lives elsewhere. A destination on another
+     * file system is reached by copying: rename() fails with EXDEV there,
+     * so the file is copied, verified and flushed before the source is
+     * unlinked.
+     */
+    const OrganizerDestination *destinations;
+    size_t destination_count;
+
+    /** Threads for cross-file-system copies and duplicate hashing; 0 selects the default. */
+    unsigned copy_jobs;
+
+    /**
+     * Handling of name collisions with identical content. Only the file
+     * already holding the name (on disk, or planned earlier in the same
+     * plan) is compared; sizes first, then hashes, then bytes.
+     */
+    OrganizerDedupe dedupe;
+
+    /**
+     * Shard of the entries this process handles, for nodes organizing one
+     * tree without coordination: an entry belongs to shard 'shard_index'
+     * (0 <= shard_index < shard_count) if the FNV-1a hash of its file name
+     * (not its path) modulo 'shard_count' says so; others are skipped.
+     * Collision variants then carry the shard ("photo_s2-1.jpg"), so no two
+     * shards ever claim the same destination. shard_count 0 or 1: no sharding.
+     */
+    unsigned shard_index;
+    unsigned shard_count;
+
+    /**
+     * Ceiling in bytes for the entries and moves buffered between scanning
+     * and executing; 0 selects ORGANIZER_DEFAULT_MAX_MEM. Runs execute in
+     * chunks as they scan (the serial path plans and executes on two
+     * threads at once), so memory no longer grows with the directory.
+     * Category name sets, which must know every name in the category
+     * folders, and organizer_plan()'s returned plan are not bounded by it.
+     */
+    size_t max_mem;
+
+    /**
+     * If set, execution is paced by it: every metadata operation (rename,
+     * mkdir, link, unlink) takes one op from its budget and every copied
+     * byte one byte. Scanning and classification are not paced. Its limits
+     * may be changed while a run is going; watch mode re-reads its limits
+     * file on SIGHUP.
+     */
+    Throttle *throttle;
 } OrganizerConfig;
 
 /**
- * Run the file organizer.
+ * A single planned move. Strings are owned by the plan.
+ */
+typedef struct {
+    /**
+     * Directory of the source relative to the target directory, with a
+     * trailing '/' ("a/b/"), or "" for the target directory itself. Moves
+     * from one directory share the same string.
+     */
+    const char *src_dir;
+
+    /** Source entry name inside 'src_dir'. */
+    const char *src_name;
+
+    /** Category directory name the entry is moved into. */
+    const char *category;
+
+    /** Collision-free file name inside the category directory. */
+    const char *dst_name;
+
+    /** Name the entry collided with (so 'dst_name' has a suffix), or NULL. */
+    const char *collided_with;
+
+    /** Inode number of the source as read from its directory; 0 if unknown. */
+    uint64_t src_ino;
+} OrganizerMove;
+
+/**
+ * Move plan produced by organizer_plan() and applied by organizer_execute().
+ */
+typedef struct {
+    OrganizerMove *moves;
+    size_t count;
+    size_t capacity;
+
+    /** Storage of every string the moves point to. */
+    Arena strings;
+} OrganizerPlan;
+
+/**
+ * Scan the target directory and build a move plan without touching
+ * the file system.
+ *
+ * @param config  Pointer to configuration structure.
+ * @param plan    Output plan; release it with organizer_plan_free().
+ * @return        0 if every entry was planned, non-zero if some entries
+ *                (or the whole directory) could not be planned.
+ */
+int organizer_plan(const OrganizerConfig *config, OrganizerPlan *plan);
+
+/**
+ * Apply a plan built by organizer_plan(). Category directories are created
+ * once each; with config->dry_run set, moves are only logged.
+ *
+ * @param config  Pointer to configuration structure.
+ * @param plan    Plan to apply.
+ * @return        0 on success, non-zero if any move failed.
+ */
+int organizer_execute(const OrganizerConfig *config, const OrganizerPlan *plan);
+
+/**
+ * Release the memory held by a plan.
+ */
+void organizer_plan_free(OrganizerPlan *plan);
+
+/**
+ * Run the file organizer (plan followed by execute).
  *
  * @param config  Pointer to configuration structure.
  * @return        0 on success, non-zero on failure.
  */
 int organizer_run(const OrganizerConfig *config);
 
+/**
+ * Organize the target directory, then stay resident and organize files as
+ * they land (closed after writing, or renamed in), in debounced batches
+ * that reuse the warm category and collision caches. Returns when SIGINT
+ * or SIGTERM arrives, or when the directory goes away. Linux only;
+ * config->recursive is not supported.
+ *
+ * @param config  Pointer to configuration structure.
+ * @return        0 if every batch succeeded, non-zero otherwise.
+ */
+int organizer_watch(const OrganizerConfig *config);
+
+/**
+ * Warm state for repeated runs on one target directory: the open target
+ * and category descriptors with their name sets, the worker pool and the
+ * journal (one run record for the context's lifetime). Opaque.
+ */
+typedef struct OrganizerContext OrganizerContext;
+
+/**
+ * Validate config->target_dir and set up a context for it. The
+ * configuration is copied, but everything it points to (target directory,
+ * rules, destinations, stats) must outlive the context. config->state_path
+ * is ignored: the context itself remembers what it has seen.
+ *
+ * @param config  Pointer to configuration structure.
+ * @return        A context for organizer_context_destroy(), or NULL (logged).
+ */
+OrganizerContext *organizer_context_create(const OrganizerConfig *config);
+
+/**
+ * Organize the whole target directory, in the configured mode, reusing
+ * everything the context resolved before. Name sets of category
+ * directories that changed since the previous call are re-read.
+ *
+ * @param ctx  Context from organizer_context_create().
+ * @return     0 on success, non-zero if any entry failed.
+ */
+int organizer_context_run(OrganizerContext *ctx);
+
+/**
+ * Organize just the given entries of the target directory (bare names, no
+ * '/'), without scanning it. Names that no longer exist are skipped.
+ *
+ * @param ctx    Context from organizer_context_create().
+ * @param names  Entry names.
+ * @param count  Number of names.
+ * @return       0 on success, non-zero if any entry failed.
+ */
+int organizer_context_run_names(OrganizerContext *ctx, const char *const *names, size_t count);
+
+/**
+ * Release a context and complete its journal.
+ *
+ * @return  0, or non-zero if the journal could not be completed.
+ */
+int organizer_context_destroy(OrganizerContext *ctx);
+
+/**
+ * Revert the runs recorded in a journal, newest move first: every file is
+ * renamed back to where it came from and every category directory the runs
+ * created is removed if it is empty again. Honors config->dry_run,
+ * config->backend and config->queue_depth; the target directories come from
+ * the journal, not from config->target_dir.
+ *
+ * @param config        Pointer to configuration structure.
+ * @param journal_path  Journal written with config->journal_path.
+ * @return              0 if everything was restored, non-zero otherwise.
+ */
+int organizer_undo(const OrganizerConfig *config, const char *journal_path);
+
+/**
+ * Short lowercase names ("scan", "rename", ...) for reports.
+ */
+const char *organizer_phase_name(OrganizerPhase phase);
+const char *organizer_syscall_name(OrganizerSyscall syscall_class);
+
 #endif /* ORGANIZER_H */
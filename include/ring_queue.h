@@ -0,0 +1,83 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       ring_queue.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Bounded FIFO of pointers connecting the stages of a pipeline. A full
+    queue blocks the producer (backpressure), an empty one the consumer,
+    so at most 'capacity' items are ever waiting between two stages.
+
+ Usage:
+    RingQueue queue;
+    ring_queue_init(&queue, 2);
+    // producer                       // consumer
+    ring_queue_push(&queue, chunk);   while (ring_queue_pop(&queue, &item)) { ... }
+    ring_queue_close(&queue);
+    ring_queue_free(&queue);
+
+ Notes:
+    - Any number of producers and consumers may share one queue; one mutex
+      guards it. Items are meant to be coarse (a batch of work), not single
+      entries.
+    - Blocking needs the other end on another thread; see thread_pool.h.
+
+==========================================================================================================
+*/
+
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "thread_pool.h"
+
+typedef struct {
+    void **items;
+    size_t capacity;
+    size_t head;      /* next item to pop */
+    size_t count;
+    bool closed;
+    PoolMutex lock;
+    PoolCond changed; /* an item was pushed or popped, or the queue closed */
+} RingQueue;
+
+/**
+ * Initialize an empty queue holding at most 'capacity' (>= 1) items.
+ *
+ * @return  0 on success, -1 on allocation failure.
+ */
+int ring_queue_init(RingQueue *queue, size_t capacity);
+
+/**
+ * Append an item, waiting while the queue is full.
+ *
+ * @return  0, or -1 if the queue was closed (the item was not added).
+ */
+int ring_queue_push(RingQueue *queue, void *item);
+
+/**
+ * Remove the oldest item into '*item', waiting while the queue is empty.
+ *
+ * @return  true, or false once the queue is closed and drained.
+ */
+bool ring_queue_pop(RingQueue *queue, void **item);
+
+/**
+ * Refuse further pushes and wake every waiter; items already queued can
+ * still be popped.
+ */
+void ring_queue_close(RingQueue *queue);
+
+/**
+ * Release the queue. Items still queued are not freed.
+ */
+void ring_queue_free(RingQueue *queue);
+
+#endif /* RING_QUEUE_H */
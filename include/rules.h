@@ -0,0 +1,143 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       rules.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    User-defined classification rules. A rule file maps extensions, name
+    globs, size ranges and ages to category directories; it is compiled into a
+    single DFA over the reversed, lowercased file name, so a lookup costs
+    one table step per name byte however many rules there are, and usually
+    stops after the extension.
+
+ Usage:
+    RuleSet rules;
+    if (rules_load(&rules, "organizer.rules", true) == 0) {
+        const char *category = rules_classify(&rules, name, strlen(name), NULL, NULL);
+        rules_free(&rules);
+    }
+
+    Rule file:
+        # CATEGORY: TERM...
+        Screenshots: screenshot*.png "screen shot*"
+        Installers:  .deb .rpm .msi *setup*.exe
+        Huge:        size>=1G
+        Small PDFs:  .pdf size<100K
+        Video/Large: .mp4 .mkv .mov size>4G
+        Archive:     age>90d
+
+ Notes:
+    - A rule matches if the name matches any of its patterns (all names
+      when it has none) and the size and age satisfy every size and age
+      term. The first
+      matching rule in file order wins; unmatched files fall back to the
+      built-in extension table.
+    - Terms: ".ext"; a glob with '*', '?', "[a-z]", "[!0-9]" and '\'
+      escapes; size<N, size<=N, size>N, size>=N or size=N with an
+      optional K, M or G suffix; age<N, age<=N, age>N, age>=N or age=N
+      (time since the last modification) with an optional s, m, h, d or w
+      suffix (seconds by default). Double quotes allow spaces in a
+      pattern. Matching is ASCII case-insensitive.
+    - A category may name a subfolder ("Video/Large"); missing parents are
+      created with it.
+    - Metadata is only fetched for a name whose candidate rules test it,
+      and only the fields those rules need (RuleField); rule sets without
+      size or age terms never fetch any.
+    - The compiled automaton is cached in $XDG_CACHE_HOME/file-organizer
+      (default ~/.cache/file-organizer), keyed by a hash of the rule file,
+      so repeated runs skip parsing and compilation. The cache is specific
+      to the machine that wrote it and is validated before use.
+
+==========================================================================================================
+*/
+
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Metadata a rule can test; masks of these say what to fetch. */
+typedef enum {
+    RULE_FIELD_SIZE = 1u << 0,
+    RULE_FIELD_MTIME = 1u << 1
+} RuleField;
+
+#define RULE_FIELDS_ALL (RULE_FIELD_SIZE | RULE_FIELD_MTIME)
+
+typedef struct {
+    uint32_t category;  /* index into RuleSet.categories */
+    uint32_t fields;    /* RuleField mask of the ranges that apply */
+    uint64_t min_size;  /* inclusive */
+    uint64_t max_size;  /* inclusive */
+    int64_t min_age;    /* seconds since the last modification, inclusive */
+    int64_t max_age;    /* inclusive */
+} Rule;
+
+/** Metadata of the entry being classified; only the requested fields are set. */
+typedef struct {
+    uint64_t size;
+    int64_t mtime;      /* seconds since the epoch */
+} RuleMeta;
+
+typedef struct {
+    /*
+     * Category names. Names equal to a built-in category are that
+     * category's pointer, so categories still compare by address.
+     */
+    const char **categories;
+    size_t category_count;
+
+    const Rule *rules;
+    size_t rule_count;
+
+    /* DFA over the reversed name: state 0 is dead, state 1 is the start. */
+    const uint8_t *byte_class;     /* 256 entries */
+    uint32_t class_count;
+    uint32_t state_count;
+    const uint32_t *next;          /* state_count * class_count */
+    const uint32_t *accept_start;  /* state_count + 1 offsets into accept_rules */
+    const uint32_t *accept_rules;  /* matching rule indices, ascending */
+    const uint8_t *settled;        /* 1 if no further byte changes the match */
+    unsigned fields;               /* RuleField mask any rule tests; 0: names only */
+
+    void *storage;                 /* the block everything above points into */
+    bool from_cache;
+} RuleSet;
+
+/**
+ * Fetch the 'fields' (RuleField mask) of the entry being classified;
+ * called at most once per lookup, and only when a rule matching the name
+ * tests metadata.
+ *
+ * @return  0 on success, -1 if the metadata is unavailable.
+ */
+typedef int (*RuleMetaFn)(void *ctx, unsigned fields, RuleMeta *meta);
+
+/**
+ * Load a rule file, from the compiled cache when it is current. Syntax
+ * errors are logged with their line number.
+ *
+ * @param write_cache  Store a freshly compiled automaton in the cache;
+ *                     false keeps the load read-only (dry runs).
+ * @return             0 on success, -1 on failure.
+ */
+int rules_load(RuleSet *rules, const char *path, bool write_cache);
+
+/**
+ * Category of the first rule matching 'name', or NULL if none does.
+ * 'meta_of' may be NULL, in which case rules with size or age terms never
+ * match. Ages are measured against the current time.
+ */
+const char *rules_classify(const RuleSet *rules, const char *name, size_t name_len,
+                           RuleMetaFn meta_of, void *ctx);
+
+void rules_free(RuleSet *rules);
+
+#endif /* RULES_H */
@@ -0,0 +1,97 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       scanner.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Directory scanner that yields entries in batches. On Linux it reads raw
+    getdents64 records into one large buffer and hands out pointers into it;
+    elsewhere it wraps opendir()/readdir().
+
+ Usage:
+    DirScanner scanner;
+    if (dir_scanner_open(&scanner, dir_fd, path, 0) == 0) {
+        const ScanEntry *batch;
+        long n;
+        while ((n = dir_scanner_next_batch(&scanner, &batch)) > 0) { ... }
+        dir_scanner_close(&scanner);
+    }
+
+ Notes:
+    - "." and ".." are never returned.
+    - Entries of a batch stay valid until the next call on the same scanner.
+
+==========================================================================================================
+*/
+
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <dirent.h>
+
+/** Default getdents64 buffer size. */
+#define SCANNER_DEFAULT_BUFFER_SIZE ((size_t)1024 * 1024)
+
+/**
+ * Entry type as reported by the directory itself (d_type). UNKNOWN means
+ * the file system did not say and the caller has to stat the entry.
+ */
+typedef enum {
+    SCAN_TYPE_UNKNOWN = 0,
+    SCAN_TYPE_REGULAR,
+    SCAN_TYPE_DIRECTORY,
+    SCAN_TYPE_SYMLINK,
+    SCAN_TYPE_OTHER
+} ScanEntryType;
+
+typedef struct {
+    const char *name;   /* NUL-terminated, owned by the scanner */
+    size_t name_len;
+    ScanEntryType type;
+    uint64_t ino;       /* d_ino; 0 where the platform does not report it */
+} ScanEntry;
+
+typedef struct {
+    DIR *dir;             /* readdir() fallback stream, or NULL */
+    int fd;               /* getdents64 descriptor, or -1 */
+    char *buffer;         /* raw getdents64 records */
+    size_t buffer_size;
+    ScanEntry *batch;
+    size_t batch_capacity;
+} DirScanner;
+
+/**
+ * Start scanning a directory, given either an open descriptor or a path.
+ *
+ * @param scanner      Scanner to initialize.
+ * @param dir_fd       Open directory descriptor, or -1 to use 'path'. The
+ *                     descriptor is not consumed and its offset is untouched.
+ * @param path         Directory path (used when dir_fd is -1).
+ * @param buffer_size  getdents64 buffer size in bytes; 0 selects the default.
+ * @return             0 on success, -1 on failure (errno set).
+ */
+int dir_scanner_open(DirScanner *scanner, int dir_fd, const char *path,
+                     size_t buffer_size);
+
+/**
+ * Fetch the next batch of entries.
+ *
+ * @param scanner  Open scanner.
+ * @param batch    Receives a pointer to the batch.
+ * @return         Number of entries (> 0), 0 at the end, -1 on error (errno set).
+ */
+long dir_scanner_next_batch(DirScanner *scanner, const ScanEntry **batch);
+
+/**
+ * Release the scanner's descriptor and buffers.
+ */
+void dir_scanner_close(DirScanner *scanner);
+
+#endif /* SCANNER_H */
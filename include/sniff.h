@@ -0,0 +1,59 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       sniff.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Bounded header reads for content sniffing: the first
+    CLASSIFIER_HEADER_SIZE bytes of a file, one at a time or as a batch
+    whose opens, reads and closes are submitted together through io_uring.
+
+ Usage:
+    SniffRequest requests[2] = { { "README", 0, {0} }, { "photo", 0, {0} } };
+    sniff_read_headers(dir_fd, requests, 2, 256);
+    if (requests[1].len > 0) {
+        category = classifier_category_for_header(requests[1].header, (size_t)requests[1].len);
+    }
+
+ Notes:
+    - Files are opened O_NONBLOCK, so an entry swapped for a FIFO after it
+      was stat()ed cannot hang the run.
+    - Without io_uring (or on failure) batches fall back to openat+pread.
+    - Not available on Windows: reads fail with ENOSYS.
+
+==========================================================================================================
+*/
+
+#ifndef SNIFF_H
+#define SNIFF_H
+
+#include <stddef.h>
+
+#include "classifier.h"
+
+typedef struct {
+    const char *name;  /* relative to the directory descriptor */
+    int len;           /* bytes read, or -1 if the file could not be read */
+    unsigned char header[CLASSIFIER_HEADER_SIZE];
+} SniffRequest;
+
+/**
+ * Read the first 'size' bytes of 'name' (relative to 'dir_fd').
+ *
+ * @return  Bytes read (0 for an empty file), or -1 on failure (errno set).
+ */
+int sniff_read_header(int dir_fd, const char *name, unsigned char *header, size_t size);
+
+/**
+ * Fill the header of every request, 'queue_depth' files in flight at a
+ * time when io_uring is available.
+ */
+void sniff_read_headers(int dir_fd, SniffRequest *requests, size_t count,
+                        unsigned queue_depth);
+
+#endif /* SNIFF_H */
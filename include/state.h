@@ -0,0 +1,118 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       state.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Persistent state of incremental runs: the target directory's identity
+    and timestamps as seen when the last run started, and the entries that
+    run left in place on purpose (subdirectories, special files, ...).
+
+ Usage:
+    IncrementalState state;
+    incremental_load(&state, path);
+    if (incremental_unchanged(&state, &st)) { nothing to do }
+    ... incremental_skip() / incremental_note_skipped() per entry ...
+    incremental_save(&state, path, &st, run_succeeded);
+    incremental_free(&state);
+
+ Notes:
+    - A run may be skipped only if the directory's device, inode, mtime and
+      ctime all match the saved ones. The saved stamp is taken before the
+      scan, so changes made while a run is in progress are never lost.
+    - A stamp is not trusted if the directory changed within a second of
+      being stat()ed (timestamps are coarse) or if the run had failures.
+    - Left-over entries are remembered as (inode, name hash), so a name that
+      is reused by a new file is processed again.
+    - File format (text): "file-organizer-state 1", a "dir" line with the
+      stamp, then one "known <ino> <hash>" line per left-over entry.
+
+==========================================================================================================
+*/
+
+#ifndef STATE_H
+#define STATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "scanner.h"
+
+typedef struct {
+    uint64_t ino;
+    uint64_t hash; /* FNV-1a of the name; never 0 */
+} KnownEntry;
+
+/* Open-addressing set of entries; a zero hash marks a free slot. */
+typedef struct {
+    KnownEntry *slots;
+    size_t capacity; /* power of two, or 0 */
+    size_t count;
+} KnownSet;
+
+typedef struct {
+    uint64_t dev;
+    uint64_t ino;
+    int64_t mtime_sec;
+    long mtime_nsec;
+    int64_t ctime_sec;
+    long ctime_nsec;
+} DirStamp;
+
+typedef struct {
+    bool loaded;      /* a trusted stamp was read from disk */
+    DirStamp stamp;
+    KnownSet previous; /* left-over entries of the last run */
+    KnownSet next;     /* left-over entries of this run */
+} IncrementalState;
+
+/**
+ * Load the state file at 'path'. A missing file yields an empty state.
+ *
+ * @return  0 on success, -1 if the file exists but cannot be read or
+ *          parsed (errno set; EINVAL for a malformed file).
+ */
+int incremental_load(IncrementalState *state, const char *path);
+
+/**
+ * True if the directory described by 'st' is unchanged since the last run.
+ */
+bool incremental_unchanged(const IncrementalState *state, const struct stat *st);
+
+/**
+ * True if 'entry' was left in place by the last run; it is then carried
+ * over to this run's state and should not be processed again.
+ */
+bool incremental_skip(IncrementalState *state, const ScanEntry *entry);
+
+/**
+ * Remember that this run left 'entry' in place on purpose.
+ *
+ * @return  0 on success, -1 on allocation failure.
+ */
+int incremental_note_skipped(IncrementalState *state, const ScanEntry *entry);
+
+/**
+ * Atomically replace the state file with this run's stamp ('st', taken
+ * before the scan) and left-over entries.
+ *
+ * @param trusted  false if the run had failures; the next run then scans
+ *                 again even if nothing changed.
+ * @return         0 on success, -1 on failure (errno set).
+ */
+int incremental_save(const IncrementalState *state, const char *path,
+                     const struct stat *st, bool trusted);
+
+/**
+ * Release the state's memory.
+ */
+void incremental_free(IncrementalState *state);
+
+#endif /* STATE_H */
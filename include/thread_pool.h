@@ -0,0 +1,96 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       thread_pool.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Fixed-size pool of worker threads that run one task on every worker at
+    once ("parallel for"). The calling thread takes part as worker 0.
+
+ Usage:
+    ThreadPool *pool = thread_pool_create(4);
+    thread_pool_run(pool, task, &shared_state);  // task(arg, worker, workers)
+    thread_pool_destroy(pool);
+
+ Notes:
+    - Workers are created once and reused by every thread_pool_run() call.
+    - Without pthreads (e.g. Windows builds) the pool has a single worker
+      and tasks run inline, and PoolMutex operations are no-ops.
+    - PoolMutex is a thin portable wrapper for the few places where workers
+      do share state; PoolCond lets one of them wait for another. Waiting
+      needs a second thread, so a single-worker pool must never wait.
+
+==========================================================================================================
+*/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#ifndef _WIN32
+#include <pthread.h>
+typedef pthread_mutex_t PoolMutex;
+typedef pthread_cond_t PoolCond;
+#else
+typedef int PoolMutex;
+typedef int PoolCond;
+#endif
+
+/** Initialize a mutex. */
+void pool_mutex_init(PoolMutex *mutex);
+
+/** Lock a mutex. */
+void pool_mutex_lock(PoolMutex *mutex);
+
+/** Unlock a mutex. */
+void pool_mutex_unlock(PoolMutex *mutex);
+
+/** Destroy a mutex. */
+void pool_mutex_destroy(PoolMutex *mutex);
+
+/** Initialize a condition variable. */
+void pool_cond_init(PoolCond *cond);
+
+/** Atomically release 'mutex' and wait; 'mutex' is held again on return. */
+void pool_cond_wait(PoolCond *cond, PoolMutex *mutex);
+
+/** Wake every waiter. */
+void pool_cond_broadcast(PoolCond *cond);
+
+/** Destroy a condition variable. */
+void pool_cond_destroy(PoolCond *cond);
+
+/**
+ * Task run by every worker. 'worker' is in [0, workers).
+ */
+typedef void (*ThreadPoolTask)(void *arg, unsigned worker, unsigned workers);
+
+typedef struct ThreadPool ThreadPool;
+
+/**
+ * Create a pool with 'workers' workers, including the caller.
+ *
+ * @return  The pool, or NULL if it could not be created.
+ */
+ThreadPool *thread_pool_create(unsigned workers);
+
+/**
+ * Number of workers (including the caller).
+ */
+unsigned thread_pool_size(const ThreadPool *pool);
+
+/**
+ * Run 'task' on every worker and wait until all of them have returned.
+ */
+void thread_pool_run(ThreadPool *pool, ThreadPoolTask task, void *arg);
+
+/**
+ * Stop and join all workers and release the pool.
+ */
+void thread_pool_destroy(ThreadPool *pool);
+
+#endif /* THREAD_POOL_H */
@@ -0,0 +1,133 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       throttle.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Pacing for shared storage: token-bucket limits on metadata operations
+    per second and on bytes copied per second, and lowering the process's
+    CPU and I/O priority.
+
+ Usage:
+    Throttle throttle;
+    throttle_init(&throttle, 500, 20u << 20);   // 500 ops/s, 20 MiB/s
+    throttle_ops(&throttle, 1);                 // before each rename()
+    throttle_bytes(&throttle, chunk_len);       // before each copied chunk
+    throttle_set(&throttle, 2000, 0);           // retune at any time; 0 = unlimited
+    throttle_destroy(&throttle);
+
+    throttle_lower_priority(THROTTLE_IO_IDLE, 0, true);  // before starting threads
+
+ Notes:
+    - Each limit is a generic cell rate algorithm: callers reserve their
+      slot under a lock and sleep outside it, so workers share one budget
+      without waking each other. Up to THROTTLE_BURST_NS worth of work may
+      go at once after an idle spell.
+    - throttle_set() takes effect immediately, also for callers already
+      asleep: they wake within THROTTLE_SLICE_NS and queue again at the new
+      rate.
+    - A NULL throttle or a zero rate costs one load and never sleeps.
+    - Limits file (throttle_load): "ops N" and "bandwidth N[K|M|G]" lines,
+      '#' comments; a missing line or 0 means unlimited.
+      throttle_request_reload() may be called from a signal handler; the
+      next caller to take from the throttle, or to throttle_poll() it,
+      re-reads the file and logs the outcome.
+    - Priorities are per thread on Linux and inherited by threads started
+      afterwards, so throttle_lower_priority() belongs before any thread
+      is created. I/O priority only affects local disks whose scheduler
+      honours it (BFQ); network file systems see the rate limits only.
+
+==========================================================================================================
+*/
+
+#ifndef THROTTLE_H
+#define THROTTLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "thread_pool.h"
+
+/** Work allowed at once after an idle spell, as time at the current rate. */
+#define THROTTLE_BURST_NS (UINT64_C(100) * 1000 * 1000)
+
+/** Longest single sleep; sleepers notice new rates this often. */
+#define THROTTLE_SLICE_NS (UINT64_C(100) * 1000 * 1000)
+
+typedef struct {
+    uint64_t rate;       /* units per second; 0 means unlimited */
+    uint64_t due_ns;     /* when the next unit conforms (theoretical arrival time) */
+    uint64_t generation; /* bumped when the rate changes */
+} ThrottleBucket;
+
+typedef struct {
+    ThrottleBucket ops;   /* metadata operations */
+    ThrottleBucket bytes; /* copied bytes */
+    char *limits_path;    /* file throttle_reload() reads, or NULL */
+    int reload_pending;   /* set by throttle_request_reload() */
+    PoolMutex lock;
+} Throttle;
+
+typedef enum {
+    THROTTLE_IO_DEFAULT = 0,  /* leave the I/O priority alone */
+    THROTTLE_IO_BEST_EFFORT,  /* best-effort class, level 0 (highest) to 7 (lowest) */
+    THROTTLE_IO_IDLE          /* only served when the disk is otherwise idle */
+} ThrottleIoClass;
+
+/** Start with the given limits (0 = unlimited). */
+void throttle_init(Throttle *throttle, uint64_t ops_per_sec, uint64_t bytes_per_sec);
+
+/** Change both limits; callers waiting under the old ones re-queue. */
+void throttle_set(Throttle *throttle, uint64_t ops_per_sec, uint64_t bytes_per_sec);
+
+/**
+ * Apply the limits in the file at 'path' and remember it for
+ * throttle_reload().
+ *
+ * @return  0 on success, -1 on failure (errno set; EINVAL for a malformed
+ *          file, whose limits are then not applied).
+ */
+int throttle_load(Throttle *throttle, const char *path);
+
+/**
+ * Read the file given to throttle_load() again.
+ *
+ * @return  0 on success, -1 on failure (errno set; ENOENT if no file was
+ *          given).
+ */
+int throttle_reload(Throttle *throttle);
+
+/** Ask for throttle_reload() at the next opportunity; async-signal-safe. */
+void throttle_request_reload(Throttle *throttle);
+
+/** Carry out a requested reload now, if one is pending. */
+void throttle_poll(Throttle *throttle);
+
+/** Wait until 'count' more metadata operations fit in the limit. */
+void throttle_ops(Throttle *throttle, uint64_t count);
+
+/** Wait until 'count' more copied bytes fit in the limit. */
+void throttle_bytes(Throttle *throttle, uint64_t count);
+
+/** True if copies are currently limited, so they should be cut into slices. */
+bool throttle_limits_bytes(Throttle *throttle);
+
+/** Release the throttle. */
+void throttle_destroy(Throttle *throttle);
+
+/**
+ * Lower the calling thread's (and its future threads') priority: the I/O
+ * class with 'level' (best effort only), and SCHED_IDLE CPU scheduling if
+ * 'sched_idle' is set.
+ *
+ * @return  0 on success, -1 on failure (errno set; ENOSYS where
+ *          unsupported).
+ */
+int throttle_lower_priority(ThrottleIoClass io_class, unsigned level, bool sched_idle);
+
+#endif /* THROTTLE_H */
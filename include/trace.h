@@ -0,0 +1,103 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       trace.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-15
+ Updated:    2026-10-15
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Static tracepoints (USDT / SystemTap SDT probes) on the hot path. Each
+    probe is a single nop in the code plus an ELF note (.note.stapsdt)
+    naming it and telling a tracer where its arguments live. Nothing runs
+    until a tracer such as bpftrace or perf attaches and patches the nop.
+
+ Usage:
+    TRACE3(entry_scanned, prefix, entry->name, entry->ino);
+
+    bpftrace -e 'usdt:./bin/file_organizer:file_organizer:move_completed
+                 { printf("%s -> %s: %d\n", str(arg1), str(arg2), arg3); }'
+
+ Notes:
+    - The provider is "file_organizer". Arguments are passed as signed
+      64-bit values; strings arrive as pointers (str(argN) in bpftrace).
+    - The notes are written inline, in the format of <sys/sdt.h>, so no
+      systemtap headers are needed to build. Probes are emitted with GCC
+      or Clang for ELF targets on x86-64 and AArch64; elsewhere, or when
+      built with -DORGANIZER_NO_TRACE (make TRACE=0), they compile to
+      nothing.
+    - Probes have no semaphore: argument values are ones the code has
+      computed anyway, so there is nothing to skip when no tracer listens.
+
+==========================================================================================================
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#if !defined(ORGANIZER_NO_TRACE) && defined(__GNUC__) && defined(__ELF__) && \
+    (defined(__x86_64__) || defined(__aarch64__))
+#define TRACE_ENABLED 1
+#else
+#define TRACE_ENABLED 0
+#endif
+
+#if TRACE_ENABLED
+
+/* Where a probe argument may live: an immediate, memory or a register. */
+#define TRACE_ARG_(x) "nor"((long long)(x))
+
+/*
+ * One probe site: the nop, its stapsdt note (address, base, no semaphore,
+ * provider, name, argument spec), and the .stapsdt.base anchor tracers use
+ * to adjust for prelinking, emitted once per object.
+ */
+#define TRACE_PROBE_(name, args, ...)                                              \
+    __asm__ __volatile__("990: nop\n"                                              \
+                         ".pushsection .note.stapsdt,\"\",\"note\"\n"              \
+                         ".balign 4\n"                                             \
+                         ".4byte 992f-991f, 994f-993f, 3\n"                        \
+                         "991: .asciz \"stapsdt\"\n"                               \
+                         "992: .balign 4\n"                                        \
+                         "993: .8byte 990b\n"                                      \
+                         ".8byte _.stapsdt.base\n"                                 \
+                         ".8byte 0\n"                                              \
+                         ".asciz \"file_organizer\"\n"                             \
+                         ".asciz \"" #name "\"\n"                                  \
+                         ".asciz \"" args "\"\n"                                   \
+                         "994: .balign 4\n"                                        \
+                         ".popsection\n"                                           \
+                         ".ifndef _.stapsdt.base\n"                                \
+                         ".pushsection .stapsdt.base,\"aG\",\"progbits\","         \
+                         ".stapsdt.base,comdat\n"                                  \
+                         ".weak _.stapsdt.base\n"                                  \
+                         ".hidden _.stapsdt.base\n"                                \
+                         "_.stapsdt.base: .space 1\n"                              \
+                         ".size _.stapsdt.base, 1\n"                               \
+                         ".popsection\n"                                           \
+                         ".endif\n"                                                \
+                         : : __VA_ARGS__)
+
+#define TRACE1(name, a)                                                            \
+    TRACE_PROBE_(name, "-8@%0", TRACE_ARG_(a))
+#define TRACE2(name, a, b)                                                         \
+    TRACE_PROBE_(name, "-8@%0 -8@%1", TRACE_ARG_(a), TRACE_ARG_(b))
+#define TRACE3(name, a, b, c)                                                      \
+    TRACE_PROBE_(name, "-8@%0 -8@%1 -8@%2",                                        \
+                 TRACE_ARG_(a), TRACE_ARG_(b), TRACE_ARG_(c))
+#define TRACE4(name, a, b, c, d)                                                   \
+    TRACE_PROBE_(name, "-8@%0 -8@%1 -8@%2 -8@%3",                                  \
+                 TRACE_ARG_(a), TRACE_ARG_(b), TRACE_ARG_(c), TRACE_ARG_(d))
+
+#else
+
+#define TRACE1(name, a) ((void)0)
+#define TRACE2(name, a, b) ((void)0)
+#define TRACE3(name, a, b, c) ((void)0)
+#define TRACE4(name, a, b, c, d) ((void)0)
+
+#endif
+
+#endif /* TRACE_H */
@@ -0,0 +1,154 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       uring.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Minimal io_uring wrapper for batching metadata system calls (renameat,
+    mkdirat, statx) and the small reads of content sniffing (openat, read,
+    close). Talks to the kernel directly; liburing is not required.
+
+ Usage:
+    Uring ring;
+    if (uring_open(&ring, 256) == 0) {
+        uring_prep_renameat(&ring, src_fd, "a.jpg", dst_fd, "a.jpg", 0, id);
+        uring_submit_and_wait(&ring, 1);
+        UringCompletion done[64];
+        unsigned n = uring_reap(&ring, done, 64);
+        uring_close(&ring);
+    }
+
+ Notes:
+    - uring_open() fails (returns -1) on non-Linux systems, kernels without
+      io_uring, or kernels lacking any of the opcodes above; callers are
+      expected to fall back to plain system calls.
+    - Path strings, statx and read buffers must stay valid until their
+      completion has been reaped.
+    - Build with -DORGANIZER_NO_IO_URING to compile the backend out.
+
+==========================================================================================================
+*/
+
+#ifndef URING_H
+#define URING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Default submission queue depth. */
+#define URING_DEFAULT_QUEUE_DEPTH 256u
+
+typedef struct {
+    int fd;
+    unsigned entries;
+    unsigned inflight;  /* submitted or queued, not yet reaped */
+
+    /* Submission ring */
+    void *sq_ring;
+    size_t sq_ring_size;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    void *sqes;
+    size_t sqes_size;
+    unsigned sq_local_tail; /* entries prepared but not yet published */
+
+    /* Completion ring */
+    void *cq_ring;
+    size_t cq_ring_size;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    void *cqes;
+} Uring;
+
+typedef struct {
+    uint64_t user_data;
+    int res; /* result of the operation, or -errno */
+} UringCompletion;
+
+/**
+ * Set up a ring and verify the kernel supports RENAMEAT, MKDIRAT and STATX.
+ *
+ * @param ring         Ring to initialize.
+ * @param queue_depth  Requested number of submission entries (0 = default).
+ * @return             0 on success, -1 if io_uring cannot be used (errno set).
+ */
+int uring_open(Uring *ring, unsigned queue_depth);
+
+/**
+ * Tear down a ring opened with uring_open().
+ */
+void uring_close(Uring *ring);
+
+/**
+ * Number of operations that can still be prepared before a reap is needed.
+ */
+unsigned uring_space(const Uring *ring);
+
+/**
+ * Queue a renameat2(old_dfd, old_path, new_dfd, new_path, flags).
+ * @return 0 on success, -1 if the ring is full.
+ */
+int uring_prep_renameat(Uring *ring, int old_dfd, const char *old_path,
+                        int new_dfd, const char *new_path,
+                        unsigned flags, uint64_t user_data);
+
+/**
+ * Queue a mkdirat(dfd, path, mode).
+ * @return 0 on success, -1 if the ring is full.
+ */
+int uring_prep_mkdirat(Uring *ring, int dfd, const char *path,
+                       unsigned mode, uint64_t user_data);
+
+/**
+ * Queue a statx(dfd, path, flags, mask, statx_buf); 'statx_buf' points to a
+ * struct statx.
+ * @return 0 on success, -1 if the ring is full.
+ */
+int uring_prep_statx(Uring *ring, int dfd, const char *path, int flags,
+                     unsigned mask, void *statx_buf, uint64_t user_data);
+
+/**
+ * Queue an openat(dfd, path, flags, mode); the completion's 'res' is the
+ * new descriptor.
+ * @return 0 on success, -1 if the ring is full.
+ */
+int uring_prep_openat(Uring *ring, int dfd, const char *path, int flags,
+                      unsigned mode, uint64_t user_data);
+
+/**
+ * Queue a pread(fd, buf, len, offset).
+ * @return 0 on success, -1 if the ring is full.
+ */
+int uring_prep_read(Uring *ring, int fd, void *buf, unsigned len,
+                    uint64_t offset, uint64_t user_data);
+
+/**
+ * Queue a close(fd).
+ * @return 0 on success, -1 if the ring is full.
+ */
+int uring_prep_close(Uring *ring, int fd, uint64_t user_data);
+
+/**
+ * Submit all queued operations and wait until at least 'wait_nr'
+ * completions are available.
+ *
+ * @return 0 on success, -1 on failure (errno set).
+ */
+int uring_submit_and_wait(Uring *ring, unsigned wait_nr);
+
+/**
+ * Collect up to 'max' available completions without blocking.
+ *
+ * @return Number of completions stored in 'out'.
+ */
+unsigned uring_reap(Uring *ring, UringCompletion *out, unsigned max);
+
+#endif /* URING_H */
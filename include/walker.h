@@ -0,0 +1,104 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       walker.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Parallel directory tree walker. Directories are distributed over the
+    workers of a ThreadPool through per-worker work-stealing queues, and the
+    entries of each directory are streamed to a callback batch by batch.
+
+ Usage:
+    WalkOptions options = { .root_fd = fd, .root_path = path,
+                            .on_batch = visit, .descend = filter, .ctx = state };
+    int rc = walker_run(&options, pool);   // pool may be NULL (one worker)
+
+ Notes:
+    - Only pending directory paths are queued; entries are never collected,
+      so memory is bounded by the width of the tree, not its size.
+    - Symlinks to directories are never followed, and every directory is
+      identified by (st_dev, st_ino) so a directory reached twice (bind
+      mounts, cycles) is visited only once.
+    - Not available on Windows builds (walker_run() fails with ENOSYS).
+
+==========================================================================================================
+*/
+
+#ifndef WALKER_H
+#define WALKER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "scanner.h"
+#include "thread_pool.h"
+
+/**
+ * A directory being visited.
+ */
+typedef struct {
+    /** Open descriptor of the directory. */
+    int dir_fd;
+
+    /** Path relative to the walk root; "" for the root itself. */
+    const char *rel_path;
+
+    /** 0 for the root, 1 for its subdirectories, ... */
+    unsigned depth;
+} WalkDir;
+
+/**
+ * Called with each batch of entries of a directory, from the worker that
+ * visits it. Returns non-zero to record a failure (the walk continues).
+ */
+typedef int (*WalkBatchFn)(void *ctx, unsigned worker, const WalkDir *dir,
+                           const ScanEntry *entries, long count);
+
+/**
+ * Decides whether a subdirectory 'name' of 'parent' should be walked.
+ */
+typedef bool (*WalkFilterFn)(void *ctx, const WalkDir *parent, const char *name);
+
+typedef struct {
+    /** Open descriptor of the walk root (not consumed). */
+    int root_fd;
+
+    /** Root path, used in log messages. */
+    const char *root_path;
+
+    /** Directory read buffer size; 0 selects the scanner default. */
+    size_t scan_buffer_size;
+
+    WalkBatchFn on_batch;
+
+    /** Optional; NULL walks every subdirectory. */
+    WalkFilterFn descend;
+
+    void *ctx;
+
+    /**
+     * Optional; if set, directory opens and reads are counted in '*reads'
+     * and their nanoseconds added to '*read_ns' (atomically, from every
+     * worker). Both must be set, or neither.
+     */
+    uint64_t *reads;
+    uint64_t *read_ns;
+} WalkOptions;
+
+/**
+ * Walk the tree below options->root_fd.
+ *
+ * @param options  Walk options.
+ * @param pool     Worker pool, or NULL to walk on the calling thread.
+ * @return         0 on success, non-zero if any directory could not be read
+ *                 or any callback reported a failure.
+ */
+int walker_run(const WalkOptions *options, ThreadPool *pool);
+
+#endif /* WALKER_H */
@@ -0,0 +1,99 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       watch.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Thin wrapper around inotify for watch mode: reports names that land in
+    a watched directory, one event at a time, with a poll() timeout so the
+    caller can debounce and batch them.
+
+ Usage:
+    DirWatch watch;
+    dir_watch_open(&watch);
+    int wd = dir_watch_add(&watch, "/srv/drop", WATCH_FILES_LANDED);
+    WatchEvent event;
+    while (dir_watch_next(&watch, 50, &event) > 0) { ... }
+    dir_watch_close(&watch);
+
+ Notes:
+    - Linux only; elsewhere dir_watch_open() fails with ENOSYS.
+    - Event names point into the watch's buffer and are valid until the
+      next dir_watch_next() call.
+    - A directory held open elsewhere reports no WATCH_EVENT_GONE when it
+      is deleted (the inode lives on); watch its parent in
+      WATCH_FILES_LANDED mode and use WATCH_EVENT_REMOVED instead.
+
+==========================================================================================================
+*/
+
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <stddef.h>
+
+/** What to report for a watched directory. */
+typedef enum {
+    /**
+     * Files closed after writing, or renamed into the directory; also
+     * subdirectories deleted or renamed away.
+     */
+    WATCH_FILES_LANDED,
+
+    /** Any name created in, or renamed into, the directory. */
+    WATCH_NAMES_CREATED
+} WatchMode;
+
+typedef enum {
+    WATCH_EVENT_NAME,     /* 'name' appeared in the directory 'wd' */
+    WATCH_EVENT_REMOVED,  /* subdirectory 'name' of 'wd' went away */
+    WATCH_EVENT_GONE,     /* directory 'wd' was deleted or moved away */
+    WATCH_EVENT_OVERFLOW  /* the kernel dropped events; rescan everything */
+} WatchEventKind;
+
+typedef struct {
+    WatchEventKind kind;
+    int wd;
+    const char *name;  /* WATCH_EVENT_NAME and WATCH_EVENT_REMOVED only */
+} WatchEvent;
+
+typedef struct {
+    int fd;
+    char *buffer;
+    size_t pos;   /* next unread event in 'buffer' */
+    size_t len;   /* bytes of events in 'buffer' */
+} DirWatch;
+
+/**
+ * Create an inotify instance.
+ *
+ * @return  0 on success, -1 on failure (errno set).
+ */
+int dir_watch_open(DirWatch *watch);
+
+/**
+ * Start watching a directory (watching it again just returns its id).
+ *
+ * @return  Watch descriptor (>= 0), or -1 on failure (errno set).
+ */
+int dir_watch_add(DirWatch *watch, const char *path, WatchMode mode);
+
+/**
+ * Wait up to 'timeout_ms' (-1: forever) for the next event.
+ *
+ * @return  1 if 'event' was filled, 0 on timeout, -1 on failure (errno set,
+ *          EINTR if a signal arrived).
+ */
+int dir_watch_next(DirWatch *watch, int timeout_ms, WatchEvent *event);
+
+/**
+ * Release the inotify instance.
+ */
+void dir_watch_close(DirWatch *watch);
+
+#endif /* WATCH_H */
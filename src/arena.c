@@ -0,0 +1,143 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       arena.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Implementation of the bump allocator: a singly linked list of blocks,
+    carved front to back.
+
+ Usage:
+    See arena.h.
+
+ Notes:
+    - Blocks are ARENA_BLOCK_SIZE bytes; larger requests get a block of
+      their own, so they waste nothing in the current one.
+
+==========================================================================================================
+*/
+
+#include "arena.h"
+
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_BLOCK_SIZE ((size_t)64 * 1024)
+
+struct ArenaBlock {
+    ArenaBlock *next;
+    alignas(max_align_t) char data[];
+};
+
+void arena_init(Arena *arena)
+{
+    arena->blocks = NULL;
+    arena->cursor = NULL;
+    arena->remaining = 0;
+}
+
+static void *alloc_bytes(Arena *arena, size_t size, size_t align)
+{
+    size_t pad = arena->cursor ? (size_t)(-(uintptr_t)arena->cursor & (align - 1)) : 0;
+
+    if (arena->blocks && pad + size <= arena->remaining) {
+        char *p = arena->cursor + pad;
+        arena->cursor = p + size;
+        arena->remaining -= pad + size;
+        return p;
+    }
+
+    if (size > ARENA_BLOCK_SIZE / 4) {
+        /* Oversized: own block, linked behind the current one. */
+        ArenaBlock *big = malloc(sizeof(*big) + size);
+        if (!big) {
+            return NULL;
+        }
+        if (arena->blocks) {
+            big->next = arena->blocks->next;
+            arena->blocks->next = big;
+        } else {
+            big->next = NULL;
+            arena->blocks = big;
+            arena->cursor = big->data + size;
+            arena->remaining = 0;
+        }
+        return big->data;
+    }
+
+    ArenaBlock *block = malloc(sizeof(*block) + ARENA_BLOCK_SIZE);
+    if (!block) {
+        return NULL;
+    }
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->cursor = block->data + size;
+    arena->remaining = ARENA_BLOCK_SIZE - size;
+    return block->data;
+}
+
+void *arena_alloc(Arena *arena, size_t size)
+{
+    return alloc_bytes(arena, size, alignof(max_align_t));
+}
+
+char *arena_strndup(Arena *arena, const char *s, size_t len)
+{
+    char *copy = alloc_bytes(arena, len + 1, 1);
+    if (copy) {
+        memcpy(copy, s, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+char *arena_concat(Arena *arena, const char *a, const char *b)
+{
+    size_t a_len = strlen(a);
+    size_t b_len = strlen(b);
+    char *joined = alloc_bytes(arena, a_len + b_len + 1, 1);
+    if (joined) {
+        memcpy(joined, a, a_len);
+        memcpy(joined + a_len, b, b_len + 1);
+    }
+    return joined;
+}
+
+void arena_adopt(Arena *dst, Arena *src)
+{
+    if (!src->blocks) {
+        return;
+    }
+    if (!dst->blocks) {
+        *dst = *src;
+        arena_init(src);
+        return;
+    }
+
+    /* Keep dst's current block in front so its free space stays usable. */
+    ArenaBlock *last = src->blocks;
+    while (last->next) {
+        last = last->next;
+    }
+    last->next = dst->blocks->next;
+    dst->blocks->next = src->blocks;
+    arena_init(src);
+}
+
+void arena_free(Arena *arena)
+{
+    ArenaBlock *block = arena->blocks;
+    while (block) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena_init(arena);
+}
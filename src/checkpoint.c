@@ -0,0 +1,220 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       checkpoint.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Memory-mapped progress checkpoints.
+
+ Usage:
+    See checkpoint.h.
+
+ Notes:
+    - Fields are stored one by one; 'sequence' is bumped last, and the
+      counters are only ever read back as hints (the journal is the record
+      of what was done), so a store cut short by a crash is harmless.
+
+==========================================================================================================
+*/
+
+#define _POSIX_C_SOURCE 200809L /* ftruncate, msync */
+
+#include "checkpoint.h"
+
+#include <errno.h>
+#include <string.h>
+
+#define CHECKPOINT_MAGIC "FOCKPT1\n"
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+int checkpoint_open(Checkpoint *checkpoint, const char *path)
+{
+    memset(checkpoint, 0, sizeof(*checkpoint));
+    checkpoint->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    struct stat st;
+    if (checkpoint->fd < 0 || fstat(checkpoint->fd, &st) != 0) {
+        goto fail;
+    }
+
+    /* An empty file is ours to claim; anything else must already be a checkpoint. */
+    if (st.st_size != 0 && st.st_size != (off_t)sizeof(CheckpointRecord)) {
+        errno = EINVAL;
+        goto fail;
+    }
+    if (st.st_size == 0 && ftruncate(checkpoint->fd, (off_t)sizeof(CheckpointRecord)) != 0) {
+        goto fail;
+    }
+
+    void *map = mmap(NULL, sizeof(CheckpointRecord), PROT_READ | PROT_WRITE, MAP_SHARED,
+                     checkpoint->fd, 0);
+    if (map == MAP_FAILED) {
+        goto fail;
+    }
+    checkpoint->record = map;
+
+    if (st.st_size == 0) {
+        memcpy(checkpoint->record->magic, CHECKPOINT_MAGIC, sizeof(checkpoint->record->magic));
+    } else if (memcmp(checkpoint->record->magic, CHECKPOINT_MAGIC,
+                      sizeof(checkpoint->record->magic)) != 0) {
+        errno = EINVAL;
+        goto fail;
+    }
+    checkpoint->previous = *checkpoint->record;
+
+    pool_mutex_init(&checkpoint->lock);
+    return 0;
+
+fail:;
+    int saved = errno;
+    if (checkpoint->record) {
+        munmap(checkpoint->record, sizeof(CheckpointRecord));
+        checkpoint->record = NULL;
+    }
+    if (checkpoint->fd >= 0) {
+        close(checkpoint->fd);
+    }
+    checkpoint->fd = -1;
+    errno = saved;
+    return -1;
+}
+
+bool checkpoint_resumable(const Checkpoint *checkpoint, const struct stat *target,
+                          const struct stat *journal)
+{
+    const CheckpointRecord *previous = &checkpoint->previous;
+    return previous->status == CHECKPOINT_RUNNING &&
+           previous->target_dev == (uint64_t)target->st_dev &&
+           previous->target_ino == (uint64_t)target->st_ino &&
+           previous->journal_dev == (uint64_t)journal->st_dev &&
+           previous->journal_ino == (uint64_t)journal->st_ino &&
+           (uint64_t)journal->st_size >= previous->journal_offset;
+}
+
+int checkpoint_begin(Checkpoint *checkpoint, const struct stat *target,
+                     const struct stat *journal, uint64_t run_offset, uint64_t moves)
+{
+    CheckpointRecord *record = checkpoint->record;
+    checkpoint->base_moves = moves;
+    checkpoint->moves = 0;
+
+    record->status = CHECKPOINT_RUNNING;
+    record->target_dev = (uint64_t)target->st_dev;
+    record->target_ino = (uint64_t)target->st_ino;
+    record->journal_dev = (uint64_t)journal->st_dev;
+    record->journal_ino = (uint64_t)journal->st_ino;
+    record->run_offset = run_offset;
+    record->journal_offset = run_offset;
+    record->moves = moves;
+    record->sequence = 0;
+    return msync(record, sizeof(*record), MS_SYNC);
+}
+
+bool checkpoint_tick(Checkpoint *checkpoint)
+{
+    uint64_t moves = __atomic_add_fetch(&checkpoint->moves, 1, __ATOMIC_RELAXED);
+    return moves % CHECKPOINT_INTERVAL == 0;
+}
+
+void checkpoint_save(Checkpoint *checkpoint, uint64_t journal_offset)
+{
+    CheckpointRecord *record = checkpoint->record;
+
+    pool_mutex_lock(&checkpoint->lock);
+    /* Savers may finish out of order; never move the record backwards. */
+    if (journal_offset > record->journal_offset) {
+        record->journal_offset = journal_offset;
+    }
+    record->moves = checkpoint->base_moves +
+                    __atomic_load_n(&checkpoint->moves, __ATOMIC_RELAXED);
+    record->sequence++;
+    msync(record, sizeof(*record), MS_ASYNC);
+    pool_mutex_unlock(&checkpoint->lock);
+}
+
+int checkpoint_finish(Checkpoint *checkpoint, uint64_t journal_offset)
+{
+    checkpoint_save(checkpoint, journal_offset);
+    checkpoint->record->status = CHECKPOINT_DONE;
+    return msync(checkpoint->record, sizeof(CheckpointRecord), MS_SYNC);
+}
+
+void checkpoint_close(Checkpoint *checkpoint)
+{
+    if (checkpoint->record) {
+        munmap(checkpoint->record, sizeof(CheckpointRecord));
+        pool_mutex_destroy(&checkpoint->lock);
+    }
+    if (checkpoint->fd >= 0) {
+        close(checkpoint->fd);
+    }
+    checkpoint->record = NULL;
+    checkpoint->fd = -1;
+}
+
+#else /* _WIN32 */
+
+int checkpoint_open(Checkpoint *checkpoint, const char *path)
+{
+    (void)path;
+    memset(checkpoint, 0, sizeof(*checkpoint));
+    checkpoint->fd = -1;
+    errno = ENOSYS;
+    return -1;
+}
+
+bool checkpoint_resumable(const Checkpoint *checkpoint, const struct stat *target,
+                          const struct stat *journal)
+{
+    (void)checkpoint;
+    (void)target;
+    (void)journal;
+    return false;
+}
+
+int checkpoint_begin(Checkpoint *checkpoint, const struct stat *target,
+                     const struct stat *journal, uint64_t run_offset, uint64_t moves)
+{
+    (void)checkpoint;
+    (void)target;
+    (void)journal;
+    (void)run_offset;
+    (void)moves;
+    errno = ENOSYS;
+    return -1;
+}
+
+bool checkpoint_tick(Checkpoint *checkpoint)
+{
+    (void)checkpoint;
+    return false;
+}
+
+void checkpoint_save(Checkpoint *checkpoint, uint64_t journal_offset)
+{
+    (void)checkpoint;
+    (void)journal_offset;
+}
+
+int checkpoint_finish(Checkpoint *checkpoint, uint64_t journal_offset)
+{
+    (void)checkpoint;
+    (void)journal_offset;
+    return 0;
+}
+
+void checkpoint_close(Checkpoint *checkpoint)
+{
+    (void)checkpoint;
+}
+
+#endif
@@ -0,0 +1,333 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       classifier.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Built-in extension classifier. Extensions of up to 8 bytes are packed into
+    a 64-bit key while being lowercased, then looked up in a perfect hash table
+    whose slot indices are computed by the compiler. Files the extension
+    table does not know can be classified by their leading magic bytes.
+
+ Usage:
+    const char *category = classifier_category_for_extension(ext);
+    category = classifier_category_for_header(header, len);
+
+ Notes:
+    - The table is built with designated initializers indexed by EXT_SLOT(),
+      so two extensions hashing to the same slot trigger -Woverride-init
+      (enabled by -Wextra). Pick a new EXT_HASH_MULTIPLIER if that happens.
+    - Only [a-z0-9] appear in keys; folding touches only 'A'..'Z', so control
+      characters can never alias a digit.
+    - classifier_category_for_name() never looks further back than the
+      longest key: with the name's length known, the last dot, the key and
+      the case fold come from one unaligned 8-byte load of the name's tail
+      (SWAR; scalar on big-endian or non-GCC builds), whatever the length.
+    - The signature table is small enough that a linear scan with a
+      first-byte reject is cheaper than the read that produced the header.
+
+==========================================================================================================
+*/
+
+#include "classifier.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define EXT_MAX_LEN 8
+#define EXT_HASH_BITS 7
+#define EXT_HASH_SIZE (1u << EXT_HASH_BITS)
+#define EXT_HASH_MULTIPLIER UINT64_C(0x9314bb58058e4bbb)
+
+/* Little-endian packing of up to four characters (shorter keys pad with 0). */
+#define EXT_KEY(a, b, c, d)                         \
+    ((uint64_t)(unsigned char)(a)                   \
+     | ((uint64_t)(unsigned char)(b) << 8)          \
+     | ((uint64_t)(unsigned char)(c) << 16)         \
+     | ((uint64_t)(unsigned char)(d) << 24))
+
+#define EXT_SLOT(key) ((size_t)(((uint64_t)(key) * EXT_HASH_MULTIPLIER) >> (64 - EXT_HASH_BITS)))
+
+#define EXT(a, b, c, d, category) \
+    [EXT_SLOT(EXT_KEY(a, b, c, d))] = { EXT_KEY(a, b, c, d), category }
+
+/* Map packed lowercase extensions to category directory names. */
+typedef struct {
+    uint64_t key;         /* packed lowercase extension, 0 for an empty slot */
+    const char *category; /* directory name */
+} ExtensionSlot;
+
+/*
+ * One object per category so every lookup returns the same pointer for the
+ * same directory; callers may compare categories by address.
+ */
+static const char CATEGORY_IMAGES[] = "Images";
+static const char CATEGORY_DOCUMENTS[] = "Documents";
+static const char CATEGORY_SPREADSHEETS[] = "Spreadsheets";
+static const char CATEGORY_PRESENTATIONS[] = "Presentations";
+static const char CATEGORY_AUDIO[] = "Audio";
+static const char CATEGORY_VIDEO[] = "Video";
+static const char CATEGORY_ARCHIVES[] = "Archives";
+static const char CATEGORY_SOURCE[] = "Source";
+static const char CATEGORY_OTHER[] = "Other";
+
+static const ExtensionSlot EXTENSION_TABLE[EXT_HASH_SIZE] = {
+    EXT('j', 'p', 'g', 0,   CATEGORY_IMAGES),
+    EXT('j', 'p', 'e', 'g', CATEGORY_IMAGES),
+    EXT('p', 'n', 'g', 0,   CATEGORY_IMAGES),
+    EXT('g', 'i', 'f', 0,   CATEGORY_IMAGES),
+    EXT('b', 'm', 'p', 0,   CATEGORY_IMAGES),
+    EXT('t', 'i', 'f', 0,   CATEGORY_IMAGES),
+    EXT('t', 'i', 'f', 'f', CATEGORY_IMAGES),
+    EXT('s', 'v', 'g', 0,   CATEGORY_IMAGES),
+
+    EXT('t', 'x', 't', 0,   CATEGORY_DOCUMENTS),
+    EXT('m', 'd', 0,   0,   CATEGORY_DOCUMENTS),
+    EXT('p', 'd', 'f', 0,   CATEGORY_DOCUMENTS),
+    EXT('d', 'o', 'c', 0,   CATEGORY_DOCUMENTS),
+    EXT('d', 'o', 'c', 'x', CATEGORY_DOCUMENTS),
+    EXT('r', 't', 'f', 0,   CATEGORY_DOCUMENTS),
+
+    EXT('x', 'l', 's', 0,   CATEGORY_SPREADSHEETS),
+    EXT('x', 'l', 's', 'x', CATEGORY_SPREADSHEETS),
+    EXT('c', 's', 'v', 0,   CATEGORY_SPREADSHEETS),
+
+    EXT('p', 'p', 't', 0,   CATEGORY_PRESENTATIONS),
+    EXT('p', 'p', 't', 'x', CATEGORY_PRESENTATIONS),
+
+    EXT('m', 'p', '3', 0,   CATEGORY_AUDIO),
+    EXT('w', 'a', 'v', 0,   CATEGORY_AUDIO),
+    EXT('f', 'l', 'a', 'c', CATEGORY_AUDIO),
+    EXT('a', 'a', 'c', 0,   CATEGORY_AUDIO),
+    EXT('o', 'g', 'g', 0,   CATEGORY_AUDIO),
+
+    EXT('m', 'p', '4', 0,   CATEGORY_VIDEO),
+    EXT('m', 'k', 'v', 0,   CATEGORY_VIDEO),
+    EXT('a', 'v', 'i', 0,   CATEGORY_VIDEO),
+    EXT('m', 'o', 'v', 0,   CATEGORY_VIDEO),
+    EXT('w', 'm', 'v', 0,   CATEGORY_VIDEO),
+
+    EXT('z', 'i', 'p', 0,   CATEGORY_ARCHIVES),
+    EXT('r', 'a', 'r', 0,   CATEGORY_ARCHIVES),
+    EXT('7', 'z', 0,   0,   CATEGORY_ARCHIVES),
+    EXT('t', 'a', 'r', 0,   CATEGORY_ARCHIVES),
+    EXT('g', 'z', 0,   0,   CATEGORY_ARCHIVES),
+
+    EXT('c', 0,   0,   0,   CATEGORY_SOURCE),
+    EXT('h', 0,   0,   0,   CATEGORY_SOURCE),
+    EXT('c', 'p', 'p', 0,   CATEGORY_SOURCE),
+    EXT('h', 'p', 'p', 0,   CATEGORY_SOURCE),
+    EXT('p', 'y', 0,   0,   CATEGORY_SOURCE),
+    EXT('j', 'a', 'v', 'a', CATEGORY_SOURCE),
+    EXT('j', 's', 0,   0,   CATEGORY_SOURCE),
+    EXT('t', 's', 0,   0,   CATEGORY_SOURCE),
+    EXT('c', 's', 0,   0,   CATEGORY_SOURCE),
+    EXT('g', 'o', 0,   0,   CATEGORY_SOURCE),
+    EXT('r', 'b', 0,   0,   CATEGORY_SOURCE),
+    EXT('p', 'h', 'p', 0,   CATEGORY_SOURCE),
+};
+
+/* Every category, in a fixed order; the default category is last. */
+static const char *const CATEGORIES[] = {
+    CATEGORY_IMAGES, CATEGORY_DOCUMENTS, CATEGORY_SPREADSHEETS,
+    CATEGORY_PRESENTATIONS, CATEGORY_AUDIO, CATEGORY_VIDEO,
+    CATEGORY_ARCHIVES, CATEGORY_SOURCE, CATEGORY_OTHER
+};
+
+size_t classifier_category_count(void)
+{
+    return sizeof(CATEGORIES) / sizeof(CATEGORIES[0]);
+}
+
+const char *classifier_category_at(size_t index)
+{
+    return index < classifier_category_count() ? CATEGORIES[index] : NULL;
+}
+
+const char *classifier_default_category(void)
+{
+    return CATEGORY_OTHER;
+}
+
+/*
+ * Content signature: 'magic' at byte 'offset' and, if 'magic2' is set,
+ * 'magic2' at byte 8 (RIFF and ISO media containers name their format
+ * there). More specific signatures come first.
+ */
+typedef struct {
+    unsigned char offset;
+    unsigned char len;
+    unsigned char len2;
+    const char *magic;
+    const char *magic2;
+    const char *category;
+} MagicSignature;
+
+#define MAGIC(offset, magic, category) { offset, sizeof(magic) - 1, 0, magic, NULL, category }
+#define MAGIC2(offset, magic, magic2, category) \
+    { offset, sizeof(magic) - 1, sizeof(magic2) - 1, magic, magic2, category }
+
+static const MagicSignature MAGIC_TABLE[] = {
+    MAGIC(0, "\xFF\xD8\xFF",             CATEGORY_IMAGES),      /* JPEG */
+    MAGIC(0, "\x89PNG\r\n\x1A\n",         CATEGORY_IMAGES),
+    MAGIC(0, "GIF87a",                   CATEGORY_IMAGES),
+    MAGIC(0, "GIF89a",                   CATEGORY_IMAGES),
+    MAGIC(0, "II*\0",                    CATEGORY_IMAGES),      /* TIFF */
+    MAGIC(0, "MM\0*",                    CATEGORY_IMAGES),
+    MAGIC2(0, "RIFF", "WEBP",            CATEGORY_IMAGES),
+
+    MAGIC(0, "%PDF-",                    CATEGORY_DOCUMENTS),
+    MAGIC(0, "{\\rtf",                   CATEGORY_DOCUMENTS),
+    MAGIC(0, "\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1", CATEGORY_DOCUMENTS), /* legacy Office */
+
+    MAGIC2(0, "RIFF", "WAVE",            CATEGORY_AUDIO),
+    MAGIC2(4, "ftyp", "M4A ",            CATEGORY_AUDIO),
+    MAGIC(0, "ID3",                      CATEGORY_AUDIO),       /* MP3 */
+    MAGIC(0, "fLaC",                     CATEGORY_AUDIO),
+    MAGIC(0, "OggS",                     CATEGORY_AUDIO),
+
+    MAGIC2(0, "RIFF", "AVI ",            CATEGORY_VIDEO),
+    MAGIC(4, "ftyp",                     CATEGORY_VIDEO),       /* MP4, MOV */
+    MAGIC(0, "\x1A\x45\xDF\xA3",         CATEGORY_VIDEO),       /* Matroska, WebM */
+
+    MAGIC(0, "PK\x03\x04",               CATEGORY_ARCHIVES),
+    MAGIC(0, "PK\x05\x06",               CATEGORY_ARCHIVES),    /* empty zip */
+    MAGIC(0, "Rar!\x1A\x07",             CATEGORY_ARCHIVES),
+    MAGIC(0, "7z\xBC\xAF\x27\x1C",       CATEGORY_ARCHIVES),
+    MAGIC(0, "\x1F\x8B\x08",             CATEGORY_ARCHIVES),    /* gzip */
+    MAGIC(0, "BZh",                      CATEGORY_ARCHIVES),
+    MAGIC(0, "\xFD" "7zXZ\0",             CATEGORY_ARCHIVES),
+    MAGIC(0, "\x28\xB5\x2F\xFD",         CATEGORY_ARCHIVES),    /* zstd */
+
+    MAGIC(0, "#!",                       CATEGORY_SOURCE),      /* scripts */
+};
+
+#define MAGIC_COUNT (sizeof(MAGIC_TABLE) / sizeof(MAGIC_TABLE[0]))
+
+const char *classifier_category_for_header(const unsigned char *header, size_t len)
+{
+    if (!header) {
+        return CATEGORY_OTHER;
+    }
+
+    for (size_t i = 0; i < MAGIC_COUNT; ++i) {
+        const MagicSignature *sig = &MAGIC_TABLE[i];
+
+        /* The first byte rejects nearly every signature before any memcmp(). */
+        if ((size_t)sig->offset + sig->len > len ||
+            header[sig->offset] != (unsigned char)sig->magic[0] ||
+            memcmp(header + sig->offset, sig->magic, sig->len) != 0) {
+            continue;
+        }
+        if (sig->magic2 && (8 + (size_t)sig->len2 > len ||
+                            memcmp(header + 8, sig->magic2, sig->len2) != 0)) {
+            continue;
+        }
+        return sig->category;
+    }
+    return CATEGORY_OTHER;
+}
+
+static const char *category_for_key(uint64_t key)
+{
+    const ExtensionSlot *slot = &EXTENSION_TABLE[EXT_SLOT(key)];
+    return slot->key == key ? slot->category : CATEGORY_OTHER;
+}
+
+/* Pack and lowercase 'len' (<= EXT_MAX_LEN) bytes; 'A'..'Z' gain 0x20, everything else is kept. */
+static uint64_t pack_extension(const char *ext, size_t len)
+{
+    uint64_t key = 0;
+    for (size_t i = 0; i < len; ++i) {
+        unsigned c = (unsigned char)ext[i];
+        c |= (unsigned)((c - 'A') < 26u) << 5;
+        key |= (uint64_t)c << (8 * i);
+    }
+    return key;
+}
+
+const char *classifier_category_for_extension(const char *ext)
+{
+    if (!ext) {
+        return CATEGORY_OTHER;
+    }
+
+    size_t len = 0;
+    while (len < EXT_MAX_LEN && ext[len] != '\0') {
+        ++len;
+    }
+    if (len == 0 || ext[len] != '\0') {
+        return CATEGORY_OTHER; /* empty, or longer than any packed key */
+    }
+    return category_for_key(pack_extension(ext, len));
+}
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define CLASSIFIER_SWAR 1
+
+#define BYTES_01 UINT64_C(0x0101010101010101)
+#define BYTES_7F UINT64_C(0x7f7f7f7f7f7f7f7f)
+#define BYTES_80 UINT64_C(0x8080808080808080)
+
+/* High bit of every byte of 'word' that equals 'c'; no false positives. */
+static uint64_t bytes_equal(uint64_t word, unsigned char c)
+{
+    uint64_t x = word ^ (BYTES_01 * c);
+    return ~(((x & BYTES_7F) + BYTES_7F) | x | BYTES_7F);
+}
+
+/* 'A'..'Z' in each byte gain 0x20; the same fold as pack_extension(). */
+static uint64_t fold_upper(uint64_t word)
+{
+    uint64_t low = word & BYTES_7F;
+    uint64_t at_least_a = low + BYTES_01 * (0x80 - 'A');
+    uint64_t past_z = low + BYTES_01 * (0x7f - 'Z');
+    uint64_t upper = at_least_a & ~past_z & ~word & BYTES_80;
+    return word | (upper >> 2);
+}
+#endif
+
+const char *classifier_category_for_name(const char *name, size_t len)
+{
+    if (!name || len < 3) {
+        return CATEGORY_OTHER; /* nothing fits before a dot and a one-byte extension */
+    }
+
+#ifdef CLASSIFIER_SWAR
+    if (len > EXT_MAX_LEN) {
+        uint64_t word;
+        memcpy(&word, name + len - 8, sizeof(word));
+
+        uint64_t dots = bytes_equal(word, '.');
+        unsigned shift;
+        if (dots) {
+            shift = (unsigned)(64 - __builtin_clzll(dots)); /* bits up to the last dot */
+            if (shift == 64) {
+                return CATEGORY_OTHER; /* trailing dot */
+            }
+        } else if (name[len - 9] == '.' && len > 9) {
+            shift = 0; /* an 8-byte extension fills the word */
+        } else {
+            return CATEGORY_OTHER; /* no dot, or an extension longer than any key */
+        }
+        return category_for_key(fold_upper(word) >> shift);
+    }
+#endif
+
+    /* The last dot within EXT_MAX_LEN + 1 bytes of the end, but not at index 0. */
+    size_t stop = len > EXT_MAX_LEN + 1 ? len - EXT_MAX_LEN - 1 : 1;
+    size_t i = len;
+    while (i > stop && name[i - 1] != '.') {
+        --i;
+    }
+    if (i == stop || i == len) {
+        return CATEGORY_OTHER;
+    }
+    return category_for_key(pack_extension(name + i, len - i));
+}
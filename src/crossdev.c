@@ -0,0 +1,636 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       crossdev.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Copy-then-unlink moves for destinations on another file system. A batch
+    is processed in windows of files: every worker opens, creates and copies
+    whole files; large files are left open and their chunks are then copied
+    by all workers; finally the destination directories are flushed and the
+    sources unlinked.
+
+ Usage:
+    See crossdev.h.
+
+ Notes:
+    - Only the files of one window (CROSSDEV_WINDOW) hold descriptors at
+      once, so a large batch cannot run out of them.
+    - copy_file_range and pread/pwrite use explicit offsets and can copy
+      chunks of one file concurrently; sendfile writes at the destination's
+      file offset, so it is only used for whole files.
+    - Under a bandwidth limit, data is copied in CROSSDEV_PACE_SLICE pieces,
+      each waiting for its share of the limit first. Reflinks copy no data
+      and are not paced.
+
+==========================================================================================================
+*/
+
+#define _GNU_SOURCE /* copy_file_range */
+
+#include "crossdev.h"
+#include "thread_pool.h"
+#include "throttle.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/fs.h> /* FICLONE */
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#endif
+
+/* Files per window, and the buffer of the pread/pwrite fallback. */
+#define CROSSDEV_WINDOW      64u
+#define CROSSDEV_BUFFER_SIZE (1u << 20)
+
+/* Bytes copied per wait under a bandwidth limit. */
+#define CROSSDEV_PACE_SLICE (1u << 20)
+
+typedef struct {
+    CrossDevMove *move;
+    int src_fd;
+    int dst_fd;
+    struct stat st;   /* the source when it was opened */
+    bool created;     /* the destination exists and is ours to remove */
+    bool chunked;     /* data still to be copied by the chunk stage */
+    int error;
+} CopyFile;
+
+typedef struct {
+    CopyFile *file;
+    uint64_t offset;
+    uint64_t len;
+} CopyChunk;
+
+typedef struct {
+    CopyFile *files;
+    size_t count;
+    CopyChunk *chunks;
+    size_t chunk_count;
+    size_t next;      /* next work item, taken with an atomic add */
+    bool may_chunk;
+    bool keep_sources; /* copy only */
+    Throttle *throttle; /* bandwidth limit, or NULL */
+} CopyWindow;
+
+/* Errors that mean "this method cannot copy between these files". */
+static bool method_unsupported(int err)
+{
+    return err == ENOSYS || err == EXDEV || err == EINVAL || err == EOPNOTSUPP ||
+           err == ENOTTY || err == ENOTSUP;
+}
+
+static int copy_buffered(int src_fd, int dst_fd, uint64_t offset, uint64_t len)
+{
+    size_t size = len < CROSSDEV_BUFFER_SIZE ? (size_t)len : CROSSDEV_BUFFER_SIZE;
+    char *buffer = malloc(size);
+    if (!buffer) {
+        return ENOMEM;
+    }
+
+    int err = 0;
+    while (len > 0 && err == 0) {
+        ssize_t n = pread(src_fd, buffer, len < size ? (size_t)len : size, (off_t)offset);
+        if (n < 0) {
+            err = errno == EINTR ? 0 : errno;
+            continue;
+        }
+        if (n == 0) {
+            err = EBUSY; /* the source shrank while it was copied */
+            break;
+        }
+        for (ssize_t done = 0; done < n && err == 0; ) {
+            ssize_t w = pwrite(dst_fd, buffer + done, (size_t)(n - done), (off_t)(offset + done));
+            if (w < 0) {
+                err = errno == EINTR ? 0 : errno;
+            } else {
+                done += w;
+            }
+        }
+        offset += (uint64_t)n;
+        len -= (uint64_t)n;
+    }
+
+    free(buffer);
+    return err;
+}
+
+/*
+ * Copy 'len' bytes at 'offset' of the source to the same offset of the
+ * destination, in the kernel when it can. 'whole' allows sendfile, which
+ * needs the destination's file offset to be 'offset'. Returns 0 or an
+ * errno value.
+ */
+static int copy_span(int src_fd, int dst_fd, uint64_t offset, uint64_t len, bool whole)
+{
+    if (len == 0) {
+        return 0;
+    }
+#ifdef __linux__
+    off_t in = (off_t)offset;
+    off_t out = (off_t)offset;
+    uint64_t left = len;
+    while (left > 0) {
+        ssize_t n = copy_file_range(src_fd, &in, dst_fd, &out, (size_t)left, 0);
+        if (n > 0) {
+            left -= (uint64_t)n;
+        } else if (n == 0) {
+            return EBUSY;
+        } else if (errno != EINTR) {
+            if (left == len && method_unsupported(errno)) {
+                break;
+            }
+            return errno;
+        }
+    }
+    if (left == 0) {
+        return 0;
+    }
+
+    if (whole) {
+        in = (off_t)offset;
+        while (left > 0) {
+            ssize_t n = sendfile(dst_fd, src_fd, &in, (size_t)left);
+            if (n > 0) {
+                left -= (uint64_t)n;
+            } else if (n == 0) {
+                return EBUSY;
+            } else if (errno != EINTR) {
+                if (left == len && method_unsupported(errno)) {
+                    break;
+                }
+                return errno;
+            }
+        }
+        if (left == 0) {
+            return 0;
+        }
+    }
+#else
+    (void)whole;
+#endif
+    return copy_buffered(src_fd, dst_fd, offset, len);
+}
+
+/* copy_span(), paced by 'throttle' when it limits bandwidth. */
+static int copy_range(int src_fd, int dst_fd, uint64_t offset, uint64_t len, bool whole,
+                      Throttle *throttle)
+{
+    if (!throttle_limits_bytes(throttle)) {
+        return copy_span(src_fd, dst_fd, offset, len, whole);
+    }
+
+    /* Slices mix methods, and sendfile would write at the wrong offset. */
+    int err = 0;
+    while (len > 0 && err == 0) {
+        uint64_t n = len < CROSSDEV_PACE_SLICE ? len : CROSSDEV_PACE_SLICE;
+        throttle_bytes(throttle, n);
+        err = copy_span(src_fd, dst_fd, offset, n, false);
+        offset += n;
+        len -= n;
+    }
+    return err;
+}
+
+static void copy_close(CopyFile *file)
+{
+    if (file->src_fd >= 0) {
+        close(file->src_fd);
+        file->src_fd = -1;
+    }
+    if (file->dst_fd >= 0) {
+        if (close(file->dst_fd) != 0 && file->error == 0) {
+            file->error = errno;
+        }
+        file->dst_fd = -1;
+    }
+}
+
+/* Give up on a file: close it and remove whatever was created. */
+static void copy_abort(CopyFile *file)
+{
+    copy_close(file);
+    if (file->created) {
+        unlinkat(file->move->dst_dir_fd, file->move->dst_name, 0);
+        file->created = false;
+    }
+}
+
+/*
+ * Check the copy against the source, carry over its metadata and flush it.
+ * Returns 0 or an errno value.
+ */
+static int copy_verify(CopyFile *file)
+{
+    struct stat now, copy;
+    if (fstat(file->src_fd, &now) != 0 || fstat(file->dst_fd, &copy) != 0) {
+        return errno;
+    }
+    if (now.st_size != file->st.st_size ||
+        now.st_mtim.tv_sec != file->st.st_mtim.tv_sec ||
+        now.st_mtim.tv_nsec != file->st.st_mtim.tv_nsec) {
+        return EBUSY; /* written to while it was copied */
+    }
+    if (copy.st_size != file->st.st_size) {
+        return EIO;
+    }
+
+    /* Only root may give files away; a copy owned by the caller is fine. */
+    if (fchown(file->dst_fd, file->st.st_uid, file->st.st_gid) != 0 && errno != EPERM) {
+        return errno;
+    }
+    struct timespec times[2] = { file->st.st_atim, file->st.st_mtim };
+    if (fchmod(file->dst_fd, file->st.st_mode & 07777) != 0 ||
+        futimens(file->dst_fd, times) != 0 ||
+        fsync(file->dst_fd) != 0) {
+        return errno;
+    }
+    return 0;
+}
+
+/* Verify and close a fully copied file, or undo it. */
+static void copy_complete(CopyFile *file)
+{
+    if (file->error == 0) {
+        file->error = copy_verify(file);
+    }
+    if (file->error == 0) {
+        copy_close(file);
+    }
+    if (file->error != 0) {
+        copy_abort(file);
+    }
+}
+
+static int copy_symlink(CopyFile *file)
+{
+    const CrossDevMove *move = file->move;
+    if (fstatat(move->src_dir_fd, move->src_name, &file->st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return errno;
+    }
+    if (!S_ISLNK(file->st.st_mode)) {
+        return EBUSY;
+    }
+
+    char *target = malloc((size_t)file->st.st_size + 1);
+    if (!target) {
+        return ENOMEM;
+    }
+    ssize_t len = readlinkat(move->src_dir_fd, move->src_name, target, (size_t)file->st.st_size + 1);
+    int err = len < 0 ? errno : len != file->st.st_size ? EBUSY : 0;
+    if (err == 0) {
+        target[len] = '\0';
+        if (symlinkat(target, move->dst_dir_fd, move->dst_name) != 0) {
+            err = errno;
+        } else {
+            struct timespec times[2] = { file->st.st_atim, file->st.st_mtim };
+            utimensat(move->dst_dir_fd, move->dst_name, times, AT_SYMLINK_NOFOLLOW);
+            file->created = true;
+        }
+    }
+    free(target);
+    return err;
+}
+
+/*
+ * First stage of one file: open both ends and copy it, unless it is large
+ * enough to be chunked, in which case it stays open for the chunk stage.
+ */
+static void copy_begin(CopyFile *file, bool may_chunk, Throttle *throttle)
+{
+    const CrossDevMove *move = file->move;
+
+    file->src_fd = openat(move->src_dir_fd, move->src_name,
+                          O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC);
+    if (file->src_fd < 0) {
+        file->error = errno == ELOOP ? copy_symlink(file) : errno;
+        if (file->error != 0) {
+            copy_abort(file);
+        }
+        return;
+    }
+    if (fstat(file->src_fd, &file->st) != 0) {
+        file->error = errno;
+    } else if (!S_ISREG(file->st.st_mode)) {
+        file->error = ENOTSUP; /* swapped for a special file since it was planned */
+    }
+    if (file->error != 0) {
+        copy_abort(file);
+        return;
+    }
+
+    file->dst_fd = openat(move->dst_dir_fd, move->dst_name,
+                          O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (file->dst_fd < 0) {
+        file->error = errno;
+        copy_abort(file);
+        return;
+    }
+    file->created = true;
+
+#ifdef __linux__
+    /* A reflink shares the extents and is done at once. */
+    if (ioctl(file->dst_fd, FICLONE, file->src_fd) == 0) {
+        copy_complete(file);
+        return;
+    }
+#endif
+    if (may_chunk && (uint64_t)file->st.st_size >= CROSSDEV_CHUNK_THRESHOLD) {
+        file->chunked = true;
+        return;
+    }
+    file->error = copy_range(file->src_fd, file->dst_fd, 0, (uint64_t)file->st.st_size, true,
+                             throttle);
+    copy_complete(file);
+}
+
+static void begin_task(void *arg, unsigned worker, unsigned workers)
+{
+    CopyWindow *window = arg;
+    (void)worker;
+    (void)workers;
+
+    size_t i;
+    while ((i = __atomic_fetch_add(&window->next, 1, __ATOMIC_RELAXED)) < window->count) {
+        copy_begin(&window->files[i], window->may_chunk, window->throttle);
+    }
+}
+
+static void chunk_task(void *arg, unsigned worker, unsigned workers)
+{
+    CopyWindow *window = arg;
+    (void)worker;
+    (void)workers;
+
+    size_t i;
+    while ((i = __atomic_fetch_add(&window->next, 1, __ATOMIC_RELAXED)) < window->chunk_count) {
+        const CopyChunk *chunk = &window->chunks[i];
+        CopyFile *file = chunk->file;
+        if (__atomic_load_n(&file->error, __ATOMIC_RELAXED) != 0) {
+            continue;
+        }
+        int err = copy_range(file->src_fd, file->dst_fd, chunk->offset, chunk->len, false,
+                             window->throttle);
+        if (err != 0) {
+            int none = 0;
+            __atomic_compare_exchange_n(&file->error, &none, err, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void complete_task(void *arg, unsigned worker, unsigned workers)
+{
+    CopyWindow *window = arg;
+    (void)worker;
+    (void)workers;
+
+    size_t i;
+    while ((i = __atomic_fetch_add(&window->next, 1, __ATOMIC_RELAXED)) < window->count) {
+        if (window->files[i].chunked) {
+            copy_complete(&window->files[i]);
+        }
+    }
+}
+
+static void run_stage(ThreadPool *pool, CopyWindow *window, ThreadPoolTask task)
+{
+    window->next = 0;
+    if (pool) {
+        thread_pool_run(pool, task, window);
+    } else {
+        task(window, 0, 1);
+    }
+}
+
+/* Split every chunked file of the window; returns an errno value. */
+static int plan_chunks(CopyWindow *window)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < window->count; ++i) {
+        if (window->files[i].chunked) {
+            total += ((uint64_t)window->files[i].st.st_size + CROSSDEV_CHUNK_SIZE - 1) /
+                     CROSSDEV_CHUNK_SIZE;
+        }
+    }
+
+    window->chunk_count = 0;
+    if (total == 0) {
+        return 0;
+    }
+    CopyChunk *chunks = realloc(window->chunks, total * sizeof(*chunks));
+    if (!chunks) {
+        return ENOMEM;
+    }
+    window->chunks = chunks;
+
+    for (size_t i = 0; i < window->count; ++i) {
+        CopyFile *file = &window->files[i];
+        uint64_t size = (uint64_t)file->st.st_size;
+        for (uint64_t offset = 0; file->chunked && offset < size; offset += CROSSDEV_CHUNK_SIZE) {
+            CopyChunk *chunk = &chunks[window->chunk_count++];
+            chunk->file = file;
+            chunk->offset = offset;
+            chunk->len = size - offset < CROSSDEV_CHUNK_SIZE ? size - offset : CROSSDEV_CHUNK_SIZE;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Flush the directory a copy was created in. Returns 0 or an errno value;
+ * file systems that cannot sync directories count as flushed.
+ */
+static int sync_parent(int dir_fd, const char *name)
+{
+    const char *slash = strrchr(name, '/');
+    int fd = dir_fd;
+
+    if (slash || dir_fd == AT_FDCWD) {
+        char parent[4096] = ".";
+        if (slash) {
+            size_t len = slash == name ? 1 : (size_t)(slash - name); /* keep "/" itself */
+            if (len >= sizeof(parent)) {
+                return ENAMETOOLONG;
+            }
+            memcpy(parent, name, len);
+            parent[len] = '\0';
+        }
+        fd = openat(dir_fd, parent, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return errno;
+        }
+    }
+
+    int err = fsync(fd) != 0 && errno != EINVAL ? errno : 0;
+    if (fd != dir_fd) {
+        close(fd);
+    }
+    return err;
+}
+
+/* Last stage: make the copies durable, then let go of the sources. */
+static void finish_window(CopyWindow *window)
+{
+    for (size_t i = 0; i < window->count; ++i) {
+        CopyFile *file = &window->files[i];
+        if (file->error != 0) {
+            continue;
+        }
+
+        /* One fsync per destination directory of the window. */
+        const CrossDevMove *move = file->move;
+        bool synced = false;
+        for (size_t j = 0; j < i && !synced; ++j) {
+            const CrossDevMove *prev = window->files[j].move;
+            synced = window->files[j].error == 0 && move->dst_dir_fd != AT_FDCWD &&
+                     prev->dst_dir_fd == move->dst_dir_fd &&
+                     !strchr(move->dst_name, '/') && !strchr(prev->dst_name, '/');
+        }
+        if (!synced) {
+            file->error = sync_parent(move->dst_dir_fd, move->dst_name);
+        }
+        if (file->error == 0 && !window->keep_sources &&
+            unlinkat(move->src_dir_fd, move->src_name, 0) != 0) {
+            file->error = errno;
+        }
+        if (file->error != 0) {
+            copy_abort(file);
+        }
+    }
+}
+
+static void transfer_batch(CrossDevMove *moves, size_t count, unsigned jobs, bool keep_sources,
+                           Throttle *throttle)
+{
+    if (count == 0) {
+        return;
+    }
+    if (jobs == 0) {
+        jobs = CROSSDEV_DEFAULT_JOBS;
+    }
+
+    ThreadPool *pool = jobs > 1 ? thread_pool_create(jobs) : NULL;
+    if (pool && thread_pool_size(pool) <= 1) {
+        thread_pool_destroy(pool);
+        pool = NULL;
+    }
+
+    CopyWindow window;
+    memset(&window, 0, sizeof(window));
+    window.files = malloc(CROSSDEV_WINDOW * sizeof(*window.files));
+    window.may_chunk = pool != NULL;
+    window.keep_sources = keep_sources;
+    window.throttle = throttle;
+
+    for (size_t base = 0; base < count; base += CROSSDEV_WINDOW) {
+        size_t n = count - base < CROSSDEV_WINDOW ? count - base : CROSSDEV_WINDOW;
+        if (!window.files) {
+            for (size_t i = 0; i < n; ++i) {
+                moves[base + i].error = ENOMEM;
+            }
+            continue;
+        }
+
+        window.count = n;
+        for (size_t i = 0; i < n; ++i) {
+            CopyFile *file = &window.files[i];
+            memset(file, 0, sizeof(*file));
+            file->move = &moves[base + i];
+            file->src_fd = -1;
+            file->dst_fd = -1;
+        }
+
+        run_stage(pool, &window, begin_task);
+        int err = plan_chunks(&window);
+        if (err == 0 && window.chunk_count > 0) {
+            run_stage(pool, &window, chunk_task);
+        }
+        for (size_t i = 0; err != 0 && i < n; ++i) {
+            if (window.files[i].chunked) {
+                window.files[i].error = err;
+            }
+        }
+        run_stage(pool, &window, complete_task);
+        finish_window(&window);
+
+        for (size_t i = 0; i < n; ++i) {
+            moves[base + i].error = window.files[i].error;
+        }
+    }
+
+    free(window.chunks);
+    free(window.files);
+    thread_pool_destroy(pool);
+}
+
+void crossdev_move_batch(CrossDevMove *moves, size_t count, unsigned jobs, Throttle *throttle)
+{
+    transfer_batch(moves, count, jobs, false, throttle);
+}
+
+int crossdev_move(int src_dir_fd, const char *src_name, int dst_dir_fd, const char *dst_name)
+{
+    CrossDevMove move = { src_dir_fd, src_name, dst_dir_fd, dst_name, 0 };
+    transfer_batch(&move, 1, 1, false, NULL);
+    if (move.error != 0) {
+        errno = move.error;
+        return -1;
+    }
+    return 0;
+}
+
+int crossdev_copy(int src_dir_fd, const char *src_name, int dst_dir_fd, const char *dst_name)
+{
+    CrossDevMove copy = { src_dir_fd, src_name, dst_dir_fd, dst_name, 0 };
+    transfer_batch(&copy, 1, 1, true, NULL);
+    if (copy.error != 0) {
+        errno = copy.error;
+        return -1;
+    }
+    return 0;
+}
+
+#else /* _WIN32 */
+
+void crossdev_move_batch(CrossDevMove *moves, size_t count, unsigned jobs, Throttle *throttle)
+{
+    (void)jobs;
+    (void)throttle;
+    for (size_t i = 0; i < count; ++i) {
+        moves[i].error = ENOSYS;
+    }
+}
+
+int crossdev_move(int src_dir_fd, const char *src_name, int dst_dir_fd, const char *dst_name)
+{
+    (void)src_dir_fd;
+    (void)src_name;
+    (void)dst_dir_fd;
+    (void)dst_name;
+    errno = ENOSYS;
+    return -1;
+}
+
+int crossdev_copy(int src_dir_fd, const char *src_name, int dst_dir_fd, const char *dst_name)
+{
+    return crossdev_move(src_dir_fd, src_name, dst_dir_fd, dst_name);
+}
+
+#endif
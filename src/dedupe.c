@@ -0,0 +1,503 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       dedupe.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Duplicate detection in three parallel stages over the distinct files of
+    a batch: stat every file, hash the ones whose size matches their
+    partner's, and confirm equal hashes with a byte comparison.
+
+ Usage:
+    See dedupe.h.
+
+ Notes:
+    - XXH64 is computed over 32-byte stripes with four independent
+      accumulators, which compilers keep in registers (and vectorize where
+      the target allows); reads are 1 MiB, so hashing keeps up with storage.
+    - A file that changes between its stat and its hash (size, mtime or
+      inode) is reported DEDUPE_FAILED rather than compared.
+
+==========================================================================================================
+*/
+
+#define _POSIX_C_SOURCE 200809L /* openat, fstatat, pread */
+
+#include "dedupe.h"
+#include "thread_pool.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define DEDUPE_BUFFER_SIZE (1u << 20) /* a multiple of the 32-byte stripe */
+
+/* ---- XXH64 ---------------------------------------------------------------------------- */
+
+#define XXH_PRIME64_1 UINT64_C(0x9E3779B185EBCA87)
+#define XXH_PRIME64_2 UINT64_C(0xC2B2AE3D27D4EB4F)
+#define XXH_PRIME64_3 UINT64_C(0x165667B19E3779F9)
+#define XXH_PRIME64_4 UINT64_C(0x85EBCA77C2B2AE63)
+#define XXH_PRIME64_5 UINT64_C(0x27D4EB2F165667C5)
+
+typedef struct {
+    uint64_t v[4];
+    uint64_t total;
+} XxhState;
+
+static uint64_t rotl64(uint64_t x, unsigned r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t read64(const unsigned char *p)
+{
+    return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+           (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 |
+           (uint64_t)p[7] << 56;
+}
+
+static uint64_t read32(const unsigned char *p)
+{
+    return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24;
+}
+
+static uint64_t xxh_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_PRIME64_2;
+    return rotl64(acc, 31) * XXH_PRIME64_1;
+}
+
+static uint64_t xxh_merge(uint64_t acc, uint64_t v)
+{
+    acc ^= xxh_round(0, v);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static void xxh_init(XxhState *state)
+{
+    state->v[0] = XXH_PRIME64_1 + XXH_PRIME64_2;
+    state->v[1] = XXH_PRIME64_2;
+    state->v[2] = 0;
+    state->v[3] = (uint64_t)0 - XXH_PRIME64_1;
+    state->total = 0;
+}
+
+/* Consume whole 32-byte stripes; 'len' must be a multiple of 32. */
+static void xxh_stripes(XxhState *state, const unsigned char *p, size_t len)
+{
+    uint64_t v0 = state->v[0], v1 = state->v[1], v2 = state->v[2], v3 = state->v[3];
+    for (const unsigned char *end = p + len; p < end; p += 32) {
+        v0 = xxh_round(v0, read64(p));
+        v1 = xxh_round(v1, read64(p + 8));
+        v2 = xxh_round(v2, read64(p + 16));
+        v3 = xxh_round(v3, read64(p + 24));
+    }
+    state->v[0] = v0;
+    state->v[1] = v1;
+    state->v[2] = v2;
+    state->v[3] = v3;
+    state->total += len;
+}
+
+/* Finish with the last 'len' (< 32) bytes. */
+static uint64_t xxh_final(const XxhState *state, const unsigned char *p, size_t len)
+{
+    uint64_t total = state->total + len;
+    uint64_t h;
+
+    if (state->total >= 32) {
+        h = rotl64(state->v[0], 1) + rotl64(state->v[1], 7) +
+            rotl64(state->v[2], 12) + rotl64(state->v[3], 18);
+        for (int i = 0; i < 4; ++i) {
+            h = xxh_merge(h, state->v[i]);
+        }
+    } else {
+        h = XXH_PRIME64_5;
+    }
+    h += total;
+
+    for (; len >= 8; p += 8, len -= 8) {
+        h ^= xxh_round(0, read64(p));
+        h = rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if (len >= 4) {
+        h ^= read32(p) * XXH_PRIME64_1;
+        h = rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+        len -= 4;
+    }
+    for (; len > 0; ++p, --len) {
+        h ^= *p * XXH_PRIME64_5;
+        h = rotl64(h, 11) * XXH_PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+/* ---- Batches -------------------------------------------------------------------------- */
+
+typedef struct {
+    int dir_fd;
+    const char *name;
+    struct stat st;
+    int error;        /* errno of the stat or the read; EINVAL if not a regular file */
+    bool need_hash;
+    uint64_t hash;
+} DedupeFile;
+
+typedef struct {
+    DedupePair *pair;
+    size_t kept;      /* indices into 'files' */
+    size_t candidate;
+} DedupeLink;
+
+typedef struct {
+    DedupeFile *files;
+    size_t file_count;
+    DedupeLink *links;  /* one per pair */
+    size_t link_count;
+    size_t *verify;     /* links whose hashes matched */
+    size_t verify_count;
+    size_t next;        /* next work item, taken with an atomic add */
+} DedupeBatch;
+
+static size_t next_item(DedupeBatch *batch)
+{
+    return __atomic_fetch_add(&batch->next, 1, __ATOMIC_RELAXED);
+}
+
+/* Open a file for reading and make sure it is still what was stat()ed. */
+static int open_unchanged(const DedupeFile *file)
+{
+    int fd = openat(file->dir_fd, file->name, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_ino != file->st.st_ino || st.st_dev != file->st.st_dev ||
+        st.st_size != file->st.st_size || st.st_mtim.tv_sec != file->st.st_mtim.tv_sec ||
+        st.st_mtim.tv_nsec != file->st.st_mtim.tv_nsec) {
+        close(fd);
+        errno = EBUSY;
+        return -1;
+    }
+    return fd;
+}
+
+/* Read until 'size' bytes or end of file; returns bytes read or -1. */
+static ssize_t read_full(int fd, unsigned char *buffer, size_t size, off_t offset)
+{
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, buffer + done, size - done, offset + (off_t)done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += (size_t)n;
+    }
+    return (ssize_t)done;
+}
+
+static int hash_file(DedupeFile *file, unsigned char *buffer)
+{
+    int fd = open_unchanged(file);
+    if (fd < 0) {
+        return errno;
+    }
+
+    XxhState state;
+    xxh_init(&state);
+    int err = 0;
+    for (off_t offset = 0; ; ) {
+        ssize_t n = read_full(fd, buffer, DEDUPE_BUFFER_SIZE, offset);
+        if (n < 0) {
+            err = errno;
+            break;
+        }
+        size_t whole = (size_t)n & ~(size_t)31;
+        xxh_stripes(&state, buffer, whole);
+        if ((size_t)n < DEDUPE_BUFFER_SIZE) {
+            file->hash = xxh_final(&state, buffer + whole, (size_t)n - whole);
+            break;
+        }
+        offset += n;
+    }
+
+    close(fd);
+    return err;
+}
+
+static DedupeResult compare_files(const DedupeFile *a, const DedupeFile *b, unsigned char *buffer)
+{
+    DedupeResult result = DEDUPE_FAILED;
+    int fd_a = open_unchanged(a);
+    int fd_b = fd_a >= 0 ? open_unchanged(b) : -1;
+
+    if (fd_b >= 0) {
+        unsigned char *other = buffer + DEDUPE_BUFFER_SIZE;
+        result = DEDUPE_IDENTICAL;
+        for (off_t offset = 0; result == DEDUPE_IDENTICAL; ) {
+            ssize_t na = read_full(fd_a, buffer, DEDUPE_BUFFER_SIZE, offset);
+            ssize_t nb = read_full(fd_b, other, DEDUPE_BUFFER_SIZE, offset);
+            if (na < 0 || nb < 0) {
+                result = DEDUPE_FAILED;
+            } else if (na != nb || memcmp(buffer, other, (size_t)na) != 0) {
+                result = DEDUPE_DIFFERENT;
+            } else if (na < (ssize_t)DEDUPE_BUFFER_SIZE) {
+                break;
+            }
+            offset += na;
+        }
+    }
+
+    if (fd_a >= 0) {
+        close(fd_a);
+    }
+    if (fd_b >= 0) {
+        close(fd_b);
+    }
+    return result;
+}
+
+static void stat_task(void *arg, unsigned worker, unsigned workers)
+{
+    DedupeBatch *batch = arg;
+    (void)worker;
+    (void)workers;
+
+    size_t i;
+    while ((i = next_item(batch)) < batch->file_count) {
+        DedupeFile *file = &batch->files[i];
+        if (fstatat(file->dir_fd, file->name, &file->st, AT_SYMLINK_NOFOLLOW) != 0) {
+            file->error = errno;
+        } else if (!S_ISREG(file->st.st_mode)) {
+            file->error = EINVAL;
+        }
+    }
+}
+
+static void hash_task(void *arg, unsigned worker, unsigned workers)
+{
+    DedupeBatch *batch = arg;
+    unsigned char *buffer = NULL;
+    (void)worker;
+    (void)workers;
+
+    size_t i;
+    while ((i = next_item(batch)) < batch->file_count) {
+        DedupeFile *file = &batch->files[i];
+        if (!file->need_hash) {
+            continue;
+        }
+        if (!buffer && !(buffer = malloc(DEDUPE_BUFFER_SIZE))) {
+            file->error = ENOMEM;
+            continue;
+        }
+        file->error = hash_file(file, buffer);
+    }
+    free(buffer);
+}
+
+static void verify_task(void *arg, unsigned worker, unsigned workers)
+{
+    DedupeBatch *batch = arg;
+    unsigned char *buffer = NULL;
+    (void)worker;
+    (void)workers;
+
+    size_t i;
+    while ((i = next_item(batch)) < batch->verify_count) {
+        DedupeLink *link = &batch->links[batch->verify[i]];
+        if (!buffer && !(buffer = malloc(2 * (size_t)DEDUPE_BUFFER_SIZE))) {
+            link->pair->result = DEDUPE_FAILED;
+            continue;
+        }
+        link->pair->result = compare_files(&batch->files[link->kept],
+                                           &batch->files[link->candidate], buffer);
+    }
+    free(buffer);
+}
+
+static void run_stage(ThreadPool *pool, DedupeBatch *batch, ThreadPoolTask task)
+{
+    batch->next = 0;
+    if (pool) {
+        thread_pool_run(pool, task, batch);
+    } else {
+        task(batch, 0, 1);
+    }
+}
+
+static int compare_kept(const void *a, const void *b)
+{
+    const DedupePair *x = *(const DedupePair *const *)a;
+    const DedupePair *y = *(const DedupePair *const *)b;
+    if (x->kept_dir_fd != y->kept_dir_fd) {
+        return x->kept_dir_fd < y->kept_dir_fd ? -1 : 1;
+    }
+    return strcmp(x->kept_name, y->kept_name);
+}
+
+static DedupeFile *add_file(DedupeBatch *batch, int dir_fd, const char *name)
+{
+    DedupeFile *file = &batch->files[batch->file_count++];
+    memset(file, 0, sizeof(*file));
+    file->dir_fd = dir_fd;
+    file->name = name;
+    return file;
+}
+
+/*
+ * Collect the distinct files of the batch: a kept file shared by several
+ * pairs (sorted next to each other) is listed once.
+ */
+static int build_batch(DedupeBatch *batch, DedupePair *pairs, size_t count)
+{
+    DedupePair **sorted = malloc(count * sizeof(*sorted));
+    batch->files = malloc(2 * count * sizeof(*batch->files));
+    batch->links = malloc(count * sizeof(*batch->links));
+    batch->verify = malloc(count * sizeof(*batch->verify));
+    if (!sorted || !batch->files || !batch->links || !batch->verify) {
+        free(sorted);
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        sorted[i] = &pairs[i];
+    }
+    qsort(sorted, count, sizeof(*sorted), compare_kept);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+        DedupeLink *link = &batch->links[batch->link_count++];
+        link->pair = sorted[i];
+        if (i == 0 || compare_kept(&sorted[i - 1], &sorted[i]) != 0) {
+            kept = batch->file_count;
+            add_file(batch, sorted[i]->kept_dir_fd, sorted[i]->kept_name);
+        }
+        link->kept = kept;
+        link->candidate = batch->file_count;
+        add_file(batch, sorted[i]->dir_fd, sorted[i]->name);
+    }
+
+    free(sorted);
+    return 0;
+}
+
+void dedupe_compare_batch(DedupePair *pairs, size_t count, unsigned jobs)
+{
+    for (size_t i = 0; i < count; ++i) {
+        pairs[i].result = DEDUPE_FAILED;
+        pairs[i].kept_size = 0;
+        pairs[i].kept_mtime_ns = 0;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    DedupeBatch batch;
+    memset(&batch, 0, sizeof(batch));
+    if (build_batch(&batch, pairs, count) != 0) {
+        goto out;
+    }
+
+    if (jobs == 0) {
+        jobs = DEDUPE_DEFAULT_JOBS;
+    }
+    ThreadPool *pool = jobs > 1 ? thread_pool_create(jobs) : NULL;
+
+    run_stage(pool, &batch, stat_task);
+
+    /* Sizes decide most pairs; only equal sizes are read. */
+    for (size_t i = 0; i < batch.link_count; ++i) {
+        DedupeLink *link = &batch.links[i];
+        const DedupeFile *kept = &batch.files[link->kept];
+        DedupeFile *candidate = &batch.files[link->candidate];
+
+        link->pair->kept_size = (uint64_t)kept->st.st_size;
+        link->pair->kept_mtime_ns = (int64_t)kept->st.st_mtim.tv_sec * 1000000000 +
+                                    kept->st.st_mtim.tv_nsec;
+        if (kept->error == EINVAL || candidate->error == EINVAL) {
+            link->pair->result = DEDUPE_DIFFERENT;
+        } else if (kept->error != 0 || candidate->error != 0) {
+            link->pair->result = DEDUPE_FAILED;
+        } else if (kept->st.st_dev == candidate->st.st_dev &&
+                   kept->st.st_ino == candidate->st.st_ino) {
+            link->pair->result = DEDUPE_IDENTICAL; /* two names of one file */
+        } else if (kept->st.st_size != candidate->st.st_size) {
+            link->pair->result = DEDUPE_DIFFERENT;
+        } else if (kept->st.st_size == 0) {
+            link->pair->result = DEDUPE_IDENTICAL;
+        } else {
+            batch.files[link->kept].need_hash = true;
+            candidate->need_hash = true;
+        }
+    }
+
+    run_stage(pool, &batch, hash_task);
+
+    for (size_t i = 0; i < batch.link_count; ++i) {
+        DedupeLink *link = &batch.links[i];
+        const DedupeFile *kept = &batch.files[link->kept];
+        const DedupeFile *candidate = &batch.files[link->candidate];
+        if (!candidate->need_hash) {
+            continue;
+        }
+        if (kept->error != 0 || candidate->error != 0) {
+            link->pair->result = DEDUPE_FAILED;
+        } else if (kept->hash != candidate->hash) {
+            link->pair->result = DEDUPE_DIFFERENT;
+        } else {
+            batch.verify[batch.verify_count++] = i;
+        }
+    }
+
+    if (batch.verify_count > 0) {
+        run_stage(pool, &batch, verify_task);
+    }
+    thread_pool_destroy(pool);
+
+out:
+    free(batch.files);
+    free(batch.links);
+    free(batch.verify);
+}
+
+#else /* _WIN32 */
+
+void dedupe_compare_batch(DedupePair *pairs, size_t count, unsigned jobs)
+{
+    (void)jobs;
+    for (size_t i = 0; i < count; ++i) {
+        pairs[i].result = DEDUPE_FAILED;
+        pairs[i].kept_size = 0;
+        pairs[i].kept_mtime_ns = 0;
+    }
+}
+
+#endif
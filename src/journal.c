@@ -0,0 +1,517 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       journal.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-15
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Implementation of the move journal: a buffered append-only writer and a
+    loader that indexes every record of a journal file.
+
+ Usage:
+    See journal.h.
+
+ Notes:
+    - Records are encoded byte by byte, so journals are portable between
+      hosts of different endianness.
+    - JSON export escapes quotes, backslashes and control characters; other
+      bytes of file names are copied as they are.
+
+==========================================================================================================
+*/
+
+#define _XOPEN_SOURCE 700 /* realpath, fsync */
+
+#include "journal.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define JOURNAL_MAGIC        "FOJRNL1\n"
+#define JOURNAL_MAGIC_LEN    8
+#define JOURNAL_BUFFER_SIZE  ((size_t)1024 * 1024)
+#define JOURNAL_HEADER_LEN   5 /* type, src_len, dst_len */
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int write_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/* Write the buffer out; fsync once enough has accumulated (or if 'sync'). */
+static int flush_locked(Journal *journal, int sync)
+{
+    if (journal->error) {
+        return -1;
+    }
+
+    if (journal->used > 0) {
+        if (write_all(journal->fd, journal->buffer, journal->used) != 0) {
+            journal->error = errno;
+            return -1;
+        }
+        journal->unsynced += journal->used;
+        journal->size += journal->used;
+        journal->used = 0;
+        journal->pending = 0;
+    }
+
+    if (journal->unsynced > 0 && (sync || journal->unsynced >= JOURNAL_SYNC_BYTES)) {
+        if (fsync(journal->fd) != 0) {
+            journal->error = errno;
+            return -1;
+        }
+        journal->unsynced = 0;
+    }
+    return 0;
+}
+
+/*
+ * Append one record; 'src' is the concatenation of src_a and src_b, 'dst'
+ * of dst_a, dst_sep and dst_b (any part may be "").
+ */
+static void append_record(Journal *journal, JournalRecordType type,
+                          const char *src_a, const char *src_b,
+                          const char *dst_a, const char *dst_sep, const char *dst_b)
+{
+    size_t sa = strlen(src_a), sb = strlen(src_b);
+    size_t da = strlen(dst_a), ds = strlen(dst_sep), db = strlen(dst_b);
+    size_t src_len = sa + sb;
+    size_t dst_len = da + ds + db;
+    size_t need = JOURNAL_HEADER_LEN + src_len + 1 + dst_len + 1;
+
+    pool_mutex_lock(&journal->lock);
+
+    if (journal->error) {
+        pool_mutex_unlock(&journal->lock);
+        return;
+    }
+    if (src_len > UINT16_MAX || dst_len > UINT16_MAX) {
+        journal->error = ENAMETOOLONG;
+        pool_mutex_unlock(&journal->lock);
+        return;
+    }
+    if (journal->used + need > JOURNAL_BUFFER_SIZE && flush_locked(journal, 0) != 0) {
+        pool_mutex_unlock(&journal->lock);
+        return;
+    }
+
+    unsigned char *p = (unsigned char *)journal->buffer + journal->used;
+    p[0] = (unsigned char)type;
+    p[1] = (unsigned char)(src_len & 0xff);
+    p[2] = (unsigned char)(src_len >> 8);
+    p[3] = (unsigned char)(dst_len & 0xff);
+    p[4] = (unsigned char)(dst_len >> 8);
+    p += JOURNAL_HEADER_LEN;
+
+    memcpy(p, src_a, sa);
+    memcpy(p + sa, src_b, sb);
+    p[src_len] = '\0';
+    p += src_len + 1;
+
+    memcpy(p, dst_a, da);
+    memcpy(p + da, dst_sep, ds);
+    memcpy(p + da + ds, dst_b, db);
+    p[dst_len] = '\0';
+
+    journal->used += need;
+    if (++journal->pending >= JOURNAL_WRITE_RECORDS) {
+        flush_locked(journal, 0); /* a failure is kept in journal->error */
+    }
+    pool_mutex_unlock(&journal->lock);
+}
+
+int journal_open(Journal *journal, const char *path)
+{
+    journal->fd = -1;
+    journal->used = 0;
+    journal->pending = 0;
+    journal->unsynced = 0;
+    journal->size = 0;
+    journal->error = 0;
+    journal->buffer = malloc(JOURNAL_BUFFER_SIZE);
+    if (!journal->buffer) {
+        return -1;
+    }
+
+    journal->fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    struct stat st;
+    if (journal->fd < 0 || fstat(journal->fd, &st) != 0) {
+        goto fail;
+    }
+
+    if (st.st_size == 0) {
+        if (write_all(journal->fd, JOURNAL_MAGIC, JOURNAL_MAGIC_LEN) != 0) {
+            goto fail;
+        }
+        journal->size = JOURNAL_MAGIC_LEN;
+    } else {
+        char magic[JOURNAL_MAGIC_LEN];
+        if (pread(journal->fd, magic, sizeof(magic), 0) != (ssize_t)sizeof(magic) ||
+            memcmp(magic, JOURNAL_MAGIC, JOURNAL_MAGIC_LEN) != 0) {
+            errno = EINVAL;
+            goto fail;
+        }
+        journal->size = (uint64_t)st.st_size;
+    }
+
+    pool_mutex_init(&journal->lock);
+    return 0;
+
+fail:;
+    int saved = errno;
+    if (journal->fd >= 0) {
+        close(journal->fd);
+    }
+    free(journal->buffer);
+    journal->buffer = NULL;
+    errno = saved;
+    return -1;
+}
+
+int journal_begin_run(Journal *journal, const char *target_dir)
+{
+    char absolute[PATH_MAX];
+    if (!realpath(target_dir, absolute)) {
+        return -1;
+    }
+    append_record(journal, JOURNAL_RECORD_RUN, absolute, "", "", "", "");
+    return journal->error ? (errno = journal->error, -1) : 0;
+}
+
+void journal_record_mkdir(Journal *journal, const char *category)
+{
+    append_record(journal, JOURNAL_RECORD_MKDIR, category, "", "", "", "");
+}
+
+void journal_record_move(Journal *journal, const char *src_dir, const char *src_name,
+                         const char *category, const char *dst_name)
+{
+    append_record(journal, JOURNAL_RECORD_MOVE, src_dir, src_name, category, "/", dst_name);
+}
+
+void journal_record_duplicate(Journal *journal, JournalRecordType type,
+                              const char *src_dir, const char *src_name,
+                              const char *category, const char *kept_name)
+{
+    append_record(journal, type, src_dir, src_name, category, "/", kept_name);
+}
+
+int journal_flush(Journal *journal)
+{
+    pool_mutex_lock(&journal->lock);
+    int result = flush_locked(journal, 0);
+    pool_mutex_unlock(&journal->lock);
+    return result;
+}
+
+uint64_t journal_size(Journal *journal)
+{
+    pool_mutex_lock(&journal->lock);
+    uint64_t size = journal->size;
+    pool_mutex_unlock(&journal->lock);
+    return size;
+}
+
+int journal_close(Journal *journal)
+{
+    pool_mutex_lock(&journal->lock);
+    int result = flush_locked(journal, 1);
+    pool_mutex_unlock(&journal->lock);
+
+    int saved = journal->error;
+    if (close(journal->fd) != 0 && result == 0) {
+        saved = errno;
+        result = -1;
+    }
+    pool_mutex_destroy(&journal->lock);
+    free(journal->buffer);
+    journal->buffer = NULL;
+    journal->fd = -1;
+
+    if (result != 0) {
+        errno = saved;
+    }
+    return result;
+}
+
+int journal_load(JournalReader *reader, const char *path)
+{
+    return journal_load_from(reader, path, 0);
+}
+
+int journal_load_from(JournalReader *reader, const char *path, uint64_t offset)
+{
+    reader->data = NULL;
+    reader->size = 0;
+    reader->entries = NULL;
+    reader->count = 0;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0) {
+        goto fail;
+    }
+
+    char magic[JOURNAL_MAGIC_LEN];
+    if (offset < JOURNAL_MAGIC_LEN) {
+        offset = JOURNAL_MAGIC_LEN;
+    }
+    if ((uint64_t)st.st_size < offset ||
+        pread(fd, magic, sizeof(magic), 0) != (ssize_t)sizeof(magic) ||
+        memcmp(magic, JOURNAL_MAGIC, JOURNAL_MAGIC_LEN) != 0) {
+        errno = EINVAL;
+        goto fail;
+    }
+
+    /* Only the records from 'offset' on are kept in memory. */
+    reader->size = (size_t)((uint64_t)st.st_size - offset);
+    reader->data = malloc(reader->size ? reader->size : 1);
+    if (!reader->data) {
+        goto fail;
+    }
+    for (size_t done = 0; done < reader->size; ) {
+        ssize_t n = pread(fd, reader->data + done, reader->size - done,
+                          (off_t)(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            if (n == 0) {
+                errno = EIO; /* shrank while reading */
+            }
+            goto fail;
+        }
+        done += (size_t)n;
+    }
+    close(fd);
+    fd = -1;
+
+    /* Records take at least JOURNAL_HEADER_LEN + 2 bytes each. */
+    size_t max_records = reader->size / (JOURNAL_HEADER_LEN + 2) + 1;
+    reader->entries = malloc(max_records * sizeof(*reader->entries));
+    if (!reader->entries) {
+        goto fail;
+    }
+
+    const char *base = NULL;
+    size_t pos = 0;
+    while (reader->size - pos >= JOURNAL_HEADER_LEN) {
+        const unsigned char *p = (const unsigned char *)reader->data + pos;
+        size_t src_len = (size_t)p[1] | ((size_t)p[2] << 8);
+        size_t dst_len = (size_t)p[3] | ((size_t)p[4] << 8);
+        size_t len = JOURNAL_HEADER_LEN + src_len + 1 + dst_len + 1;
+        if (reader->size - pos < len) {
+            break; /* torn final record */
+        }
+
+        JournalEntry *entry = &reader->entries[reader->count];
+        entry->type = (JournalRecordType)p[0];
+        entry->src = reader->data + pos + JOURNAL_HEADER_LEN;
+        entry->dst = entry->src + src_len + 1;
+
+        if (entry->src[src_len] != '\0' || entry->dst[dst_len] != '\0' ||
+            (entry->type != JOURNAL_RECORD_RUN && entry->type != JOURNAL_RECORD_MKDIR &&
+             entry->type != JOURNAL_RECORD_MOVE && entry->type != JOURNAL_RECORD_DROP &&
+             entry->type != JOURNAL_RECORD_LINK) ||
+            (entry->type != JOURNAL_RECORD_RUN && !base)) {
+            errno = EINVAL;
+            goto fail;
+        }
+        if (entry->type == JOURNAL_RECORD_RUN) {
+            base = entry->src;
+        }
+        entry->base = base;
+        reader->count++;
+        pos += len;
+    }
+    return 0;
+
+fail:;
+    int saved = errno;
+    if (fd >= 0) {
+        close(fd);
+    }
+    journal_reader_free(reader);
+    errno = saved;
+    return -1;
+}
+
+#else /* _WIN32 */
+
+int journal_open(Journal *journal, const char *path)
+{
+    (void)path;
+    journal->buffer = NULL;
+    errno = ENOSYS;
+    return -1;
+}
+
+int journal_begin_run(Journal *journal, const char *target_dir)
+{
+    (void)journal;
+    (void)target_dir;
+    errno = ENOSYS;
+    return -1;
+}
+
+void journal_record_mkdir(Journal *journal, const char *category)
+{
+    (void)journal;
+    (void)category;
+}
+
+int journal_flush(Journal *journal)
+{
+    (void)journal;
+    return 0;
+}
+
+void journal_record_duplicate(Journal *journal, JournalRecordType type,
+                              const char *src_dir, const char *src_name,
+                              const char *category, const char *kept_name)
+{
+    (void)journal;
+    (void)type;
+    (void)src_dir;
+    (void)src_name;
+    (void)category;
+    (void)kept_name;
+}
+
+void journal_record_move(Journal *journal, const char *src_dir, const char *src_name,
+                         const char *category, const char *dst_name)
+{
+    (void)journal;
+    (void)src_dir;
+    (void)src_name;
+    (void)category;
+    (void)dst_name;
+}
+
+uint64_t journal_size(Journal *journal)
+{
+    (void)journal;
+    return 0;
+}
+
+int journal_close(Journal *journal)
+{
+    (void)journal;
+    return 0;
+}
+
+int journal_load(JournalReader *reader, const char *path)
+{
+    return journal_load_from(reader, path, 0);
+}
+
+int journal_load_from(JournalReader *reader, const char *path, uint64_t offset)
+{
+    (void)path;
+    (void)offset;
+    reader->data = NULL;
+    reader->entries = NULL;
+    reader->count = 0;
+    errno = ENOSYS;
+    return -1;
+}
+
+#endif
+
+void journal_reader_free(JournalReader *reader)
+{
+    free(reader->entries);
+    free(reader->data);
+    reader->entries = NULL;
+    reader->data = NULL;
+    reader->size = 0;
+    reader->count = 0;
+}
+
+static void put_json_string(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fputc('\\', out);
+            fputc(c, out);
+        } else if (c < 0x20) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+int journal_export_jsonl(const char *path, FILE *out)
+{
+    JournalReader reader;
+    if (journal_load(&reader, path) != 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < reader.count; ++i) {
+        const JournalEntry *entry = &reader.entries[i];
+        switch (entry->type) {
+        case JOURNAL_RECORD_RUN:
+            fputs("{\"op\":\"run\",\"base\":", out);
+            put_json_string(out, entry->src);
+            break;
+        case JOURNAL_RECORD_MKDIR:
+            fputs("{\"op\":\"mkdir\",\"base\":", out);
+            put_json_string(out, entry->base);
+            fputs(",\"dir\":", out);
+            put_json_string(out, entry->src);
+            break;
+        case JOURNAL_RECORD_MOVE:
+        case JOURNAL_RECORD_DROP:
+        case JOURNAL_RECORD_LINK:
+            fprintf(out, "{\"op\":\"%s\",\"base\":",
+                    entry->type == JOURNAL_RECORD_MOVE ? "move"
+                    : entry->type == JOURNAL_RECORD_DROP ? "drop" : "link");
+            put_json_string(out, entry->base);
+            fputs(",\"src\":", out);
+            put_json_string(out, entry->src);
+            fputs(",\"dst\":", out);
+            put_json_string(out, entry->dst);
+            break;
+        }
+        fputs("}\n", out);
+    }
+
+    journal_reader_free(&reader);
+    return ferror(out) ? (errno = EIO, -1) : 0;
+}
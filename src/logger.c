@@ -4,7 +4,7 @@
  File:       logger.c
  Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
  Created:    2025-11-29
- Updated:    2025-11-29
+ Updated:    2026-10-15
  License:    MIT License (see LICENSE file for details)
 ==========================================================================================================
 
@@ -18,24 +18,74 @@
 
  Notes:
     - ERROR/WARN messages go to stderr, INFO/DEBUG go to stdout.
-    - Timestamps are generated using local time.
+    - Timestamps are generated using local time, formatted at most once
+      per second per thread.
+    - Safe to call from several threads; each message is written as one unit.
+    - Async mode: every thread owns a single-producer/single-consumer ring
+      of [header][text] records. Producers never take a lock; the flusher
+      polls all rings, so a ring that fills up only makes its own thread
+      wait. Order is kept per thread, not across threads; a message too
+      long for a record waits for its thread's ring to drain and is then
+      written synchronously.
+    - Timing (logger_set_timing) is two monotonic clock reads around each
+      written message, added to process-wide atomic totals.
 
 ==========================================================================================================
 */
 
+#define _POSIX_C_SOURCE 200809L /* localtime_r, flockfile, nanosleep, clock_gettime */
+
 #include "logger.h"
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <stdarg.h>
 
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
 static LogLevel current_level = LOG_LEVEL_INFO;
 
+/* Timing totals; accessed with __atomic builtins. */
+static int timing_enabled;
+static uint64_t timed_messages;
+static uint64_t timed_ns;
+
 void logger_set_level(LogLevel level)
 {
     current_level = level;
 }
 
+void logger_set_timing(bool enabled)
+{
+    __atomic_store_n(&timing_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+void logger_timing(uint64_t *messages, uint64_t *ns)
+{
+    *messages = __atomic_load_n(&timed_messages, __ATOMIC_RELAXED);
+    *ns = __atomic_load_n(&timed_ns, __ATOMIC_RELAXED);
+}
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+#ifndef _WIN32
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
 static const char *level_to_string(LogLevel level)
 {
     switch (level) {
@@ -47,28 +97,349 @@ static const char *level_to_string(LogLevel level)
     }
 }
 
-void logger_log(LogLevel level, const char *fmt, ...)
+/* Formatted "YYYY-mm-dd HH:MM:SS" for the current second, cached per thread. */
+static const char *current_timestamp(void)
 {
-    if (level > current_level) {
-        return;
-    }
+    static _Thread_local time_t cached_second = (time_t)-1;
+    static _Thread_local char cached[20];
 
     time_t now = time(NULL);
+    if (now == cached_second) {
+        return cached;
+    }
+
+#ifndef _WIN32
+    struct tm tm_buf;
+    struct tm *tm_now = localtime_r(&now, &tm_buf);
+#else
     struct tm *tm_now = localtime(&now);
+#endif
 
-    char timestamp[20];
     if (tm_now != NULL) {
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_now);
+        strftime(cached, sizeof(cached), "%Y-%m-%d %H:%M:%S", tm_now);
     } else {
-        timestamp[0] = '\0';
+        cached[0] = '\0';
     }
+    cached_second = now;
+    return cached;
+}
 
-    FILE *out = (level == LOG_LEVEL_ERROR || level == LOG_LEVEL_WARN) ? stderr : stdout;
-
+static void log_sync(FILE *out, const char *timestamp, LogLevel level,
+                     const char *fmt, va_list args)
+{
+#ifndef _WIN32
+    flockfile(out); /* keep prefix and message together across threads */
+#endif
     fprintf(out, "[%s] %-5s: ", timestamp, level_to_string(level));
+    vfprintf(out, fmt, args);
+#ifndef _WIN32
+    funlockfile(out);
+#endif
+}
+
+#ifndef _WIN32
+
+/* ---- Async mode ---------------------------------------------------------------------- */
+
+#define LOG_RING_SIZE      ((size_t)64 * 1024)  /* per thread, power of two */
+#define LOG_LINE_MAX       1024                 /* formatted on the stack up to this */
+#define LOG_RECORD_STDERR  UINT32_C(0x80000000) /* header bit: record goes to stderr */
+
+/*
+ * One thread's ring. 'head' is advanced by the producer only, 'tail' by the
+ * flusher only; both count bytes ever written, so head - tail is the fill.
+ */
+typedef struct LogRing {
+    struct LogRing *next;  /* registry link, set once before publishing */
+    size_t head;
+    size_t tail;
+    char data[LOG_RING_SIZE];
+} LogRing;
+
+static LogRing *ring_registry;      /* lock-free push-only list */
+static int async_running;           /* accessed with __atomic builtins */
+static unsigned long async_generation;
+static pthread_t flusher_thread;
+static int exit_hook_installed;
+
+static _Thread_local LogRing *thread_ring;
+static _Thread_local unsigned long thread_ring_generation;
+
+static LogRing *own_ring(void)
+{
+    unsigned long generation = __atomic_load_n(&async_generation, __ATOMIC_ACQUIRE);
+    if (thread_ring && thread_ring_generation == generation) {
+        return thread_ring;
+    }
+
+    LogRing *ring = malloc(sizeof(*ring));
+    if (!ring) {
+        return NULL;
+    }
+    ring->head = 0;
+    ring->tail = 0;
+
+    ring->next = __atomic_load_n(&ring_registry, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&ring_registry, &ring->next, ring, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        /* ring->next was refreshed by the failed exchange */
+    }
+
+    thread_ring = ring;
+    thread_ring_generation = generation;
+    return ring;
+}
+
+static void ring_copy_in(LogRing *ring, size_t pos, const void *src, size_t len)
+{
+    size_t at = pos & (LOG_RING_SIZE - 1);
+    size_t first = LOG_RING_SIZE - at < len ? LOG_RING_SIZE - at : len;
+    memcpy(ring->data + at, src, first);
+    memcpy(ring->data, (const char *)src + first, len - first);
+}
+
+static void ring_copy_out(const LogRing *ring, size_t pos, void *dst, size_t len)
+{
+    size_t at = pos & (LOG_RING_SIZE - 1);
+    size_t first = LOG_RING_SIZE - at < len ? LOG_RING_SIZE - at : len;
+    memcpy(dst, ring->data + at, first);
+    memcpy((char *)dst + first, ring->data, len - first);
+}
+
+/*
+ * Write every complete record of every ring. A ring's tail only moves once
+ * its records have been flushed to the streams. Returns the bytes consumed.
+ */
+static size_t drain_rings(void)
+{
+    size_t drained = 0;
+
+    for (LogRing *ring = __atomic_load_n(&ring_registry, __ATOMIC_ACQUIRE);
+         ring; ring = ring->next) {
+        size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        size_t tail = ring->tail;
+        bool wrote_err = false;
+        bool wrote_out = false;
+
+        if (tail == head) {
+            continue;
+        }
+
+        while (tail != head) {
+            uint32_t header;
+            ring_copy_out(ring, tail, &header, sizeof(header));
+
+            size_t len = header & ~LOG_RECORD_STDERR;
+            FILE *out = (header & LOG_RECORD_STDERR) ? stderr : stdout;
+            size_t at = (tail + sizeof(header)) & (LOG_RING_SIZE - 1);
+            size_t first = LOG_RING_SIZE - at < len ? LOG_RING_SIZE - at : len;
+
+            fwrite(ring->data + at, 1, first, out);
+            fwrite(ring->data, 1, len - first, out);
+            wrote_err |= out == stderr;
+            wrote_out |= out == stdout;
+
+            tail += sizeof(header) + len;
+            drained += sizeof(header) + len;
+        }
+
+        if (wrote_out) {
+            fflush(stdout);
+        }
+        if (wrote_err) {
+            fflush(stderr);
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    return drained;
+}
+
+static void *flusher_main(void *arg)
+{
+    (void)arg;
+    const struct timespec idle = { 0, 1000000 }; /* 1 ms */
+
+    while (__atomic_load_n(&async_running, __ATOMIC_ACQUIRE)) {
+        if (drain_rings() == 0) {
+            nanosleep(&idle, NULL);
+        }
+    }
+    drain_rings(); /* whatever was queued before the stop */
+    return NULL;
+}
+
+/* Queue one formatted message. Returns -1 if it must be written synchronously. */
+static int log_async(LogLevel level, const char *timestamp, const char *fmt, va_list args)
+{
+    LogRing *ring = own_ring();
+    if (!ring) {
+        return -1;
+    }
+
+    char line[LOG_LINE_MAX];
+    int prefix = snprintf(line, sizeof(line), "[%s] %-5s: ", timestamp, level_to_string(level));
+    va_list copy;
+    va_copy(copy, args);
+    int body = vsnprintf(line + prefix, sizeof(line) - (size_t)prefix, fmt, copy);
+    va_end(copy);
+    if (prefix < 0 || body < 0 || (size_t)(prefix + body) >= sizeof(line)) {
+        /* Too long for a record; rare enough to go through stdio, after what is queued. */
+        while (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) != ring->head &&
+               __atomic_load_n(&async_running, __ATOMIC_ACQUIRE)) {
+            sched_yield();
+        }
+        return -1;
+    }
+
+    uint32_t header = (uint32_t)(prefix + body);
+    size_t need = sizeof(header) + header;
+    if (level <= LOG_LEVEL_WARN) {
+        header |= LOG_RECORD_STDERR;
+    }
+
+    size_t head = ring->head;
+    while (LOG_RING_SIZE - (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) < need) {
+        sched_yield(); /* ring full: let the flusher catch up */
+    }
+
+    ring_copy_in(ring, head, &header, sizeof(header));
+    ring_copy_in(ring, head + sizeof(header), line, header & ~LOG_RECORD_STDERR);
+    __atomic_store_n(&ring->head, head + need, __ATOMIC_RELEASE);
+
+    if (level == LOG_LEVEL_ERROR) {
+        /* Errors must be visible before the caller goes on (or dies). */
+        while (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) != head + need &&
+               __atomic_load_n(&async_running, __ATOMIC_ACQUIRE)) {
+            sched_yield();
+        }
+    }
+    return 0;
+}
+
+/*
+ * Last-chance drain on a fatal signal: raw write(2) of whatever is queued,
+ * whether or not the flusher got to it, then the default action.
+ */
+static void fatal_signal_drain(int sig)
+{
+    for (LogRing *ring = __atomic_load_n(&ring_registry, __ATOMIC_ACQUIRE);
+         ring; ring = ring->next) {
+        size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+        while (tail != head) {
+            uint32_t header;
+            ring_copy_out(ring, tail, &header, sizeof(header));
+
+            size_t len = header & ~LOG_RECORD_STDERR;
+            int fd = (header & LOG_RECORD_STDERR) ? STDERR_FILENO : STDOUT_FILENO;
+            size_t at = (tail + sizeof(header)) & (LOG_RING_SIZE - 1);
+            size_t first = LOG_RING_SIZE - at < len ? LOG_RING_SIZE - at : len;
+
+            if (write(fd, ring->data + at, first) < 0 ||
+                write(fd, ring->data, len - first) < 0) {
+                break;
+            }
+            tail += sizeof(header) + len;
+        }
+    }
+
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void install_fatal_handlers(void)
+{
+    static const int signals[] = { SIGSEGV, SIGBUS, SIGABRT, SIGFPE, SIGINT, SIGTERM };
+
+    for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); ++i) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = fatal_signal_drain;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESETHAND;
+        sigaction(signals[i], &action, NULL);
+    }
+}
+
+int logger_start_async(void)
+{
+    if (__atomic_load_n(&async_running, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    __atomic_store_n(&async_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&flusher_thread, NULL, flusher_main, NULL) != 0) {
+        __atomic_store_n(&async_running, 0, __ATOMIC_RELEASE);
+        return -1;
+    }
+
+    if (!exit_hook_installed) {
+        exit_hook_installed = 1;
+        atexit(logger_stop_async);
+        install_fatal_handlers();
+    }
+    return 0;
+}
+
+void logger_stop_async(void)
+{
+    if (!__atomic_load_n(&async_running, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    __atomic_store_n(&async_running, 0, __ATOMIC_RELEASE);
+    pthread_join(flusher_thread, NULL);
+
+    /* Rings of this generation are dead; threads register fresh ones next time. */
+    __atomic_add_fetch(&async_generation, 1, __ATOMIC_RELEASE);
+    LogRing *ring = __atomic_exchange_n(&ring_registry, NULL, __ATOMIC_ACQ_REL);
+    while (ring) {
+        LogRing *next = ring->next;
+        free(ring);
+        ring = next;
+    }
+}
+
+#else /* _WIN32 */
+
+int logger_start_async(void)
+{
+    return -1;
+}
+
+void logger_stop_async(void)
+{
+}
+
+#endif
+
+void logger_log(LogLevel level, const char *fmt, ...)
+{
+    if (level > current_level) {
+        return;
+    }
+
+    bool timed = __atomic_load_n(&timing_enabled, __ATOMIC_RELAXED) != 0;
+    uint64_t start = timed ? monotonic_ns() : 0;
+    const char *timestamp = current_timestamp();
+    FILE *out = (level == LOG_LEVEL_ERROR || level == LOG_LEVEL_WARN) ? stderr : stdout;
 
     va_list args;
     va_start(args, fmt);
-    vfprintf(out, fmt, args);
+#ifndef _WIN32
+    if (!__atomic_load_n(&async_running, __ATOMIC_ACQUIRE) ||
+        log_async(level, timestamp, fmt, args) != 0) {
+        log_sync(out, timestamp, level, fmt, args);
+    }
+#else
+    log_sync(out, timestamp, level, fmt, args);
+#endif
     va_end(args);
+
+    if (timed) {
+        __atomic_add_fetch(&timed_ns, monotonic_ns() - start, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&timed_messages, 1, __ATOMIC_RELAXED);
+    }
 }
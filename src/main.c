@@ -4,7 +4,7 @@
  File:       main.c
  Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
  Created:    2025-11-29
- Updated:    2025-11-29
+ Updated:    2026-10-14
  License:    MIT License (see LICENSE file for details)
 ==========================================================================================================
 
@@ -19,22 +19,96 @@
       -d, --dir DIR     Target directory (default: current directory)
       -n, --dry-run     Show planned moves without changing the file system
       -v, --verbose     Enable verbose logging
+      -r, --recursive   Also organize files in subdirectories
+      --rules FILE      Classify with the rules in FILE before the built-in table
+      --sniff           Classify files with unknown extensions by content
+      --async-log       Write log output from a background thread
+      --scan-buffer N   Directory read buffer size (e.g. 4M; default 1M)
+      --max-mem N       Memory for work buffered between scanning and moving
+                        (e.g. 256M; default 64M)
+      --backend NAME    Execute backend: serial (default) or uring
+      --queue-depth N   io_uring operations in flight (default 256)
+      --order ORDER     Move order: readdir (default) or inode (by category,
+                        then source inode number)
+      -j, --jobs N      Worker threads (default 1)
+      --journal FILE    Append created directories and moves to FILE
+      --incremental FILE
+                        Keep state in FILE; skip unchanged directories and
+                        only examine new entries
+      --checkpoint FILE Record progress in FILE every few thousand moves
+                        (needs --journal)
+      --resume          Continue the interrupted run recorded in the
+                        --checkpoint file
+      --undo FILE       Revert the runs recorded in journal FILE
+      --export-journal FILE
+                        Print journal FILE as JSON Lines
+      --watch           Keep running and organize files as they arrive
+      --dest CATEGORY=DIR
+                        Use absolute path DIR as CATEGORY's folder (may be on
+                        another file system); repeatable
+      --copy-jobs N     Threads for copies to other file systems and for
+                        hashing (default 4)
+      --dedupe MODE     Replace files identical to the one holding their name:
+                        drop (delete them) or link (hard-link them)
+      --shard I/N       Only handle the entries of shard I of N (0 <= I < N)
+      --max-ops N       Do at most N renames, mkdirs and links per second
+      --max-bandwidth N Copy at most N bytes per second (e.g. 20M)
+      --limits FILE     Take both limits from FILE ("ops N", "bandwidth N");
+                        --watch re-reads it on SIGHUP
+      --ioprio CLASS    I/O priority: idle, or be[:LEVEL] (0-7; Linux only)
+      --sched-idle      Only use otherwise idle CPU time (Linux only)
+      --stats           Print counters and timings to stderr when done
+      --stats-json      Print them as one JSON object on stdout
       -h, --help        Show help message
 
  Notes:
     - A positional DIRECTORY argument overrides the -d/--dir option.
-    - Non-regular files (directories, symlinks, devices) are skipped.
+    - Non-regular files (directories, symlinks, devices) are skipped; with
+      -r, subdirectories are descended into instead (hidden ones excepted).
+    - Sizes accept an optional K, M or G suffix (powers of 1024).
+    - --undo ignores the target directory; the journal records it.
+    - --dry-run is read-only, down to not caching compiled --rules files.
+    - --watch stops on SIGINT/SIGTERM (Linux only).
+    - Compiled --rules files are cached under ~/.cache/file-organizer.
+    - A --dest folder on another file system is filled by copying; each
+      source is unlinked only after its copy is verified and flushed.
+    - --dedupe only looks at files whose name is taken in their category;
+      they must match byte for byte, not just by hash. Undo restores them.
+    - --shard lets N nodes organize one shared tree without coordinating:
+      entries are split by a hash of their name, and collision suffixes
+      include the shard ("photo_s2-1.jpg") so nodes never pick the same one.
+    - --resume does not read the category folders the interrupted run
+      created again; the journal names everything it put there. Without an
+      interrupted run it is an ordinary run.
+    - --max-ops and --max-bandwidth pace moving only (scanning is not
+      paced) and are shared by all --jobs / --copy-jobs workers. --limits
+      overrides both; if it cannot be read again on SIGHUP, the limits in
+      force are kept.
+    - --ioprio takes effect only where the disk's I/O scheduler honours it
+      (e.g. BFQ on local disks); on network file systems, use the limits.
+    - --stats with --watch reports the totals of every batch on exit. The
+      JSON line is printed after all log output, so it is stdout's last line.
 
 ==========================================================================================================
 */
 
+#include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "organizer.h"
+#include "journal.h"
 #include "logger.h"
+#include "rules.h"
+#include "throttle.h"
 
 static void print_usage(const char *progname);
+static int parse_size(const char *text, size_t *out);
+static int is_absolute_path(const char *path);
+static void print_stats(FILE *out, const OrganizerStats *stats);
+static void print_stats_json(FILE *out, const OrganizerStats *stats);
 
 int main(int argc, char **argv)
 {
@@ -42,6 +116,41 @@ int main(int argc, char **argv)
     config.target_dir = ".";  /* default: current directory */
     config.dry_run = false;
     config.verbose = false;
+    config.scan_buffer_size = 0; /* organizer default */
+    config.backend = ORGANIZER_BACKEND_SERIAL;
+    config.queue_depth = 0;      /* organizer default */
+    config.order = ORGANIZER_ORDER_READDIR;
+    config.jobs = 1;
+    config.recursive = false;
+    config.journal_path = NULL;
+    config.state_path = NULL;
+    config.checkpoint_path = NULL;
+    config.resume = false;
+    config.sniff = false;
+    config.rules = NULL;
+    config.stats = NULL;
+    config.destinations = NULL;
+    config.destination_count = 0;
+    config.copy_jobs = 0;        /* organizer default */
+    config.dedupe = ORGANIZER_DEDUPE_OFF;
+    config.shard_index = 0;
+    config.shard_count = 0;      /* no sharding */
+    config.max_mem = 0;          /* organizer default */
+    config.throttle = NULL;      /* unlimited */
+    OrganizerDestination *destinations = NULL;
+    bool async_log = false;
+    bool watch = false;
+    bool show_stats = false;
+    bool show_stats_json = false;
+    const char *undo_path = NULL;
+    const char *export_path = NULL;
+    const char *rules_path = NULL;
+    const char *limits_path = NULL;
+    size_t max_ops = 0;
+    size_t max_bandwidth = 0;
+    ThrottleIoClass io_class = THROTTLE_IO_DEFAULT;
+    unsigned io_level = 0;
+    bool sched_idle = false;
 
     for (int i = 1; i < argc; ++i) {
         const char *arg = argv[i];
@@ -53,6 +162,8 @@ int main(int argc, char **argv)
             config.dry_run = true;
         } else if (strcmp(arg, "-v") == 0 || strcmp(arg, "--verbose") == 0) {
             config.verbose = true;
+        } else if (strcmp(arg, "-r") == 0 || strcmp(arg, "--recursive") == 0) {
+            config.recursive = true;
         } else if (strcmp(arg, "-d") == 0 || strcmp(arg, "--dir") == 0) {
             if (i + 1 >= argc) {
                 fprintf(stderr, "Error: missing argument for %s\n", arg);
@@ -60,6 +171,225 @@ int main(int argc, char **argv)
                 return 1;
             }
             config.target_dir = argv[++i];
+        } else if (strcmp(arg, "--journal") == 0 || strcmp(arg, "--undo") == 0 ||
+                   strcmp(arg, "--export-journal") == 0 || strcmp(arg, "--incremental") == 0 ||
+                   strcmp(arg, "--rules") == 0 || strcmp(arg, "--checkpoint") == 0 ||
+                   strcmp(arg, "--limits") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            if (strcmp(arg, "--journal") == 0) {
+                config.journal_path = argv[++i];
+            } else if (strcmp(arg, "--undo") == 0) {
+                undo_path = argv[++i];
+            } else if (strcmp(arg, "--incremental") == 0) {
+                config.state_path = argv[++i];
+            } else if (strcmp(arg, "--rules") == 0) {
+                rules_path = argv[++i];
+            } else if (strcmp(arg, "--checkpoint") == 0) {
+                config.checkpoint_path = argv[++i];
+            } else if (strcmp(arg, "--limits") == 0) {
+                limits_path = argv[++i];
+            } else {
+                export_path = argv[++i];
+            }
+        } else if (strcmp(arg, "--async-log") == 0) {
+            async_log = true;
+        } else if (strcmp(arg, "--sniff") == 0) {
+            config.sniff = true;
+        } else if (strcmp(arg, "--resume") == 0) {
+            config.resume = true;
+        } else if (strcmp(arg, "--watch") == 0) {
+            watch = true;
+        } else if (strcmp(arg, "--sched-idle") == 0) {
+            sched_idle = true;
+        } else if (strcmp(arg, "--stats") == 0) {
+            show_stats = true;
+        } else if (strcmp(arg, "--stats-json") == 0) {
+            show_stats_json = true;
+        } else if (strcmp(arg, "--scan-buffer") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            if (parse_size(argv[++i], &config.scan_buffer_size) != 0) {
+                fprintf(stderr, "Error: invalid size '%s' for %s\n", argv[i], arg);
+                return 1;
+            }
+        } else if (strcmp(arg, "--max-mem") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            if (parse_size(argv[++i], &config.max_mem) != 0 || config.max_mem == 0) {
+                fprintf(stderr, "Error: invalid size '%s' for %s\n", argv[i], arg);
+                return 1;
+            }
+        } else if (strcmp(arg, "--max-ops") == 0 || strcmp(arg, "--max-bandwidth") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            size_t *limit = strcmp(arg, "--max-ops") == 0 ? &max_ops : &max_bandwidth;
+            if (parse_size(argv[++i], limit) != 0 || *limit == 0) {
+                fprintf(stderr, "Error: invalid limit '%s' for %s\n", argv[i], arg);
+                return 1;
+            }
+        } else if (strcmp(arg, "--ioprio") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            const char *spec = argv[++i];
+            if (strcmp(spec, "idle") == 0) {
+                io_class = THROTTLE_IO_IDLE;
+            } else if (strcmp(spec, "be") == 0) {
+                io_class = THROTTLE_IO_BEST_EFFORT;
+                io_level = 4; /* the kernel's default level */
+            } else if (strncmp(spec, "be:", 3) == 0 && spec[3] >= '0' && spec[3] <= '7' &&
+                       spec[4] == '\0') {
+                io_class = THROTTLE_IO_BEST_EFFORT;
+                io_level = (unsigned)(spec[3] - '0');
+            } else {
+                fprintf(stderr, "Error: unknown I/O priority '%s' (idle, be or be:0-7)\n", spec);
+                return 1;
+            }
+        } else if (strcmp(arg, "--backend") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            const char *name = argv[++i];
+            if (strcmp(name, "serial") == 0) {
+                config.backend = ORGANIZER_BACKEND_SERIAL;
+            } else if (strcmp(name, "uring") == 0) {
+                config.backend = ORGANIZER_BACKEND_URING;
+            } else {
+                fprintf(stderr, "Error: unknown backend '%s'\n", name);
+                return 1;
+            }
+        } else if (strcmp(arg, "--order") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            const char *order = argv[++i];
+            if (strcmp(order, "readdir") == 0) {
+                config.order = ORGANIZER_ORDER_READDIR;
+            } else if (strcmp(order, "inode") == 0) {
+                config.order = ORGANIZER_ORDER_INODE;
+            } else {
+                fprintf(stderr, "Error: unknown order '%s' (readdir or inode)\n", order);
+                return 1;
+            }
+        } else if (strcmp(arg, "--queue-depth") == 0) {
+            size_t depth;
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            if (parse_size(argv[++i], &depth) != 0 || depth == 0 || depth > 32768) {
+                fprintf(stderr, "Error: invalid queue depth '%s'\n", argv[i]);
+                return 1;
+            }
+            config.queue_depth = (unsigned)depth;
+        } else if (strcmp(arg, "-j") == 0 || strcmp(arg, "--jobs") == 0) {
+            size_t jobs;
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            if (parse_size(argv[++i], &jobs) != 0 || jobs == 0 || jobs > 1024) {
+                fprintf(stderr, "Error: invalid job count '%s'\n", argv[i]);
+                return 1;
+            }
+            config.jobs = (unsigned)jobs;
+        } else if (strcmp(arg, "--copy-jobs") == 0) {
+            size_t jobs;
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            if (parse_size(argv[++i], &jobs) != 0 || jobs == 0 || jobs > 1024) {
+                fprintf(stderr, "Error: invalid job count '%s'\n", argv[i]);
+                return 1;
+            }
+            config.copy_jobs = (unsigned)jobs;
+        } else if (strcmp(arg, "--dedupe") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            const char *mode = argv[++i];
+            if (strcmp(mode, "drop") == 0) {
+                config.dedupe = ORGANIZER_DEDUPE_DROP;
+            } else if (strcmp(mode, "link") == 0) {
+                config.dedupe = ORGANIZER_DEDUPE_LINK;
+            } else {
+                fprintf(stderr, "Error: unknown dedupe mode '%s' (drop or link)\n", mode);
+                return 1;
+            }
+        } else if (strcmp(arg, "--shard") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            const char *spec = argv[++i];
+            char *end;
+            errno = 0;
+            unsigned long index = strtoul(spec, &end, 10);
+            unsigned long count = 0;
+            bool valid = errno == 0 && end != spec && spec[0] != '-' && *end == '/';
+            if (valid) {
+                const char *count_text = end + 1;
+                count = strtoul(count_text, &end, 10);
+                valid = errno == 0 && end != count_text && count_text[0] != '-' && *end == '\0' &&
+                        count >= 1 && count <= 65536 && index < count;
+            }
+            if (!valid) {
+                fprintf(stderr, "Error: invalid shard '%s' (expected I/N with 0 <= I < N)\n", spec);
+                return 1;
+            }
+            config.shard_index = (unsigned)index;
+            config.shard_count = (unsigned)count;
+        } else if (strcmp(arg, "--dest") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: missing argument for %s\n", arg);
+                print_usage(argv[0]);
+                return 1;
+            }
+            char *spec = argv[++i];
+            char *eq = strchr(spec, '=');
+            if (!eq || eq == spec || !is_absolute_path(eq + 1)) {
+                fprintf(stderr, "Error: expected CATEGORY=/absolute/dir for %s, got '%s'\n",
+                        arg, spec);
+                return 1;
+            }
+            if (!destinations) {
+                destinations = malloc((size_t)argc * sizeof(*destinations));
+                if (!destinations) {
+                    fprintf(stderr, "Error: out of memory\n");
+                    return 1;
+                }
+                config.destinations = destinations;
+            }
+            *eq = '\0';
+            destinations[config.destination_count].category = spec;
+            destinations[config.destination_count].path = eq + 1;
+            config.destination_count++;
         } else if (arg[0] == '-') {
             fprintf(stderr, "Error: unknown option '%s'\n", arg);
             print_usage(argv[0]);
@@ -70,17 +400,116 @@ int main(int argc, char **argv)
         }
     }
 
+    if (config.state_path && config.recursive) {
+        fprintf(stderr, "Error: --incremental cannot be combined with --recursive\n");
+        return 1;
+    }
+    if (watch && (config.recursive || config.state_path || undo_path || export_path)) {
+        fprintf(stderr, "Error: --watch cannot be combined with --recursive, --incremental, "
+                        "--undo or --export-journal\n");
+        return 1;
+    }
+    if (config.checkpoint_path && !config.journal_path) {
+        fprintf(stderr, "Error: --checkpoint needs --journal\n");
+        return 1;
+    }
+    if (config.resume && !config.checkpoint_path) {
+        fprintf(stderr, "Error: --resume needs --checkpoint\n");
+        return 1;
+    }
+    if (watch && config.checkpoint_path) {
+        fprintf(stderr, "Error: --watch cannot be combined with --checkpoint\n");
+        return 1;
+    }
+    if ((show_stats || show_stats_json) && (undo_path || export_path)) {
+        fprintf(stderr, "Error: --stats cannot be combined with --undo or --export-journal\n");
+        return 1;
+    }
+
+    /* Before any thread exists, so the logger and every worker inherit it. */
+    if ((io_class != THROTTLE_IO_DEFAULT || sched_idle) &&
+        throttle_lower_priority(io_class, io_level, sched_idle) != 0) {
+        fprintf(stderr, "Warning: cannot lower priority: %s\n", strerror(errno));
+    }
+
     if (config.verbose) {
         logger_set_level(LOG_LEVEL_DEBUG);
     } else {
         logger_set_level(LOG_LEVEL_INFO);
     }
 
-    int rc = organizer_run(&config);
+    if (async_log && logger_start_async() != 0) {
+        logger_log(LOG_LEVEL_WARN, "Asynchronous logging unavailable; logging synchronously\n");
+    }
+
+    if (export_path) {
+        if (journal_export_jsonl(export_path, stdout) != 0) {
+            fprintf(stderr, "Error: cannot export journal '%s': %s\n",
+                    export_path, strerror(errno));
+            return 1;
+        }
+        return 0;
+    }
+
+    RuleSet rules;
+    if (rules_path && !undo_path) {
+        if (rules_load(&rules, rules_path, !config.dry_run) != 0) {
+            logger_stop_async();
+            return 1;
+        }
+        config.rules = &rules;
+    }
+
+    Throttle throttle;
+    if (max_ops || max_bandwidth || limits_path) {
+        throttle_init(&throttle, max_ops, max_bandwidth);
+        if (limits_path && throttle_load(&throttle, limits_path) != 0) {
+            logger_log(LOG_LEVEL_ERROR, "Cannot read limits file '%s': %s\n",
+                       limits_path, strerror(errno));
+            throttle_destroy(&throttle);
+            if (config.rules) {
+                rules_free(&rules);
+            }
+            logger_stop_async();
+            return 1;
+        }
+        config.throttle = &throttle;
+    }
+
+    OrganizerStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (show_stats || show_stats_json) {
+        config.stats = &stats;
+    }
+
+    int rc;
+    if (undo_path) {
+        rc = organizer_undo(&config, undo_path);
+    } else if (watch) {
+        rc = organizer_watch(&config);
+    } else {
+        rc = organizer_run(&config);
+    }
     if (rc != 0) {
         logger_log(LOG_LEVEL_ERROR, "File organization failed with code %d\n", rc);
     }
 
+    if (config.rules) {
+        rules_free(&rules);
+    }
+    if (config.throttle) {
+        throttle_destroy(config.throttle);
+    }
+
+    free(destinations);
+    logger_stop_async();
+
+    if (show_stats) {
+        print_stats(stderr, &stats);
+    }
+    if (show_stats_json) {
+        print_stats_json(stdout, &stats);
+    }
     return rc;
 }
 
@@ -93,6 +522,132 @@ static void print_usage(const char *progname)
             "  -d, --dir DIR     Target directory (default: current directory)\n"
             "  -n, --dry-run     Show planned moves without changing the file system\n"
             "  -v, --verbose     Enable verbose logging\n"
+            "  -r, --recursive   Also organize files in subdirectories\n"
+            "  --rules FILE      Classify with the rules in FILE before the built-in table\n"
+            "  --sniff           Classify files with unknown extensions by content\n"
+            "  --async-log       Write log output from a background thread\n"
+            "  --scan-buffer N   Directory read buffer size (e.g. 4M; default 1M)\n"
+            "  --max-mem N       Memory for work buffered between scanning and moving\n"
+            "                    (e.g. 256M; default 64M)\n"
+            "  --backend NAME    Execute backend: serial (default) or uring\n"
+            "  --queue-depth N   io_uring operations in flight (default 256)\n"
+            "  --order ORDER     Move order: readdir (default) or inode (by category,\n"
+            "                    then source inode number)\n"
+            "  -j, --jobs N      Worker threads (default 1)\n"
+            "  --journal FILE    Append created directories and moves to FILE\n"
+            "  --incremental FILE\n"
+            "                    Keep state in FILE; skip unchanged directories and\n"
+            "                    only examine new entries\n"
+            "  --checkpoint FILE Record progress in FILE every few thousand moves\n"
+            "                    (needs --journal)\n"
+            "  --resume          Continue the interrupted run recorded in the\n"
+            "                    --checkpoint file\n"
+            "  --undo FILE       Revert the runs recorded in journal FILE\n"
+            "  --export-journal FILE\n"
+            "                    Print journal FILE as JSON Lines\n"
+            "  --watch           Keep running and organize files as they arrive\n"
+            "  --dest CATEGORY=DIR\n"
+            "                    Use absolute path DIR as CATEGORY's folder (may be on\n"
+            "                    another file system); repeatable\n"
+            "  --copy-jobs N     Threads for copies to other file systems and for\n"
+            "                    hashing (default 4)\n"
+            "  --dedupe MODE     Replace files identical to the one holding their name:\n"
+            "                    drop (delete them) or link (hard-link them)\n"
+            "  --shard I/N       Only handle the entries of shard I of N (0 <= I < N)\n"
+            "  --max-ops N       Do at most N renames, mkdirs and links per second\n"
+            "  --max-bandwidth N Copy at most N bytes per second (e.g. 20M)\n"
+            "  --limits FILE     Take both limits from FILE (\"ops N\", \"bandwidth N\");\n"
+            "                    --watch re-reads it on SIGHUP\n"
+            "  --ioprio CLASS    I/O priority: idle, or be[:LEVEL] (0-7; Linux only)\n"
+            "  --sched-idle      Only use otherwise idle CPU time (Linux only)\n"
+            "  --stats           Print counters and timings to stderr when done\n"
+            "  --stats-json      Print them as one JSON object on stdout\n"
             "  -h, --help        Show this help message\n",
             progname);
 }
+
+static int parse_size(const char *text, size_t *out)
+{
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (errno != 0 || end == text || text[0] == '-') {
+        return -1;
+    }
+
+    unsigned shift = 0;
+    switch (*end) {
+    case 'K': case 'k': shift = 10; ++end; break;
+    case 'M': case 'm': shift = 20; ++end; break;
+    case 'G': case 'g': shift = 30; ++end; break;
+    default: break;
+    }
+    if (*end != '\0' || value > ((unsigned long long)SIZE_MAX >> shift)) {
+        return -1;
+    }
+
+    *out = (size_t)(value << shift);
+    return 0;
+}
+
+static int is_absolute_path(const char *path)
+{
+    if (path[0] == '/' || path[0] == '\\') {
+        return 1;
+    }
+    /* Windows drive paths: C:\dir or C:/dir */
+    return ((path[0] >= 'A' && path[0] <= 'Z') || (path[0] >= 'a' && path[0] <= 'z')) &&
+           path[1] == ':' && (path[2] == '/' || path[2] == '\\');
+}
+
+static void print_stats(FILE *out, const OrganizerStats *stats)
+{
+    fprintf(out,
+            "Scanned %llu, skipped %llu, planned %llu, moved %llu, collisions %llu, "
+            "mkdirs %llu, duplicates %llu, errors %llu\n",
+            (unsigned long long)stats->scanned, (unsigned long long)stats->skipped,
+            (unsigned long long)stats->planned, (unsigned long long)stats->moved,
+            (unsigned long long)stats->collisions, (unsigned long long)stats->mkdirs,
+            (unsigned long long)stats->duplicates, (unsigned long long)stats->errors);
+    fprintf(out, "  %-10s %12.3f ms\n", "total", stats->total_ns / 1e6);
+
+    for (int p = 0; p < ORGANIZER_PHASE_COUNT; ++p) {
+        fprintf(out, "  %-10s %12.3f ms\n",
+                organizer_phase_name((OrganizerPhase)p), stats->phase_ns[p] / 1e6);
+    }
+    for (int c = 0; c < ORGANIZER_SYSCALL_COUNT; ++c) {
+        if (stats->syscalls[c] == 0) {
+            continue;
+        }
+        fprintf(out, "  %-10s %12.3f ms %10llu calls %10.2f us/call\n",
+                organizer_syscall_name((OrganizerSyscall)c), stats->syscall_ns[c] / 1e6,
+                (unsigned long long)stats->syscalls[c],
+                stats->syscall_ns[c] / 1e3 / (double)stats->syscalls[c]);
+    }
+}
+
+static void print_stats_json(FILE *out, const OrganizerStats *stats)
+{
+    fprintf(out,
+            "{\"scanned\":%llu,\"skipped\":%llu,\"planned\":%llu,\"moved\":%llu,"
+            "\"collisions\":%llu,\"mkdirs\":%llu,\"duplicates\":%llu,\"errors\":%llu,"
+            "\"total_ns\":%llu",
+            (unsigned long long)stats->scanned, (unsigned long long)stats->skipped,
+            (unsigned long long)stats->planned, (unsigned long long)stats->moved,
+            (unsigned long long)stats->collisions, (unsigned long long)stats->mkdirs,
+            (unsigned long long)stats->duplicates, (unsigned long long)stats->errors,
+            (unsigned long long)stats->total_ns);
+
+    fputs(",\"phase_ns\":{", out);
+    for (int p = 0; p < ORGANIZER_PHASE_COUNT; ++p) {
+        fprintf(out, "%s\"%s\":%llu", p ? "," : "",
+                organizer_phase_name((OrganizerPhase)p), (unsigned long long)stats->phase_ns[p]);
+    }
+    fputs("},\"syscalls\":{", out);
+    for (int c = 0; c < ORGANIZER_SYSCALL_COUNT; ++c) {
+        fprintf(out, "%s\"%s\":{\"calls\":%llu,\"ns\":%llu}", c ? "," : "",
+                organizer_syscall_name((OrganizerSyscall)c),
+                (unsigned long long)stats->syscalls[c], (unsigned long long)stats->syscall_ns[c]);
+    }
+    fputs("}}\n", out);
+}
@@ -0,0 +1,178 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       metadata.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    statx-based metadata fetching for size and age rules.
+
+ Usage:
+    See metadata.h.
+
+ Notes:
+    - A batch is processed in windows of up to 'queue_depth' entries: every
+      statx of the window is submitted at once, so a window costs one
+      io_uring_enter() call instead of one system call per entry.
+    - A field the file system cannot report (missing from stx_mask) fails
+      the request with ENODATA rather than reading as 0.
+
+==========================================================================================================
+*/
+
+#define _GNU_SOURCE /* statx */
+
+#include "metadata.h"
+#include "uring.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#if defined(__linux__) && defined(STATX_SIZE)
+#define METADATA_STATX 1
+
+static unsigned statx_mask(unsigned fields)
+{
+    unsigned mask = 0;
+    if (fields & RULE_FIELD_SIZE) {
+        mask |= STATX_SIZE;
+    }
+    if (fields & RULE_FIELD_MTIME) {
+        mask |= STATX_MTIME;
+    }
+    return mask;
+}
+
+static int from_statx(const struct statx *stx, unsigned fields, RuleMeta *meta)
+{
+    unsigned mask = statx_mask(fields);
+    if ((stx->stx_mask & mask) != mask) {
+        errno = ENODATA;
+        return -1;
+    }
+    meta->size = (uint64_t)stx->stx_size;
+    meta->mtime = (int64_t)stx->stx_mtime.tv_sec;
+    return 0;
+}
+#endif
+
+int metadata_stat(int dir_fd, const char *name, unsigned fields, RuleMeta *meta)
+{
+#ifdef METADATA_STATX
+    struct statx stx;
+    if (statx(dir_fd, name, AT_STATX_DONT_SYNC, statx_mask(fields), &stx) == 0) {
+        return from_statx(&stx, fields, meta);
+    }
+    if (errno != ENOSYS) {
+        return -1;
+    }
+#endif
+    (void)fields;
+    struct stat st;
+    if (fstatat(dir_fd, name, &st, 0) != 0) {
+        return -1;
+    }
+    meta->size = (uint64_t)st.st_size;
+    meta->mtime = (int64_t)st.st_mtime;
+    return 0;
+}
+
+#ifdef METADATA_STATX
+/*
+ * Fetch one window through the ring. On failure the ring is unusable and
+ * the window is left for the synchronous fallback.
+ */
+static int metadata_window(Uring *ring, int dir_fd, MetaRequest *requests, size_t count,
+                           struct statx *buffers, UringCompletion *done)
+{
+    unsigned queued = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (uring_prep_statx(ring, dir_fd, requests[i].name, AT_STATX_DONT_SYNC,
+                             statx_mask(requests[i].fields), &buffers[i], i) == 0) {
+            ++queued;
+        }
+    }
+
+    unsigned reaped = 0;
+    while (reaped < queued) {
+        if (uring_submit_and_wait(ring, queued - reaped) != 0) {
+            return -1;
+        }
+        reaped += uring_reap(ring, done + reaped, queued - reaped);
+    }
+
+    for (unsigned k = 0; k < queued; ++k) {
+        MetaRequest *request = &requests[done[k].user_data];
+        if (done[k].res < 0) {
+            request->status = -1;
+        } else {
+            request->status = from_statx(&buffers[done[k].user_data], request->fields,
+                                         &request->meta);
+        }
+    }
+    return queued == count ? 0 : -1;
+}
+#endif
+
+void metadata_stat_batch(int dir_fd, MetaRequest *requests, size_t count,
+                         unsigned queue_depth)
+{
+    size_t done_count = 0;
+
+#ifdef METADATA_STATX
+    Uring ring;
+    if (count > 1 && uring_open(&ring, queue_depth ? queue_depth : URING_DEFAULT_QUEUE_DEPTH) == 0) {
+        size_t window = uring_space(&ring);
+        struct statx *buffers = malloc(window * sizeof(*buffers));
+        UringCompletion *done = malloc(window * sizeof(*done));
+
+        while (buffers && done && done_count < count) {
+            size_t n = count - done_count < window ? count - done_count : window;
+            if (metadata_window(&ring, dir_fd, requests + done_count, n, buffers, done) != 0) {
+                break; /* the rest of the batch is fetched synchronously */
+            }
+            done_count += n;
+        }
+
+        uring_close(&ring);
+        free(buffers);
+        free(done);
+    }
+#else
+    (void)queue_depth;
+#endif
+
+    for (size_t i = done_count; i < count; ++i) {
+        requests[i].status = metadata_stat(dir_fd, requests[i].name, requests[i].fields,
+                                           &requests[i].meta);
+    }
+}
+
+#else /* _WIN32 */
+
+int metadata_stat(int dir_fd, const char *name, unsigned fields, RuleMeta *meta)
+{
+    (void)dir_fd; (void)name; (void)fields; (void)meta;
+    errno = ENOSYS;
+    return -1;
+}
+
+void metadata_stat_batch(int dir_fd, MetaRequest *requests, size_t count,
+                         unsigned queue_depth)
+{
+    (void)dir_fd; (void)queue_depth;
+    for (size_t i = 0; i < count; ++i) {
+        requests[i].status = -1;
+    }
+}
+
+#endif
@@ -0,0 +1,125 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       name_set.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Implementation of the file name hash set: FNV-1a hashing with linear
+    probing, kept at most half full.
+
+ Usage:
+    See name_set.h.
+
+ Notes:
+    - Full hashes are stored with each entry, so growing the table and
+      rejecting mismatches rarely touch the key strings.
+    - Keys live in the set's arena and are released together.
+
+==========================================================================================================
+*/
+
+#include "name_set.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static size_t hash_name(const char *s)
+{
+    /* FNV-1a */
+    size_t h = (size_t)2166136261u;
+    for (; *s; ++s) {
+        h ^= (unsigned char)*s;
+        h *= (size_t)16777619u;
+    }
+    return h;
+}
+
+void name_set_init(NameSet *set)
+{
+    set->slots = NULL;
+    set->capacity = 0;
+    set->count = 0;
+    arena_init(&set->keys);
+}
+
+void name_set_free(NameSet *set)
+{
+    free(set->slots);
+    arena_free(&set->keys);
+    name_set_init(set);
+}
+
+static NameSetEntry *find_slot(const NameSet *set, const char *name, size_t hash)
+{
+    size_t mask = set->capacity - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        NameSetEntry *slot = &set->slots[i];
+        if (slot->name == NULL ||
+            (slot->hash == hash && strcmp(slot->name, name) == 0)) {
+            return slot;
+        }
+    }
+}
+
+static int grow(NameSet *set)
+{
+    size_t new_capacity = set->capacity ? set->capacity * 2 : 64;
+    NameSetEntry *new_slots = calloc(new_capacity, sizeof(*new_slots));
+    if (!new_slots) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < set->capacity; ++i) {
+        NameSetEntry *old = &set->slots[i];
+        if (!old->name) {
+            continue;
+        }
+        size_t j = old->hash & (new_capacity - 1);
+        while (new_slots[j].name) {
+            j = (j + 1) & (new_capacity - 1);
+        }
+        new_slots[j] = *old;
+    }
+
+    free(set->slots);
+    set->slots = new_slots;
+    set->capacity = new_capacity;
+    return 0;
+}
+
+NameSetEntry *name_set_find(const NameSet *set, const char *name)
+{
+    if (set->capacity == 0) {
+        return NULL;
+    }
+
+    NameSetEntry *slot = find_slot(set, name, hash_name(name));
+    return slot->name ? slot : NULL;
+}
+
+NameSetEntry *name_set_insert(NameSet *set, const char *name)
+{
+    if ((set->count + 1) * 2 > set->capacity && grow(set) != 0) {
+        return NULL;
+    }
+
+    size_t hash = hash_name(name);
+    NameSetEntry *slot = find_slot(set, name, hash);
+    if (slot->name) {
+        return slot;
+    }
+
+    slot->name = arena_strndup(&set->keys, name, strlen(name));
+    if (!slot->name) {
+        return NULL;
+    }
+    slot->hash = hash;
+    slot->next_suffix = 0;
+    set->count++;
+    return slot;
+}
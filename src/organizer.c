@@ -4,7 +4,7 @@
  File:       organizer.c
  Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
  Created:    2025-11-29
- Updated:    2025-11-29
+ Updated:    2026-10-14
  License:    MIT License (see LICENSE file for details)
 ==========================================================================================================
 
@@ -13,6 +13,9 @@
     categorizes regular files by extension, and moves them into category folders
     such as Images, Documents, Audio, Video, Archives, Source, Other, etc.
 
+    Work is split into two phases: organizer_plan() scans the directory once and
+    builds an in-memory move plan, and organizer_execute() applies it.
+
  Usage:
     OrganizerConfig config = { .target_dir = ".", .dry_run = false, .verbose = false };
     int rc = organizer_run(&config);
@@ -21,96 +24,119 @@
     - Only regular files are moved; directories and other special file types
       are skipped.
     - If a file with the same name already exists in the target category,
-      a unique name with a numeric suffix is generated.
+      a unique name with a numeric suffix is generated. Names claimed earlier
+      in the same plan count as taken. Renames never replace a file: one
+      that appeared since the names were read gets the next free name.
+    - Category directories are resolved once per run and kept open; their
+      existing names are read once into a hash set, so collision resolution
+      costs no system calls per file.
+    - Entries are addressed relative to open directory descriptors (fstatat,
+      renameat, mkdirat), and d_type is trusted when the file system fills it.
+      A category is resolved with a single openat(O_DIRECTORY).
+    - Dry runs share the planner with real runs and never mutate anything:
+      a missing category is reported once and then exists only in memory,
+      empty, so the logged names match what a real run would produce.
+    - Directories are read through the batched scanner (getdents64 on Linux).
+    - Names and directory prefixes are interned in arenas (per plan, per name
+      set, per scan) and released in one shot, never one malloc per file.
+    - The execute phase runs serially or, with ORGANIZER_BACKEND_URING, as
+      batched io_uring mkdirat/renameat submissions.
+    - organizer_run() streams: the serial path plans on the calling thread
+      and executes chunks on a second one, through a bounded ring queue; the
+      parallel path works in windows of entries. Chunks and windows start
+      small and grow to a share of config->max_mem, so moves begin at once
+      and buffered work stays under the ceiling however big the directory.
+    - With config->jobs > 1, classification runs in parallel chunks and
+      collision resolution plus moves run in parallel per category.
+    - With config->state_path, a run on an unchanged directory stops after
+      one stat(), and entries earlier runs left in place are not looked at
+      again.
+    - With config->checkpoint_path, organizer_run() flushes the journal and
+      saves a checkpoint every CHECKPOINT_INTERVAL moves (one atomic add per
+      move otherwise). With config->resume, the folders an interrupted run
+      created take their name sets from its journal instead of a readdir,
+      and moves into them use RENAME_NOREPLACE; a name the journal missed
+      makes the folder's names be read from disk after all.
+    - With config->throttle, every mkdir, rename, link and unlink of the
+      execute phase (serial, parallel or queued for io_uring) first takes
+      an op from its budget, and crossdev copies take their bytes; in watch
+      mode SIGHUP re-reads its limits file.
+    - With config->recursive, subdirectories are walked by the work-stealing
+      walker and their files are moved into the top-level categories.
+    - With config->rules, the compiled rule automaton is consulted before
+      the built-in extension table.
+    - With config->sniff, files the extension table cannot place are
+      classified by their first bytes; the serial planner queues them and
+      reads every header in one batch after the scan.
+    - organizer_watch() keeps the category cache warm across inotify
+      batches; names other programs create in a category are added to its
+      name set as they appear.
+    - An OrganizerContext keeps the same cache across calls; each call
+      first fstat()s the categories it knows and re-reads only the name sets
+      of directories whose mtime moved (a change within the same timestamp
+      tick as the end of the previous call goes unnoticed).
+    - config->destinations put categories elsewhere; their absolute path is
+      used with the *at() calls (which then ignore the base descriptor) and
+      recorded in the journal. Renames refused with EXDEV are queued and
+      copied as one crossdev batch at the end of the execute phase.
+    - With config->stats, counters and per-phase / per-syscall timers are
+      accumulated through the cache with relaxed atomic adds; without it
+      no clock is read.
+    - USDT probes (trace.h) mark each entry scanned, classified and given a
+      variant name, and each move issued and completed, for bpftrace or
+      perf; unattached, each is one nop.
 
 ==========================================================================================================
 */
 
+#define _POSIX_C_SOURCE 200809L /* openat/fstatat/renameat/mkdirat, O_DIRECTORY, O_CLOEXEC */
+#define _DEFAULT_SOURCE          /* syscall() for renameat2 */
+
 #include "organizer.h"
+#include "arena.h"
+#include "checkpoint.h"
+#include "classifier.h"
+#include "crossdev.h"
+#include "dedupe.h"
+#include "journal.h"
 #include "logger.h"
+#include "metadata.h"
+#include "name_set.h"
+#include "ring_queue.h"
+#include "rules.h"
+#include "scanner.h"
+#include "sniff.h"
+#include "state.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include "uring.h"
+#include "walker.h"
+#include "watch.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <dirent.h>
+#include <time.h>
 
 #ifndef PATH_MAX
 #define PATH_MAX 4096
 #endif
 
 #ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #else
 #include <direct.h>  /* _mkdir */
 #endif
 
-/* Map file extensions to category directory names. */
-typedef struct {
-    const char *ext;      /* lowercase extension, without dot */
-    const char *category; /* directory name */
-} ExtensionCategory;
-
-static const ExtensionCategory EXTENSION_TABLE[] = {
-    {"jpg",  "Images"},
-    {"jpeg", "Images"},
-    {"png",  "Images"},
-    {"gif",  "Images"},
-    {"bmp",  "Images"},
-    {"tif",  "Images"},
-    {"tiff", "Images"},
-    {"svg",  "Images"},
-
-    {"txt",  "Documents"},
-    {"md",   "Documents"},
-    {"pdf",  "Documents"},
-    {"doc",  "Documents"},
-    {"docx", "Documents"},
-    {"rtf",  "Documents"},
-
-    {"xls",  "Spreadsheets"},
-    {"xlsx", "Spreadsheets"},
-    {"csv",  "Spreadsheets"},
-
-    {"ppt",  "Presentations"},
-    {"pptx", "Presentations"},
-
-    {"mp3",  "Audio"},
-    {"wav",  "Audio"},
-    {"flac", "Audio"},
-    {"aac",  "Audio"},
-    {"ogg",  "Audio"},
-
-    {"mp4",  "Video"},
-    {"mkv",  "Video"},
-    {"avi",  "Video"},
-    {"mov",  "Video"},
-    {"wmv",  "Video"},
-
-    {"zip",  "Archives"},
-    {"rar",  "Archives"},
-    {"7z",   "Archives"},
-    {"tar",  "Archives"},
-    {"gz",   "Archives"},
-
-    {"c",    "Source"},
-    {"h",    "Source"},
-    {"cpp",  "Source"},
-    {"hpp",  "Source"},
-    {"py",   "Source"},
-    {"java", "Source"},
-    {"js",   "Source"},
-    {"ts",   "Source"},
-    {"cs",   "Source"},
-    {"go",   "Source"},
-    {"rb",   "Source"},
-    {"php",  "Source"},
-};
-
-static const char *DEFAULT_CATEGORY = "Other";
-
 static void join_path(char *buffer, size_t bufsize,
                       const char *dir, const char *name)
 {
@@ -131,245 +157,3916 @@ static void join_path(char *buffer, size_t bufsize,
     }
 }
 
-static void to_lowercase(char *s)
+/* ---- Statistics ---------------------------------------------------------------------- */
+
+static const char *const PHASE_NAMES[ORGANIZER_PHASE_COUNT] = {
+    "scan", "classify", "resolve", "execute",
+};
+
+static const char *const SYSCALL_NAMES[ORGANIZER_SYSCALL_COUNT] = {
+    "readdir", "stat", "open", "read", "mkdir", "rename", "uring", "copy", "hash", "log",
+};
+
+const char *organizer_phase_name(OrganizerPhase phase)
 {
-    for (; *s; ++s) {
-        if (*s >= 'A' && *s <= 'Z') {
-            *s = (char)(*s - 'A' + 'a');
-        }
-    }
+    return (unsigned)phase < ORGANIZER_PHASE_COUNT ? PHASE_NAMES[phase] : "?";
 }
 
-static const char *get_extension(const char *name)
+const char *organizer_syscall_name(OrganizerSyscall syscall_class)
 {
-    const char *dot = strrchr(name, '.');
-    if (!dot || dot == name) {
-        return NULL;
-    }
-    return dot + 1;
+    return (unsigned)syscall_class < ORGANIZER_SYSCALL_COUNT ? SYSCALL_NAMES[syscall_class] : "?";
 }
 
-static const char *category_for_extension(const char *ext)
+/* Counters are shared by the workers of a run, so every update is atomic. */
+#define STATS_ADD(stats, field, n) \
+    do { \
+        if (stats) { \
+            __atomic_add_fetch(&(stats)->field, (uint64_t)(n), __ATOMIC_RELAXED); \
+        } \
+    } while (0)
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+#ifndef _WIN32
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Start of a timed interval; reads no clock when stats are off. */
+static uint64_t stats_now(const OrganizerStats *stats)
+{
+    return stats ? monotonic_ns() : 0;
+}
+
+/* Charge the time since 'since' to a phase and return the end, for the next phase. */
+static uint64_t stats_phase(OrganizerStats *stats, OrganizerPhase phase, uint64_t since)
 {
-    if (!ext) {
-        return DEFAULT_CATEGORY;
+    if (!stats) {
+        return 0;
     }
+    uint64_t now = monotonic_ns();
+    STATS_ADD(stats, phase_ns[phase], now - since);
+    return now;
+}
 
-    char tmp[64];
-    size_t len = strlen(ext);
-    if (len == 0 || len >= sizeof(tmp)) {
-        return DEFAULT_CATEGORY;
+/* Account 'calls' system calls of one class that started at 'since'. */
+static void stats_syscalls(OrganizerStats *stats, OrganizerSyscall syscall_class,
+                           uint64_t calls, uint64_t since)
+{
+    if (stats) {
+        STATS_ADD(stats, syscall_ns[syscall_class], monotonic_ns() - since);
+        STATS_ADD(stats, syscalls[syscall_class], calls);
     }
+}
 
-    strcpy(tmp, ext);
-    to_lowercase(tmp);
+/*
+ * Wall time of one public call, plus the logger time spent meanwhile. The
+ * logger's totals are process-wide, so messages other threads write during
+ * the call are charged to it as well.
+ */
+typedef struct {
+    uint64_t start;
+    uint64_t log_messages;
+    uint64_t log_ns;
+} StatsSpan;
 
-    size_t count = sizeof(EXTENSION_TABLE) / sizeof(EXTENSION_TABLE[0]);
-    for (size_t i = 0; i < count; ++i) {
-        if (strcmp(tmp, EXTENSION_TABLE[i].ext) == 0) {
-            return EXTENSION_TABLE[i].category;
-        }
+static void stats_span_begin(OrganizerStats *stats, StatsSpan *span)
+{
+    if (!stats) {
+        return;
     }
+    logger_set_timing(true);
+    logger_timing(&span->log_messages, &span->log_ns);
+    span->start = monotonic_ns();
+}
 
-    return DEFAULT_CATEGORY;
+static void stats_span_end(OrganizerStats *stats, const StatsSpan *span)
+{
+    if (!stats) {
+        return;
+    }
+    uint64_t messages, ns;
+    STATS_ADD(stats, total_ns, monotonic_ns() - span->start);
+    logger_timing(&messages, &ns);
+    STATS_ADD(stats, syscalls[ORGANIZER_SYSCALL_LOG], messages - span->log_messages);
+    STATS_ADD(stats, syscall_ns[ORGANIZER_SYSCALL_LOG], ns - span->log_ns);
 }
 
-static int ensure_directory_exists(const char *base_dir,
-                                   const char *category,
-                                   char *out_path,
-                                   size_t out_size)
+/* Resolution state of a category directory within one run. */
+typedef enum {
+    CATEGORY_UNRESOLVED = 0,
+    CATEGORY_PRESENT,   /* exists as a directory */
+    CATEGORY_MISSING,   /* does not exist yet */
+    CATEGORY_FAILED,    /* unusable (not a directory, mkdir failed, ...) */
+    CATEGORY_CREATING,  /* mkdir submitted to io_uring, not completed yet */
+    CATEGORY_SIMULATED  /* dry run: reported as created, exists only in memory */
+} CategoryState;
+
+typedef struct {
+    const char *name;
+    const char *location; /* 'name', or an absolute external destination */
+    char path[PATH_MAX];
+    CategoryState state;
+    int fd; /* open directory descriptor while PRESENT, otherwise -1 */
+    NameSet names;      /* names on disk plus names claimed by the plan */
+    bool names_loaded;
+    bool reread;        /* names re-read from disk after a destination was taken */
+    int64_t names_stamp; /* directory mtime the names were current at (contexts) */
+    PoolMutex lock;     /* guards state, fd and names while the cache is shared */
+    int watch_wd;       /* inotify watch in watch mode, or -1 */
+} CategoryDir;
+
+/*
+ * Per-run cache of category directories. Each category is stat()ed at most
+ * once, created at most once, and kept open so later lookups inside it can
+ * use the descriptor instead of a path. The target directory itself is kept
+ * open too, so entries are addressed as (descriptor, name) pairs.
+ */
+typedef struct {
+    const char *base_dir;
+    const char *base_sep; /* "/" unless base_dir already ends in a separator */
+    int base_fd;          /* open target directory, or -1 */
+    size_t scan_buffer_size;
+    CategoryDir *dirs;
+    size_t count;
+    size_t capacity;
+    bool shared;          /* categories claimed from several workers at once */
+    Journal *journal;     /* records what the run changes, or NULL */
+    IncrementalState *incremental; /* entries earlier runs left in place, or NULL */
+    Checkpoint *checkpoint; /* progress of the run, with journal, or NULL */
+    const struct ResumeSeeds *resume; /* what the run being resumed did, or NULL */
+    OrganizerStats *stats; /* counters and timers of the run, or NULL */
+    Throttle *throttle;    /* paces metadata operations, or NULL */
+    const OrganizerDestination *destinations; /* categories kept elsewhere */
+    size_t destination_count;
+    unsigned shard_index;  /* config->shard_index / shard_count */
+    unsigned shard_count;
+} CategoryCache;
+
+static int category_cache_open(CategoryCache *cache, const char *base_dir)
 {
-    struct stat st;
+    size_t len = base_dir ? strlen(base_dir) : 0;
 
-    join_path(out_path, out_size, base_dir, category);
+    cache->base_dir = base_dir;
+    cache->base_sep = (len > 0 && (base_dir[len - 1] == '/' || base_dir[len - 1] == '\\'))
+                      ? "" : "/";
+    cache->base_fd = -1;
+    cache->scan_buffer_size = 0;
+    cache->dirs = NULL;
+    cache->count = 0;
+    cache->capacity = 0;
+    cache->shared = false;
+    cache->journal = NULL;
+    cache->incremental = NULL;
+    cache->checkpoint = NULL;
+    cache->resume = NULL;
+    cache->stats = NULL;
+    cache->throttle = NULL;
+    cache->destinations = NULL;
+    cache->destination_count = 0;
+    cache->shard_index = 0;
+    cache->shard_count = 0;
 
-    if (stat(out_path, &st) == 0) {
-        if (S_ISDIR(st.st_mode)) {
-            return 0;
-        }
+    if (!base_dir) {
+        return 1;
+    }
 
+#ifndef _WIN32
+    cache->base_fd = open(base_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (cache->base_fd < 0) {
         logger_log(LOG_LEVEL_ERROR,
-                   "Path exists but is not a directory: %s\n",
-                   out_path);
-        return -1;
+                   "Failed to open directory '%s': %s\n",
+                   base_dir, strerror(errno));
+        return 1;
     }
+#endif
+    return 0;
+}
 
-    /* Try to create the directory. */
-#ifdef _WIN32
-    if (_mkdir(out_path) != 0) {
-        logger_log(LOG_LEVEL_ERROR,
-                   "Failed to create directory '%s': %s\n",
-                   out_path, strerror(errno));
-        return -1;
+/*
+ * Release the cache. Returns non-zero if the journal could not be completed.
+ */
+static int category_cache_free(CategoryCache *cache)
+{
+    int result = 0;
+
+    if (cache->journal) {
+        if (journal_close(cache->journal) != 0) {
+            logger_log(LOG_LEVEL_ERROR, "Failed to write journal: %s\n", strerror(errno));
+            result = 1;
+        }
+        free(cache->journal);
+        cache->journal = NULL;
     }
-#else
-    if (mkdir(out_path, 0755) != 0) {
-        logger_log(LOG_LEVEL_ERROR,
-                   "Failed to create directory '%s': %s\n",
-                   out_path, strerror(errno));
-        return -1;
+#ifndef _WIN32
+    if (cache->base_fd >= 0) {
+        close(cache->base_fd);
+        cache->base_fd = -1;
     }
 #endif
+    for (size_t i = 0; i < cache->count; ++i) {
+#ifndef _WIN32
+        if (cache->dirs[i].fd >= 0) {
+            close(cache->dirs[i].fd);
+        }
+#endif
+        name_set_free(&cache->dirs[i].names);
+        if (cache->shared) {
+            pool_mutex_destroy(&cache->dirs[i].lock);
+        }
+    }
+    free(cache->dirs);
+    cache->dirs = NULL;
+    cache->count = 0;
+    cache->capacity = 0;
+    cache->shared = false;
+    return result;
+}
 
-    logger_log(LOG_LEVEL_INFO, "Created directory: %s\n", out_path);
-    return 0;
+/*
+ * Let several workers claim names in, and create, the same categories. The
+ * cache must not grow afterwards, so every category is resolved first.
+ */
+static void category_cache_share(CategoryCache *cache)
+{
+    if (cache->shared) {
+        return; /* a warm cache shared by an earlier pass */
+    }
+    for (size_t i = 0; i < cache->count; ++i) {
+        pool_mutex_init(&cache->dirs[i].lock);
+    }
+    cache->shared = true;
 }
 
-static int build_unique_destination(const char *category_dir,
-                                    const char *filename,
-                                    char *out_path,
-                                    size_t out_size)
+static void category_dir_lock(const CategoryCache *cache, CategoryDir *cdir)
 {
-    struct stat st;
+    if (cache->shared) {
+        pool_mutex_lock(&cdir->lock);
+    }
+}
 
-    /* First try plain name. */
-    join_path(out_path, out_size, category_dir, filename);
-    if (stat(out_path, &st) != 0) {
-        return 0; /* free */
+static void category_dir_unlock(const CategoryCache *cache, CategoryDir *cdir)
+{
+    if (cache->shared) {
+        pool_mutex_unlock(&cdir->lock);
     }
+}
 
-    /* Split into base name and extension. */
-    char name[PATH_MAX];
-    char ext[PATH_MAX];
+static void category_dir_open(const CategoryCache *cache, CategoryDir *cdir)
+{
+    cdir->state = CATEGORY_PRESENT;
+#ifndef _WIN32
+    /* A missing descriptor is not fatal; lookups fall back to the path. */
+    uint64_t start = stats_now(cache->stats);
+    cdir->fd = openat(cache->base_fd, cdir->location, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_OPEN, 1, start);
+#else
+    (void)cache;
+#endif
+}
 
-    const char *dot = strrchr(filename, '.');
-    if (!dot || dot == filename) {
-        /* No extension. */
-        strncpy(name, filename, sizeof(name));
-        name[sizeof(name) - 1] = '\0';
-        ext[0] = '\0';
-    } else {
-        size_t base_len = (size_t)(dot - filename);
-        if (base_len >= sizeof(name)) {
-            base_len = sizeof(name) - 1;
+/*
+ * Return the cache slot for a category, resolving its on-disk state on
+ * first use. Never modifies the file system. Returns NULL on allocation
+ * failure.
+ */
+static CategoryDir *category_cache_lookup(CategoryCache *cache, const char *category)
+{
+    /* Categories point into the static extension table; pointer identity is enough. */
+    for (size_t i = 0; i < cache->count; ++i) {
+        if (cache->dirs[i].name == category) {
+            return &cache->dirs[i];
         }
-        memcpy(name, filename, base_len);
-        name[base_len] = '\0';
-
-        strncpy(ext, dot, sizeof(ext));
-        ext[sizeof(ext) - 1] = '\0';
     }
 
-    for (int i = 1; i < 10000; ++i) {
-        if (snprintf(out_path, out_size, "%s/%s_%d%s",
-                     category_dir, name, i, ext) >= (int)out_size) {
-            continue; /* truncated; try next */
+    if (cache->count == cache->capacity) {
+        size_t new_capacity = cache->capacity ? cache->capacity * 2 : 16;
+        CategoryDir *new_dirs = realloc(cache->dirs, new_capacity * sizeof(*new_dirs));
+        if (!new_dirs) {
+            logger_log(LOG_LEVEL_ERROR, "Out of memory while caching category '%s'\n", category);
+            return NULL;
         }
+        cache->dirs = new_dirs;
+        cache->capacity = new_capacity;
+    }
 
-        if (stat(out_path, &st) != 0) {
-            return 0; /* found free name */
+    CategoryDir *cdir = &cache->dirs[cache->count++];
+    cdir->name = category;
+    cdir->location = category;
+    cdir->state = CATEGORY_UNRESOLVED;
+    cdir->fd = -1;
+    name_set_init(&cdir->names);
+    cdir->names_loaded = false;
+    cdir->reread = false;
+    cdir->names_stamp = -1;
+    cdir->watch_wd = -1;
+    for (size_t i = 0; i < cache->destination_count; ++i) {
+        if (strcmp(cache->destinations[i].category, category) == 0) {
+            cdir->location = cache->destinations[i].path;
+            break;
         }
     }
+    if (cdir->location != category) {
+        snprintf(cdir->path, sizeof(cdir->path), "%s", cdir->location);
+    } else {
+        join_path(cdir->path, sizeof(cdir->path), cache->base_dir, category);
+    }
 
-    logger_log(LOG_LEVEL_ERROR,
-               "Could not generate unique name for '%s' in '%s'\n",
-               filename, category_dir);
-    return -1;
+#ifndef _WIN32
+    /*
+     * One openat() both tells whether the directory exists and opens it.
+     * An absolute location ignores the base descriptor.
+     */
+    uint64_t start = stats_now(cache->stats);
+    cdir->fd = openat(cache->base_fd, cdir->location, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    int err = cdir->fd < 0 ? errno : 0;
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_OPEN, 1, start);
+    bool exists = err == 0 || err == EACCES; /* unreadable: lookups use the path */
+    bool is_dir = err != ENOTDIR;
+#else
+    struct stat st;
+    uint64_t start = stats_now(cache->stats);
+    int rc = stat(cdir->path, &st);
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_STAT, 1, start);
+    bool exists = rc == 0;
+    bool is_dir = rc != 0 || S_ISDIR(st.st_mode);
+#endif
+    if (!is_dir) {
+        logger_log(LOG_LEVEL_ERROR,
+                   "Path exists but is not a directory: %s\n",
+                   cdir->path);
+        cdir->state = CATEGORY_FAILED;
+        STATS_ADD(cache->stats, errors, 1);
+    } else {
+        cdir->state = exists ? CATEGORY_PRESENT : CATEGORY_MISSING;
+    }
+
+    return cdir;
 }
 
-int organizer_run(const OrganizerConfig *config)
+/*
+ * Resolve every category a run can produce (built-in and rule categories),
+ * so the cache never grows once it is shared between threads.
+ */
+static int category_cache_resolve_all(const OrganizerConfig *config, CategoryCache *cache)
 {
-    if (config == NULL || config->target_dir == NULL) {
-        logger_log(LOG_LEVEL_ERROR, "Invalid configuration\n");
-        return 1;
+    for (size_t i = 0; i < classifier_category_count(); ++i) {
+        if (!category_cache_lookup(cache, classifier_category_at(i))) {
+            return -1;
+        }
+    }
+    for (size_t i = 0; config->rules && i < config->rules->category_count; ++i) {
+        if (!category_cache_lookup(cache, config->rules->categories[i])) {
+            return -1;
+        }
     }
+    return 0;
+}
 
-    const char *base_dir = config->target_dir;
-    struct stat st;
+/*
+ * Make sure a resolved category directory exists, creating it on first
+ * request. Returns 0 if the directory is usable.
+ */
+static int category_dir_ensure(const CategoryCache *cache, CategoryDir *cdir);
 
-    if (stat(base_dir, &st) != 0) {
-        logger_log(LOG_LEVEL_ERROR,
-                   "Cannot access directory '%s': %s\n",
-                   base_dir, strerror(errno));
-        return 1;
+/* mkdir() of 'location' (relative to the target directory, or absolute). */
+static int make_directory(const CategoryCache *cache, const char *location)
+{
+    throttle_ops(cache->throttle, 1);
+    uint64_t start = stats_now(cache->stats);
+#ifdef _WIN32
+    char path[PATH_MAX];
+    if (location[0] == '/' || location[0] == '\\' || (location[0] && location[1] == ':')) {
+        snprintf(path, sizeof(path), "%s", location);
+    } else {
+        join_path(path, sizeof(path), cache->base_dir, location);
     }
+    int rc = _mkdir(path);
+#else
+    int rc = mkdirat(cache->base_fd, location, 0755);
+#endif
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_MKDIR, 1, start);
+    return rc;
+}
 
-    if (!S_ISDIR(st.st_mode)) {
-        logger_log(LOG_LEVEL_ERROR,
-                   "Path is not a directory: '%s'\n",
-                   base_dir);
-        return 1;
+/*
+ * Create the missing parents of a nested category ("Video" for
+ * "Video/Large"), outermost first, so undo removes them innermost first.
+ * A parent that is a category itself is created through its own entry and
+ * learns the child's name, which its name set would otherwise miss.
+ */
+static int category_dir_create_parents(const CategoryCache *cache, const CategoryDir *cdir)
+{
+    const char *name = cdir->name;
+    char parent[PATH_MAX];
+
+    for (const char *slash = strchr(name, '/'); slash; slash = strchr(slash + 1, '/')) {
+        snprintf(parent, sizeof(parent), "%.*s", (int)(slash - name), name);
+        const char *child = slash + 1;
+        size_t child_len = strcspn(child, "/");
+
+        CategoryDir *owner = NULL;
+        for (size_t i = 0; i < cache->count; ++i) {
+            if (cache->dirs[i].location == cache->dirs[i].name &&
+                strcmp(cache->dirs[i].name, parent) == 0) {
+                owner = &cache->dirs[i];
+            }
+        }
+        if (owner) {
+            if (category_dir_ensure(cache, owner) != 0) {
+                return -1;
+            }
+            char component[256]; /* category names are at most 255 bytes */
+            snprintf(component, sizeof(component), "%.*s", (int)child_len, child);
+            category_dir_lock(cache, owner);
+            if (owner->names_loaded && !name_set_find(&owner->names, component)) {
+                name_set_insert(&owner->names, component);
+            }
+            category_dir_unlock(cache, owner);
+            continue;
+        }
+
+        if (make_directory(cache, parent) != 0) {
+            if (errno == EEXIST) {
+                continue;
+            }
+            logger_log(LOG_LEVEL_ERROR, "Failed to create directory '%s%s%s': %s\n",
+                       cache->base_dir, cache->base_sep, parent, strerror(errno));
+            return -1;
+        }
+        STATS_ADD(cache->stats, mkdirs, 1);
+        logger_log(LOG_LEVEL_INFO, "Created directory: %s%s%s\n",
+                   cache->base_dir, cache->base_sep, parent);
+        if (cache->journal) {
+            journal_record_mkdir(cache->journal, parent);
+        }
     }
+    return 0;
+}
 
-    DIR *dir = opendir(base_dir);
-    if (!dir) {
+static int category_dir_create(const CategoryCache *cache, CategoryDir *cdir)
+{
+    int rc = make_directory(cache, cdir->location);
+    if (rc != 0 && errno == ENOENT && cdir->location == cdir->name && strchr(cdir->name, '/')) {
+        rc = category_dir_create_parents(cache, cdir) == 0
+             ? make_directory(cache, cdir->location)
+             : -1;
+    }
+    if (rc != 0 && errno == EEXIST) {
+        /* Another process (a shard, say) created it first; it is theirs to undo. */
+        category_dir_open(cache, cdir);
+        return 0;
+    }
+    if (rc != 0) {
         logger_log(LOG_LEVEL_ERROR,
-                   "Failed to open directory '%s': %s\n",
-                   base_dir, strerror(errno));
-        return 1;
+                   "Failed to create directory '%s': %s\n",
+                   cdir->path, strerror(errno));
+        cdir->state = CATEGORY_FAILED;
+        STATS_ADD(cache->stats, errors, 1);
+        return -1;
     }
 
-    logger_log(LOG_LEVEL_INFO,
-               "Organizing files in '%s'%s\n",
-               base_dir,
-               config->dry_run ? " (dry-run mode)" : "");
+    STATS_ADD(cache->stats, mkdirs, 1);
+    logger_log(LOG_LEVEL_INFO, "Created directory: %s\n", cdir->path);
+    if (cache->journal) {
+        journal_record_mkdir(cache->journal, cdir->location);
+    }
+    category_dir_open(cache, cdir);
+    return 0;
+}
 
-    struct dirent *entry;
-    char src_path[PATH_MAX];
-    char category_dir[PATH_MAX];
-    char dst_path[PATH_MAX];
+/* A category folder nested in the target ("Video/Large"), whose parents it may create. */
+static bool category_dir_nested(const CategoryDir *cdir)
+{
+    return cdir->location == cdir->name && strchr(cdir->name, '/') != NULL;
+}
+
+static int category_dir_ensure(const CategoryCache *cache, CategoryDir *cdir)
+{
     int result = 0;
 
-    while ((entry = readdir(dir)) != NULL) {
-        const char *name = entry->d_name;
+    category_dir_lock(cache, cdir);
+    if (cdir->state == CATEGORY_MISSING) {
+        result = category_dir_create(cache, cdir);
+    } else if (cdir->state != CATEGORY_PRESENT) {
+        result = -1;
+    }
+    category_dir_unlock(cache, cdir);
 
-        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
-            continue;
-        }
+    return result;
+}
+
+/*
+ * Create a missing nested category, and its parents, on the calling thread.
+ * Workers that partition categories between them call this first: creating
+ * it from a worker would touch a parent category another worker owns.
+ */
+static void category_dir_create_nested(const OrganizerConfig *config,
+                                       const CategoryCache *cache, CategoryDir *cdir)
+{
+    if (!config->dry_run && cdir->state == CATEGORY_MISSING && category_dir_nested(cdir)) {
+        category_dir_ensure(cache, cdir); /* a failure marks the category failed */
+    }
+}
 
-        join_path(src_path, sizeof(src_path), base_dir, name);
+/* ---- Resuming ------------------------------------------------------------------------ */
 
-        if (stat(src_path, &st) != 0) {
-            logger_log(LOG_LEVEL_WARN,
-                       "Skipping '%s' (cannot stat: %s)\n",
-                       src_path, strerror(errno));
-            continue;
+/* A category folder an interrupted run created, with every name it put there. */
+typedef struct {
+    const char *location; /* points into the journal */
+    size_t location_len;
+    const char **names;
+    size_t count;
+    size_t capacity;
+} ResumeCategory;
+
+/*
+ * What an interrupted run did, read back from its journal. Only folders it
+ * created are listed: nothing else was in them, so the journal knows their
+ * every name (up to its last flush) and they need not be read again.
+ */
+typedef struct ResumeSeeds {
+    JournalReader journal;
+    ResumeCategory *categories;
+    size_t count;
+    size_t capacity;
+} ResumeSeeds;
+
+static ResumeCategory *resume_find(const ResumeSeeds *seeds, const char *location, size_t len)
+{
+    for (size_t i = 0; i < seeds->count; ++i) {
+        ResumeCategory *category = &seeds->categories[i];
+        if (category->location_len == len && memcmp(category->location, location, len) == 0) {
+            return category;
         }
+    }
+    return NULL;
+}
 
-        if (!S_ISREG(st.st_mode)) {
-            if (config->verbose) {
-                logger_log(LOG_LEVEL_DEBUG,
-                           "Skipping non-regular file: %s\n",
-                           src_path);
-            }
-            continue; /* Only organize regular files */
+static int resume_add_name(ResumeCategory *category, const char *name)
+{
+    if (category->count == category->capacity) {
+        size_t new_capacity = category->capacity ? category->capacity * 2 : 256;
+        const char **new_names = realloc(category->names, new_capacity * sizeof(*new_names));
+        if (!new_names) {
+            return -1;
         }
+        category->names = new_names;
+        category->capacity = new_capacity;
+    }
+    category->names[category->count++] = name;
+    return 0;
+}
+
+/* Note a created folder; a nested one is also a name inside its parent. */
+static int resume_add_category(ResumeSeeds *seeds, const char *location)
+{
+    size_t len = strlen(location);
+    if (resume_find(seeds, location, len)) {
+        return 0;
+    }
 
-        const char *ext = get_extension(name);
-        const char *category = category_for_extension(ext);
+    const char *slash = strrchr(location, '/');
+    ResumeCategory *parent = slash ? resume_find(seeds, location, (size_t)(slash - location))
+                                   : NULL;
+    if (parent && resume_add_name(parent, slash + 1) != 0) {
+        return -1;
+    }
 
-        if (ensure_directory_exists(base_dir, category,
-                                    category_dir,
-                                    sizeof(category_dir)) != 0) {
-            result = 1;
-            continue;
+    if (seeds->count == seeds->capacity) {
+        size_t new_capacity = seeds->capacity ? seeds->capacity * 2 : 16;
+        ResumeCategory *new_categories = realloc(seeds->categories,
+                                                 new_capacity * sizeof(*new_categories));
+        if (!new_categories) {
+            return -1;
         }
+        seeds->categories = new_categories;
+        seeds->capacity = new_capacity;
+    }
+    ResumeCategory *category = &seeds->categories[seeds->count++];
+    category->location = location;
+    category->location_len = len;
+    category->names = NULL;
+    category->count = 0;
+    category->capacity = 0;
+    return 0;
+}
 
-        if (build_unique_destination(category_dir, name,
-                                     dst_path, sizeof(dst_path)) != 0) {
-            result = 1;
+static void resume_seeds_free(ResumeSeeds *seeds)
+{
+    for (size_t i = 0; i < seeds->count; ++i) {
+        free(seeds->categories[i].names);
+    }
+    free(seeds->categories);
+    journal_reader_free(&seeds->journal);
+    seeds->categories = NULL;
+    seeds->count = 0;
+    seeds->capacity = 0;
+}
+
+/*
+ * Read the journal of the run to resume from 'offset', its first RUN
+ * record, which must name 'target' (absolute). Records of other targets
+ * sharing the journal are ignored. Returns 0, or -1 with errno set.
+ */
+static int resume_seeds_load(ResumeSeeds *seeds, const char *journal_path, uint64_t offset,
+                             const char *target)
+{
+    seeds->categories = NULL;
+    seeds->count = 0;
+    seeds->capacity = 0;
+    if (journal_load_from(&seeds->journal, journal_path, offset) != 0) {
+        return -1;
+    }
+
+    const JournalReader *journal = &seeds->journal;
+    if (journal->count == 0 || strcmp(journal->entries[0].base, target) != 0) {
+        resume_seeds_free(seeds);
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (size_t i = 0; i < journal->count; ++i) {
+        const JournalEntry *entry = &journal->entries[i];
+        if (strcmp(entry->base, target) != 0) {
             continue;
         }
 
-        if (config->dry_run) {
-            logger_log(LOG_LEVEL_INFO,
-                       "[DRY-RUN] Move '%s' -> '%s'\n",
-                       src_path, dst_path);
-            continue;
+        int rc = 0;
+        if (entry->type == JOURNAL_RECORD_MKDIR) {
+            rc = resume_add_category(seeds, entry->src);
+        } else if (entry->type != JOURNAL_RECORD_RUN) {
+            /* MOVE and LINK name the new file; DROP the one kept, which is there too. */
+            const char *slash = strrchr(entry->dst, '/');
+            ResumeCategory *category = slash
+                                       ? resume_find(seeds, entry->dst, (size_t)(slash - entry->dst))
+                                       : NULL;
+            rc = category ? resume_add_name(category, slash + 1) : 0;
+        }
+        if (rc != 0) {
+            resume_seeds_free(seeds);
+            errno = ENOMEM;
+            return -1;
         }
+    }
+    return 0;
+}
+
+/* Add every name in a category directory to its name set. */
+static int category_dir_read_names(const CategoryCache *cache, CategoryDir *cdir)
+{
+    DirScanner scanner;
+    uint64_t start = stats_now(cache->stats);
+    int opened = dir_scanner_open(&scanner, cdir->fd, cdir->path, cache->scan_buffer_size);
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_READDIR, 1, start);
+    if (opened != 0) {
+        logger_log(LOG_LEVEL_ERROR,
+                   "Failed to read directory '%s': %s\n",
+                   cdir->path, strerror(errno));
+        cdir->state = CATEGORY_FAILED;
+        STATS_ADD(cache->stats, errors, 1);
+        return -1;
+    }
 
-        if (rename(src_path, dst_path) != 0) {
+    const ScanEntry *batch;
+    long count;
+    int result = 0;
+    while (result == 0) {
+        start = stats_now(cache->stats);
+        count = dir_scanner_next_batch(&scanner, &batch);
+        stats_syscalls(cache->stats, ORGANIZER_SYSCALL_READDIR, 1, start);
+        if (count == 0) {
+            break;
+        }
+        if (count < 0) {
             logger_log(LOG_LEVEL_ERROR,
-                       "Failed to move '%s' -> '%s': %s\n",
-                       src_path, dst_path, strerror(errno));
-            result = 1;
-        } else {
-            logger_log(LOG_LEVEL_INFO,
-                       "Moved '%s' -> '%s'\n",
-                       src_path, dst_path);
+                       "Failed to read directory '%s': %s\n",
+                       cdir->path, strerror(errno));
+            result = -1;
+            break;
+        }
+        for (long i = 0; i < count; ++i) {
+            if (!name_set_insert(&cdir->names, batch[i].name)) {
+                logger_log(LOG_LEVEL_ERROR,
+                           "Out of memory while reading '%s'\n", cdir->path);
+                result = -1;
+                break;
+            }
         }
     }
 
-    closedir(dir);
+    if (result != 0) {
+        cdir->state = CATEGORY_FAILED;
+        STATS_ADD(cache->stats, errors, 1);
+    }
+    dir_scanner_close(&scanner);
     return result;
 }
+
+/*
+ * Load the names already present in a category directory, once. After this
+ * the directory's NameSet is the authority on which names are taken, and it
+ * also absorbs every destination claimed by the plan being built. A folder
+ * the run being resumed created takes its names from that run's journal.
+ */
+static int category_dir_load_names(const CategoryCache *cache, CategoryDir *cdir)
+{
+    if (cdir->names_loaded) {
+        return 0;
+    }
+    cdir->names_loaded = true;
+
+    if (cdir->state == CATEGORY_MISSING) {
+        return 0; /* directory not created yet, so nothing in it can clash */
+    }
+
+    const ResumeCategory *seed = cache->resume
+                                 ? resume_find(cache->resume, cdir->location, strlen(cdir->location))
+                                 : NULL;
+    if (!seed) {
+        return category_dir_read_names(cache, cdir);
+    }
+
+    for (size_t i = 0; i < seed->count; ++i) {
+        if (!name_set_insert(&cdir->names, seed->names[i])) {
+            logger_log(LOG_LEVEL_ERROR, "Out of memory while reading '%s'\n", cdir->path);
+            cdir->state = CATEGORY_FAILED;
+            STATS_ADD(cache->stats, errors, 1);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Pick a name in the category directory that is neither on disk nor already
+ * claimed by this plan, and claim it. Costs no system calls once the
+ * directory's names are loaded; repeated duplicates of one name resume
+ * probing where the previous one stopped. '*out_name' points into the name
+ * set and stays valid until the cache is freed.
+ */
+static int build_unique_destination(const CategoryCache *cache,
+                                    CategoryDir *cdir,
+                                    const char *filename,
+                                    const char **out_name)
+{
+    if (category_dir_load_names(cache, cdir) != 0) {
+        return -1;
+    }
+
+    /* First try plain name. */
+    NameSetEntry *taken = name_set_find(&cdir->names, filename);
+    if (!taken) {
+        NameSetEntry *claimed = name_set_insert(&cdir->names, filename);
+        if (!claimed) {
+            logger_log(LOG_LEVEL_ERROR, "Out of memory while planning '%s'\n", filename);
+            return -1;
+        }
+        *out_name = claimed->name;
+        return 0; /* free */
+    }
+
+    /* Split into base name and extension, without copying either. */
+    const char *dot = strrchr(filename, '.');
+    if (!dot || dot == filename) {
+        dot = filename + strlen(filename); /* no extension */
+    }
+    int base_len = (int)(dot - filename);
+
+    /* A shard only ever claims its own variants; other names are some other shard's. */
+    char candidate[PATH_MAX];
+    for (unsigned i = taken->next_suffix ? taken->next_suffix : 1; i < 10000; ++i) {
+        int len = cache->shard_count > 1
+                  ? snprintf(candidate, sizeof(candidate), "%.*s_s%u-%u%s",
+                             base_len, filename, cache->shard_index, i, dot)
+                  : snprintf(candidate, sizeof(candidate), "%.*s_%u%s",
+                             base_len, filename, i, dot);
+        if (len >= (int)sizeof(candidate)) {
+            continue; /* truncated; try next */
+        }
+
+        if (!name_set_find(&cdir->names, candidate)) {
+            /* Record progress before inserting; insertion may move 'taken'. */
+            taken->next_suffix = i + 1;
+            NameSetEntry *claimed = name_set_insert(&cdir->names, candidate);
+            if (!claimed) {
+                logger_log(LOG_LEVEL_ERROR, "Out of memory while planning '%s'\n", filename);
+                return -1;
+            }
+            STATS_ADD(cache->stats, collisions, 1);
+            TRACE3(collision_resolved, cdir->path, filename, claimed->name);
+            *out_name = claimed->name;
+            return 0; /* found free name */
+        }
+    }
+
+    taken->next_suffix = 10000;
+    logger_log(LOG_LEVEL_ERROR,
+               "Could not generate unique name for '%s' in '%s'\n",
+               filename, cdir->path);
+    return -1;
+}
+
+/*
+ * Append a move. 'src_dir' must already live in the plan's arena (or be a
+ * literal); the names are copied into it. 'collided' tells that 'dst_name'
+ * is a variant because the entry's own name was taken.
+ */
+static int plan_append(OrganizerPlan *plan,
+                       const char *src_dir,
+                       const char *src_name,
+                       size_t src_len,
+                       const char *category,
+                       const char *dst_name,
+                       bool collided,
+                       uint64_t src_ino)
+{
+    if (plan->count == plan->capacity) {
+        size_t new_capacity = plan->capacity ? plan->capacity * 2 : 256;
+        OrganizerMove *new_moves = realloc(plan->moves,
+                                           new_capacity * sizeof(*new_moves));
+        if (!new_moves) {
+            return -1;
+        }
+        plan->moves = new_moves;
+        plan->capacity = new_capacity;
+    }
+
+    OrganizerMove *move = &plan->moves[plan->count];
+    move->src_dir = src_dir;
+    move->src_name = arena_strndup(&plan->strings, src_name, src_len);
+    move->dst_name = arena_strndup(&plan->strings, dst_name, strlen(dst_name));
+    move->category = category;
+    move->collided_with = collided ? move->src_name : NULL;
+    move->src_ino = src_ino;
+
+    if (!move->src_name || !move->dst_name) {
+        return -1;
+    }
+
+    plan->count++;
+    return 0;
+}
+
+void organizer_plan_free(OrganizerPlan *plan)
+{
+    if (plan == NULL) {
+        return;
+    }
+
+    free(plan->moves);
+    arena_free(&plan->strings);
+
+    plan->moves = NULL;
+    plan->count = 0;
+    plan->capacity = 0;
+}
+
+/* Check the target directory; its stat() result is stored in 'st'. */
+static int validate_target_dir(const OrganizerConfig *config, struct stat *st)
+{
+    if (config == NULL || config->target_dir == NULL) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid configuration\n");
+        return 1;
+    }
+
+    const char *base_dir = config->target_dir;
+
+    if (stat(base_dir, st) != 0) {
+        logger_log(LOG_LEVEL_ERROR,
+                   "Cannot access directory '%s': %s\n",
+                   base_dir, strerror(errno));
+        return 1;
+    }
+
+    if (!S_ISDIR(st->st_mode)) {
+        logger_log(LOG_LEVEL_ERROR,
+                   "Path is not a directory: '%s'\n",
+                   base_dir);
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Decide whether a directory entry is a regular file. d_type answers that
+ * without a system call on most Linux/BSD file systems; only unknown types
+ * and symlinks (which are followed, like stat()) need an fstatat().
+ * Returns 1 for a regular file, 0 for anything else, -1 if it cannot be stat()ed.
+ */
+static int entry_is_regular(const CategoryCache *cache, int dir_fd,
+                            const char *prefix, const ScanEntry *entry)
+{
+    if (entry->type == SCAN_TYPE_REGULAR) {
+        return 1;
+    }
+    if (entry->type != SCAN_TYPE_UNKNOWN && entry->type != SCAN_TYPE_SYMLINK) {
+        return 0;
+    }
+
+    struct stat st;
+    uint64_t start = stats_now(cache->stats);
+#ifndef _WIN32
+    (void)prefix;
+    int rc = fstatat(dir_fd, entry->name, &st, 0);
+#else
+    char src_path[PATH_MAX];
+    (void)dir_fd;
+    snprintf(src_path, sizeof(src_path), "%s%s%s%s",
+             cache->base_dir, cache->base_sep, prefix, entry->name);
+    int rc = stat(src_path, &st);
+#endif
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_STAT, 1, start);
+    if (rc != 0) {
+        return -1;
+    }
+    return S_ISREG(st.st_mode) ? 1 : 0;
+}
+
+/*
+ * Classify one scanned entry of the directory open as 'dir_fd', whose path
+ * relative to the target directory is 'prefix' ("" or "a/b/"). Returns its
+ * category, or NULL if the entry is not a regular file (or cannot be
+ * stat()ed) and must be skipped.
+ */
+/* Where a size or age rule finds the entry being classified. */
+typedef struct {
+    const CategoryCache *cache;
+    int dir_fd;
+    const char *prefix;
+    const char *name;
+    const MetaRequest *fetched; /* metadata already fetched in a batch, or NULL */
+    unsigned *deferred;         /* non-NULL: note the fields wanted instead of fetching */
+} EntryMetaProbe;
+
+static int entry_meta(void *ctx, unsigned fields, RuleMeta *meta)
+{
+    const EntryMetaProbe *probe = ctx;
+    if (probe->fetched) {
+        if (probe->fetched->status != 0 || (fields & ~probe->fetched->fields) != 0) {
+            return -1;
+        }
+        *meta = probe->fetched->meta;
+        return 0;
+    }
+    if (probe->deferred) {
+        *probe->deferred = fields;
+        return -1;
+    }
+
+    uint64_t start = stats_now(probe->cache->stats);
+#ifndef _WIN32
+    int rc = metadata_stat(probe->dir_fd, probe->name, fields, meta);
+#else
+    struct stat st;
+    char src_path[PATH_MAX];
+    snprintf(src_path, sizeof(src_path), "%s%s%s%s", probe->cache->base_dir,
+             probe->cache->base_sep, probe->prefix, probe->name);
+    int rc = stat(src_path, &st);
+    if (rc == 0) {
+        meta->size = (uint64_t)st.st_size;
+        meta->mtime = (int64_t)st.st_mtime;
+    }
+#endif
+    stats_syscalls(probe->cache->stats, ORGANIZER_SYSCALL_STAT, 1, start);
+    return rc;
+}
+
+/* Category of a regular file: the rules first, then the extension table. */
+static const char *classify_name(const OrganizerConfig *config, EntryMetaProbe *probe,
+                                 const char *name, size_t name_len)
+{
+    if (config->rules) {
+        const char *category = rules_classify(config->rules, name, name_len, entry_meta, probe);
+        if (category) {
+            return category;
+        }
+    }
+    return classifier_category_for_name(name, name_len);
+}
+
+/*
+ * Classify an entry by name (and, for size and age rules, metadata): NULL
+ * if it is skipped, the default category if nothing places it. With
+ * 'deferred_fields', metadata is not fetched: if the rules want some, its
+ * RuleField mask is stored there and the result must be ignored.
+ */
+static const char *classify_by_name(const OrganizerConfig *config,
+                                    const CategoryCache *cache,
+                                    int dir_fd,
+                                    const char *prefix,
+                                    const ScanEntry *entry,
+                                    unsigned *deferred_fields)
+{
+    const char *base_dir = cache->base_dir;
+    const char *name = entry->name;
+
+    int regular = entry_is_regular(cache, dir_fd, prefix, entry);
+    if (regular < 0) {
+        logger_log(LOG_LEVEL_WARN,
+                   "Skipping '%s%s%s%s' (cannot stat: %s)\n",
+                   base_dir, cache->base_sep, prefix, name, strerror(errno));
+        STATS_ADD(cache->stats, skipped, 1);
+        STATS_ADD(cache->stats, errors, 1);
+        return NULL;
+    }
+
+    if (!regular) {
+        STATS_ADD(cache->stats, skipped, 1);
+        if (config->verbose) {
+            logger_log(LOG_LEVEL_DEBUG,
+                       "Skipping non-regular file: %s%s%s%s\n",
+                       base_dir, cache->base_sep, prefix, name);
+        }
+        return NULL; /* Only organize regular files */
+    }
+
+    EntryMetaProbe probe = { cache, dir_fd, prefix, name, NULL, deferred_fields };
+    return classify_name(config, &probe, name, entry->name_len);
+}
+
+static const char *category_for_header(int len, const unsigned char *header)
+{
+    return len > 0 ? classifier_category_for_header(header, (size_t)len)
+                   : classifier_default_category();
+}
+
+/* Classify an entry, reading its header if the name says nothing. */
+static const char *classify_entry(const OrganizerConfig *config,
+                                  const CategoryCache *cache,
+                                  int dir_fd,
+                                  const char *prefix,
+                                  const ScanEntry *entry)
+{
+    const char *category = classify_by_name(config, cache, dir_fd, prefix, entry, NULL);
+    if (config->sniff && category == classifier_default_category()) {
+        unsigned char header[CLASSIFIER_HEADER_SIZE];
+        uint64_t start = stats_now(cache->stats);
+        int len = sniff_read_header(dir_fd, entry->name, header, sizeof(header));
+        stats_syscalls(cache->stats, ORGANIZER_SYSCALL_READ, 1, start);
+        category = category_for_header(len, header);
+    }
+    return category;
+}
+
+/*
+ * Whether the entry belongs to this process's shard. The name alone decides
+ * (FNV-1a, so every node agrees), which keeps same-named files of different
+ * subdirectories, and so every claim of one destination name, on one shard.
+ */
+static bool shard_owns(const CategoryCache *cache, const char *name, size_t len)
+{
+    if (cache->shard_count <= 1) {
+        return true;
+    }
+
+    uint64_t hash = UINT64_C(14695981039346656037);
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)name[i];
+        hash *= UINT64_C(1099511628211);
+    }
+    return hash % cache->shard_count == cache->shard_index;
+}
+
+/*
+ * Claim a destination in an already resolved category directory and append
+ * the move of 'src_dir' + 'name' (inode 'ino') to the plan. Returns 0 on success, 1 if the entry could not be
+ * planned, -1 on allocation failure.
+ */
+static int plan_claim(const CategoryCache *cache, CategoryDir *cdir,
+                      const char *src_dir, const char *name, size_t name_len,
+                      uint64_t ino, OrganizerPlan *plan)
+{
+    const char *dst_name = NULL;
+
+    TRACE3(entry_classified, src_dir, name, cdir->name);
+    category_dir_lock(cache, cdir);
+    int rc = cdir->state == CATEGORY_FAILED
+             ? -1
+             : build_unique_destination(cache, cdir, name, &dst_name);
+    if (rc == 0 && plan_append(plan, src_dir, name, name_len, cdir->name, dst_name,
+                               strcmp(dst_name, name) != 0, ino) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while planning '%s%s'\n", src_dir, name);
+        rc = -2;
+    }
+    category_dir_unlock(cache, cdir);
+
+    if (rc == 0) {
+        STATS_ADD(cache->stats, planned, 1);
+    } else {
+        STATS_ADD(cache->stats, errors, 1);
+    }
+    return rc == 0 ? 0 : rc == -2 ? -1 : 1;
+}
+
+/*
+ * Entries of the target directory waiting for one batched round of I/O
+ * before they can be classified: header reads for names that did not
+ * classify them (config->sniff) and, with the io_uring backend, the
+ * metadata their size and age rules test ('metadata').
+ */
+typedef struct {
+    SniffRequest *requests;
+    uint64_t *inos;         /* d_ino of each request's entry */
+    size_t count;
+    size_t capacity;
+    MetaRequest *metas;
+    uint64_t *meta_inos;    /* d_ino of each metadata request's entry */
+    size_t meta_count;
+    size_t meta_capacity;
+    bool metadata;          /* metadata rules are deferred here */
+    Arena names;
+} DeferredQueue;
+
+/* Make room for one more entry in a request array and its inode array. */
+static int deferred_reserve(void **items, uint64_t **inos, size_t *capacity, size_t count,
+                            size_t item_size)
+{
+    if (count < *capacity) {
+        return 0;
+    }
+    size_t new_capacity = *capacity ? *capacity * 2 : 64;
+    void *new_items = realloc(*items, new_capacity * item_size);
+    if (!new_items) {
+        return -1;
+    }
+    *items = new_items;
+    uint64_t *new_inos = realloc(*inos, new_capacity * sizeof(*new_inos));
+    if (!new_inos) {
+        return -1;
+    }
+    *inos = new_inos;
+    *capacity = new_capacity;
+    return 0;
+}
+
+static int deferred_push_sniff(DeferredQueue *queue, const char *entry_name, size_t len,
+                               uint64_t ino)
+{
+    if (deferred_reserve((void **)&queue->requests, &queue->inos, &queue->capacity,
+                         queue->count, sizeof(*queue->requests)) != 0) {
+        return -1;
+    }
+    const char *name = arena_strndup(&queue->names, entry_name, len);
+    if (!name) {
+        return -1;
+    }
+    queue->requests[queue->count].name = name;
+    queue->requests[queue->count].len = -1;
+    queue->inos[queue->count] = ino;
+    ++queue->count;
+    return 0;
+}
+
+static int deferred_push_meta(DeferredQueue *queue, const ScanEntry *entry, unsigned fields)
+{
+    if (deferred_reserve((void **)&queue->metas, &queue->meta_inos, &queue->meta_capacity,
+                         queue->meta_count, sizeof(*queue->metas)) != 0) {
+        return -1;
+    }
+    const char *name = arena_strndup(&queue->names, entry->name, entry->name_len);
+    if (!name) {
+        return -1;
+    }
+    MetaRequest *request = &queue->metas[queue->meta_count];
+    request->name = name;
+    request->fields = fields;
+    request->status = -1;
+    queue->meta_inos[queue->meta_count] = entry->ino;
+    ++queue->meta_count;
+    return 0;
+}
+
+/* Release everything queued; the queue stays usable. */
+static void deferred_queue_clear(DeferredQueue *queue)
+{
+    bool metadata = queue->metadata;
+    free(queue->requests);
+    free(queue->inos);
+    free(queue->metas);
+    free(queue->meta_inos);
+    arena_free(&queue->names);
+    memset(queue, 0, sizeof(*queue));
+    queue->metadata = metadata;
+}
+
+/*
+ * Classify one scanned entry and append its move to the plan. In
+ * incremental runs, entries an earlier run left in place are skipped and
+ * entries this run leaves in place are remembered. With 'deferred', entries
+ * that need their header read (or, if the queue takes them, metadata
+ * fetched) are queued there instead of being planned.
+ */
+static int plan_entry(const OrganizerConfig *config,
+                      CategoryCache *cache,
+                      const ScanEntry *entry,
+                      OrganizerPlan *plan,
+                      DeferredQueue *deferred)
+{
+    STATS_ADD(cache->stats, scanned, 1);
+    TRACE3(entry_scanned, "", entry->name, entry->ino);
+    if (!shard_owns(cache, entry->name, entry->name_len) ||
+        (cache->incremental && incremental_skip(cache->incremental, entry))) {
+        STATS_ADD(cache->stats, skipped, 1);
+        return 0;
+    }
+
+    uint64_t start = stats_now(cache->stats);
+    unsigned wanted = 0;
+    const char *category = deferred
+                           ? classify_by_name(config, cache, cache->base_fd, "", entry,
+                                              deferred->metadata ? &wanted : NULL)
+                           : classify_entry(config, cache, cache->base_fd, "", entry);
+    start = stats_phase(cache->stats, ORGANIZER_PHASE_CLASSIFY, start);
+    if (wanted || (deferred && config->sniff && category == classifier_default_category())) {
+        int rc = wanted ? deferred_push_meta(deferred, entry, wanted)
+                        : deferred_push_sniff(deferred, entry->name, entry->name_len, entry->ino);
+        if (rc != 0) {
+            logger_log(LOG_LEVEL_ERROR, "Out of memory while planning '%s'\n", entry->name);
+            return -1;
+        }
+        return 0;
+    }
+    if (!category) {
+        if (cache->incremental && incremental_note_skipped(cache->incremental, entry) != 0) {
+            logger_log(LOG_LEVEL_ERROR, "Out of memory while planning '%s'\n", entry->name);
+            return -1;
+        }
+        return 0;
+    }
+
+    /* Resolved once per category; a missing directory is created at execute time. */
+    CategoryDir *cdir = category_cache_lookup(cache, category);
+    int rc = cdir ? plan_claim(cache, cdir, "", entry->name, entry->name_len, entry->ino, plan) : -1;
+    stats_phase(cache->stats, ORGANIZER_PHASE_RESOLVE, start);
+    return rc;
+}
+
+/*
+ * Fetch the queued metadata in one batch and classify those entries by
+ * their rules; the ones that still land in the default category join the
+ * header reads when sniffing.
+ */
+static int plan_fetched(const OrganizerConfig *config,
+                        CategoryCache *cache,
+                        DeferredQueue *queue,
+                        unsigned depth,
+                        OrganizerPlan *plan)
+{
+    uint64_t start = stats_now(cache->stats);
+    metadata_stat_batch(cache->base_fd, queue->metas, queue->meta_count, depth);
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_STAT, queue->meta_count, start);
+
+    int result = 0;
+    for (size_t i = 0; i < queue->meta_count; ++i) {
+        const MetaRequest *request = &queue->metas[i];
+        size_t len = strlen(request->name);
+        EntryMetaProbe probe = { cache, cache->base_fd, "", request->name, request, NULL };
+        const char *category = classify_name(config, &probe, request->name, len);
+        start = stats_phase(cache->stats, ORGANIZER_PHASE_CLASSIFY, start);
+
+        int rc;
+        if (config->sniff && category == classifier_default_category()) {
+            rc = deferred_push_sniff(queue, request->name, len, queue->meta_inos[i]);
+            if (rc != 0) {
+                logger_log(LOG_LEVEL_ERROR, "Out of memory while planning '%s'\n", request->name);
+                rc = -1;
+            }
+        } else {
+            CategoryDir *cdir = category_cache_lookup(cache, category);
+            rc = cdir ? plan_claim(cache, cdir, "", request->name, len, queue->meta_inos[i], plan)
+                      : -1;
+            start = stats_phase(cache->stats, ORGANIZER_PHASE_RESOLVE, start);
+        }
+        if (rc != 0) {
+            result = 1;
+        }
+        if (rc < 0) {
+            break;
+        }
+    }
+    queue->meta_count = 0;
+    return result;
+}
+
+/*
+ * Do the queued I/O in batches (through io_uring with that backend):
+ * metadata first, then header reads, and plan the entries by what came
+ * back.
+ */
+static int plan_deferred(const OrganizerConfig *config,
+                         CategoryCache *cache,
+                         DeferredQueue *queue,
+                         OrganizerPlan *plan)
+{
+    unsigned depth = 0; /* one file at a time */
+    if (config->backend == ORGANIZER_BACKEND_URING) {
+        depth = config->queue_depth ? config->queue_depth : URING_DEFAULT_QUEUE_DEPTH;
+    }
+    int result = 0;
+    if (queue->meta_count > 0) {
+        result = plan_fetched(config, cache, queue, depth, plan);
+    }
+    if (queue->count == 0) {
+        return result;
+    }
+
+    uint64_t start = stats_now(cache->stats);
+    sniff_read_headers(cache->base_fd, queue->requests, queue->count, depth);
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_READ, queue->count, start);
+    start = stats_phase(cache->stats, ORGANIZER_PHASE_CLASSIFY, start);
+
+    for (size_t i = 0; i < queue->count; ++i) {
+        const SniffRequest *request = &queue->requests[i];
+        CategoryDir *cdir = category_cache_lookup(cache, category_for_header(request->len,
+                                                                             request->header));
+        int rc = cdir ? plan_claim(cache, cdir, "", request->name, strlen(request->name),
+                                   queue->inos[i], plan)
+                      : -1;
+        if (rc != 0) {
+            result = 1;
+        }
+        if (rc < 0) {
+            break;
+        }
+    }
+    queue->count = 0;
+    stats_phase(cache->stats, ORGANIZER_PHASE_RESOLVE, start);
+    return result;
+}
+
+/* ---- Chunked planning --------------------------------------------------------------- */
+
+/* Size of the first chunk a streaming planner hands off, so moves start at once. */
+#define PLAN_FIRST_CHUNK_BYTES ((size_t)16 * 1024)
+
+/*
+ * Receiver of a plan built in chunks: every time the moves (and queued
+ * sniff and metadata requests) grow past 'limit' bytes, 'flush' takes the moves over and
+ * leaves the plan empty. The limit starts small and doubles per chunk up to
+ * 'max_limit', so the first moves happen right away and later chunks are
+ * large enough to amortize a batch.
+ */
+typedef struct PlanSink PlanSink;
+struct PlanSink {
+    int (*flush)(PlanSink *sink, OrganizerPlan *plan); /* non-zero if a move failed */
+    size_t limit;
+    size_t max_limit;
+    size_t bytes;    /* what the current chunk holds */
+    size_t moves;    /* moves of the current chunk counted in 'bytes' */
+    size_t sniffed;  /* sniff requests counted in 'bytes' */
+    size_t fetched;  /* metadata requests counted in 'bytes' */
+};
+
+/* Ceiling derived from config->max_mem. */
+static size_t config_max_mem(const OrganizerConfig *config)
+{
+    return config->max_mem ? config->max_mem : ORGANIZER_DEFAULT_MAX_MEM;
+}
+
+static void plan_sink_init(PlanSink *sink, int (*flush)(PlanSink *, OrganizerPlan *),
+                           size_t max_limit)
+{
+    sink->flush = flush;
+    sink->max_limit = max_limit > PLAN_FIRST_CHUNK_BYTES ? max_limit : PLAN_FIRST_CHUNK_BYTES;
+    sink->limit = PLAN_FIRST_CHUNK_BYTES;
+    sink->bytes = 0;
+    sink->moves = 0;
+    sink->sniffed = 0;
+    sink->fetched = 0;
+}
+
+/* Heap bytes one planned move holds: its slot and its two names. */
+static size_t move_bytes(const OrganizerMove *move)
+{
+    return sizeof(*move) + strlen(move->src_name) + strlen(move->dst_name) + 2;
+}
+
+static int plan_sink_handoff(PlanSink *sink, OrganizerPlan *plan)
+{
+    int result = plan->count > 0 ? sink->flush(sink, plan) : 0;
+    sink->bytes = 0;
+    sink->moves = 0;
+    sink->sniffed = 0;
+    sink->fetched = 0;
+    if (sink->limit < sink->max_limit) {
+        sink->limit = sink->limit * 2 < sink->max_limit ? sink->limit * 2 : sink->max_limit;
+    }
+    return result;
+}
+
+/*
+ * Account for what the planner added since the last call and hand the
+ * chunk off once it is full; queued sniff and metadata requests are
+ * planned first, so they count against the same ceiling.
+ */
+static int plan_sink_offer(const OrganizerConfig *config, CategoryCache *cache,
+                           PlanSink *sink, OrganizerPlan *plan, DeferredQueue *deferred)
+{
+    for (; sink->moves < plan->count; ++sink->moves) {
+        sink->bytes += move_bytes(&plan->moves[sink->moves]);
+    }
+    for (; deferred && sink->sniffed < deferred->count; ++sink->sniffed) {
+        sink->bytes += sizeof(SniffRequest) + sizeof(uint64_t) +
+                       strlen(deferred->requests[sink->sniffed].name) + 1;
+    }
+    for (; deferred && sink->fetched < deferred->meta_count; ++sink->fetched) {
+        sink->bytes += sizeof(MetaRequest) + sizeof(uint64_t) +
+                       strlen(deferred->metas[sink->fetched].name) + 1;
+    }
+    if (sink->bytes < sink->limit) {
+        return 0;
+    }
+
+    int result = 0;
+    if (deferred && (deferred->count > 0 || deferred->meta_count > 0)) {
+        result = plan_deferred(config, cache, deferred, plan);
+        deferred_queue_clear(deferred);
+    }
+    return plan_sink_handoff(sink, plan) | result;
+}
+
+/*
+ * Plan every entry of the target directory into 'plan'. With 'sink', the
+ * plan is handed off in chunks while the scan goes on, and whatever is left
+ * at the end is handed off too.
+ */
+static int plan_directory(const OrganizerConfig *config,
+                          CategoryCache *cache,
+                          OrganizerPlan *plan,
+                          PlanSink *sink)
+{
+    plan->moves = NULL;
+    plan->count = 0;
+    plan->capacity = 0;
+    arena_init(&plan->strings);
+
+    DirScanner scanner;
+    uint64_t start = stats_now(cache->stats);
+    int opened = dir_scanner_open(&scanner, cache->base_fd, cache->base_dir,
+                                  cache->scan_buffer_size);
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_READDIR, 1, start);
+    stats_phase(cache->stats, ORGANIZER_PHASE_SCAN, start);
+    if (opened != 0) {
+        logger_log(LOG_LEVEL_ERROR,
+                   "Failed to open directory '%s': %s\n",
+                   cache->base_dir, strerror(errno));
+        STATS_ADD(cache->stats, errors, 1);
+        return 1;
+    }
+
+    /*
+     * Header reads wait until the scan is done (or a chunk is full) and then
+     * go out as one batch; so do the statx calls of size and age rules when
+     * io_uring can batch them.
+     */
+    DeferredQueue deferred;
+    memset(&deferred, 0, sizeof(deferred));
+#ifdef __linux__
+    deferred.metadata = config->rules && config->rules->fields &&
+                        config->backend == ORGANIZER_BACKEND_URING;
+#endif
+    DeferredQueue *queue = config->sniff || deferred.metadata ? &deferred : NULL;
+
+    const ScanEntry *batch;
+    long count;
+    int result = 0;
+
+    for (;;) {
+        start = stats_now(cache->stats);
+        count = dir_scanner_next_batch(&scanner, &batch);
+        stats_syscalls(cache->stats, ORGANIZER_SYSCALL_READDIR, 1, start);
+        stats_phase(cache->stats, ORGANIZER_PHASE_SCAN, start);
+        if (count == 0) {
+            break;
+        }
+        if (count < 0) {
+            logger_log(LOG_LEVEL_ERROR,
+                       "Failed to read directory '%s': %s\n",
+                       cache->base_dir, strerror(errno));
+            STATS_ADD(cache->stats, errors, 1);
+            result = 1;
+            break;
+        }
+
+        int rc = 0;
+        for (long i = 0; i < count && rc >= 0; ++i) {
+            rc = plan_entry(config, cache, &batch[i], plan, queue);
+            if (rc != 0) {
+                result = 1;
+            }
+            if (rc >= 0 && sink && plan_sink_offer(config, cache, sink, plan, queue) != 0) {
+                result = 1;
+            }
+        }
+        if (rc < 0) {
+            break; /* out of memory */
+        }
+    }
+    dir_scanner_close(&scanner);
+
+    if (count == 0 && (deferred.count > 0 || deferred.meta_count > 0) &&
+        plan_deferred(config, cache, &deferred, plan) != 0) {
+        result = 1;
+    }
+    deferred_queue_clear(&deferred);
+    if (sink && plan_sink_handoff(sink, plan) != 0) {
+        result = 1;
+    }
+    return result;
+}
+
+/*
+ * Streaming run of the target directory: the calling thread scans,
+ * classifies and claims destinations, and hands chunks of moves through a
+ * bounded queue to a second thread that executes them. A full queue stalls
+ * the planner, so at most STREAM_QUEUE_DEPTH chunks wait at any time.
+ */
+#define STREAM_QUEUE_DEPTH 2
+
+typedef struct {
+    PlanSink sink; /* first member: stream_flush() gets the run from it */
+    const OrganizerConfig *config;
+    CategoryCache *cache;
+    RingQueue chunks;  /* OrganizerPlan *, planned and waiting */
+    bool threaded;     /* false: chunks are executed inline */
+    int plan_result;
+    int execute_result;
+} StreamRun;
+
+static int execute_plan(const OrganizerConfig *config, CategoryCache *cache,
+                        const OrganizerPlan *plan);
+
+static int stream_flush(PlanSink *sink, OrganizerPlan *plan)
+{
+    StreamRun *run = (StreamRun *)sink;
+    OrganizerPlan *chunk = run->threaded ? malloc(sizeof(*chunk)) : NULL;
+    int result = 0;
+
+    if (chunk) {
+        *chunk = *plan;
+        ring_queue_push(&run->chunks, chunk); /* only the planner closes the queue */
+    } else {
+        result = execute_plan(run->config, run->cache, plan);
+        organizer_plan_free(plan);
+    }
+
+    plan->moves = NULL;
+    plan->count = 0;
+    plan->capacity = 0;
+    arena_init(&plan->strings);
+    return result;
+}
+
+static void stream_task(void *arg, unsigned worker, unsigned workers)
+{
+    StreamRun *run = arg;
+    (void)workers;
+
+    if (worker == 0) {
+        OrganizerPlan plan;
+        run->plan_result = plan_directory(run->config, run->cache, &plan, &run->sink);
+        organizer_plan_free(&plan);
+        ring_queue_close(&run->chunks);
+    } else if (worker == 1) {
+        void *item;
+        while (ring_queue_pop(&run->chunks, &item)) {
+            OrganizerPlan *chunk = item;
+            if (execute_plan(run->config, run->cache, chunk) != 0) {
+                run->execute_result = 1;
+            }
+            organizer_plan_free(chunk);
+            free(chunk);
+        }
+    }
+}
+
+static int run_streaming(const OrganizerConfig *config, CategoryCache *cache)
+{
+    StreamRun run;
+    memset(&run, 0, sizeof(run));
+    run.config = config;
+    run.cache = cache;
+    /* Room for the queued chunks, the one being planned and the one executing. */
+    plan_sink_init(&run.sink, stream_flush, config_max_mem(config) / (STREAM_QUEUE_DEPTH + 2));
+
+    /* The executor looks categories up while the planner claims names in them. */
+    bool queued = category_cache_resolve_all(config, cache) == 0 &&
+                  ring_queue_init(&run.chunks, STREAM_QUEUE_DEPTH) == 0;
+    ThreadPool *pool = queued ? thread_pool_create(2) : NULL;
+
+    if (pool && thread_pool_size(pool) >= 2) {
+        run.threaded = true;
+        category_cache_share(cache);
+        thread_pool_run(pool, stream_task, &run);
+    } else {
+        OrganizerPlan plan;
+        run.plan_result = plan_directory(config, cache, &plan, &run.sink);
+        organizer_plan_free(&plan);
+    }
+
+    thread_pool_destroy(pool);
+    if (queued) {
+        ring_queue_free(&run.chunks);
+    }
+    return run.plan_result | run.execute_result;
+}
+
+/*
+ * Plan one entry of the target directory known by name (a watch event, a
+ * name handed to organizer_context_run_names()). It is stat()ed first,
+ * since it may be gone already; a missing entry is skipped, not an error.
+ */
+static int plan_named_entry(const OrganizerConfig *config,
+                            CategoryCache *cache,
+                            const char *name,
+                            OrganizerPlan *plan)
+{
+    struct stat st;
+    uint64_t start = stats_now(cache->stats);
+#ifndef _WIN32
+    int rc = fstatat(cache->base_fd, name, &st, 0);
+#else
+    char src_path[PATH_MAX];
+    join_path(src_path, sizeof(src_path), cache->base_dir, name);
+    int rc = stat(src_path, &st);
+#endif
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_STAT, 1, start);
+    if (rc != 0) {
+        if (config->verbose) {
+            logger_log(LOG_LEVEL_DEBUG, "Ignoring '%s%s%s': %s\n",
+                       cache->base_dir, cache->base_sep, name, strerror(errno));
+        }
+        return 0;
+    }
+
+    ScanEntry entry = { name, strlen(name),
+                        S_ISREG(st.st_mode) ? SCAN_TYPE_REGULAR : SCAN_TYPE_OTHER,
+                        (uint64_t)st.st_ino };
+    return plan_entry(config, cache, &entry, plan, NULL);
+}
+
+/*
+ * Path of a move's source relative to the target directory: the bare name
+ * for top-level entries, otherwise 'src_dir' + 'src_name' joined into
+ * 'buffer'. Returns NULL with errno set if the joined path does not fit.
+ */
+static const char *move_source(const OrganizerMove *move, char *buffer, size_t size)
+{
+    if (move->src_dir[0] == '\0') {
+        return move->src_name;
+    }
+    if (snprintf(buffer, size, "%s%s", move->src_dir, move->src_name) >= (int)size) {
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    return buffer;
+}
+
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE (1u << 0)
+#endif
+
+#ifndef _WIN32
+/*
+ * renameat() that fails with EEXIST rather than replace the destination.
+ * Without renameat2() (or its flag) the check is a racy fstatat().
+ */
+static int rename_noreplace(int src_fd, const char *src, int dst_fd, const char *dst)
+{
+#if defined(__linux__) && defined(SYS_renameat2)
+    if (syscall(SYS_renameat2, src_fd, src, dst_fd, dst, RENAME_NOREPLACE) == 0) {
+        return 0;
+    }
+    if (errno != ENOSYS && errno != EINVAL) {
+        return -1;
+    }
+#endif
+    struct stat st;
+    if (fstatat(dst_fd, dst, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    return renameat(src_fd, src, dst_fd, dst);
+}
+#endif
+
+/*
+ * Rename one planned entry into its category directory, relative to the
+ * cached descriptors. An existing destination is refused instead of
+ * replaced: the name set may be older than the directory (a journal seed,
+ * a watch session, a context). Returns 0 on success, -1 with errno set.
+ */
+static int move_entry(const CategoryCache *cache, const CategoryDir *cdir,
+                      const OrganizerMove *move)
+{
+    char relative[PATH_MAX];
+    const char *src_name = move_source(move, relative, sizeof(relative));
+    if (!src_name) {
+        return -1;
+    }
+
+    throttle_ops(cache->throttle, 1);
+    TRACE4(move_issued, move->src_dir, move->src_name, cdir->path, move->dst_name);
+    uint64_t start = stats_now(cache->stats);
+    int rc;
+#ifndef _WIN32
+    if (cache->base_fd >= 0 && cdir->fd >= 0) {
+        rc = rename_noreplace(cache->base_fd, src_name, cdir->fd, move->dst_name);
+        stats_syscalls(cache->stats, ORGANIZER_SYSCALL_RENAME, 1, start);
+        return rc;
+    }
+#endif
+
+    char src_path[PATH_MAX];
+    char dst_path[PATH_MAX];
+    join_path(src_path, sizeof(src_path), cache->base_dir, src_name);
+    join_path(dst_path, sizeof(dst_path), cdir->path, move->dst_name);
+    rc = rename(src_path, dst_path);
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_RENAME, 1, start);
+    return rc;
+}
+
+/* user_data tag separating mkdir completions from rename completions. */
+#define URING_MKDIR_TAG (UINT64_C(1) << 63)
+
+/*
+ * Count a completed move towards the next checkpoint. Every
+ * CHECKPOINT_INTERVAL moves the journal is flushed, so the checkpoint can
+ * record a size that covers every move it counts.
+ */
+static void checkpoint_progress(const CategoryCache *cache)
+{
+    if (cache->checkpoint && checkpoint_tick(cache->checkpoint) &&
+        journal_flush(cache->journal) == 0) {
+        checkpoint_save(cache->checkpoint, journal_size(cache->journal));
+    }
+}
+
+static void log_move_result(const CategoryCache *cache, const CategoryDir *cdir,
+                            const OrganizerMove *move, int err)
+{
+    TRACE4(move_completed, move->src_dir, move->src_name, move->dst_name, err);
+    if (err != 0) {
+        STATS_ADD(cache->stats, errors, 1);
+        logger_log(LOG_LEVEL_ERROR,
+                   "Failed to move '%s%s%s%s' -> '%s/%s': %s\n",
+                   cache->base_dir, cache->base_sep, move->src_dir, move->src_name,
+                   cdir->path, move->dst_name, strerror(err));
+    } else {
+        STATS_ADD(cache->stats, moved, 1);
+        logger_log(LOG_LEVEL_INFO,
+                   "Moved '%s%s%s%s' -> '%s/%s'\n",
+                   cache->base_dir, cache->base_sep, move->src_dir, move->src_name,
+                   cdir->path, move->dst_name);
+        if (cache->journal) {
+            journal_record_move(cache->journal, move->src_dir, move->src_name,
+                                cdir->location, move->dst_name);
+        }
+        checkpoint_progress(cache);
+    }
+}
+
+/*
+ * A move found its destination taken: by a file an interrupted run moved
+ * after the journal's last flush (names seeded from it), or by another
+ * program since the names were read. Complete the names from disk (once
+ * per category), claim a free one and move there instead. Returns 0 or
+ * the errno of the failure.
+ */
+static int move_reclaimed(const CategoryCache *cache, CategoryDir *cdir,
+                          const OrganizerMove *move)
+{
+    const char *dst_name = NULL;
+
+    category_dir_lock(cache, cdir);
+    int rc = 0;
+    if (!cdir->reread) {
+        cdir->reread = true;
+        rc = category_dir_read_names(cache, cdir);
+    }
+    if (rc == 0) {
+        rc = build_unique_destination(cache, cdir, move->src_name, &dst_name);
+    }
+    category_dir_unlock(cache, cdir);
+
+    OrganizerMove retry = *move;
+    int err = EEXIST;
+    if (rc == 0) {
+        retry.dst_name = dst_name;
+        retry.collided_with = move->src_name;
+        err = move_entry(cache, cdir, &retry) != 0 ? errno : 0;
+    }
+    log_move_result(cache, cdir, &retry, err);
+    return err;
+}
+
+/* Moves rename() refused with EXDEV, copied after the plan's renames. */
+typedef struct {
+    size_t *moves;  /* indices into the plan */
+    size_t count;
+    size_t capacity;
+} CrossDevQueue;
+
+static int crossdev_queue_push(CrossDevQueue *queue, size_t index)
+{
+    if (queue->count == queue->capacity) {
+        size_t new_capacity = queue->capacity ? queue->capacity * 2 : 64;
+        size_t *new_moves = realloc(queue->moves, new_capacity * sizeof(*new_moves));
+        if (!new_moves) {
+            return -1;
+        }
+        queue->moves = new_moves;
+        queue->capacity = new_capacity;
+    }
+    queue->moves[queue->count++] = index;
+    return 0;
+}
+
+/*
+ * Rename one planned entry synchronously and log it. A category on another
+ * file system gets the entry queued for copying instead. Returns non-zero
+ * if the move failed.
+ */
+static int execute_move(const CategoryCache *cache, CategoryDir *cdir,
+                        const OrganizerPlan *plan, size_t index, CrossDevQueue *queue)
+{
+    const OrganizerMove *move = &plan->moves[index];
+    int err = move_entry(cache, cdir, move) != 0 ? errno : 0;
+
+    if (err == EXDEV && crossdev_queue_push(queue, index) == 0) {
+        return 0;
+    }
+    if (err == EEXIST) {
+        return move_reclaimed(cache, cdir, move) != 0;
+    }
+    log_move_result(cache, cdir, move, err);
+    return err != 0;
+}
+
+/*
+ * Move the queued entries by copying them, as one batch: small files are
+ * copied side by side and large ones in parallel chunks. Returns non-zero
+ * if any of them failed.
+ */
+static int execute_cross_device(const OrganizerConfig *config, CategoryCache *cache,
+                                const OrganizerPlan *plan, const CrossDevQueue *queue)
+{
+    CrossDevMove *moves = malloc(queue->count * sizeof(*moves));
+    Arena scratch;
+    arena_init(&scratch);
+    int oom = moves == NULL;
+
+    for (size_t k = 0; !oom && k < queue->count; ++k) {
+        const OrganizerMove *move = &plan->moves[queue->moves[k]];
+        const CategoryDir *cdir = category_cache_lookup(cache, move->category);
+        CrossDevMove *copy = &moves[k];
+
+        copy->src_dir_fd = cache->base_fd;
+        copy->src_name = move->src_dir[0]
+                         ? arena_concat(&scratch, move->src_dir, move->src_name)
+                         : move->src_name;
+        copy->dst_dir_fd = cdir->fd;
+        copy->dst_name = move->dst_name;
+        copy->error = 0;
+        if (cdir->fd < 0) {
+            /* Unreadable category: address it through its location instead. */
+            char relative[PATH_MAX];
+            snprintf(relative, sizeof(relative), "%s/%s", cdir->location, move->dst_name);
+            copy->dst_dir_fd = cache->base_fd;
+            copy->dst_name = arena_strndup(&scratch, relative, strlen(relative));
+        }
+        oom = !copy->src_name || !copy->dst_name;
+        TRACE4(move_issued, move->src_dir, move->src_name, cdir->path, move->dst_name);
+    }
+
+    if (!oom) {
+        logger_log(LOG_LEVEL_DEBUG, "Copying %zu files to other file systems\n", queue->count);
+        uint64_t start = stats_now(cache->stats);
+        crossdev_move_batch(moves, queue->count, config->copy_jobs, config->throttle);
+        stats_syscalls(cache->stats, ORGANIZER_SYSCALL_COPY, queue->count, start);
+    }
+
+    int result = 0;
+    for (size_t k = 0; k < queue->count; ++k) {
+        const OrganizerMove *move = &plan->moves[queue->moves[k]];
+        int err = oom ? ENOMEM : moves[k].error;
+        log_move_result(cache, category_cache_lookup(cache, move->category), move, err);
+        result |= err != 0;
+    }
+
+    free(moves);
+    arena_free(&scratch);
+    return result;
+}
+
+/*
+ * Handle completed io_uring operations. Renames across file systems are
+ * queued on 'queue'. Returns non-zero if any of them failed.
+ */
+static int uring_handle_completions(CategoryCache *cache,
+                                    const OrganizerPlan *plan,
+                                    CrossDevQueue *queue,
+                                    const UringCompletion *done,
+                                    unsigned count)
+{
+    int result = 0;
+
+    for (unsigned i = 0; i < count; ++i) {
+        if (done[i].user_data & URING_MKDIR_TAG) {
+            CategoryDir *cdir = &cache->dirs[done[i].user_data & ~URING_MKDIR_TAG];
+            if (done[i].res == 0 || done[i].res == -EEXIST) {
+                if (done[i].res == 0) {
+                    STATS_ADD(cache->stats, mkdirs, 1);
+                    logger_log(LOG_LEVEL_INFO, "Created directory: %s\n", cdir->path);
+                    if (cache->journal) {
+                        journal_record_mkdir(cache->journal, cdir->location);
+                    }
+                }
+                category_dir_open(cache, cdir);
+            } else {
+                logger_log(LOG_LEVEL_ERROR,
+                           "Failed to create directory '%s': %s\n",
+                           cdir->path, strerror(-done[i].res));
+                cdir->state = CATEGORY_FAILED;
+                STATS_ADD(cache->stats, errors, 1);
+                result = 1;
+            }
+            continue;
+        }
+
+        if (done[i].res == -EXDEV && crossdev_queue_push(queue, done[i].user_data) == 0) {
+            continue;
+        }
+        const OrganizerMove *move = &plan->moves[done[i].user_data];
+        CategoryDir *cdir = category_cache_lookup(cache, move->category);
+        if (done[i].res == -EEXIST) {
+            result |= move_reclaimed(cache, cdir, move) != 0;
+            continue;
+        }
+        log_move_result(cache, cdir, move, -done[i].res);
+        if (done[i].res < 0) {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+/*
+ * Submit what is queued and reap completions. With 'drain' set, wait until
+ * nothing is in flight; otherwise wait until at least one slot is free.
+ */
+static int uring_flush(Uring *ring, CategoryCache *cache,
+                       const OrganizerPlan *plan, CrossDevQueue *queue, bool drain)
+{
+    UringCompletion done[64];
+    int result = 0;
+
+    do {
+        uint64_t start = stats_now(cache->stats);
+        int rc = uring_submit_and_wait(ring, 1);
+        stats_syscalls(cache->stats, ORGANIZER_SYSCALL_URING, 1, start);
+        if (rc != 0) {
+            logger_log(LOG_LEVEL_ERROR, "io_uring submission failed: %s\n",
+                       strerror(errno));
+            return -1;
+        }
+
+        unsigned count;
+        while ((count = uring_reap(ring, done, 64)) > 0) {
+            if (uring_handle_completions(cache, plan, queue, done, count) != 0) {
+                result = 1;
+            }
+        }
+    } while (drain ? ring->inflight > 0 : uring_space(ring) == 0);
+
+    return result;
+}
+
+/*
+ * io_uring execute backend: all missing category directories are created in
+ * one batch, then renames are kept in flight up to the queue depth. Renames
+ * use RENAME_NOREPLACE, so a destination that appeared since planning is
+ * reported instead of overwritten. With a shared cache, other workers may be
+ * creating the same directories, so they are created synchronously under
+ * their locks instead.
+ */
+static int execute_plan_uring(CategoryCache *cache,
+                              const OrganizerPlan *plan,
+                              CrossDevQueue *queue,
+                              Uring *ring,
+                              Arena *scratch)
+{
+    int result = 0;
+    int rc;
+
+    /* Nested categories need their parents first, so they are created synchronously. */
+    for (size_t i = 0; !cache->shared && i < plan->count; ++i) {
+        CategoryDir *cdir = category_cache_lookup(cache, plan->moves[i].category);
+        if (!cdir) {
+            return 1;
+        }
+        if (cdir->state == CATEGORY_MISSING && category_dir_nested(cdir) &&
+            category_dir_ensure(cache, cdir) != 0) {
+            result = 1;
+        }
+    }
+
+    for (size_t i = 0; i < plan->count; ++i) {
+        CategoryDir *cdir = category_cache_lookup(cache, plan->moves[i].category);
+        if (!cdir) {
+            return 1;
+        }
+        if (cache->shared || cdir->state != CATEGORY_MISSING) {
+            continue;
+        }
+
+        if (uring_space(ring) == 0 && (rc = uring_flush(ring, cache, plan, queue, false)) != 0) {
+            result = 1;
+            if (rc < 0) {
+                return 1;
+            }
+        }
+        throttle_ops(cache->throttle, 1);
+        uring_prep_mkdirat(ring, cache->base_fd, cdir->location, 0755,
+                           URING_MKDIR_TAG | (uint64_t)(cdir - cache->dirs));
+        cdir->state = CATEGORY_CREATING;
+    }
+
+    if (ring->inflight > 0 && (rc = uring_flush(ring, cache, plan, queue, true)) != 0) {
+        result = 1;
+        if (rc < 0) {
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < plan->count; ++i) {
+        const OrganizerMove *move = &plan->moves[i];
+        CategoryDir *cdir = category_cache_lookup(cache, move->category);
+
+        if (cache->shared ? category_dir_ensure(cache, cdir) != 0
+                          : cdir->state != CATEGORY_PRESENT) {
+            STATS_ADD(cache->stats, errors, 1);
+            result = 1;
+            continue;
+        }
+
+        if (cdir->fd < 0) {
+            /* No descriptor to submit against; do this one synchronously. */
+            result |= execute_move(cache, cdir, plan, i, queue);
+            continue;
+        }
+
+        if (uring_space(ring) == 0 && (rc = uring_flush(ring, cache, plan, queue, false)) != 0) {
+            result = 1;
+            if (rc < 0) {
+                return 1;
+            }
+        }
+        /* Joined paths must outlive the submission, so they go to 'scratch'. */
+        const char *src_name = move->src_dir[0]
+                               ? arena_concat(scratch, move->src_dir, move->src_name)
+                               : move->src_name;
+        if (!src_name) {
+            logger_log(LOG_LEVEL_ERROR, "Out of memory while moving '%s'\n", move->src_name);
+            STATS_ADD(cache->stats, errors, 1);
+            result = 1;
+            continue;
+        }
+        throttle_ops(cache->throttle, 1);
+        TRACE4(move_issued, move->src_dir, move->src_name, cdir->path, move->dst_name);
+        uring_prep_renameat(ring, cache->base_fd, src_name,
+                            cdir->fd, move->dst_name, RENAME_NOREPLACE, (uint64_t)i);
+    }
+
+    if (ring->inflight > 0 && uring_flush(ring, cache, plan, queue, true) != 0) {
+        result = 1;
+    }
+
+    return result;
+}
+
+static int execute_plan_now(const OrganizerConfig *config,
+                            CategoryCache *cache,
+                            const OrganizerPlan *plan,
+                            CrossDevQueue *queue)
+{
+    const char *base_dir = cache->base_dir;
+    const char *sep = cache->base_sep;
+    int result = 0;
+
+    if (config->backend == ORGANIZER_BACKEND_URING && !config->dry_run) {
+        Uring ring;
+        if (cache->base_fd >= 0 && uring_open(&ring, config->queue_depth) == 0) {
+            Arena scratch;
+            arena_init(&scratch);
+            result = execute_plan_uring(cache, plan, queue, &ring, &scratch);
+            uring_close(&ring);
+            arena_free(&scratch);
+            return result;
+        }
+        logger_log(LOG_LEVEL_WARN,
+                   "io_uring backend unavailable (%s); using serial execution\n",
+                   strerror(errno));
+    }
+
+    for (size_t i = 0; i < plan->count; ++i) {
+        const OrganizerMove *move = &plan->moves[i];
+
+        CategoryDir *cdir = category_cache_lookup(cache, move->category);
+        if (!cdir) {
+            return 1;
+        }
+
+        /* Only the first move into a category pays for the mkdir(). */
+        if (!config->dry_run && category_dir_ensure(cache, cdir) != 0) {
+            STATS_ADD(cache->stats, errors, 1);
+            result = 1;
+            continue;
+        }
+
+        if (config->dry_run) {
+            category_dir_lock(cache, cdir);
+            if (cdir->state == CATEGORY_MISSING) {
+                logger_log(LOG_LEVEL_INFO, "[DRY-RUN] Create directory: %s\n", cdir->path);
+                cdir->state = CATEGORY_SIMULATED;
+            }
+            category_dir_unlock(cache, cdir);
+            logger_log(LOG_LEVEL_INFO,
+                       "[DRY-RUN] Move '%s%s%s%s' -> '%s/%s'\n",
+                       base_dir, sep, move->src_dir, move->src_name,
+                       cdir->path, move->dst_name);
+            continue;
+        }
+
+        if (execute_move(cache, cdir, plan, i, queue) != 0) {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+/* Apply a plan: renames first, then the copies to other file systems. */
+static int execute_moves(const OrganizerConfig *config,
+                         CategoryCache *cache,
+                         const OrganizerPlan *plan)
+{
+    CrossDevQueue queue = { NULL, 0, 0 };
+    int result = execute_plan_now(config, cache, plan, &queue);
+    if (queue.count > 0 && execute_cross_device(config, cache, plan, &queue) != 0) {
+        result = 1;
+    }
+    free(queue.moves);
+    return result;
+}
+
+/* ---- Duplicates ---------------------------------------------------------------------- */
+
+/* Order of moves by destination, to find the move that claimed a name. */
+static int compare_claims(const void *a, const void *b)
+{
+    const OrganizerMove *x = *(const OrganizerMove *const *)a;
+    const OrganizerMove *y = *(const OrganizerMove *const *)b;
+    if (x->category != y->category) {
+        return (uintptr_t)x->category < (uintptr_t)y->category ? -1 : 1;
+    }
+    return strcmp(x->dst_name, y->dst_name);
+}
+
+/*
+ * Where a category's file 'name' is reached from: the category descriptor,
+ * or the target directory plus the category's location when the category
+ * has none. Returns the name to use with '*dir_fd', or NULL on allocation
+ * failure.
+ */
+static const char *category_file(const CategoryCache *cache, CategoryDir *cdir,
+                                 const char *name, Arena *scratch, int *dir_fd)
+{
+    category_dir_lock(cache, cdir);
+    *dir_fd = cdir->fd;
+    category_dir_unlock(cache, cdir);
+    if (*dir_fd >= 0) {
+        return name;
+    }
+
+    *dir_fd = cache->base_fd;
+    char relative[PATH_MAX];
+    snprintf(relative, sizeof(relative), "%s/%s", cdir->location, name);
+    return arena_strndup(scratch, relative, strlen(relative));
+}
+
+/*
+ * Replace one identical duplicate by the file already holding its name:
+ * delete it, after hard-linking its planned name to that file with
+ * ORGANIZER_DEDUPE_LINK. The kept file must still be the one compared.
+ * Returns 0 on success, 1 if the entry should be moved after all, -1 if
+ * it failed (logged).
+ */
+static int replace_duplicate(const OrganizerConfig *config, CategoryCache *cache,
+                             const OrganizerMove *move, const DedupePair *pair,
+                             Arena *scratch)
+{
+    CategoryDir *cdir = category_cache_lookup(cache, move->category);
+    bool link = config->dedupe == ORGANIZER_DEDUPE_LINK;
+
+    if (config->dry_run) {
+        STATS_ADD(cache->stats, duplicates, 1);
+        logger_log(LOG_LEVEL_INFO,
+                   "[DRY-RUN] %s duplicate '%s%s%s%s'%s%s%s%s (identical to '%s/%s')\n",
+                   link ? "Link" : "Drop",
+                   cache->base_dir, cache->base_sep, move->src_dir, move->src_name,
+                   link ? " -> '" : "", link ? cdir->path : "", link ? "/" : "",
+                   link ? move->dst_name : "", cdir->path, move->collided_with);
+        return 0;
+    }
+
+    int dir_fd;
+    const char *kept = category_file(cache, cdir, move->collided_with, scratch, &dir_fd);
+    const char *linked = link ? category_file(cache, cdir, move->dst_name, scratch, &dir_fd)
+                              : NULL;
+    const char *src_name = move->src_dir[0]
+                           ? arena_concat(scratch, move->src_dir, move->src_name)
+                           : move->src_name;
+    if (!kept || !src_name || (link && !linked)) {
+        return 1;
+    }
+
+#ifndef _WIN32
+    struct stat st;
+    if (fstatat(dir_fd, kept, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISREG(st.st_mode) ||
+        (uint64_t)st.st_size != pair->kept_size ||
+        (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec != pair->kept_mtime_ns) {
+        return 1; /* the kept file changed or never arrived */
+    }
+    throttle_ops(cache->throttle, link ? 2 : 1);
+    if (link && linkat(dir_fd, kept, dir_fd, linked, 0) != 0) {
+        return 1; /* no hard links here (or over the limit); an ordinary move will do */
+    }
+
+    if (unlinkat(cache->base_fd, src_name, 0) != 0) {
+        int err = errno;
+        if (link) {
+            unlinkat(dir_fd, linked, 0);
+        }
+        STATS_ADD(cache->stats, errors, 1);
+        logger_log(LOG_LEVEL_ERROR, "Failed to remove duplicate '%s%s%s%s': %s\n",
+                   cache->base_dir, cache->base_sep, move->src_dir, move->src_name,
+                   strerror(err));
+        return -1;
+    }
+#else
+    (void)pair;
+    return 1;
+#endif
+
+    STATS_ADD(cache->stats, duplicates, 1);
+    if (link) {
+        logger_log(LOG_LEVEL_INFO, "Linked duplicate '%s%s%s%s' -> '%s/%s' (identical to '%s/%s')\n",
+                   cache->base_dir, cache->base_sep, move->src_dir, move->src_name,
+                   cdir->path, move->dst_name, cdir->path, move->collided_with);
+    } else {
+        logger_log(LOG_LEVEL_INFO, "Dropped duplicate '%s%s%s%s' (identical to '%s/%s')\n",
+                   cache->base_dir, cache->base_sep, move->src_dir, move->src_name,
+                   cdir->path, move->collided_with);
+    }
+    if (cache->journal) {
+        journal_record_duplicate(cache->journal, link ? JOURNAL_RECORD_LINK : JOURNAL_RECORD_DROP,
+                                 move->src_dir, move->src_name, cdir->location,
+                                 link ? move->dst_name : move->collided_with);
+    }
+    checkpoint_progress(cache);
+    return 0;
+}
+
+/*
+ * Execute a plan with config->dedupe. Every move that collided is compared
+ * with the file holding its name: the category's file on disk, or the
+ * source of the move that claimed the name earlier in this plan. The plan
+ * is executed without the identical ones, which are then dropped (or
+ * linked) once the files they duplicate are in place; any that cannot be
+ * are moved after all.
+ */
+static int execute_deduplicated(const OrganizerConfig *config,
+                                CategoryCache *cache,
+                                const OrganizerPlan *plan)
+{
+    size_t candidates = 0;
+    for (size_t i = 0; i < plan->count; ++i) {
+        candidates += plan->moves[i].collided_with != NULL;
+    }
+    if (candidates == 0) {
+        return execute_moves(config, cache, plan);
+    }
+
+    const OrganizerMove **claims = malloc(plan->count * sizeof(*claims));
+    DedupePair *pairs = malloc(candidates * sizeof(*pairs));
+    size_t *indices = malloc(candidates * sizeof(*indices));
+    OrganizerPlan rest = { malloc(plan->count * sizeof(*rest.moves)), 0, plan->count, { 0 } };
+    Arena scratch;
+    arena_init(&scratch);
+    arena_init(&rest.strings);
+    int result = 0;
+
+    bool ok = claims && pairs && indices && rest.moves;
+    size_t claim_count = 0;
+    for (size_t i = 0; ok && i < plan->count; ++i) {
+        if (!plan->moves[i].collided_with) {
+            claims[claim_count++] = &plan->moves[i];
+        }
+    }
+    if (ok) {
+        qsort(claims, claim_count, sizeof(*claims), compare_claims);
+    }
+
+    size_t pair_count = 0;
+    for (size_t i = 0; ok && i < plan->count; ++i) {
+        const OrganizerMove *move = &plan->moves[i];
+        if (!move->collided_with) {
+            continue;
+        }
+
+        /* The name is held either by a move of this plan or by a file on disk. */
+        OrganizerMove key = *move;
+        key.dst_name = move->collided_with;
+        const OrganizerMove *probe = &key;
+        const OrganizerMove **claim = bsearch(&probe, claims, claim_count, sizeof(*claims),
+                                              compare_claims);
+        DedupePair *pair = &pairs[pair_count];
+        if (claim) {
+            pair->kept_dir_fd = cache->base_fd;
+            pair->kept_name = (*claim)->src_dir[0]
+                              ? arena_concat(&scratch, (*claim)->src_dir, (*claim)->src_name)
+                              : (*claim)->src_name;
+        } else {
+            pair->kept_name = category_file(cache, category_cache_lookup(cache, move->category),
+                                            move->collided_with, &scratch, &pair->kept_dir_fd);
+        }
+        pair->dir_fd = cache->base_fd;
+        pair->name = move->src_dir[0] ? arena_concat(&scratch, move->src_dir, move->src_name)
+                                      : move->src_name;
+        ok = pair->kept_name && pair->name;
+        indices[pair_count++] = i;
+    }
+
+    if (!ok) {
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while looking for duplicates\n");
+        free(claims);
+        free(pairs);
+        free(indices);
+        free(rest.moves);
+        arena_free(&scratch);
+        return execute_moves(config, cache, plan) | 1;
+    }
+
+    uint64_t start = stats_now(cache->stats);
+    dedupe_compare_batch(pairs, pair_count, config->copy_jobs);
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_HASH, pair_count, start);
+
+    /* Everything but the duplicates goes first, so the files they match are in place. */
+    size_t k = 0;
+    for (size_t i = 0; i < plan->count; ++i) {
+        if (k < pair_count && indices[k] == i) {
+            if (pairs[k++].result == DEDUPE_IDENTICAL) {
+                continue;
+            }
+        }
+        rest.moves[rest.count++] = plan->moves[i];
+    }
+    if (rest.count > 0 && execute_moves(config, cache, &rest) != 0) {
+        result = 1;
+    }
+
+    rest.count = 0;
+    for (k = 0; k < pair_count; ++k) {
+        if (pairs[k].result != DEDUPE_IDENTICAL) {
+            continue;
+        }
+        const OrganizerMove *move = &plan->moves[indices[k]];
+        int rc = replace_duplicate(config, cache, move, &pairs[k], &scratch);
+        if (rc > 0) {
+            rest.moves[rest.count++] = *move;
+        } else if (rc < 0) {
+            result = 1;
+        }
+    }
+    if (rest.count > 0 && execute_moves(config, cache, &rest) != 0) {
+        result = 1;
+    }
+
+    free(claims);
+    free(pairs);
+    free(indices);
+    free(rest.moves);
+    arena_free(&scratch);
+    return result;
+}
+
+/* ---- Execution order ---------------------------------------------------------------- */
+
+/*
+ * ORGANIZER_ORDER_INODE: moves into one category together, and in source
+ * inode order within it. Ties (inode unknown) fall back to the source path
+ * so the order does not depend on qsort().
+ */
+static int compare_locality(const void *a, const void *b)
+{
+    const OrganizerMove *x = a;
+    const OrganizerMove *y = b;
+    if (x->category != y->category) {
+        int rc = strcmp(x->category, y->category);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    if (x->src_ino != y->src_ino) {
+        return x->src_ino < y->src_ino ? -1 : 1;
+    }
+    int rc = strcmp(x->src_dir, y->src_dir);
+    return rc != 0 ? rc : strcmp(x->src_name, y->src_name);
+}
+
+/*
+ * The moves of 'plan' in config->order, as a view sharing the plan's
+ * strings. Returns NULL (the plan is executed as is) for readdir order, or
+ * if the copy cannot be allocated.
+ */
+static OrganizerMove *order_moves(const OrganizerConfig *config, const OrganizerPlan *plan,
+                                  OrganizerPlan *view)
+{
+    if (config->order != ORGANIZER_ORDER_INODE || plan->count < 2) {
+        return NULL;
+    }
+    OrganizerMove *moves = malloc(plan->count * sizeof(*moves));
+    if (!moves) {
+        logger_log(LOG_LEVEL_WARN, "Out of memory while ordering moves; using readdir order\n");
+        return NULL;
+    }
+    memcpy(moves, plan->moves, plan->count * sizeof(*moves));
+    qsort(moves, plan->count, sizeof(*moves), compare_locality);
+
+    *view = *plan;
+    view->moves = moves;
+    view->capacity = plan->count;
+    return moves;
+}
+
+static int execute_plan(const OrganizerConfig *config,
+                        CategoryCache *cache,
+                        const OrganizerPlan *plan)
+{
+    uint64_t start = stats_now(cache->stats);
+    OrganizerPlan view;
+    OrganizerMove *ordered = order_moves(config, plan, &view);
+    if (ordered) {
+        plan = &view;
+    }
+    int result = config->dedupe != ORGANIZER_DEDUPE_OFF
+                 ? execute_deduplicated(config, cache, plan)
+                 : execute_moves(config, cache, plan);
+    free(ordered);
+    if (cache->journal) {
+        journal_flush(cache->journal); /* the batch's last records; errors surface on close */
+    }
+    stats_phase(cache->stats, ORGANIZER_PHASE_EXECUTE, start);
+    return result;
+}
+
+/* ---- Multi-threaded runs ------------------------------------------------------------- */
+
+/* Entry copied out of the scanner, waiting for the parallel stages. */
+typedef struct {
+    const char *name;     /* in ParallelRun.names */
+    size_t name_len;
+    ScanEntryType type;
+    uint64_t ino;
+    const char *category; /* NULL if the entry is skipped */
+    size_t cdir_index;    /* index into CategoryCache.dirs once resolved */
+} PendingEntry;
+
+/*
+ * Shared state of a multi-threaded run. Work is partitioned by category:
+ * worker w owns every category whose cache index is congruent to w, so it
+ * alone touches those directories' name sets and descriptors and no
+ * cross-thread locking is needed. The category cache itself is fully
+ * resolved by the calling thread before any worker reads it.
+ */
+typedef struct {
+    const OrganizerConfig *config;
+    CategoryCache *cache;
+    PendingEntry *entries;
+    size_t count;
+    size_t capacity;
+    size_t bytes;          /* held by the entries and their names */
+    Arena names;           /* storage of every entry name */
+    size_t *order;         /* entry indices grouped by owning worker */
+    size_t *worker_start;  /* workers + 1 offsets into 'order' */
+    OrganizerPlan *plans;  /* one per worker */
+    int *results;          /* one per worker */
+    bool plan_only;
+} ParallelRun;
+
+static void classify_task(void *arg, unsigned worker, unsigned workers)
+{
+    ParallelRun *run = arg;
+    size_t begin = run->count * worker / workers;
+    size_t end = run->count * (worker + 1) / workers;
+    uint64_t start = stats_now(run->cache->stats);
+
+    for (size_t i = begin; i < end; ++i) {
+        const PendingEntry *pending = &run->entries[i];
+        ScanEntry entry = { pending->name, pending->name_len, pending->type, pending->ino };
+        run->entries[i].category = classify_entry(run->config, run->cache,
+                                                  run->cache->base_fd, "", &entry);
+    }
+    stats_phase(run->cache->stats, ORGANIZER_PHASE_CLASSIFY, start);
+}
+
+static void claim_and_execute_task(void *arg, unsigned worker, unsigned workers)
+{
+    ParallelRun *run = arg;
+    OrganizerPlan *plan = &run->plans[worker];
+    uint64_t start = stats_now(run->cache->stats);
+    (void)workers;
+
+    for (size_t k = run->worker_start[worker]; k < run->worker_start[worker + 1]; ++k) {
+        const PendingEntry *entry = &run->entries[run->order[k]];
+        int rc = plan_claim(run->cache, &run->cache->dirs[entry->cdir_index],
+                            "", entry->name, entry->name_len, entry->ino, plan);
+        if (rc != 0) {
+            run->results[worker] = 1;
+        }
+        if (rc < 0) {
+            stats_phase(run->cache->stats, ORGANIZER_PHASE_RESOLVE, start);
+            return;
+        }
+    }
+    stats_phase(run->cache->stats, ORGANIZER_PHASE_RESOLVE, start);
+
+    if (!run->plan_only && plan->count > 0 &&
+        execute_plan(run->config, run->cache, plan) != 0) {
+        run->results[worker] = 1;
+    }
+}
+
+static void execute_task(void *arg, unsigned worker, unsigned workers)
+{
+    ParallelRun *run = arg;
+    (void)workers;
+
+    if (run->plans[worker].count > 0 &&
+        execute_plan(run->config, run->cache, &run->plans[worker]) != 0) {
+        run->results[worker] = 1;
+    }
+}
+
+static void parallel_run_free(ParallelRun *run)
+{
+    arena_free(&run->names);
+    free(run->entries);
+    free(run->order);
+    free(run->worker_start);
+    free(run->plans);
+    free(run->results);
+}
+
+static int parallel_run_alloc(ParallelRun *run, unsigned workers)
+{
+    run->worker_start = calloc(workers + 1, sizeof(*run->worker_start));
+    run->plans = calloc(workers, sizeof(*run->plans));
+    run->results = calloc(workers, sizeof(*run->results));
+    return run->worker_start && run->plans && run->results ? 0 : -1;
+}
+
+/*
+ * Copy entries of the target directory out of the scanner until they hold
+ * 'budget' bytes (checked between directory reads) or the directory ends,
+ * which sets '*done'.
+ */
+static int collect_entries(CategoryCache *cache, ParallelRun *run, DirScanner *scanner,
+                           size_t budget, bool *done)
+{
+    uint64_t scan_start = stats_now(cache->stats);
+    uint64_t start;
+    const ScanEntry *batch;
+    long count;
+    int result = 0;
+
+    *done = false;
+    while (run->bytes < budget) {
+        start = stats_now(cache->stats);
+        count = dir_scanner_next_batch(scanner, &batch);
+        stats_syscalls(cache->stats, ORGANIZER_SYSCALL_READDIR, 1, start);
+        if (count == 0) {
+            *done = true;
+            break;
+        }
+        if (count < 0) {
+            logger_log(LOG_LEVEL_ERROR,
+                       "Failed to read directory '%s': %s\n",
+                       cache->base_dir, strerror(errno));
+            STATS_ADD(cache->stats, errors, 1);
+            result = 1;
+            break;
+        }
+        STATS_ADD(cache->stats, scanned, count);
+
+        if (run->count + (size_t)count > run->capacity) {
+            size_t new_capacity = run->capacity ? run->capacity * 2 : 1024;
+            while (new_capacity < run->count + (size_t)count) {
+                new_capacity *= 2;
+            }
+            PendingEntry *entries = realloc(run->entries, new_capacity * sizeof(*entries));
+            if (!entries) {
+                result = -1;
+                break;
+            }
+            run->entries = entries;
+            run->capacity = new_capacity;
+        }
+
+        for (long i = 0; i < count; ++i) {
+            TRACE3(entry_scanned, "", batch[i].name, batch[i].ino);
+            if (!shard_owns(cache, batch[i].name, batch[i].name_len) ||
+                (cache->incremental && incremental_skip(cache->incremental, &batch[i]))) {
+                STATS_ADD(cache->stats, skipped, 1);
+                continue;
+            }
+
+            PendingEntry *entry = &run->entries[run->count];
+            entry->name = arena_strndup(&run->names, batch[i].name, batch[i].name_len);
+            if (!entry->name) {
+                result = -1;
+                break;
+            }
+            entry->name_len = batch[i].name_len;
+            entry->type = batch[i].type;
+            entry->ino = batch[i].ino;
+            entry->category = NULL;
+            entry->cdir_index = 0;
+            run->count++;
+            run->bytes += sizeof(*entry) + batch[i].name_len + 1;
+        }
+        if (result != 0) {
+            break;
+        }
+    }
+
+    if (result < 0) {
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while scanning '%s'\n", cache->base_dir);
+    }
+    stats_phase(cache->stats, ORGANIZER_PHASE_SCAN, scan_start);
+    return result;
+}
+
+/* Forget one window of a windowed run, keeping the allocations that are reused. */
+static void parallel_run_reset(ParallelRun *run, unsigned workers)
+{
+    run->count = 0;
+    run->bytes = 0;
+    arena_free(&run->names);
+    free(run->order);
+    run->order = NULL;
+    memset(run->worker_start, 0, (workers + 1) * sizeof(*run->worker_start));
+    for (unsigned w = 0; w < workers; ++w) {
+        organizer_plan_free(&run->plans[w]);
+    }
+}
+
+/*
+ * Resolve the category of every classified entry on the calling thread
+ * (creating missing nested ones when executing) and group entry indices by
+ * owning worker, keeping scan order within a worker.
+ */
+static int partition_entries(ParallelRun *run, unsigned workers)
+{
+    size_t *counts = run->worker_start;
+    uint64_t start = stats_now(run->cache->stats);
+
+    for (size_t i = 0; i < run->count; ++i) {
+        PendingEntry *entry = &run->entries[i];
+        if (!entry->category) {
+            ScanEntry skipped = { entry->name, entry->name_len, entry->type, entry->ino };
+            if (run->cache->incremental &&
+                incremental_note_skipped(run->cache->incremental, &skipped) != 0) {
+                return -1;
+            }
+            continue;
+        }
+        CategoryDir *cdir = category_cache_lookup(run->cache, entry->category);
+        if (!cdir) {
+            return -1;
+        }
+        if (!run->plan_only) {
+            category_dir_create_nested(run->config, run->cache, cdir);
+        }
+        entry->cdir_index = (size_t)(cdir - run->cache->dirs);
+        counts[entry->cdir_index % workers + 1]++;
+    }
+
+    for (unsigned w = 0; w < workers; ++w) {
+        counts[w + 1] += counts[w];
+    }
+
+    run->order = malloc((counts[workers] ? counts[workers] : 1) * sizeof(*run->order));
+    size_t *fill = malloc(workers * sizeof(*fill));
+    if (!run->order || !fill) {
+        free(fill);
+        return -1;
+    }
+    memcpy(fill, counts, workers * sizeof(*fill));
+
+    for (size_t i = 0; i < run->count; ++i) {
+        if (run->entries[i].category) {
+            run->order[fill[run->entries[i].cdir_index % workers]++] = i;
+        }
+    }
+
+    free(fill);
+    stats_phase(run->cache->stats, ORGANIZER_PHASE_RESOLVE, start);
+    return 0;
+}
+
+/*
+ * Concatenate the per-worker plans into 'out', taking ownership of their
+ * moves and string storage.
+ */
+static int merge_plans(OrganizerPlan *plans, unsigned workers, OrganizerPlan *out)
+{
+    size_t total = 0;
+    for (unsigned w = 0; w < workers; ++w) {
+        total += plans[w].count;
+    }
+
+    out->moves = total ? malloc(total * sizeof(*out->moves)) : NULL;
+    if (total && !out->moves) {
+        return -1;
+    }
+    out->count = 0;
+    out->capacity = total;
+
+    for (unsigned w = 0; w < workers; ++w) {
+        memcpy(out->moves + out->count, plans[w].moves,
+               plans[w].count * sizeof(*out->moves));
+        out->count += plans[w].count;
+        arena_adopt(&out->strings, &plans[w].strings);
+        free(plans[w].moves);
+        plans[w].moves = NULL;
+        plans[w].count = 0;
+    }
+    return 0;
+}
+
+/*
+ * Multi-threaded plan (and, unless 'out_plan' is given, execute): scan on the
+ * calling thread, classify in parallel chunks, then claim destinations and
+ * move files in parallel per category.
+ */
+static int run_parallel(const OrganizerConfig *config,
+                        CategoryCache *cache,
+                        ThreadPool *pool,
+                        OrganizerPlan *out_plan)
+{
+    unsigned workers = thread_pool_size(pool);
+    ParallelRun run = {0};
+    run.config = config;
+    run.cache = cache;
+    run.plan_only = out_plan != NULL;
+
+    int result = 0;
+    if (parallel_run_alloc(&run, workers) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while starting workers\n");
+        parallel_run_free(&run);
+        return 1;
+    }
+
+    DirScanner scanner;
+    uint64_t start = stats_now(cache->stats);
+    int opened = dir_scanner_open(&scanner, cache->base_fd, cache->base_dir,
+                                  cache->scan_buffer_size);
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_READDIR, 1, start);
+    stats_phase(cache->stats, ORGANIZER_PHASE_SCAN, start);
+    if (opened != 0) {
+        logger_log(LOG_LEVEL_ERROR,
+                   "Failed to open directory '%s': %s\n",
+                   cache->base_dir, strerror(errno));
+        STATS_ADD(cache->stats, errors, 1);
+        parallel_run_free(&run);
+        return 1;
+    }
+
+    /*
+     * Executing runs go window by window, each holding at most about half
+     * of config->max_mem in entries (the moves take the rest); windows grow
+     * from PLAN_FIRST_CHUNK_BYTES so the first moves start at once. A plan
+     * to return has to hold everything anyway.
+     */
+    size_t max_window = config_max_mem(config) / 2;
+    size_t window = run.plan_only ? SIZE_MAX : PLAN_FIRST_CHUNK_BYTES;
+    bool done = false;
+    while (!done) {
+        if (collect_entries(cache, &run, &scanner, window, &done) != 0) {
+            result = 1;
+            break;
+        }
+        thread_pool_run(pool, classify_task, &run);
+
+        if (partition_entries(&run, workers) != 0) {
+            logger_log(LOG_LEVEL_ERROR, "Out of memory while partitioning work\n");
+            result = 1;
+            break;
+        }
+        thread_pool_run(pool, claim_and_execute_task, &run);
+
+        for (unsigned w = 0; w < workers; ++w) {
+            result |= run.results[w];
+            run.results[w] = 0;
+        }
+        if (!run.plan_only && !done) {
+            parallel_run_reset(&run, workers);
+            window = window < max_window / 2 ? window * 2 : max_window;
+        }
+    }
+    dir_scanner_close(&scanner);
+
+    for (unsigned w = 0; w < workers; ++w) {
+        result |= run.results[w];
+    }
+
+    if (out_plan && merge_plans(run.plans, workers, out_plan) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while merging plans\n");
+        result = 1;
+    }
+    for (unsigned w = 0; w < workers; ++w) {
+        organizer_plan_free(&run.plans[w]);
+    }
+
+    parallel_run_free(&run);
+    return result;
+}
+
+/*
+ * Multi-threaded execution of an existing plan. Moves are split by owning
+ * worker into shallow per-worker plans that borrow the caller's strings.
+ */
+static int execute_parallel(const OrganizerConfig *config,
+                            CategoryCache *cache,
+                            ThreadPool *pool,
+                            const OrganizerPlan *plan)
+{
+    unsigned workers = thread_pool_size(pool);
+    ParallelRun run = {0};
+    run.config = config;
+    run.cache = cache;
+
+    int result = 0;
+    if (parallel_run_alloc(&run, workers) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while starting workers\n");
+        parallel_run_free(&run);
+        return 1;
+    }
+
+    /* Resolve every category up front so workers never grow the cache. */
+    size_t *owners = malloc((plan->count ? plan->count : 1) * sizeof(*owners));
+    for (size_t i = 0; owners && i < plan->count; ++i) {
+        CategoryDir *cdir = category_cache_lookup(cache, plan->moves[i].category);
+        if (!cdir) {
+            free(owners);
+            owners = NULL;
+            break;
+        }
+        category_dir_create_nested(config, cache, cdir);
+        owners[i] = (size_t)(cdir - cache->dirs) % workers;
+        run.plans[owners[i]].capacity++;
+    }
+
+    for (unsigned w = 0; owners && w < workers; ++w) {
+        size_t n = run.plans[w].capacity;
+        run.plans[w].moves = malloc((n ? n : 1) * sizeof(*run.plans[w].moves));
+        if (!run.plans[w].moves) {
+            free(owners);
+            owners = NULL;
+        }
+    }
+
+    if (!owners) {
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while partitioning work\n");
+        result = 1;
+    } else {
+        for (size_t i = 0; i < plan->count; ++i) {
+            OrganizerPlan *p = &run.plans[owners[i]];
+            p->moves[p->count++] = plan->moves[i];
+        }
+        free(owners);
+
+        thread_pool_run(pool, execute_task, &run);
+        for (unsigned w = 0; w < workers; ++w) {
+            result |= run.results[w];
+        }
+    }
+
+    /* The moves' strings belong to the caller's plan. */
+    for (unsigned w = 0; w < workers; ++w) {
+        free(run.plans[w].moves);
+        run.plans[w].moves = NULL;
+        run.plans[w].count = 0;
+    }
+    parallel_run_free(&run);
+    return result;
+}
+
+/* ---- Recursive runs ------------------------------------------------------------------ */
+
+/*
+ * Moves a worker buffers before executing them, when not only planning;
+ * fewer if their share of config->max_mem is reached first.
+ */
+#define RECURSIVE_FLUSH_MOVES 4096
+
+/*
+ * Shared state of a recursive run. Every worker plans the directories the
+ * walker hands it into its own plan; destinations are claimed under the
+ * category's lock, since any worker may find files of any category.
+ */
+typedef struct {
+    const OrganizerConfig *config;
+    CategoryCache *cache;
+    OrganizerPlan *plans; /* one per worker */
+    size_t *plan_bytes;   /* one per worker: held by its plan */
+    size_t flush_bytes;   /* a worker's share of config->max_mem */
+    int *results;         /* one per worker, for the final flush */
+    bool plan_only;
+} RecursiveRun;
+
+static bool recursive_descend(void *ctx, const WalkDir *parent, const char *name)
+{
+    const RecursiveRun *run = ctx;
+
+    /* Hidden directories (.git, .cache, ...) are left alone. */
+    if (name[0] == '.') {
+        return false;
+    }
+    if (parent->depth > 0) {
+        return true;
+    }
+
+    /* Top-level category directories (and parents of nested ones) are destinations, not sources. */
+    size_t len = strlen(name);
+    for (size_t i = 0; i < run->cache->count; ++i) {
+        const char *location = run->cache->dirs[i].location;
+        if (strncmp(location, name, len) == 0 && (location[len] == '\0' || location[len] == '/')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int recursive_flush(RecursiveRun *run, unsigned worker)
+{
+    OrganizerPlan *plan = &run->plans[worker];
+    int result = plan->count > 0 ? execute_plan(run->config, run->cache, plan) : 0;
+    organizer_plan_free(plan);
+    run->plan_bytes[worker] = 0;
+    return result;
+}
+
+static int recursive_batch(void *ctx, unsigned worker, const WalkDir *dir,
+                           const ScanEntry *entries, long count)
+{
+    RecursiveRun *run = ctx;
+    OrganizerPlan *plan = &run->plans[worker];
+    int result = 0;
+
+    /* Interned once per batch and shared by every move out of it. */
+    const char *prefix = dir->rel_path[0]
+                         ? arena_concat(&plan->strings, dir->rel_path, "/")
+                         : "";
+    if (!prefix) {
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while planning '%s'\n", dir->rel_path);
+        return 1;
+    }
+
+    OrganizerStats *stats = run->cache->stats;
+    STATS_ADD(stats, scanned, count);
+    uint64_t start = stats_now(stats);
+
+    for (long i = 0; i < count; ++i) {
+        TRACE3(entry_scanned, prefix, entries[i].name, entries[i].ino);
+        if (!shard_owns(run->cache, entries[i].name, entries[i].name_len)) {
+            STATS_ADD(stats, skipped, 1);
+            continue;
+        }
+        const char *category = classify_entry(run->config, run->cache,
+                                              dir->dir_fd, prefix, &entries[i]);
+        start = stats_phase(stats, ORGANIZER_PHASE_CLASSIFY, start);
+        if (!category) {
+            continue;
+        }
+
+        /* Every category was resolved before the walk, so this never grows the cache. */
+        int rc = plan_claim(run->cache, category_cache_lookup(run->cache, category),
+                            prefix, entries[i].name, entries[i].name_len,
+                            entries[i].ino, plan);
+        start = stats_phase(stats, ORGANIZER_PHASE_RESOLVE, start);
+        if (rc != 0) {
+            result = 1;
+        }
+        if (rc < 0) {
+            return 1;
+        }
+        if (rc == 0) {
+            run->plan_bytes[worker] += move_bytes(&plan->moves[plan->count - 1]);
+        }
+    }
+
+    if (!run->plan_only &&
+        (plan->count >= RECURSIVE_FLUSH_MOVES || run->plan_bytes[worker] >= run->flush_bytes) &&
+        recursive_flush(run, worker) != 0) {
+        result = 1;
+    }
+    return result;
+}
+
+static void recursive_flush_task(void *arg, unsigned worker, unsigned workers)
+{
+    RecursiveRun *run = arg;
+    (void)workers;
+
+    run->results[worker] = recursive_flush(run, worker);
+}
+
+/*
+ * Recursive plan (and, unless 'out_plan' is given, execute): walk the tree
+ * with the work-stealing walker, planning each directory as it is read.
+ * Executing runs flush every worker's plan once it grows large, so memory
+ * stays bounded on big trees.
+ */
+static int run_recursive(const OrganizerConfig *config,
+                         CategoryCache *cache,
+                         ThreadPool *pool,
+                         OrganizerPlan *out_plan)
+{
+    unsigned workers = pool ? thread_pool_size(pool) : 1;
+
+    if (category_cache_resolve_all(config, cache) != 0) {
+        return 1;
+    }
+    if (pool) {
+        category_cache_share(cache);
+    }
+
+    RecursiveRun run = {0};
+    run.config = config;
+    run.cache = cache;
+    run.plan_only = out_plan != NULL;
+    run.plans = calloc(workers, sizeof(*run.plans));
+    run.plan_bytes = calloc(workers, sizeof(*run.plan_bytes));
+    run.results = calloc(workers, sizeof(*run.results));
+    /* Half for the plans, half for the walker's directory buffers. */
+    run.flush_bytes = config_max_mem(config) / 2 / workers;
+    if (!run.plans || !run.plan_bytes || !run.results) {
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while starting workers\n");
+        free(run.plans);
+        free(run.plan_bytes);
+        free(run.results);
+        return 1;
+    }
+
+    WalkOptions options = {0};
+    options.root_fd = cache->base_fd;
+    options.root_path = cache->base_dir;
+    options.scan_buffer_size = cache->scan_buffer_size;
+    options.on_batch = recursive_batch;
+    options.descend = recursive_descend;
+    options.ctx = &run;
+
+    /* Directory reads are both the scan phase and a syscall class. */
+    uint64_t reads = 0, read_ns = 0;
+    if (cache->stats) {
+        options.reads = &reads;
+        options.read_ns = &read_ns;
+    }
+
+    int result = walker_run(&options, pool) != 0;
+
+    STATS_ADD(cache->stats, syscalls[ORGANIZER_SYSCALL_READDIR], reads);
+    STATS_ADD(cache->stats, syscall_ns[ORGANIZER_SYSCALL_READDIR], read_ns);
+    STATS_ADD(cache->stats, phase_ns[ORGANIZER_PHASE_SCAN], read_ns);
+
+    if (out_plan) {
+        if (merge_plans(run.plans, workers, out_plan) != 0) {
+            logger_log(LOG_LEVEL_ERROR, "Out of memory while merging plans\n");
+            result = 1;
+        }
+    } else if (pool) {
+        thread_pool_run(pool, recursive_flush_task, &run);
+    } else {
+        recursive_flush_task(&run, 0, 1);
+    }
+
+    for (unsigned w = 0; w < workers; ++w) {
+        result |= run.results[w];
+        organizer_plan_free(&run.plans[w]);
+    }
+    free(run.plans);
+    free(run.plan_bytes);
+    free(run.results);
+    return result;
+}
+
+/* Create the worker pool for config->jobs, or NULL for a single-threaded run. */
+static ThreadPool *create_pool(const OrganizerConfig *config)
+{
+    if (config->jobs <= 1) {
+        return NULL;
+    }
+
+    ThreadPool *pool = thread_pool_create(config->jobs);
+    if (!pool) {
+        logger_log(LOG_LEVEL_WARN,
+                   "Could not start %u worker threads; running single-threaded\n",
+                   config->jobs);
+    } else if (thread_pool_size(pool) <= 1) {
+        thread_pool_destroy(pool);
+        pool = NULL;
+    }
+    return pool;
+}
+
+/*
+ * Validate the target directory and open the per-run cache on it; 'st'
+ * receives the directory's stat() result. The cache is safe to free even
+ * when this fails.
+ */
+static int begin_run(const OrganizerConfig *config, CategoryCache *cache, struct stat *st)
+{
+    uint64_t start = stats_now(config ? config->stats : NULL);
+    int invalid = validate_target_dir(config, st);
+    stats_syscalls(config ? config->stats : NULL, ORGANIZER_SYSCALL_STAT, 1, start);
+    if (invalid) {
+        category_cache_open(cache, NULL);
+        return 1;
+    }
+
+    int result = category_cache_open(cache, config->target_dir);
+    cache->scan_buffer_size = config->scan_buffer_size;
+    cache->stats = config->stats;
+    cache->throttle = config->throttle;
+    cache->destinations = config->destinations;
+    cache->destination_count = config->destination_count;
+    cache->shard_index = config->shard_index;
+    cache->shard_count = config->shard_count;
+    return result;
+}
+
+/*
+ * Open config->journal_path for a run that changes the file system. Only
+ * the calling thread opens it; workers append through the cache.
+ * '*run_offset' (if given) receives the offset of the run's RUN record.
+ */
+static int open_journal(const OrganizerConfig *config, CategoryCache *cache,
+                        uint64_t *run_offset)
+{
+    if (!config->journal_path || config->dry_run) {
+        return 0;
+    }
+
+    Journal *journal = malloc(sizeof(*journal));
+    if (!journal || journal_open(journal, config->journal_path) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Cannot open journal '%s': %s\n",
+                   config->journal_path, journal ? strerror(errno) : "out of memory");
+        free(journal);
+        return 1;
+    }
+
+    cache->journal = journal;
+    if (run_offset) {
+        *run_offset = journal_size(journal);
+    }
+    if (journal_begin_run(journal, config->target_dir) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Cannot write journal '%s': %s\n",
+                   config->journal_path, strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+/* Drop every cached category (a directory vanished); the journal stays open. */
+static int rebuild_cache(const OrganizerConfig *config, CategoryCache *cache)
+{
+    Journal *journal = cache->journal;
+    Checkpoint *checkpoint = cache->checkpoint;
+    const ResumeSeeds *resume = cache->resume;
+    cache->journal = NULL;
+    category_cache_free(cache);
+
+    int result = category_cache_open(cache, config->target_dir);
+    cache->scan_buffer_size = config->scan_buffer_size;
+    cache->journal = journal;
+    cache->checkpoint = checkpoint;
+    cache->resume = resume;
+    cache->stats = config->stats;
+    cache->throttle = config->throttle;
+    cache->destinations = config->destinations;
+    cache->destination_count = config->destination_count;
+    cache->shard_index = config->shard_index;
+    cache->shard_count = config->shard_count;
+    return result;
+}
+
+/* Plan and execute the whole target directory once, in the configured mode. */
+static int organize_pass(const OrganizerConfig *config, CategoryCache *cache, ThreadPool *pool)
+{
+    if (config->recursive) {
+        return run_recursive(config, cache, pool, NULL);
+    }
+    if (pool) {
+        return run_parallel(config, cache, pool, NULL);
+    }
+
+    return run_streaming(config, cache);
+}
+
+/*
+ * With config->resume, read back what the run in the checkpoint did, if it
+ * was interrupted on this directory and journal. Returns true if 'seeds'
+ * was filled; otherwise the run starts from the beginning.
+ */
+static bool resume_prepare(const OrganizerConfig *config, const Checkpoint *checkpoint,
+                           const struct stat *st, ResumeSeeds *seeds)
+{
+    const CheckpointRecord *previous = &checkpoint->previous;
+    if (previous->status != CHECKPOINT_RUNNING) {
+        logger_log(LOG_LEVEL_INFO, "No interrupted run in '%s'; starting from the beginning\n",
+                   config->checkpoint_path);
+        return false;
+    }
+
+#ifndef _WIN32
+    struct stat journal_st;
+    char target[PATH_MAX];
+    if (stat(config->journal_path, &journal_st) != 0 ||
+        !checkpoint_resumable(checkpoint, st, &journal_st)) {
+        logger_log(LOG_LEVEL_WARN,
+                   "Checkpoint '%s' is for another directory or journal; starting from the beginning\n",
+                   config->checkpoint_path);
+        return false;
+    }
+    if (!realpath(config->target_dir, target) ||
+        resume_seeds_load(seeds, config->journal_path, previous->run_offset, target) != 0) {
+        logger_log(LOG_LEVEL_WARN,
+                   "Cannot read the interrupted run from '%s': %s; starting from the beginning\n",
+                   config->journal_path, strerror(errno));
+        return false;
+    }
+    logger_log(LOG_LEVEL_INFO,
+               "Resuming the run interrupted after %llu moves; %zu category folders known "
+               "from the journal\n", (unsigned long long)previous->moves, seeds->count);
+    return true;
+#else
+    (void)st;
+    (void)seeds;
+    return false;
+#endif
+}
+
+/* Start checkpointing the run into 'checkpoint' (after open_journal()). */
+static int begin_checkpoint(const OrganizerConfig *config, CategoryCache *cache,
+                            Checkpoint *checkpoint, const struct stat *st,
+                            uint64_t run_offset, uint64_t moves)
+{
+    struct stat journal_st;
+    if (stat(config->journal_path, &journal_st) != 0 ||
+        checkpoint_begin(checkpoint, st, &journal_st, run_offset, moves) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Cannot write checkpoint '%s': %s\n",
+                   config->checkpoint_path, strerror(errno));
+        return 1;
+    }
+    cache->checkpoint = checkpoint;
+    return 0;
+}
+
+int organizer_plan(const OrganizerConfig *config, OrganizerPlan *plan)
+{
+    if (plan == NULL) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid plan\n");
+        return 1;
+    }
+
+    plan->moves = NULL;
+    plan->count = 0;
+    plan->capacity = 0;
+    arena_init(&plan->strings);
+
+    StatsSpan span;
+    OrganizerStats *stats = config ? config->stats : NULL;
+    stats_span_begin(stats, &span);
+
+    CategoryCache cache;
+    struct stat st;
+    int result = begin_run(config, &cache, &st);
+    if (result == 0) {
+        ThreadPool *pool = create_pool(config);
+        if (config->recursive) {
+            result = run_recursive(config, &cache, pool, plan);
+        } else if (pool) {
+            result = run_parallel(config, &cache, pool, plan);
+        } else {
+            result = plan_directory(config, &cache, plan, NULL);
+        }
+        thread_pool_destroy(pool);
+    }
+    category_cache_free(&cache);
+    stats_span_end(stats, &span);
+    return result;
+}
+
+int organizer_execute(const OrganizerConfig *config, const OrganizerPlan *plan)
+{
+    if (plan == NULL) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid plan\n");
+        return 1;
+    }
+
+    StatsSpan span;
+    OrganizerStats *stats = config ? config->stats : NULL;
+    stats_span_begin(stats, &span);
+
+    CategoryCache cache;
+    struct stat st;
+    int result = begin_run(config, &cache, &st);
+    if (result == 0) {
+        result = open_journal(config, &cache, NULL);
+    }
+    if (result == 0) {
+        ThreadPool *pool = create_pool(config);
+        if (pool) {
+            result = execute_parallel(config, &cache, pool, plan);
+            thread_pool_destroy(pool);
+        } else {
+            result = execute_plan(config, &cache, plan);
+        }
+    }
+    result |= category_cache_free(&cache);
+    stats_span_end(stats, &span);
+    return result;
+}
+
+int organizer_run(const OrganizerConfig *config)
+{
+    if (config == NULL || config->target_dir == NULL) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid configuration\n");
+        return 1;
+    }
+
+    logger_log(LOG_LEVEL_INFO,
+               "Organizing files in '%s'%s\n",
+               config->target_dir,
+               config->dry_run ? " (dry-run mode)" : "");
+
+    StatsSpan span;
+    stats_span_begin(config->stats, &span);
+
+    /* One cache for both phases: categories resolved while planning stay warm. */
+    CategoryCache cache;
+    IncrementalState incremental;
+    bool use_state = config->state_path && !config->recursive;
+    struct stat st;
+    int result = begin_run(config, &cache, &st);
+
+    if (result == 0 && use_state) {
+        if (incremental_load(&incremental, config->state_path) != 0) {
+            logger_log(LOG_LEVEL_WARN, "Ignoring state file '%s': %s\n",
+                       config->state_path, strerror(errno));
+            incremental_free(&incremental);
+        }
+        if (incremental_unchanged(&incremental, &st)) {
+            logger_log(LOG_LEVEL_INFO, "No changes in '%s' since the last run\n",
+                       config->target_dir);
+            incremental_free(&incremental);
+            category_cache_free(&cache);
+            stats_span_end(config->stats, &span);
+            return 0;
+        }
+        cache.incremental = &incremental;
+    }
+
+    /* Checkpoints point into the journal, so they need one. */
+    Checkpoint checkpoint;
+    ResumeSeeds seeds;
+    bool use_checkpoint = result == 0 && config->checkpoint_path && config->journal_path &&
+                          !config->dry_run;
+    bool resumed = false;
+    uint64_t run_offset = 0;
+
+    if (use_checkpoint && checkpoint_open(&checkpoint, config->checkpoint_path) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Cannot open checkpoint file '%s': %s\n",
+                   config->checkpoint_path, strerror(errno));
+        use_checkpoint = false;
+        result = 1;
+    }
+    if (use_checkpoint && config->resume) {
+        resumed = resume_prepare(config, &checkpoint, &st, &seeds);
+        cache.resume = resumed ? &seeds : NULL;
+    }
+    if (result == 0) {
+        result = open_journal(config, &cache, &run_offset);
+    }
+    if (result == 0 && use_checkpoint) {
+        /* A resumed run keeps the start of the one it continues. */
+        result = begin_checkpoint(config, &cache, &checkpoint, &st,
+                                  resumed ? checkpoint.previous.run_offset : run_offset,
+                                  resumed ? checkpoint.previous.moves : 0);
+    }
+
+    if (result == 0) {
+        ThreadPool *pool = create_pool(config);
+        result = organize_pass(config, &cache, pool);
+        thread_pool_destroy(pool);
+    }
+
+    /* Reaching the end, failures included, finishes the run: nothing is left to resume. */
+    if (cache.checkpoint) {
+        if (journal_flush(cache.journal) != 0 ||
+            checkpoint_finish(cache.checkpoint, journal_size(cache.journal)) != 0) {
+            logger_log(LOG_LEVEL_ERROR, "Failed to finish checkpoint '%s': %s\n",
+                       config->checkpoint_path, strerror(errno));
+            result = 1;
+        }
+        cache.checkpoint = NULL;
+    }
+
+    /* Saved with the stamp taken before the scan, so nothing that arrived since is lost. */
+    if (cache.incremental) {
+        if (!config->dry_run &&
+            incremental_save(&incremental, config->state_path, &st, result == 0) != 0) {
+            logger_log(LOG_LEVEL_ERROR, "Failed to save state file '%s': %s\n",
+                       config->state_path, strerror(errno));
+            result = 1;
+        }
+        incremental_free(&incremental);
+    }
+
+    result |= category_cache_free(&cache);
+    if (use_checkpoint) {
+        checkpoint_close(&checkpoint);
+    }
+    if (resumed) {
+        resume_seeds_free(&seeds);
+    }
+    stats_span_end(config->stats, &span);
+    return result;
+}
+
+/* ---- Reusable context ---------------------------------------------------------------- */
+
+struct OrganizerContext {
+    OrganizerConfig config;  /* the caller's configuration, copied */
+    CategoryCache cache;     /* category descriptors and name sets, kept warm */
+    ThreadPool *pool;
+};
+
+/* Modification time of a category directory, or -1 if it cannot be told. */
+static int64_t category_dir_stamp(const CategoryCache *cache, const CategoryDir *cdir)
+{
+#ifndef _WIN32
+    struct stat st;
+    if (cdir->fd < 0) {
+        return -1;
+    }
+    uint64_t start = stats_now(cache->stats);
+    int rc = fstat(cdir->fd, &st);
+    stats_syscalls(cache->stats, ORGANIZER_SYSCALL_STAT, 1, start);
+    if (rc != 0 || st.st_nlink == 0) {
+        return -1; /* removed while we held it */
+    }
+    return (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#else
+    (void)cache;
+    (void)cdir;
+    return -1;
+#endif
+}
+
+/*
+ * Bring the warm cache up to date before a call. Name sets of directories
+ * changed since the previous call are dropped and reloaded on demand; a
+ * category that is missing, failed or gone makes the whole cache start
+ * over, like it would for a fresh run.
+ */
+static int context_refresh(OrganizerContext *ctx)
+{
+    CategoryCache *cache = &ctx->cache;
+    bool rebuild = false;
+
+    for (size_t i = 0; i < cache->count && !rebuild; ++i) {
+        CategoryDir *cdir = &cache->dirs[i];
+        if (cdir->state != CATEGORY_PRESENT) {
+            rebuild = true;
+            continue;
+        }
+        /* Without a descriptor there is nothing to fstat(); only the names are dropped. */
+        int64_t stamp = category_dir_stamp(cache, cdir);
+        if (stamp < 0 && cdir->fd >= 0) {
+            rebuild = true; /* removed since the previous call */
+        } else if (cdir->names_loaded && (cdir->names_stamp < 0 || stamp != cdir->names_stamp)) {
+            name_set_free(&cdir->names);
+            name_set_init(&cdir->names);
+            cdir->names_loaded = false;
+        }
+    }
+    return rebuild ? rebuild_cache(&ctx->config, cache) : 0;
+}
+
+/* Remember how current each name set is, and flush the journal, after a call. */
+static int context_settle(OrganizerContext *ctx)
+{
+    CategoryCache *cache = &ctx->cache;
+    for (size_t i = 0; i < cache->count; ++i) {
+        CategoryDir *cdir = &cache->dirs[i];
+        cdir->names_stamp = cdir->names_loaded ? category_dir_stamp(cache, cdir) : -1;
+    }
+
+    if (cache->journal && journal_flush(cache->journal) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to write journal: %s\n", strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+OrganizerContext *organizer_context_create(const OrganizerConfig *config)
+{
+    if (config == NULL || config->target_dir == NULL) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid configuration\n");
+        return NULL;
+    }
+
+    OrganizerContext *ctx = malloc(sizeof(*ctx));
+    if (!ctx) {
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while creating organizer context\n");
+        return NULL;
+    }
+    ctx->config = *config;
+    ctx->config.state_path = NULL; /* see organizer.h */
+    ctx->pool = NULL;
+
+    struct stat st;
+    int result = begin_run(&ctx->config, &ctx->cache, &st);
+    if (result == 0) {
+        result = open_journal(&ctx->config, &ctx->cache, NULL);
+    }
+    if (result != 0) {
+        category_cache_free(&ctx->cache);
+        free(ctx);
+        return NULL;
+    }
+
+    ctx->pool = create_pool(&ctx->config);
+    return ctx;
+}
+
+int organizer_context_run(OrganizerContext *ctx)
+{
+    if (ctx == NULL) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid organizer context\n");
+        return 1;
+    }
+
+    StatsSpan span;
+    stats_span_begin(ctx->config.stats, &span);
+    int result = context_refresh(ctx);
+    if (result == 0) {
+        result = organize_pass(&ctx->config, &ctx->cache, ctx->pool);
+    }
+    result |= context_settle(ctx);
+    stats_span_end(ctx->config.stats, &span);
+    return result;
+}
+
+int organizer_context_run_names(OrganizerContext *ctx, const char *const *names, size_t count)
+{
+    if (ctx == NULL || (names == NULL && count > 0)) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid organizer context\n");
+        return 1;
+    }
+
+    StatsSpan span;
+    stats_span_begin(ctx->config.stats, &span);
+    int result = context_refresh(ctx);
+
+    OrganizerPlan plan = {0};
+    int rc = result == 0 ? 0 : -1;
+    for (size_t i = 0; rc >= 0 && i < count; ++i) {
+        if (names[i][0] == '\0' || strchr(names[i], '/') || strcmp(names[i], ".") == 0 ||
+            strcmp(names[i], "..") == 0) {
+            logger_log(LOG_LEVEL_ERROR, "Not an entry of '%s': '%s'\n",
+                       ctx->cache.base_dir, names[i]);
+            STATS_ADD(ctx->cache.stats, errors, 1);
+            rc = 1;
+        } else {
+            rc = plan_named_entry(&ctx->config, &ctx->cache, names[i], &plan);
+        }
+        if (rc != 0) {
+            result = 1;
+        }
+    }
+
+    if (plan.count > 0 && execute_plan(&ctx->config, &ctx->cache, &plan) != 0) {
+        result = 1;
+    }
+    organizer_plan_free(&plan);
+    result |= context_settle(ctx);
+    stats_span_end(ctx->config.stats, &span);
+    return result;
+}
+
+int organizer_context_destroy(OrganizerContext *ctx)
+{
+    if (ctx == NULL) {
+        return 0;
+    }
+    thread_pool_destroy(ctx->pool);
+    int result = category_cache_free(&ctx->cache);
+    free(ctx);
+    return result;
+}
+
+/* ---- Watch mode ---------------------------------------------------------------------- */
+
+#ifdef __linux__
+
+/* Quiet time that closes a batch of arrivals, and the longest a batch may wait. */
+#define WATCH_DEBOUNCE_MS  20
+#define WATCH_MAX_DELAY_MS 250
+#define WATCH_BATCH_MAX    4096
+
+static volatile sig_atomic_t watch_stop_requested;
+
+static void watch_stop_handler(int sig)
+{
+    (void)sig;
+    watch_stop_requested = 1;
+}
+
+static Throttle *watch_throttle; /* whose limits file SIGHUP re-reads */
+
+static void watch_reload_handler(int sig)
+{
+    (void)sig;
+    throttle_request_reload(watch_throttle);
+}
+
+static long elapsed_ms(const struct timespec *since)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long)(now.tv_sec - since->tv_sec) * 1000 +
+           (now.tv_nsec - since->tv_nsec) / 1000000;
+}
+
+/* Changes observed during one debounce window. */
+typedef struct {
+    NameSet names;  /* distinct names that landed in the target directory */
+    bool rescan;    /* the kernel dropped events: organize the whole directory */
+    bool stale;     /* a category directory went away: rebuild the cache */
+    bool gone;      /* the target directory itself went away */
+} WatchBatch;
+
+/*
+ * Watch every existing category directory, so names other programs put
+ * there enter the warm name sets and are never overwritten.
+ */
+static void watch_category_dirs(DirWatch *watch, CategoryCache *cache)
+{
+    for (size_t i = 0; i < cache->count; ++i) {
+        CategoryDir *cdir = &cache->dirs[i];
+        if (cdir->state == CATEGORY_PRESENT && cdir->watch_wd < 0) {
+            cdir->watch_wd = dir_watch_add(watch, cdir->path, WATCH_NAMES_CREATED);
+            if (cdir->watch_wd < 0) {
+                logger_log(LOG_LEVEL_WARN, "Cannot watch '%s': %s\n",
+                           cdir->path, strerror(errno));
+            }
+        }
+    }
+}
+
+static void watch_handle_event(CategoryCache *cache, int target_wd,
+                               const WatchEvent *event, WatchBatch *batch)
+{
+    if (event->kind == WATCH_EVENT_OVERFLOW) {
+        batch->rescan = true;
+        return;
+    }
+
+    if (event->wd == target_wd) {
+        if (event->kind == WATCH_EVENT_GONE) {
+            batch->gone = true;
+        } else if (event->kind == WATCH_EVENT_REMOVED) {
+            /* Category directories are held open, so only their parent notices. */
+            for (size_t i = 0; i < cache->count; ++i) {
+                if (strcmp(cache->dirs[i].location, event->name) == 0) {
+                    batch->stale = true;
+                }
+            }
+        } else if (!name_set_insert(&batch->names, event->name)) {
+            batch->rescan = true; /* out of memory: catch up with a full pass */
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < cache->count; ++i) {
+        CategoryDir *cdir = &cache->dirs[i];
+        if (cdir->watch_wd != event->wd) {
+            continue;
+        }
+        if (event->kind == WATCH_EVENT_NAME && cdir->names_loaded &&
+            !name_set_insert(&cdir->names, event->name)) {
+            batch->stale = true; /* forget the incomplete name set */
+        }
+        return;
+    }
+}
+
+/*
+ * Collect one batch: block until something happens, then keep reading until
+ * the directory has been quiet for WATCH_DEBOUNCE_MS, the batch is full, or
+ * the first event is WATCH_MAX_DELAY_MS old.
+ */
+static int watch_collect(DirWatch *watch, CategoryCache *cache, int target_wd, WatchBatch *batch)
+{
+    struct timespec first;
+    int timeout = -1;
+
+    for (;;) {
+        WatchEvent event;
+        int rc = dir_watch_next(watch, timeout, &event);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                if (watch_stop_requested || timeout >= 0) {
+                    return 0;
+                }
+                throttle_poll(cache->throttle); /* SIGHUP while idle */
+                continue;
+            }
+            logger_log(LOG_LEVEL_ERROR, "Failed to read file system events: %s\n", strerror(errno));
+            return -1;
+        }
+        if (rc == 0) {
+            return 0;
+        }
+
+        if (timeout < 0) {
+            clock_gettime(CLOCK_MONOTONIC, &first);
+            timeout = WATCH_DEBOUNCE_MS;
+        }
+
+        watch_handle_event(cache, target_wd, &event, batch);
+        if (batch->gone || batch->names.count >= WATCH_BATCH_MAX ||
+            elapsed_ms(&first) >= WATCH_MAX_DELAY_MS) {
+            return 0;
+        }
+    }
+}
+
+/* Plan and execute the names of one batch with the warm cache. */
+static int watch_process(const OrganizerConfig *config, CategoryCache *cache,
+                         ThreadPool *pool, const WatchBatch *batch)
+{
+    if (batch->rescan) {
+        logger_log(LOG_LEVEL_WARN, "File system events were lost; rescanning '%s'\n",
+                   cache->base_dir);
+        return organize_pass(config, cache, pool);
+    }
+
+    OrganizerPlan plan = {0};
+    int result = 0;
+
+    for (size_t i = 0; i < batch->names.capacity; ++i) {
+        const char *name = batch->names.slots[i].name;
+        int rc = name ? plan_named_entry(config, cache, name, &plan) : 0;
+        if (rc != 0) {
+            result = 1;
+        }
+        if (rc < 0) {
+            break;
+        }
+    }
+
+    if (plan.count > 0 && execute_plan(config, cache, &plan) != 0) {
+        result = 1;
+    }
+    organizer_plan_free(&plan);
+    return result;
+}
+
+int organizer_watch(const OrganizerConfig *config)
+{
+    if (config == NULL || config->target_dir == NULL) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid configuration\n");
+        return 1;
+    }
+    if (config->recursive) {
+        logger_log(LOG_LEVEL_ERROR, "Watch mode only watches the target directory itself\n");
+        return 1;
+    }
+
+    CategoryCache cache;
+    struct stat st;
+    DirWatch watch = { -1, NULL, 0, 0 };
+    int target_wd = -1;
+
+    int result = begin_run(config, &cache, &st);
+    if (result == 0) {
+        result = open_journal(config, &cache, NULL);
+    }
+    if (result == 0 &&
+        (dir_watch_open(&watch) != 0 ||
+         (target_wd = dir_watch_add(&watch, config->target_dir, WATCH_FILES_LANDED)) < 0)) {
+        logger_log(LOG_LEVEL_ERROR, "Cannot watch '%s': %s\n",
+                   config->target_dir, strerror(errno));
+        result = 1;
+    }
+    if (result != 0) {
+        dir_watch_close(&watch);
+        category_cache_free(&cache);
+        return 1;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = watch_stop_handler; /* no SA_RESTART: interrupt the wait */
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    if (config->throttle && config->throttle->limits_path) {
+        watch_throttle = config->throttle;
+        action.sa_handler = watch_reload_handler;
+        sigaction(SIGHUP, &action, NULL);
+    }
+
+    logger_log(LOG_LEVEL_INFO, "Watching '%s' for new files%s\n",
+               config->target_dir, config->dry_run ? " (dry-run mode)" : "");
+
+    /* The watch exists before the first pass, so nothing landing during it is missed. */
+    ThreadPool *pool = create_pool(config);
+    StatsSpan span;
+    stats_span_begin(config->stats, &span);
+    result = organize_pass(config, &cache, pool);
+    stats_span_end(config->stats, &span);
+    watch_category_dirs(&watch, &cache);
+
+    while (!watch_stop_requested) {
+        WatchBatch batch = {0};
+        name_set_init(&batch.names);
+
+        int rc = watch_collect(&watch, &cache, target_wd, &batch);
+        if (rc == 0 && batch.gone) {
+            logger_log(LOG_LEVEL_ERROR, "Directory '%s' went away; stopping\n", config->target_dir);
+            rc = -1;
+        }
+        if (rc == 0 && batch.stale) {
+            rc = rebuild_cache(config, &cache) != 0 ? -1 : 0;
+        }
+        if (rc == 0 && (batch.names.count > 0 || batch.rescan)) {
+            stats_span_begin(config->stats, &span);
+            if (watch_process(config, &cache, pool, &batch) != 0) {
+                result = 1;
+            }
+            stats_span_end(config->stats, &span);
+        }
+        name_set_free(&batch.names);
+        if (rc != 0) {
+            result = 1;
+            break;
+        }
+
+        watch_category_dirs(&watch, &cache);
+        if (cache.journal && journal_flush(cache.journal) != 0) {
+            logger_log(LOG_LEVEL_ERROR, "Failed to write journal: %s\n", strerror(errno));
+            result = 1;
+        }
+    }
+
+    logger_log(LOG_LEVEL_INFO, "Stopped watching '%s'\n", config->target_dir);
+    thread_pool_destroy(pool);
+    dir_watch_close(&watch);
+    result |= category_cache_free(&cache);
+    return result;
+}
+
+#else /* !__linux__ */
+
+int organizer_watch(const OrganizerConfig *config)
+{
+    logger_log(LOG_LEVEL_ERROR, "Watch mode is not supported on this platform: '%s'\n",
+               config && config->target_dir ? config->target_dir : "");
+    return 1;
+}
+
+#endif
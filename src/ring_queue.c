@@ -0,0 +1,98 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       ring_queue.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Implementation of the bounded pipeline queue: a fixed ring of slots
+    under one mutex, with one condition variable for both ends.
+
+ Usage:
+    See ring_queue.h.
+
+ Notes:
+    - One condition variable for "not full" and "not empty" keeps the code
+      small; with a few coarse items in flight, the extra wakeups of
+      broadcasting are irrelevant.
+
+==========================================================================================================
+*/
+
+#include "ring_queue.h"
+
+#include <stdlib.h>
+
+int ring_queue_init(RingQueue *queue, size_t capacity)
+{
+    queue->items = malloc((capacity ? capacity : 1) * sizeof(*queue->items));
+    if (!queue->items) {
+        return -1;
+    }
+    queue->capacity = capacity ? capacity : 1;
+    queue->head = 0;
+    queue->count = 0;
+    queue->closed = false;
+    pool_mutex_init(&queue->lock);
+    pool_cond_init(&queue->changed);
+    return 0;
+}
+
+int ring_queue_push(RingQueue *queue, void *item)
+{
+    pool_mutex_lock(&queue->lock);
+    while (queue->count == queue->capacity && !queue->closed) {
+        pool_cond_wait(&queue->changed, &queue->lock);
+    }
+    if (queue->closed) {
+        pool_mutex_unlock(&queue->lock);
+        return -1;
+    }
+
+    queue->items[(queue->head + queue->count) % queue->capacity] = item;
+    queue->count++;
+    pool_cond_broadcast(&queue->changed);
+    pool_mutex_unlock(&queue->lock);
+    return 0;
+}
+
+bool ring_queue_pop(RingQueue *queue, void **item)
+{
+    pool_mutex_lock(&queue->lock);
+    while (queue->count == 0 && !queue->closed) {
+        pool_cond_wait(&queue->changed, &queue->lock);
+    }
+    if (queue->count == 0) {
+        pool_mutex_unlock(&queue->lock);
+        return false; /* closed and drained */
+    }
+
+    *item = queue->items[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count--;
+    pool_cond_broadcast(&queue->changed);
+    pool_mutex_unlock(&queue->lock);
+    return true;
+}
+
+void ring_queue_close(RingQueue *queue)
+{
+    pool_mutex_lock(&queue->lock);
+    queue->closed = true;
+    pool_cond_broadcast(&queue->changed);
+    pool_mutex_unlock(&queue->lock);
+}
+
+void ring_queue_free(RingQueue *queue)
+{
+    pool_cond_destroy(&queue->changed);
+    pool_mutex_destroy(&queue->lock);
+    free(queue->items);
+    queue->items = NULL;
+    queue->capacity = 0;
+    queue->count = 0;
+}
@@ -0,0 +1,1253 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       rules.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Rule file parser, glob-to-DFA compiler and the on-disk cache of the
+    compiled automaton.
+
+ Usage:
+    See rules.h.
+
+ Notes:
+    - Every pattern is reversed and turned into a chain of NFA positions
+      (one per glob token, plus an accepting one); the union of all chains
+      is determinized by subset construction over byte equivalence
+      classes, so the table has one column per distinct kind of byte
+      rather than 256.
+    - A state is "settled" when every byte leads back to it (e.g. after
+      "gpj." for "*.jpg"); lookups stop there instead of reading the rest
+      of the name.
+    - The compiled form is one block (header, rules, transitions, accept
+      lists, names) that is written to and read from the cache as is;
+      both paths go through the same validation before use.
+
+==========================================================================================================
+*/
+
+#define _POSIX_C_SOURCE 200809L /* getpid */
+
+#include "rules.h"
+#include "classifier.h"
+#include "logger.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define RULES_CACHE_MAGIC    "FORULES1"
+#define RULES_CACHE_FORMAT   2u
+#define RULES_BYTE_ORDER     0x01020304u
+#define RULES_MAX_FILE_SIZE  ((size_t)1 << 20)
+#define RULES_MAX_RULES      65536u
+#define RULES_MAX_STATES     65536u
+#define RULES_MAX_ACCEPT     ((uint32_t)1 << 24)
+#define RULES_MAX_TERM       1024
+#define RULES_NO_RULE        UINT32_MAX
+#define RULES_DEAD_STATE     0u
+#define RULES_START_STATE    1u
+
+/* Start of the compiled block; the arrays follow in the order of RuleLayout. */
+typedef struct {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t format;
+    uint64_t source_hash;    /* FNV-1a of the rule file */
+    uint32_t category_count;
+    uint32_t rule_count;
+    uint32_t class_count;
+    uint32_t state_count;
+    uint32_t accept_count;
+    uint32_t names_size;     /* NUL-terminated category names, back to back */
+    uint8_t byte_class[256];
+} RuleCacheHeader;
+
+typedef struct {
+    size_t rules;
+    size_t next;
+    size_t accept_start;
+    size_t accept_rules;
+    size_t settled;
+    size_t names;
+    size_t total;
+} RuleLayout;
+
+static size_t align8(size_t n)
+{
+    return (n + 7) & ~(size_t)7;
+}
+
+static unsigned char fold(unsigned char c)
+{
+    return (unsigned char)(c | ((unsigned)((unsigned)(c - 'A') < 26u) << 5));
+}
+
+static uint64_t fnv1a64(const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= p[i];
+        hash *= UINT64_C(0x100000001b3);
+    }
+    return hash;
+}
+
+/* Offsets of the arrays after 'header'; -1 if the counts are out of range. */
+static int rules_layout(const RuleCacheHeader *header, RuleLayout *layout)
+{
+    if (header->class_count == 0 || header->class_count > 256 ||
+        header->state_count < 2 || header->state_count > RULES_MAX_STATES ||
+        header->rule_count == 0 || header->rule_count > RULES_MAX_RULES ||
+        header->category_count == 0 || header->category_count > header->rule_count ||
+        header->accept_count > RULES_MAX_ACCEPT ||
+        header->names_size == 0 || header->names_size > RULES_MAX_FILE_SIZE) {
+        return -1;
+    }
+
+    size_t offset = align8(sizeof(*header));
+    layout->rules = offset;
+    offset += (size_t)header->rule_count * sizeof(Rule);
+    layout->next = offset;
+    offset += (size_t)header->state_count * header->class_count * sizeof(uint32_t);
+    layout->accept_start = offset;
+    offset += ((size_t)header->state_count + 1) * sizeof(uint32_t);
+    layout->accept_rules = offset;
+    offset += (size_t)header->accept_count * sizeof(uint32_t);
+    layout->settled = offset;
+    offset += header->state_count;
+    layout->names = offset;
+    offset += header->names_size;
+    layout->total = offset;
+    return 0;
+}
+
+/*
+ * Point 'rules' into a compiled block after checking every count and
+ * index in it, so a truncated or foreign cache file is rejected rather
+ * than trusted. Takes ownership of 'storage' on success.
+ */
+static int rules_bind(RuleSet *rules, void *storage, size_t size, uint64_t source_hash)
+{
+    const unsigned char *base = storage;
+    const RuleCacheHeader *header = storage;
+    RuleLayout layout;
+
+    if (size < sizeof(*header) ||
+        memcmp(header->magic, RULES_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->byte_order != RULES_BYTE_ORDER || header->format != RULES_CACHE_FORMAT ||
+        header->source_hash != source_hash ||
+        rules_layout(header, &layout) != 0 || layout.total != size) {
+        return -1;
+    }
+
+    const Rule *rule_table = (const Rule *)(const void *)(base + layout.rules);
+    const uint32_t *next = (const uint32_t *)(const void *)(base + layout.next);
+    const uint32_t *accept_start = (const uint32_t *)(const void *)(base + layout.accept_start);
+    const uint32_t *accept_rules = (const uint32_t *)(const void *)(base + layout.accept_rules);
+    const char *names = (const char *)(base + layout.names);
+
+    for (size_t b = 0; b < 256; ++b) {
+        if (header->byte_class[b] >= header->class_count) {
+            return -1;
+        }
+    }
+    for (size_t i = 0; i < (size_t)header->state_count * header->class_count; ++i) {
+        if (next[i] >= header->state_count) {
+            return -1;
+        }
+    }
+    if (accept_start[0] != 0 || accept_start[header->state_count] != header->accept_count) {
+        return -1;
+    }
+    for (size_t s = 0; s < header->state_count; ++s) {
+        if (accept_start[s] > accept_start[s + 1]) {
+            return -1;
+        }
+    }
+    for (size_t i = 0; i < header->accept_count; ++i) {
+        if (accept_rules[i] >= header->rule_count) {
+            return -1;
+        }
+    }
+    unsigned fields = 0;
+    for (size_t r = 0; r < header->rule_count; ++r) {
+        if (rule_table[r].category >= header->category_count ||
+            (rule_table[r].fields & ~(uint32_t)RULE_FIELDS_ALL) != 0) {
+            return -1;
+        }
+        fields |= rule_table[r].fields;
+    }
+    if (names[header->names_size - 1] != '\0') {
+        return -1;
+    }
+
+    const char **categories = malloc(header->category_count * sizeof(*categories));
+    if (!categories) {
+        return -1;
+    }
+    const char *name = names;
+    for (size_t c = 0; c < header->category_count; ++c) {
+        if (name >= names + header->names_size) {
+            free(categories);
+            return -1;
+        }
+        categories[c] = name;
+        for (size_t k = 0; k < classifier_category_count(); ++k) {
+            if (strcmp(name, classifier_category_at(k)) == 0) {
+                categories[c] = classifier_category_at(k);
+            }
+        }
+        name += strlen(name) + 1;
+    }
+
+    rules->categories = categories;
+    rules->category_count = header->category_count;
+    rules->rules = rule_table;
+    rules->rule_count = header->rule_count;
+    rules->byte_class = header->byte_class;
+    rules->class_count = header->class_count;
+    rules->state_count = header->state_count;
+    rules->next = next;
+    rules->accept_start = accept_start;
+    rules->accept_rules = accept_rules;
+    rules->settled = base + layout.settled;
+    rules->fields = fields;
+    rules->storage = storage;
+    rules->from_cache = false;
+    return 0;
+}
+
+/* ---- Parsing ------------------------------------------------------------------------- */
+
+typedef struct {
+    bool star;
+    uint8_t set[32];  /* folded bytes this token matches */
+} GlobToken;
+
+/*
+ * The parsed rule file: NFA positions (pattern chains, each ending in an
+ * accepting position), the rules and their category names.
+ */
+typedef struct {
+    GlobToken *tokens;   /* one per NFA position */
+    uint32_t *accept;    /* rule of an accepting position, or RULES_NO_RULE */
+    size_t position_count;
+    size_t position_capacity;
+
+    uint32_t *starts;    /* first position of every pattern */
+    size_t start_count;
+    size_t start_capacity;
+
+    Rule *rules;
+    size_t rule_count;
+    size_t rule_capacity;
+
+    char *names;
+    size_t names_size;
+    size_t names_capacity;
+    uint32_t category_count;
+} RuleSource;
+
+static void rule_source_free(RuleSource *source)
+{
+    free(source->tokens);
+    free(source->accept);
+    free(source->starts);
+    free(source->rules);
+    free(source->names);
+}
+
+static int grow(void **array, size_t *capacity, size_t needed, size_t element_size)
+{
+    if (needed <= *capacity) {
+        return 0;
+    }
+    size_t new_capacity = *capacity ? *capacity : 16;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    void *new_array = realloc(*array, new_capacity * element_size);
+    if (!new_array) {
+        return -1;
+    }
+    *array = new_array;
+    *capacity = new_capacity;
+    return 0;
+}
+
+static void set_add(uint8_t *set, unsigned char c)
+{
+    set[c >> 3] |= (uint8_t)(1u << (c & 7));
+}
+
+static bool set_has(const uint8_t *set, unsigned char c)
+{
+    return (set[c >> 3] >> (c & 7)) & 1;
+}
+
+/*
+ * Parse a "[...]" class starting at glob[*pos] == '['. Uppercase letters
+ * are folded, so "[A-C]" and "[a-c]" are the same class.
+ */
+static int glob_parse_class(const char *glob, size_t *pos, GlobToken *token)
+{
+    size_t i = *pos + 1;
+    bool negate = glob[i] == '!' || glob[i] == '^';
+    if (negate) {
+        ++i;
+    }
+
+    uint8_t set[32] = {0};
+    bool first = true;
+    while (glob[i] != '\0' && (glob[i] != ']' || first)) {
+        unsigned char lo = (unsigned char)glob[i];
+        if (lo == '\\' && glob[i + 1] != '\0') {
+            lo = (unsigned char)glob[++i];
+        }
+        unsigned char hi = lo;
+        if (glob[i + 1] == '-' && glob[i + 2] != '\0' && glob[i + 2] != ']') {
+            hi = (unsigned char)glob[i + 2];
+            i += 2;
+        }
+        for (unsigned c = lo; c <= hi; ++c) {
+            set_add(set, (unsigned char)c);
+        }
+        ++i;
+        first = false;
+    }
+    if (glob[i] != ']') {
+        return -1;
+    }
+
+    for (unsigned c = 'a'; c <= 'z'; ++c) {
+        if (set_has(set, (unsigned char)c) || set_has(set, (unsigned char)(c - 32))) {
+            set_add(set, (unsigned char)c);
+        }
+    }
+    for (size_t k = 0; k < sizeof(set); ++k) {
+        token->set[k] = negate ? (uint8_t)~set[k] : set[k];
+    }
+    for (unsigned c = 'A'; c <= 'Z'; ++c) {
+        token->set[c >> 3] &= (uint8_t)~(1u << (c & 7)); /* names are folded first */
+    }
+
+    *pos = i;
+    return 0;
+}
+
+/* Append 'glob' to the NFA, reversed, as a pattern of rule 'rule'. */
+static int rule_source_add_pattern(RuleSource *source, const char *glob, uint32_t rule)
+{
+    GlobToken parsed[RULES_MAX_TERM];
+    size_t count = 0;
+
+    for (size_t i = 0; glob[i] != '\0'; ++i) {
+        GlobToken token;
+        memset(&token, 0, sizeof(token));
+        unsigned char c = (unsigned char)glob[i];
+
+        if (c == '*') {
+            if (count > 0 && parsed[count - 1].star) {
+                continue;
+            }
+            token.star = true;
+        } else if (c == '?') {
+            memset(token.set, 0xFF, sizeof(token.set));
+        } else if (c == '[') {
+            if (glob_parse_class(glob, &i, &token) != 0) {
+                return -1;
+            }
+        } else {
+            if (c == '\\' && glob[i + 1] != '\0') {
+                c = (unsigned char)glob[++i];
+            }
+            set_add(token.set, fold(c));
+        }
+        parsed[count++] = token;
+    }
+
+    size_t first = source->position_count;
+    if (grow((void **)&source->tokens, &source->position_capacity, first + count + 1,
+             sizeof(*source->tokens)) != 0) {
+        return -1;
+    }
+    /* 'accept' is sized alongside 'tokens'. */
+    uint32_t *accept = realloc(source->accept, source->position_capacity * sizeof(*accept));
+    if (!accept) {
+        return -1;
+    }
+    source->accept = accept;
+    if (grow((void **)&source->starts, &source->start_capacity, source->start_count + 1,
+             sizeof(*source->starts)) != 0) {
+        return -1;
+    }
+
+    for (size_t k = 0; k < count; ++k) {
+        source->tokens[first + k] = parsed[count - 1 - k];
+        source->accept[first + k] = RULES_NO_RULE;
+    }
+    memset(&source->tokens[first + count], 0, sizeof(GlobToken));
+    source->accept[first + count] = rule;
+    source->position_count = first + count + 1;
+    source->starts[source->start_count++] = (uint32_t)first;
+    return 0;
+}
+
+static int rule_source_category(RuleSource *source, const char *name, uint32_t *index)
+{
+    const char *existing = source->names;
+    for (uint32_t c = 0; c < source->category_count; ++c) {
+        if (strcmp(existing, name) == 0) {
+            *index = c;
+            return 0;
+        }
+        existing += strlen(existing) + 1;
+    }
+
+    size_t len = strlen(name) + 1;
+    if (grow((void **)&source->names, &source->names_capacity, source->names_size + len, 1) != 0) {
+        return -1;
+    }
+    memcpy(source->names + source->names_size, name, len);
+    source->names_size += len;
+    *index = source->category_count++;
+    return 0;
+}
+
+static int parse_size_value(const char *text, uint64_t *out)
+{
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (errno != 0 || end == text || text[0] == '-') {
+        return -1;
+    }
+
+    unsigned shift = 0;
+    switch (*end) {
+    case 'K': case 'k': shift = 10; ++end; break;
+    case 'M': case 'm': shift = 20; ++end; break;
+    case 'G': case 'g': shift = 30; ++end; break;
+    default: break;
+    }
+    if (*end != '\0' || value > (UINT64_MAX >> shift)) {
+        return -1;
+    }
+    *out = (uint64_t)value << shift;
+    return 0;
+}
+
+/* Narrow 'rule' by a "size..." term; -1 if it is malformed or empties the range. */
+static int parse_size_term(const char *term, Rule *rule)
+{
+    const char *op = term + 4;
+    uint64_t min = 0, max = UINT64_MAX, value;
+
+    if (op[0] == '<' && op[1] == '=' && parse_size_value(op + 2, &value) == 0) {
+        max = value;
+    } else if (op[0] == '<' && parse_size_value(op + 1, &value) == 0 && value > 0) {
+        max = value - 1;
+    } else if (op[0] == '>' && op[1] == '=' && parse_size_value(op + 2, &value) == 0) {
+        min = value;
+    } else if (op[0] == '>' && parse_size_value(op + 1, &value) == 0 && value < UINT64_MAX) {
+        min = value + 1;
+    } else if (op[0] == '=' && parse_size_value(op + 1, &value) == 0) {
+        min = max = value;
+    } else {
+        return -1;
+    }
+
+    rule->fields |= RULE_FIELD_SIZE;
+    rule->min_size = min > rule->min_size ? min : rule->min_size;
+    rule->max_size = max < rule->max_size ? max : rule->max_size;
+    return rule->min_size <= rule->max_size ? 0 : -1;
+}
+
+/* An age in seconds, with an optional s, m, h, d or w suffix. */
+static int parse_age_value(const char *text, int64_t *out)
+{
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (errno != 0 || end == text || text[0] == '-') {
+        return -1;
+    }
+
+    unsigned long long unit = 1;
+    switch (*end) {
+    case 's': ++end; break;
+    case 'm': unit = 60; ++end; break;
+    case 'h': unit = 3600; ++end; break;
+    case 'd': unit = 86400; ++end; break;
+    case 'w': unit = 7 * 86400; ++end; break;
+    default: break;
+    }
+    if (*end != '\0' || value > (unsigned long long)INT64_MAX / unit) {
+        return -1;
+    }
+    *out = (int64_t)(value * unit);
+    return 0;
+}
+
+/* Narrow 'rule' by an "age..." term; -1 if it is malformed or empties the range. */
+static int parse_age_term(const char *term, Rule *rule)
+{
+    const char *op = term + 3;
+    int64_t min = INT64_MIN, max = INT64_MAX, value;
+
+    if (op[0] == '<' && op[1] == '=' && parse_age_value(op + 2, &value) == 0) {
+        max = value;
+    } else if (op[0] == '<' && parse_age_value(op + 1, &value) == 0) {
+        max = value - 1;
+    } else if (op[0] == '>' && op[1] == '=' && parse_age_value(op + 2, &value) == 0) {
+        min = value;
+    } else if (op[0] == '>' && parse_age_value(op + 1, &value) == 0 && value < INT64_MAX) {
+        min = value + 1;
+    } else if (op[0] == '=' && parse_age_value(op + 1, &value) == 0) {
+        min = max = value;
+    } else {
+        return -1;
+    }
+
+    rule->fields |= RULE_FIELD_MTIME;
+    rule->min_age = min > rule->min_age ? min : rule->min_age;
+    rule->max_age = max < rule->max_age ? max : rule->max_age;
+    return rule->min_age <= rule->max_age ? 0 : -1;
+}
+
+/* A folder name, or '/'-separated folder names for a subfolder ("Video/Large"). */
+static bool valid_category_name(const char *name)
+{
+    size_t len = strlen(name);
+    if (len == 0 || len > 255 || strchr(name, '\\')) {
+        return false;
+    }
+    for (const char *part = name;;) {
+        size_t part_len = strcspn(part, "/");
+        if (part_len == 0 || (part[0] == '.' && (part_len == 1 ||
+                                                  (part_len == 2 && part[1] == '.')))) {
+            return false; /* empty, ".", ".." */
+        }
+        if (part[part_len] == '\0') {
+            return true;
+        }
+        part += part_len + 1;
+    }
+}
+
+/*
+ * Next whitespace-separated term of 'line' from '*pos' into 'term'. Sets
+ * '*quoted' for "..." terms. Returns 1 for a term, 0 at the end, -1 if
+ * the term is too long or a quote is unterminated.
+ */
+static int next_term(const char *line, size_t *pos, char *term, bool *quoted)
+{
+    size_t i = *pos;
+    while (line[i] == ' ' || line[i] == '\t') {
+        ++i;
+    }
+    if (line[i] == '\0') {
+        *pos = i;
+        return 0;
+    }
+
+    size_t len = 0;
+    *quoted = line[i] == '"';
+    if (*quoted) {
+        ++i;
+    }
+    while (line[i] != '\0' &&
+           (*quoted ? line[i] != '"' : (line[i] != ' ' && line[i] != '\t'))) {
+        if (line[i] == '\\' && line[i + 1] != '\0' && len + 1 < RULES_MAX_TERM) {
+            term[len++] = line[i++]; /* escapes are the glob parser's business */
+        }
+        if (len + 1 >= RULES_MAX_TERM) {
+            return -1;
+        }
+        term[len++] = line[i++];
+    }
+    if (*quoted) {
+        if (line[i] != '"') {
+            return -1;
+        }
+        ++i;
+    }
+    term[len] = '\0';
+    *pos = i;
+    return 1;
+}
+
+static int parse_line(RuleSource *source, char *line, const char *path, size_t line_no)
+{
+    while (*line == ' ' || *line == '\t') {
+        ++line;
+    }
+    if (*line == '\0' || *line == '#') {
+        return 0;
+    }
+
+    char *colon = strchr(line, ':');
+    if (!colon) {
+        logger_log(LOG_LEVEL_ERROR, "%s:%zu: expected 'CATEGORY: TERM...'\n", path, line_no);
+        return -1;
+    }
+    char *end = colon;
+    while (end > line && (end[-1] == ' ' || end[-1] == '\t')) {
+        --end;
+    }
+    *end = '\0';
+    if (!valid_category_name(line)) {
+        logger_log(LOG_LEVEL_ERROR, "%s:%zu: invalid category name '%s'\n", path, line_no, line);
+        return -1;
+    }
+    if (source->rule_count >= RULES_MAX_RULES) {
+        logger_log(LOG_LEVEL_ERROR, "%s:%zu: too many rules\n", path, line_no);
+        return -1;
+    }
+
+    Rule rule = { 0, 0, 0, UINT64_MAX, INT64_MIN, INT64_MAX };
+    uint32_t rule_index = (uint32_t)source->rule_count;
+    if (rule_source_category(source, line, &rule.category) != 0 ||
+        grow((void **)&source->rules, &source->rule_capacity, source->rule_count + 1,
+             sizeof(*source->rules)) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while loading rules\n");
+        return -1;
+    }
+
+    const char *terms = colon + 1;
+    size_t pos = 0;
+    size_t patterns = 0;
+    char term[RULES_MAX_TERM];
+    char glob[RULES_MAX_TERM + 1];
+    bool quoted;
+    int rc;
+
+    while ((rc = next_term(terms, &pos, term, &quoted)) > 0) {
+        const char *pattern = term;
+        if (!quoted && strncmp(term, "size", 4) == 0 &&
+            (term[4] == '<' || term[4] == '>' || term[4] == '=')) {
+            if (parse_size_term(term, &rule) != 0) {
+                logger_log(LOG_LEVEL_ERROR, "%s:%zu: invalid size term '%s'\n",
+                           path, line_no, term);
+                return -1;
+            }
+            continue;
+        }
+        if (!quoted && strncmp(term, "age", 3) == 0 &&
+            (term[3] == '<' || term[3] == '>' || term[3] == '=')) {
+            if (parse_age_term(term, &rule) != 0) {
+                logger_log(LOG_LEVEL_ERROR, "%s:%zu: invalid age term '%s'\n",
+                           path, line_no, term);
+                return -1;
+            }
+            continue;
+        }
+        if (!quoted && term[0] == '.' && !strpbrk(term, "*?[\\")) {
+            glob[0] = '*';          /* ".ext" */
+            memcpy(glob + 1, term, strlen(term) + 1);
+            pattern = glob;
+        }
+        if (rule_source_add_pattern(source, pattern, rule_index) != 0) {
+            logger_log(LOG_LEVEL_ERROR, "%s:%zu: invalid pattern '%s'\n",
+                       path, line_no, term);
+            return -1;
+        }
+        ++patterns;
+    }
+    if (rc < 0) {
+        logger_log(LOG_LEVEL_ERROR, "%s:%zu: unterminated or overlong term\n", path, line_no);
+        return -1;
+    }
+    if (patterns == 0 && rule_source_add_pattern(source, "*", rule_index) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while loading rules\n");
+        return -1;
+    }
+
+    source->rules[source->rule_count++] = rule;
+    return 0;
+}
+
+static int parse_rules(RuleSource *source, char *text, const char *path)
+{
+    size_t line_no = 0;
+    char *line = text;
+    while (line) {
+        char *newline = strchr(line, '\n');
+        if (newline) {
+            *newline = '\0';
+            if (newline > line && newline[-1] == '\r') {
+                newline[-1] = '\0';
+            }
+        }
+        if (parse_line(source, line, path, ++line_no) != 0) {
+            return -1;
+        }
+        line = newline ? newline + 1 : NULL;
+    }
+
+    if (source->rule_count == 0) {
+        logger_log(LOG_LEVEL_ERROR, "%s: no rules defined\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/* ---- Compilation --------------------------------------------------------------------- */
+
+/* DFA states under construction: their NFA position sets and a hash index. */
+typedef struct {
+    uint64_t *sets;       /* 'words' words per state */
+    size_t words;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t *index;      /* open addressing: state + 1, 0 = empty */
+    size_t index_size;    /* power of two */
+} StateSets;
+
+static size_t set_hash(const uint64_t *set, size_t words)
+{
+    return (size_t)fnv1a64(set, words * sizeof(*set));
+}
+
+static int state_sets_rehash(StateSets *states)
+{
+    size_t size = states->index_size ? states->index_size * 2 : 1024;
+    uint32_t *index = calloc(size, sizeof(*index));
+    if (!index) {
+        return -1;
+    }
+    for (uint32_t s = 0; s < states->count; ++s) {
+        size_t slot = set_hash(&states->sets[(size_t)s * states->words], states->words) & (size - 1);
+        while (index[slot] != 0) {
+            slot = (slot + 1) & (size - 1);
+        }
+        index[slot] = s + 1;
+    }
+    free(states->index);
+    states->index = index;
+    states->index_size = size;
+    return 0;
+}
+
+/* State id of 'set', adding it if new. Returns -1 on failure. */
+static int64_t state_sets_intern(StateSets *states, const uint64_t *set)
+{
+    if ((size_t)states->count * 2 >= states->index_size && state_sets_rehash(states) != 0) {
+        return -1;
+    }
+
+    size_t mask = states->index_size - 1;
+    size_t slot = set_hash(set, states->words) & mask;
+    while (states->index[slot] != 0) {
+        uint32_t s = states->index[slot] - 1;
+        if (memcmp(&states->sets[(size_t)s * states->words], set,
+                   states->words * sizeof(*set)) == 0) {
+            return s;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (states->count >= RULES_MAX_STATES) {
+        errno = E2BIG;
+        return -1;
+    }
+    if (states->count == states->capacity) {
+        uint32_t new_capacity = states->capacity ? states->capacity * 2 : 64;
+        uint64_t *sets = realloc(states->sets, (size_t)new_capacity * states->words * sizeof(*sets));
+        if (!sets) {
+            return -1;
+        }
+        states->sets = sets;
+        states->capacity = new_capacity;
+    }
+
+    memcpy(&states->sets[(size_t)states->count * states->words], set,
+           states->words * sizeof(*set));
+    states->index[slot] = states->count + 1;
+    return states->count++;
+}
+
+static bool is_star(const RuleSource *source, size_t pos)
+{
+    return source->accept[pos] == RULES_NO_RULE && source->tokens[pos].star;
+}
+
+/* A '*' may match nothing: add the position after every reachable one. */
+static void closure(const RuleSource *source, uint64_t *set, size_t words)
+{
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t bits = set[w];
+        while (bits) {
+            unsigned b = (unsigned)__builtin_ctzll(bits);
+            bits &= bits - 1;
+            size_t pos = w * 64 + b;
+            if (is_star(source, pos)) {
+                set[(pos + 1) / 64] |= UINT64_C(1) << ((pos + 1) % 64);
+                if ((pos + 1) / 64 == w) {
+                    bits |= UINT64_C(1) << ((pos + 1) % 64);
+                }
+            }
+        }
+    }
+}
+
+static void step(const RuleSource *source, const uint64_t *from, uint64_t *to,
+                 size_t words, unsigned char byte)
+{
+    memset(to, 0, words * sizeof(*to));
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t bits = from[w];
+        while (bits) {
+            size_t pos = w * 64 + (unsigned)__builtin_ctzll(bits);
+            bits &= bits - 1;
+            if (source->accept[pos] != RULES_NO_RULE) {
+                continue;
+            }
+            if (source->tokens[pos].star) {
+                to[pos / 64] |= UINT64_C(1) << (pos % 64);
+            } else if (set_has(source->tokens[pos].set, byte)) {
+                to[(pos + 1) / 64] |= UINT64_C(1) << ((pos + 1) % 64);
+            }
+        }
+    }
+    closure(source, to, words);
+}
+
+/* Group bytes no token tells apart; returns the number of classes. */
+static unsigned byte_classes(const RuleSource *source, uint8_t *byte_class, unsigned char *representative)
+{
+    unsigned count = 1;
+    memset(byte_class, 0, 256);
+
+    for (size_t pos = 0; pos < source->position_count; ++pos) {
+        if (source->accept[pos] != RULES_NO_RULE || source->tokens[pos].star) {
+            continue;
+        }
+        int remap[512];
+        for (size_t k = 0; k < 512; ++k) {
+            remap[k] = -1;
+        }
+        unsigned new_count = 0;
+        for (unsigned b = 0; b < 256; ++b) {
+            unsigned key = byte_class[b] * 2u + set_has(source->tokens[pos].set, (unsigned char)b);
+            if (remap[key] < 0) {
+                remap[key] = (int)new_count++;
+            }
+            byte_class[b] = (uint8_t)remap[key];
+        }
+        count = new_count;
+    }
+
+    for (unsigned b = 256; b-- > 0;) {
+        representative[byte_class[b]] = (unsigned char)b;
+    }
+    return count;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Determinize 'source' into a compiled block; returns NULL on failure. */
+static void *rules_compile(const RuleSource *source, uint64_t source_hash, size_t *out_size)
+{
+    RuleCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RULES_CACHE_MAGIC, sizeof(header.magic));
+    header.byte_order = RULES_BYTE_ORDER;
+    header.format = RULES_CACHE_FORMAT;
+    header.source_hash = source_hash;
+    header.category_count = source->category_count;
+    header.rule_count = (uint32_t)source->rule_count;
+    header.names_size = (uint32_t)source->names_size;
+
+    unsigned char representative[256];
+    unsigned classes = byte_classes(source, header.byte_class, representative);
+    header.class_count = classes;
+
+    StateSets states = { NULL, (source->position_count + 63) / 64, 0, 0, NULL, 0 };
+    uint32_t *next = NULL;
+    size_t next_capacity = 0;
+    uint32_t *accept_start = NULL;
+    uint32_t *accept_rules = NULL;
+    size_t accept_capacity = 0;
+    uint8_t *settled = NULL;
+    void *block = NULL;
+    uint64_t *set = calloc(states.words, sizeof(*set));
+    uint64_t *target = calloc(states.words, sizeof(*target));
+    if (!set || !target) {
+        goto done;
+    }
+
+    /* State 0: dead (no position). State 1: every pattern's first position. */
+    if (state_sets_intern(&states, set) != RULES_DEAD_STATE) {
+        goto done;
+    }
+    for (size_t p = 0; p < source->start_count; ++p) {
+        set[source->starts[p] / 64] |= UINT64_C(1) << (source->starts[p] % 64);
+    }
+    closure(source, set, states.words);
+    if (state_sets_intern(&states, set) != RULES_START_STATE) {
+        goto done;
+    }
+
+    for (uint32_t s = 0; s < states.count; ++s) {
+        if (grow((void **)&next, &next_capacity, ((size_t)s + 1) * classes, sizeof(*next)) != 0) {
+            goto done;
+        }
+        /* 'states.sets' may move while interning; work on a copy. */
+        memcpy(set, &states.sets[(size_t)s * states.words], states.words * sizeof(*set));
+        for (unsigned c = 0; c < classes; ++c) {
+            step(source, set, target, states.words, representative[c]);
+            int64_t id = state_sets_intern(&states, target);
+            if (id < 0) {
+                if (errno == E2BIG) {
+                    logger_log(LOG_LEVEL_ERROR, "Rules are too complex (more than %u states)\n",
+                               RULES_MAX_STATES);
+                }
+                goto done;
+            }
+            next[(size_t)s * classes + c] = (uint32_t)id;
+        }
+    }
+    header.state_count = states.count;
+
+    accept_start = malloc(((size_t)states.count + 1) * sizeof(*accept_start));
+    settled = malloc(states.count);
+    if (!accept_start || !settled) {
+        goto done;
+    }
+    size_t accept_count = 0;
+    for (uint32_t s = 0; s < states.count; ++s) {
+        const uint64_t *members = &states.sets[(size_t)s * states.words];
+        accept_start[s] = (uint32_t)accept_count;
+        for (size_t w = 0; w < states.words; ++w) {
+            uint64_t bits = members[w];
+            while (bits) {
+                size_t pos = w * 64 + (unsigned)__builtin_ctzll(bits);
+                bits &= bits - 1;
+                if (source->accept[pos] == RULES_NO_RULE) {
+                    continue;
+                }
+                if (accept_count >= RULES_MAX_ACCEPT ||
+                    grow((void **)&accept_rules, &accept_capacity, accept_count + 1,
+                         sizeof(*accept_rules)) != 0) {
+                    goto done;
+                }
+                accept_rules[accept_count++] = source->accept[pos];
+            }
+        }
+
+        /* First rule in file order wins: sort, and drop rules matched by several patterns. */
+        size_t len = accept_count - accept_start[s];
+        if (len > 1) {
+            uint32_t *list = accept_rules + accept_start[s];
+            size_t kept = 1;
+            qsort(list, len, sizeof(*list), compare_u32);
+            for (size_t k = 1; k < len; ++k) {
+                if (list[kept - 1] != list[k]) {
+                    list[kept++] = list[k];
+                }
+            }
+            accept_count = accept_start[s] + kept;
+        }
+
+        settled[s] = 1;
+        for (unsigned c = 0; c < classes; ++c) {
+            if (next[(size_t)s * classes + c] != s) {
+                settled[s] = 0;
+            }
+        }
+    }
+    accept_start[states.count] = (uint32_t)accept_count;
+    header.accept_count = (uint32_t)accept_count;
+
+    RuleLayout layout;
+    if (rules_layout(&header, &layout) != 0) {
+        goto done;
+    }
+    block = calloc(1, layout.total);
+    if (!block) {
+        goto done;
+    }
+    unsigned char *base = block;
+    memcpy(base, &header, sizeof(header));
+    memcpy(base + layout.rules, source->rules, source->rule_count * sizeof(Rule));
+    memcpy(base + layout.next, next, (size_t)states.count * classes * sizeof(*next));
+    memcpy(base + layout.accept_start, accept_start, ((size_t)states.count + 1) * sizeof(*accept_start));
+    if (accept_count > 0) {
+        memcpy(base + layout.accept_rules, accept_rules, accept_count * sizeof(*accept_rules));
+    }
+    memcpy(base + layout.settled, settled, states.count);
+    memcpy(base + layout.names, source->names, source->names_size);
+    *out_size = layout.total;
+
+done:
+    free(set);
+    free(target);
+    free(states.sets);
+    free(states.index);
+    free(next);
+    free(accept_start);
+    free(accept_rules);
+    free(settled);
+    return block;
+}
+
+/* ---- Cache --------------------------------------------------------------------------- */
+
+#ifndef _WIN32
+
+/* Cache file for a rule file hash; with 'create', make its directory too. */
+static int rules_cache_path(uint64_t hash, bool create, char *path, size_t size)
+{
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    char parent[PATH_MAX];
+
+    if (xdg && xdg[0] == '/') {
+        if (snprintf(parent, sizeof(parent), "%s", xdg) >= (int)sizeof(parent)) {
+            return -1;
+        }
+    } else if (home && home[0] == '/') {
+        if (snprintf(parent, sizeof(parent), "%s/.cache", home) >= (int)sizeof(parent)) {
+            return -1;
+        }
+    } else {
+        return -1;
+    }
+
+    char dir[PATH_MAX];
+    if (snprintf(dir, sizeof(dir), "%s/file-organizer", parent) >= (int)sizeof(dir) ||
+        snprintf(path, size, "%s/rules-%016" PRIx64 ".bin", dir, hash) >= (int)size) {
+        return -1;
+    }
+    if (create) {
+        mkdir(parent, 0755); /* failures surface when the file is created */
+        mkdir(dir, 0755);
+    }
+    return 0;
+}
+
+static void *rules_cache_read(const char *path, size_t *out_size)
+{
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        return NULL;
+    }
+
+    RuleCacheHeader header;
+    RuleLayout layout;
+    void *block = NULL;
+    if (fread(&header, sizeof(header), 1, in) == 1 && rules_layout(&header, &layout) == 0 &&
+        (block = malloc(layout.total)) != NULL) {
+        memcpy(block, &header, sizeof(header));
+        size_t rest = layout.total - sizeof(header);
+        if (fread((char *)block + sizeof(header), 1, rest, in) != rest || fgetc(in) != EOF) {
+            free(block);
+            block = NULL;
+        }
+        *out_size = layout.total;
+    }
+    fclose(in);
+    return block;
+}
+
+static void rules_cache_write(const char *path, const void *block, size_t size)
+{
+    char tmp_path[PATH_MAX];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.%ld.tmp", path, (long)getpid()) >=
+        (int)sizeof(tmp_path)) {
+        return;
+    }
+
+    FILE *out = fopen(tmp_path, "wb");
+    if (!out) {
+        logger_log(LOG_LEVEL_DEBUG, "Cannot cache rules in '%s': %s\n", path, strerror(errno));
+        return;
+    }
+    bool failed = fwrite(block, 1, size, out) != size;
+    failed |= fclose(out) != 0;
+    if (failed || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+    }
+}
+
+#else /* _WIN32: no cache */
+
+static int rules_cache_path(uint64_t hash, bool create, char *path, size_t size)
+{
+    (void)hash; (void)create; (void)path; (void)size;
+    return -1;
+}
+
+static void *rules_cache_read(const char *path, size_t *out_size)
+{
+    (void)path; (void)out_size;
+    return NULL;
+}
+
+static void rules_cache_write(const char *path, const void *block, size_t size)
+{
+    (void)path; (void)block; (void)size;
+}
+
+#endif
+
+/* ---- Public interface ---------------------------------------------------------------- */
+
+static char *read_rule_file(const char *path, size_t *out_len)
+{
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        return NULL;
+    }
+
+    char *text = malloc(RULES_MAX_FILE_SIZE + 1);
+    size_t len = text ? fread(text, 1, RULES_MAX_FILE_SIZE + 1, in) : 0;
+    int failed = !text || ferror(in);
+    fclose(in);
+
+    if (failed || len > RULES_MAX_FILE_SIZE) {
+        free(text);
+        errno = failed ? EIO : EFBIG;
+        return NULL;
+    }
+    text[len] = '\0';
+    *out_len = len;
+    return text;
+}
+
+int rules_load(RuleSet *rules, const char *path, bool write_cache)
+{
+    memset(rules, 0, sizeof(*rules));
+
+    size_t len;
+    char *text = read_rule_file(path, &len);
+    if (!text) {
+        logger_log(LOG_LEVEL_ERROR, "Cannot read rule file '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    uint64_t hash = fnv1a64(text, len);
+
+    char cache_path[PATH_MAX];
+    bool cacheable = rules_cache_path(hash, false, cache_path, sizeof(cache_path)) == 0;
+    size_t size = 0;
+    void *block = cacheable ? rules_cache_read(cache_path, &size) : NULL;
+    if (block && rules_bind(rules, block, size, hash) == 0) {
+        rules->from_cache = true;
+        free(text);
+        logger_log(LOG_LEVEL_DEBUG, "Loaded %zu rules from '%s'\n", rules->rule_count, cache_path);
+        return 0;
+    }
+    free(block);
+
+    RuleSource source;
+    memset(&source, 0, sizeof(source));
+    int result = parse_rules(&source, text, path);
+    free(text);
+
+    block = result == 0 ? rules_compile(&source, hash, &size) : NULL;
+    rule_source_free(&source);
+    if (!block) {
+        if (result == 0) {
+            logger_log(LOG_LEVEL_ERROR, "Cannot compile rule file '%s'\n", path);
+        }
+        return -1;
+    }
+    if (rules_bind(rules, block, size, hash) != 0) {
+        free(block);
+        logger_log(LOG_LEVEL_ERROR, "Cannot compile rule file '%s'\n", path);
+        return -1;
+    }
+
+    logger_log(LOG_LEVEL_DEBUG, "Compiled %zu rules from '%s' into %u states\n",
+               rules->rule_count, path, rules->state_count);
+    if (write_cache && rules_cache_path(hash, true, cache_path, sizeof(cache_path)) == 0) {
+        rules_cache_write(cache_path, block, size);
+    }
+    return 0;
+}
+
+/* Whether the metadata of an entry satisfies the size and age ranges of 'rule'. */
+static bool rule_meta_matches(const Rule *rule, const RuleMeta *meta, int64_t *now)
+{
+    if ((rule->fields & RULE_FIELD_SIZE) &&
+        (meta->size < rule->min_size || meta->size > rule->max_size)) {
+        return false;
+    }
+    if (rule->fields & RULE_FIELD_MTIME) {
+        if (*now == 0) {
+            *now = (int64_t)time(NULL);
+        }
+        int64_t age = *now - meta->mtime;
+        if (age < rule->min_age || age > rule->max_age) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char *rules_classify(const RuleSet *rules, const char *name, size_t name_len,
+                           RuleMetaFn meta_of, void *ctx)
+{
+    const uint32_t classes = rules->class_count;
+    uint32_t state = RULES_START_STATE;
+
+    for (size_t i = name_len; i > 0 && !rules->settled[state]; --i) {
+        unsigned char c = fold((unsigned char)name[i - 1]);
+        state = rules->next[(size_t)state * classes + rules->byte_class[c]];
+    }
+
+    int have_meta = 0; /* 1: fetched, -1: unavailable */
+    RuleMeta meta = { 0, 0 };
+    int64_t now = 0;
+    const uint32_t end = rules->accept_start[state + 1];
+    for (uint32_t k = rules->accept_start[state]; k < end; ++k) {
+        const Rule *rule = &rules->rules[rules->accept_rules[k]];
+        if (rule->fields) {
+            if (have_meta == 0) {
+                /* One fetch, limited to what the remaining candidates test. */
+                unsigned fields = 0;
+                for (uint32_t j = k; j < end; ++j) {
+                    fields |= rules->rules[rules->accept_rules[j]].fields;
+                }
+                have_meta = meta_of && meta_of(ctx, fields, &meta) == 0 ? 1 : -1;
+            }
+            if (have_meta < 0 || !rule_meta_matches(rule, &meta, &now)) {
+                continue;
+            }
+        }
+        return rules->categories[rule->category];
+    }
+    return NULL;
+}
+
+void rules_free(RuleSet *rules)
+{
+    free(rules->categories);
+    free(rules->storage);
+    memset(rules, 0, sizeof(*rules));
+}
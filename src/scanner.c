@@ -0,0 +1,256 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       scanner.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Batched directory scanner. The Linux path issues getdents64 with a large
+    caller-sized buffer, so a directory with millions of entries takes a few
+    hundred system calls instead of one per 32 KiB glibc refill, and parses
+    the records in place without copying names.
+
+ Usage:
+    See scanner.h.
+
+ Notes:
+    - The getdents64 path uses its own open file description (openat(fd, "."))
+      so it never disturbs the offset of the caller's descriptor.
+    - If getdents64 is unavailable the scanner silently falls back to readdir().
+
+==========================================================================================================
+*/
+
+#define _POSIX_C_SOURCE 200809L /* openat, fdopendir */
+#define _DEFAULT_SOURCE          /* d_type/DT_*, syscall() */
+
+#include "scanner.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+
+/* Record layout returned by getdents64(2). */
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+#endif
+
+/* Smallest buffer worth issuing a system call for. */
+#define SCANNER_MIN_BUFFER_SIZE ((size_t)64 * 1024)
+
+static ScanEntryType scan_type_from_dtype(unsigned char d_type)
+{
+#ifdef DT_UNKNOWN
+    switch (d_type) {
+    case DT_REG: return SCAN_TYPE_REGULAR;
+    case DT_DIR: return SCAN_TYPE_DIRECTORY;
+    case DT_LNK: return SCAN_TYPE_SYMLINK;
+    case DT_UNKNOWN: return SCAN_TYPE_UNKNOWN;
+    default: return SCAN_TYPE_OTHER;
+    }
+#else
+    (void)d_type;
+    return SCAN_TYPE_UNKNOWN;
+#endif
+}
+
+static int is_dot_or_dotdot(const char *name)
+{
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+int dir_scanner_open(DirScanner *scanner, int dir_fd, const char *path,
+                     size_t buffer_size)
+{
+    scanner->dir = NULL;
+    scanner->fd = -1;
+    scanner->buffer = NULL;
+    scanner->buffer_size = 0;
+    scanner->batch = NULL;
+    scanner->batch_capacity = 0;
+
+#ifdef __linux__
+    if (dir_fd >= 0) {
+        if (buffer_size == 0) {
+            buffer_size = SCANNER_DEFAULT_BUFFER_SIZE;
+        } else if (buffer_size < SCANNER_MIN_BUFFER_SIZE) {
+            buffer_size = SCANNER_MIN_BUFFER_SIZE;
+        }
+
+        scanner->fd = openat(dir_fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        scanner->buffer = malloc(buffer_size);
+        if (scanner->fd >= 0 && scanner->buffer) {
+            scanner->buffer_size = buffer_size;
+            return 0;
+        }
+
+        int saved = errno;
+        dir_scanner_close(scanner);
+        errno = saved;
+        return -1;
+    }
+#else
+    (void)buffer_size;
+#endif
+
+#ifndef _WIN32
+    if (dir_fd >= 0) {
+        int fd = openat(dir_fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd >= 0 && (scanner->dir = fdopendir(fd)) == NULL) {
+            close(fd);
+        }
+        return scanner->dir ? 0 : -1;
+    }
+#endif
+
+    scanner->dir = opendir(path);
+    return scanner->dir ? 0 : -1;
+}
+
+/* Make room for 'count' entries in the batch array. */
+static int reserve_batch(DirScanner *scanner, size_t count)
+{
+    if (count <= scanner->batch_capacity) {
+        return 0;
+    }
+
+    ScanEntry *batch = realloc(scanner->batch, count * sizeof(*batch));
+    if (!batch) {
+        return -1;
+    }
+    scanner->batch = batch;
+    scanner->batch_capacity = count;
+    return 0;
+}
+
+#ifdef __linux__
+static long next_getdents_batch(DirScanner *scanner, const ScanEntry **batch)
+{
+    for (;;) {
+        long nread = syscall(SYS_getdents64, scanner->fd,
+                             scanner->buffer, scanner->buffer_size);
+        if (nread < 0 && errno == ENOSYS) {
+            /* Hand the descriptor over to the readdir() fallback. */
+            scanner->dir = fdopendir(scanner->fd);
+            if (!scanner->dir) {
+                return -1;
+            }
+            scanner->fd = -1;
+            return 0;
+        }
+        if (nread <= 0) {
+            return nread;
+        }
+
+        /* Records are at least 24 bytes, which bounds the batch size. */
+        if (reserve_batch(scanner, (size_t)nread / 24 + 1) != 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+
+        size_t count = 0;
+        for (long pos = 0; pos < nread; ) {
+            struct linux_dirent64 *d = (struct linux_dirent64 *)(scanner->buffer + pos);
+            pos += d->d_reclen;
+
+            if (is_dot_or_dotdot(d->d_name)) {
+                continue;
+            }
+
+            /* The name is NUL-padded inside the record; bound the search by it. */
+            size_t max_len = d->d_reclen - offsetof(struct linux_dirent64, d_name);
+            const char *end = memchr(d->d_name, '\0', max_len);
+
+            ScanEntry *entry = &scanner->batch[count++];
+            entry->name = d->d_name;
+            entry->name_len = end ? (size_t)(end - d->d_name) : max_len;
+            entry->type = scan_type_from_dtype(d->d_type);
+            entry->ino = d->d_ino;
+        }
+
+        if (count > 0) {
+            *batch = scanner->batch;
+            return (long)count;
+        }
+        /* Buffer held only "." and ".."; read on. */
+    }
+}
+#endif
+
+long dir_scanner_next_batch(DirScanner *scanner, const ScanEntry **batch)
+{
+#ifdef __linux__
+    if (scanner->fd >= 0) {
+        long count = next_getdents_batch(scanner, batch);
+        if (count != 0 || scanner->fd >= 0) {
+            return count;
+        }
+        /* getdents64 is unavailable; continue below with readdir(). */
+    }
+#endif
+
+    if (!scanner->dir || reserve_batch(scanner, 1) != 0) {
+        errno = scanner->dir ? ENOMEM : EBADF;
+        return -1;
+    }
+
+    /* readdir() may reuse its storage, so the fallback hands out one entry at a time. */
+    struct dirent *d;
+    do {
+        errno = 0;
+        d = readdir(scanner->dir);
+        if (!d) {
+            return errno ? -1 : 0;
+        }
+    } while (is_dot_or_dotdot(d->d_name));
+
+    ScanEntry *entry = &scanner->batch[0];
+    entry->name = d->d_name;
+    entry->name_len = strlen(d->d_name);
+#ifdef DT_UNKNOWN
+    entry->type = scan_type_from_dtype(d->d_type);
+#else
+    entry->type = SCAN_TYPE_UNKNOWN;
+#endif
+    entry->ino = (uint64_t)d->d_ino;
+    *batch = scanner->batch;
+    return 1;
+}
+
+void dir_scanner_close(DirScanner *scanner)
+{
+    if (scanner->dir) {
+        closedir(scanner->dir);
+        scanner->dir = NULL;
+    }
+#ifndef _WIN32
+    if (scanner->fd >= 0) {
+        close(scanner->fd);
+        scanner->fd = -1;
+    }
+#endif
+    free(scanner->buffer);
+    free(scanner->batch);
+    scanner->buffer = NULL;
+    scanner->batch = NULL;
+    scanner->buffer_size = 0;
+    scanner->batch_capacity = 0;
+}
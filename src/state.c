@@ -0,0 +1,257 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       state.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Implementation of the incremental-run state: loading, comparing and
+    atomically saving the state file, plus the set of left-over entries.
+
+ Usage:
+    See state.h.
+
+ Notes:
+    - The file is replaced through "<path>.tmp" and rename(), so a crash
+      leaves either the old or the new state, never a torn one.
+
+==========================================================================================================
+*/
+
+#define _POSIX_C_SOURCE 200809L /* st_mtim/st_ctim, fsync, fileno */
+
+#include "state.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define STATE_HEADER "file-organizer-state 1"
+
+static uint64_t hash_name(const char *name, size_t len)
+{
+    /* FNV-1a, 64-bit */
+    uint64_t h = UINT64_C(14695981039346656037);
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char)name[i];
+        h *= UINT64_C(1099511628211);
+    }
+    return h ? h : 1;
+}
+
+static size_t slot_of(uint64_t ino, uint64_t hash, size_t capacity)
+{
+    uint64_t h = (hash ^ (ino * UINT64_C(0x9e3779b97f4a7c15)));
+    return (size_t)(h ^ (h >> 31)) & (capacity - 1);
+}
+
+static bool known_contains(const KnownSet *set, uint64_t ino, uint64_t hash)
+{
+    if (set->capacity == 0) {
+        return false;
+    }
+    for (size_t i = slot_of(ino, hash, set->capacity); set->slots[i].hash != 0;
+         i = (i + 1) & (set->capacity - 1)) {
+        if (set->slots[i].hash == hash && set->slots[i].ino == ino) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int known_insert(KnownSet *set, uint64_t ino, uint64_t hash)
+{
+    if ((set->count + 1) * 2 > set->capacity) {
+        size_t new_capacity = set->capacity ? set->capacity * 2 : 64;
+        KnownEntry *slots = calloc(new_capacity, sizeof(*slots));
+        if (!slots) {
+            return -1;
+        }
+        for (size_t i = 0; i < set->capacity; ++i) {
+            const KnownEntry *old = &set->slots[i];
+            if (old->hash == 0) {
+                continue;
+            }
+            size_t j = slot_of(old->ino, old->hash, new_capacity);
+            while (slots[j].hash != 0) {
+                j = (j + 1) & (new_capacity - 1);
+            }
+            slots[j] = *old;
+        }
+        free(set->slots);
+        set->slots = slots;
+        set->capacity = new_capacity;
+    }
+
+    size_t i = slot_of(ino, hash, set->capacity);
+    for (; set->slots[i].hash != 0; i = (i + 1) & (set->capacity - 1)) {
+        if (set->slots[i].hash == hash && set->slots[i].ino == ino) {
+            return 0;
+        }
+    }
+    set->slots[i].ino = ino;
+    set->slots[i].hash = hash;
+    set->count++;
+    return 0;
+}
+
+static DirStamp stamp_of(const struct stat *st)
+{
+    DirStamp stamp;
+    stamp.dev = (uint64_t)st->st_dev;
+    stamp.ino = (uint64_t)st->st_ino;
+#ifndef _WIN32
+    stamp.mtime_sec = (int64_t)st->st_mtim.tv_sec;
+    stamp.mtime_nsec = st->st_mtim.tv_nsec;
+    stamp.ctime_sec = (int64_t)st->st_ctim.tv_sec;
+    stamp.ctime_nsec = st->st_ctim.tv_nsec;
+#else
+    stamp.mtime_sec = (int64_t)st->st_mtime;
+    stamp.mtime_nsec = 0;
+    stamp.ctime_sec = (int64_t)st->st_ctime;
+    stamp.ctime_nsec = 0;
+#endif
+    return stamp;
+}
+
+int incremental_load(IncrementalState *state, const char *path)
+{
+    memset(state, 0, sizeof(*state));
+
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    char header[64];
+    int trusted = 0;
+    DirStamp *stamp = &state->stamp;
+    int result = 0;
+
+    if (!fgets(header, sizeof(header), in) ||
+        strncmp(header, STATE_HEADER "\n", sizeof(header)) != 0 ||
+        fscanf(in, "dir %" SCNu64 " %" SCNu64 " %" SCNd64 " %ld %" SCNd64 " %ld %d\n",
+               &stamp->dev, &stamp->ino, &stamp->mtime_sec, &stamp->mtime_nsec,
+               &stamp->ctime_sec, &stamp->ctime_nsec, &trusted) != 7) {
+        result = -1;
+    }
+
+    uint64_t ino, hash;
+    while (result == 0 && fscanf(in, "known %" SCNu64 " %" SCNu64 "\n", &ino, &hash) == 2) {
+        if (hash == 0 || known_insert(&state->previous, ino, hash) != 0) {
+            result = -1;
+        }
+    }
+    if (result == 0 && !feof(in)) {
+        result = -1;
+    }
+
+    fclose(in);
+    if (result != 0) {
+        incremental_free(state);
+        errno = EINVAL;
+        return -1;
+    }
+    state->loaded = trusted == 1;
+    return 0;
+}
+
+bool incremental_unchanged(const IncrementalState *state, const struct stat *st)
+{
+    if (!state->loaded) {
+        return false;
+    }
+    DirStamp now = stamp_of(st);
+    const DirStamp *then = &state->stamp;
+    return now.dev == then->dev && now.ino == then->ino &&
+           now.mtime_sec == then->mtime_sec && now.mtime_nsec == then->mtime_nsec &&
+           now.ctime_sec == then->ctime_sec && now.ctime_nsec == then->ctime_nsec;
+}
+
+bool incremental_skip(IncrementalState *state, const ScanEntry *entry)
+{
+    uint64_t hash = hash_name(entry->name, entry->name_len);
+    if (!known_contains(&state->previous, entry->ino, hash)) {
+        return false;
+    }
+    /* Still there, so still left over; a failed insert only costs a rescan. */
+    known_insert(&state->next, entry->ino, hash);
+    return true;
+}
+
+int incremental_note_skipped(IncrementalState *state, const ScanEntry *entry)
+{
+    return known_insert(&state->next, entry->ino, hash_name(entry->name, entry->name_len));
+}
+
+int incremental_save(const IncrementalState *state, const char *path,
+                     const struct stat *st, bool trusted)
+{
+    char tmp_path[PATH_MAX];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    /* A change within the timestamp granularity of the stat() may not show. */
+    DirStamp stamp = stamp_of(st);
+    if ((int64_t)time(NULL) - stamp.mtime_sec < 2 || (int64_t)time(NULL) - stamp.ctime_sec < 2) {
+        trusted = false;
+    }
+
+    FILE *out = fopen(tmp_path, "w");
+    if (!out) {
+        return -1;
+    }
+
+    fprintf(out, STATE_HEADER "\n");
+    fprintf(out, "dir %" PRIu64 " %" PRIu64 " %" PRId64 " %ld %" PRId64 " %ld %d\n",
+            stamp.dev, stamp.ino, stamp.mtime_sec, stamp.mtime_nsec,
+            stamp.ctime_sec, stamp.ctime_nsec, trusted ? 1 : 0);
+    for (size_t i = 0; i < state->next.capacity; ++i) {
+        const KnownEntry *entry = &state->next.slots[i];
+        if (entry->hash != 0) {
+            fprintf(out, "known %" PRIu64 " %" PRIu64 "\n", entry->ino, entry->hash);
+        }
+    }
+
+    int failed = fflush(out) != 0;
+#ifndef _WIN32
+    failed = failed || fsync(fileno(out)) != 0;
+#endif
+    int saved = errno;
+    if (fclose(out) != 0 && !failed) {
+        failed = 1;
+        saved = errno;
+    }
+    if (failed || rename(tmp_path, path) != 0) {
+        saved = failed ? saved : errno;
+        remove(tmp_path);
+        errno = saved;
+        return -1;
+    }
+    return 0;
+}
+
+void incremental_free(IncrementalState *state)
+{
+    free(state->previous.slots);
+    free(state->next.slots);
+    memset(state, 0, sizeof(*state));
+}
@@ -0,0 +1,295 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       thread_pool.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    pthread implementation of the worker pool. Dispatch is a generation
+    counter under one mutex: thread_pool_run() publishes a task, bumps the
+    generation and waits until every helper thread has finished it.
+
+ Usage:
+    See thread_pool.h.
+
+ Notes:
+    - The pool is meant for a handful of coarse tasks per run, not for
+      fine-grained work items.
+
+==========================================================================================================
+*/
+
+#include "thread_pool.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+
+void pool_mutex_init(PoolMutex *mutex)
+{
+    pthread_mutex_init(mutex, NULL);
+}
+
+void pool_mutex_lock(PoolMutex *mutex)
+{
+    pthread_mutex_lock(mutex);
+}
+
+void pool_mutex_unlock(PoolMutex *mutex)
+{
+    pthread_mutex_unlock(mutex);
+}
+
+void pool_mutex_destroy(PoolMutex *mutex)
+{
+    pthread_mutex_destroy(mutex);
+}
+
+void pool_cond_init(PoolCond *cond)
+{
+    pthread_cond_init(cond, NULL);
+}
+
+void pool_cond_wait(PoolCond *cond, PoolMutex *mutex)
+{
+    pthread_cond_wait(cond, mutex);
+}
+
+void pool_cond_broadcast(PoolCond *cond)
+{
+    pthread_cond_broadcast(cond);
+}
+
+void pool_cond_destroy(PoolCond *cond)
+{
+    pthread_cond_destroy(cond);
+}
+
+struct ThreadPool {
+    unsigned size;
+    pthread_t *threads;      /* size - 1 helpers; the caller is worker 0 */
+    unsigned started;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    unsigned long generation;
+    unsigned pending;
+    bool stopping;
+
+    ThreadPoolTask task;
+    void *arg;
+};
+
+typedef struct {
+    ThreadPool *pool;
+    unsigned index;
+} WorkerStart;
+
+static void *worker_main(void *start_arg)
+{
+    WorkerStart *start = start_arg;
+    ThreadPool *pool = start->pool;
+    unsigned index = start->index;
+    free(start);
+
+    /* Generation 0 is "no task yet"; a task published before this thread
+     * got scheduled must still be picked up. */
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    for (;;) {
+        while (pool->generation == seen && !pool->stopping) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->stopping) {
+            break;
+        }
+
+        seen = pool->generation;
+        ThreadPoolTask task = pool->task;
+        void *arg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+
+        task(arg, index, pool->size);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool *thread_pool_create(unsigned workers)
+{
+    ThreadPool *pool = calloc(1, sizeof(*pool));
+    if (!pool) {
+        return NULL;
+    }
+
+    pool->size = workers ? workers : 1;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    if (pool->size > 1) {
+        pool->threads = calloc(pool->size - 1, sizeof(*pool->threads));
+        if (!pool->threads) {
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+    }
+
+    for (unsigned i = 1; i < pool->size; ++i) {
+        WorkerStart *start = malloc(sizeof(*start));
+        if (!start) {
+            break;
+        }
+        start->pool = pool;
+        start->index = i;
+        if (pthread_create(&pool->threads[i - 1], NULL, worker_main, start) != 0) {
+            free(start);
+            break;
+        }
+        pool->started++;
+    }
+
+    if (pool->started != pool->size - 1) {
+        thread_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+unsigned thread_pool_size(const ThreadPool *pool)
+{
+    return pool->size;
+}
+
+void thread_pool_run(ThreadPool *pool, ThreadPoolTask task, void *arg)
+{
+    if (pool->size > 1) {
+        pthread_mutex_lock(&pool->lock);
+        pool->task = task;
+        pool->arg = arg;
+        pool->pending = pool->size - 1;
+        pool->generation++;
+        pthread_cond_broadcast(&pool->work_ready);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    task(arg, 0, pool->size);
+
+    if (pool->size > 1) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->pending > 0) {
+            pthread_cond_wait(&pool->work_done, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+void thread_pool_destroy(ThreadPool *pool)
+{
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (unsigned i = 0; i < pool->started; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
+
+#else /* _WIN32: single inline worker */
+
+void pool_mutex_init(PoolMutex *mutex)
+{
+    *mutex = 0;
+}
+
+void pool_mutex_lock(PoolMutex *mutex)
+{
+    (void)mutex;
+}
+
+void pool_mutex_unlock(PoolMutex *mutex)
+{
+    (void)mutex;
+}
+
+void pool_mutex_destroy(PoolMutex *mutex)
+{
+    (void)mutex;
+}
+
+void pool_cond_init(PoolCond *cond)
+{
+    *cond = 0;
+}
+
+void pool_cond_wait(PoolCond *cond, PoolMutex *mutex)
+{
+    (void)cond;
+    (void)mutex;
+}
+
+void pool_cond_broadcast(PoolCond *cond)
+{
+    (void)cond;
+}
+
+void pool_cond_destroy(PoolCond *cond)
+{
+    (void)cond;
+}
+
+struct ThreadPool {
+    unsigned size;
+};
+
+ThreadPool *thread_pool_create(unsigned workers)
+{
+    (void)workers;
+    ThreadPool *pool = malloc(sizeof(*pool));
+    if (pool) {
+        pool->size = 1;
+    }
+    return pool;
+}
+
+unsigned thread_pool_size(const ThreadPool *pool)
+{
+    return pool->size;
+}
+
+void thread_pool_run(ThreadPool *pool, ThreadPoolTask task, void *arg)
+{
+    task(arg, 0, pool->size);
+}
+
+void thread_pool_destroy(ThreadPool *pool)
+{
+    free(pool);
+}
+
+#endif
@@ -0,0 +1,328 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       throttle.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Rate limits and priority controls.
+
+ Usage:
+    See throttle.h.
+
+ Notes:
+    - A reservation moves the bucket's due time forward by the request's
+      cost (count / rate seconds) and returns once the old due time, less
+      the burst allowance, has passed.
+    - Not available on Windows: limits are accepted but never wait, and
+      throttle_lower_priority() fails with ENOSYS.
+
+==========================================================================================================
+*/
+
+#define _GNU_SOURCE /* SCHED_IDLE, syscall() */
+
+#include "throttle.h"
+#include "logger.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <sched.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+#define NS_PER_SEC UINT64_C(1000000000)
+
+/* Linux I/O priority encoding (linux/ioprio.h). */
+#define IOPRIO_CLASS_SHIFT  13
+#define IOPRIO_CLASS_BE     2
+#define IOPRIO_CLASS_IDLE   3
+#define IOPRIO_WHO_PROCESS  1
+
+#ifndef _WIN32
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns)
+{
+    struct timespec ts = { (time_t)(ns / NS_PER_SEC), (long)(ns % NS_PER_SEC) };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+#endif
+
+/* Nanoseconds 'count' units take at 'rate' units per second, without overflow. */
+static uint64_t cost_ns(uint64_t count, uint64_t rate)
+{
+    return count / rate * NS_PER_SEC + count % rate * NS_PER_SEC / rate;
+}
+
+void throttle_init(Throttle *throttle, uint64_t ops_per_sec, uint64_t bytes_per_sec)
+{
+    memset(throttle, 0, sizeof(*throttle));
+    throttle->ops.rate = ops_per_sec;
+    throttle->bytes.rate = bytes_per_sec;
+    pool_mutex_init(&throttle->lock);
+}
+
+static void bucket_set(ThrottleBucket *bucket, uint64_t rate)
+{
+    __atomic_store_n(&bucket->rate, rate, __ATOMIC_RELAXED);
+    bucket->due_ns = 0; /* the new rate starts from now, not from the old backlog */
+    __atomic_add_fetch(&bucket->generation, 1, __ATOMIC_RELAXED);
+}
+
+void throttle_set(Throttle *throttle, uint64_t ops_per_sec, uint64_t bytes_per_sec)
+{
+    pool_mutex_lock(&throttle->lock);
+    bucket_set(&throttle->ops, ops_per_sec);
+    bucket_set(&throttle->bytes, bytes_per_sec);
+    pool_mutex_unlock(&throttle->lock);
+}
+
+/* Parse "N[K|M|G]" (powers of 1024) up to the end of the token. */
+static int parse_rate(const char *text, uint64_t *out)
+{
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (errno != 0 || end == text || text[0] == '-') {
+        return -1;
+    }
+
+    unsigned shift = 0;
+    switch (*end) {
+    case 'K': case 'k': shift = 10; ++end; break;
+    case 'M': case 'm': shift = 20; ++end; break;
+    case 'G': case 'g': shift = 30; ++end; break;
+    default: break;
+    }
+    while (isspace((unsigned char)*end)) {
+        ++end;
+    }
+    if (*end != '\0' || value > (UINT64_MAX >> shift)) {
+        return -1;
+    }
+    *out = (uint64_t)value << shift;
+    return 0;
+}
+
+static int read_limits(const char *path, uint64_t *ops, uint64_t *bytes)
+{
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        return -1;
+    }
+
+    *ops = 0;
+    *bytes = 0;
+    char line[256];
+    int result = 0;
+    while (result == 0 && fgets(line, sizeof(line), in)) {
+        char *hash = strchr(line, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+        char *key = line;
+        while (isspace((unsigned char)*key)) {
+            ++key;
+        }
+        if (*key == '\0') {
+            continue;
+        }
+        char *value = key;
+        while (*value && !isspace((unsigned char)*value)) {
+            ++value;
+        }
+        if (*value) {
+            *value++ = '\0';
+        }
+        while (isspace((unsigned char)*value)) {
+            ++value;
+        }
+
+        uint64_t *target = strcmp(key, "ops") == 0 ? ops
+                           : strcmp(key, "bandwidth") == 0 ? bytes : NULL;
+        if (!target || parse_rate(value, target) != 0) {
+            result = -1;
+        }
+    }
+    if (result == 0 && ferror(in)) {
+        result = -1;
+    } else if (result != 0) {
+        errno = EINVAL;
+    }
+    fclose(in);
+    return result;
+}
+
+int throttle_load(Throttle *throttle, const char *path)
+{
+    uint64_t ops, bytes;
+    if (read_limits(path, &ops, &bytes) != 0) {
+        return -1;
+    }
+
+    char *copy = malloc(strlen(path) + 1);
+    if (!copy) {
+        return -1;
+    }
+    strcpy(copy, path);
+
+    pool_mutex_lock(&throttle->lock);
+    free(throttle->limits_path);
+    throttle->limits_path = copy;
+    bucket_set(&throttle->ops, ops);
+    bucket_set(&throttle->bytes, bytes);
+    pool_mutex_unlock(&throttle->lock);
+    return 0;
+}
+
+int throttle_reload(Throttle *throttle)
+{
+    uint64_t ops, bytes;
+    if (!throttle->limits_path) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (read_limits(throttle->limits_path, &ops, &bytes) != 0) {
+        return -1;
+    }
+    throttle_set(throttle, ops, bytes);
+    return 0;
+}
+
+void throttle_request_reload(Throttle *throttle)
+{
+    if (throttle) {
+        __atomic_store_n(&throttle->reload_pending, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void throttle_poll(Throttle *throttle)
+{
+    if (!throttle || __atomic_load_n(&throttle->reload_pending, __ATOMIC_RELAXED) == 0 ||
+        __atomic_exchange_n(&throttle->reload_pending, 0, __ATOMIC_RELAXED) == 0) {
+        return;
+    }
+
+    if (throttle_reload(throttle) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Cannot reload limits file '%s': %s; keeping the current limits\n",
+                   throttle->limits_path ? throttle->limits_path : "", strerror(errno));
+        return;
+    }
+    logger_log(LOG_LEVEL_INFO, "Limits reloaded: %llu ops/s, %llu bytes/s (0 = unlimited)\n",
+               (unsigned long long)__atomic_load_n(&throttle->ops.rate, __ATOMIC_RELAXED),
+               (unsigned long long)__atomic_load_n(&throttle->bytes.rate, __ATOMIC_RELAXED));
+}
+
+static void bucket_take(Throttle *throttle, ThrottleBucket *bucket, uint64_t count)
+{
+    throttle_poll(throttle);
+    if (!throttle || count == 0 || __atomic_load_n(&bucket->rate, __ATOMIC_RELAXED) == 0) {
+        return;
+    }
+#ifndef _WIN32
+    for (;;) {
+        pool_mutex_lock(&throttle->lock);
+        uint64_t rate = bucket->rate;
+        if (rate == 0) {
+            pool_mutex_unlock(&throttle->lock);
+            return;
+        }
+        uint64_t now = now_ns();
+        uint64_t due = bucket->due_ns > now ? bucket->due_ns : now;
+        bucket->due_ns = due + cost_ns(count, rate);
+        uint64_t generation = bucket->generation;
+        pool_mutex_unlock(&throttle->lock);
+
+        /* Sleep in slices, so a new rate is noticed. */
+        uint64_t start = due > THROTTLE_BURST_NS ? due - THROTTLE_BURST_NS : 0;
+        bool requeue = false;
+        while ((now = now_ns()) < start) {
+            uint64_t left = start - now;
+            sleep_ns(left < THROTTLE_SLICE_NS ? left : THROTTLE_SLICE_NS);
+            throttle_poll(throttle);
+            if (__atomic_load_n(&bucket->generation, __ATOMIC_RELAXED) != generation) {
+                requeue = true;
+                break;
+            }
+        }
+        if (!requeue) {
+            return;
+        }
+    }
+#endif
+}
+
+void throttle_ops(Throttle *throttle, uint64_t count)
+{
+    if (throttle) {
+        bucket_take(throttle, &throttle->ops, count);
+    }
+}
+
+void throttle_bytes(Throttle *throttle, uint64_t count)
+{
+    if (throttle) {
+        bucket_take(throttle, &throttle->bytes, count);
+    }
+}
+
+bool throttle_limits_bytes(Throttle *throttle)
+{
+    return throttle && __atomic_load_n(&throttle->bytes.rate, __ATOMIC_RELAXED) != 0;
+}
+
+void throttle_destroy(Throttle *throttle)
+{
+    free(throttle->limits_path);
+    throttle->limits_path = NULL;
+    pool_mutex_destroy(&throttle->lock);
+}
+
+int throttle_lower_priority(ThrottleIoClass io_class, unsigned level, bool sched_idle)
+{
+#if defined(__linux__) && defined(SYS_ioprio_set)
+    if (io_class != THROTTLE_IO_DEFAULT) {
+        int value = io_class == THROTTLE_IO_IDLE
+                    ? IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT
+                    : (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | (int)(level & 7);
+        if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, value) != 0) {
+            return -1;
+        }
+    }
+    if (sched_idle) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        if (sched_setscheduler(0, SCHED_IDLE, &param) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+#else
+    if (io_class == THROTTLE_IO_DEFAULT && !sched_idle) {
+        return 0;
+    }
+    (void)level;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
@@ -0,0 +1,310 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       undo.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Journal replay for organizer_undo(): walks the journal from its last
+    record to its first, renaming every moved file back, restoring dropped
+    duplicates and removing the category directories the runs created.
+
+ Usage:
+    OrganizerConfig config = { .backend = ORGANIZER_BACKEND_URING };
+    int rc = organizer_undo(&config, "moves.journal");
+
+ Notes:
+    - Restores never overwrite: the serial backend checks the original path
+      first, the io_uring backend renames with RENAME_NOREPLACE.
+    - With io_uring, renames are kept in flight up to the queue depth; the
+      ring is drained before a directory removal and before switching to an
+      older run's target directory.
+    - A category directory that is not empty again (files were added after
+      the run) is kept.
+    - Categories kept outside the target directory are journaled by
+      absolute path; a restore from another file system that rename()
+      refuses with EXDEV is done by copying, like the original move.
+    - A removed duplicate is restored as a copy of the file it duplicated
+      (a reflink where the file system can share extents), so it does not
+      share an inode with it; the hard link of a linked one is removed.
+
+==========================================================================================================
+*/
+
+#define _POSIX_C_SOURCE 200809L /* openat, fstatat, renameat, unlinkat */
+
+#include "organizer.h"
+#include "crossdev.h"
+#include "journal.h"
+#include "logger.h"
+#include "uring.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE (1u << 0)
+#endif
+
+/*
+ * printf arguments for "%s%s%s": a journal path under the run's base, or
+ * the path itself when it is absolute (an external destination).
+ */
+#define JOURNAL_PATH(base, path) \
+    ((path)[0] == '/' ? "" : (base)), ((path)[0] == '/' ? "" : "/"), (path)
+
+typedef struct {
+    const OrganizerConfig *config;
+    const JournalReader *journal;
+    const char *base;  /* target directory of the records being replayed */
+    int base_fd;
+    Uring ring;
+    bool use_ring;
+    int result;
+} UndoRun;
+
+static void log_restore(const JournalEntry *entry, int err)
+{
+    if (err != 0) {
+        logger_log(LOG_LEVEL_ERROR,
+                   "Failed to restore '%s%s%s' -> '%s/%s': %s\n",
+                   JOURNAL_PATH(entry->base, entry->dst), entry->base, entry->src,
+                   strerror(err));
+    } else {
+        logger_log(LOG_LEVEL_INFO,
+                   "Restored '%s%s%s' -> '%s/%s'\n",
+                   JOURNAL_PATH(entry->base, entry->dst), entry->base, entry->src);
+    }
+}
+
+/*
+ * Submit what is queued and reap completions. With 'drain' set, wait until
+ * nothing is in flight; otherwise wait until at least one slot is free.
+ */
+static int undo_flush(UndoRun *run, bool drain)
+{
+    UringCompletion done[64];
+
+    while (run->ring.inflight > 0 && (drain || uring_space(&run->ring) == 0)) {
+        if (uring_submit_and_wait(&run->ring, 1) != 0) {
+            logger_log(LOG_LEVEL_ERROR, "io_uring submission failed: %s\n", strerror(errno));
+            return -1;
+        }
+
+        unsigned count;
+        while ((count = uring_reap(&run->ring, done, 64)) > 0) {
+            for (unsigned i = 0; i < count; ++i) {
+                const JournalEntry *entry = &run->journal->entries[done[i].user_data];
+                int err = -done[i].res;
+                if (err == EXDEV) {
+                    err = crossdev_move(run->base_fd, entry->dst, run->base_fd, entry->src) != 0
+                          ? errno : 0;
+                }
+                log_restore(entry, err);
+                if (err != 0) {
+                    run->result = 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/* Make 'base' the directory records are resolved against. */
+static int undo_open_base(UndoRun *run, const char *base)
+{
+    if (run->base == base) {
+        return run->base_fd >= 0 ? 0 : -1;
+    }
+    if (run->use_ring && undo_flush(run, true) != 0) {
+        return -1;
+    }
+    if (run->base_fd >= 0) {
+        close(run->base_fd);
+    }
+
+    run->base = base;
+    run->base_fd = open(base, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (run->base_fd < 0) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to open directory '%s': %s\n",
+                   base, strerror(errno));
+        return -1;
+    }
+    logger_log(LOG_LEVEL_INFO, "Undoing run on '%s'%s\n", base,
+               run->config->dry_run ? " (dry-run mode)" : "");
+    return 0;
+}
+
+static int undo_move(UndoRun *run, size_t index)
+{
+    const JournalEntry *entry = &run->journal->entries[index];
+
+    if (run->config->dry_run) {
+        logger_log(LOG_LEVEL_INFO, "[DRY-RUN] Restore '%s%s%s' -> '%s/%s'\n",
+                   JOURNAL_PATH(entry->base, entry->dst), entry->base, entry->src);
+        return 0;
+    }
+
+    if (run->use_ring) {
+        if (uring_space(&run->ring) == 0 && undo_flush(run, false) != 0) {
+            return -1;
+        }
+        uring_prep_renameat(&run->ring, run->base_fd, entry->dst,
+                            run->base_fd, entry->src, RENAME_NOREPLACE, (uint64_t)index);
+        return 0;
+    }
+
+    struct stat st;
+    int err = 0;
+    if (fstatat(run->base_fd, entry->src, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+        err = EEXIST;
+    } else if (renameat(run->base_fd, entry->dst, run->base_fd, entry->src) != 0) {
+        err = errno;
+        if (err == EXDEV) {
+            err = crossdev_move(run->base_fd, entry->dst, run->base_fd, entry->src) != 0
+                  ? errno : 0;
+        }
+    }
+    log_restore(entry, err);
+    if (err != 0) {
+        run->result = 1;
+    }
+    return 0;
+}
+
+static int undo_duplicate(UndoRun *run, const JournalEntry *entry)
+{
+    if (run->config->dry_run) {
+        logger_log(LOG_LEVEL_INFO, "[DRY-RUN] Restore duplicate '%s%s%s' -> '%s/%s'\n",
+                   JOURNAL_PATH(entry->base, entry->dst), entry->base, entry->src);
+        return 0;
+    }
+
+    /* The copy is created with O_EXCL, so it never overwrites either. */
+    int err = crossdev_copy(run->base_fd, entry->dst, run->base_fd, entry->src) != 0 ? errno : 0;
+    if (err == 0 && entry->type == JOURNAL_RECORD_LINK &&
+        unlinkat(run->base_fd, entry->dst, 0) != 0 && errno != ENOENT) {
+        logger_log(LOG_LEVEL_WARN, "Failed to remove link '%s%s%s': %s\n",
+                   JOURNAL_PATH(entry->base, entry->dst), strerror(errno));
+    }
+    log_restore(entry, err);
+    if (err != 0) {
+        run->result = 1;
+    }
+    return 0;
+}
+
+static int undo_mkdir(UndoRun *run, const JournalEntry *entry)
+{
+    if (run->config->dry_run) {
+        logger_log(LOG_LEVEL_INFO, "[DRY-RUN] Remove directory '%s%s%s' if empty\n",
+                   JOURNAL_PATH(entry->base, entry->src));
+        return 0;
+    }
+
+    /* Every move into the directory comes later in the journal, so it is done. */
+    if (run->use_ring && undo_flush(run, true) != 0) {
+        return -1;
+    }
+
+    if (unlinkat(run->base_fd, entry->src, AT_REMOVEDIR) == 0) {
+        logger_log(LOG_LEVEL_INFO, "Removed directory: %s%s%s\n",
+                   JOURNAL_PATH(entry->base, entry->src));
+    } else if (errno == ENOTEMPTY || errno == EEXIST) {
+        logger_log(LOG_LEVEL_WARN, "Keeping directory '%s%s%s' (not empty)\n",
+                   JOURNAL_PATH(entry->base, entry->src));
+    } else if (errno != ENOENT) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to remove directory '%s%s%s': %s\n",
+                   JOURNAL_PATH(entry->base, entry->src), strerror(errno));
+        run->result = 1;
+    }
+    return 0;
+}
+
+int organizer_undo(const OrganizerConfig *config, const char *journal_path)
+{
+    if (config == NULL || journal_path == NULL) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid configuration\n");
+        return 1;
+    }
+
+    JournalReader journal;
+    if (journal_load(&journal, journal_path) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Cannot read journal '%s': %s\n",
+                   journal_path, strerror(errno));
+        return 1;
+    }
+
+    UndoRun run;
+    memset(&run, 0, sizeof(run));
+    run.config = config;
+    run.journal = &journal;
+    run.base_fd = -1;
+
+    if (config->backend == ORGANIZER_BACKEND_URING && !config->dry_run) {
+        run.use_ring = uring_open(&run.ring, config->queue_depth) == 0;
+        if (!run.use_ring) {
+            logger_log(LOG_LEVEL_WARN,
+                       "io_uring backend unavailable (%s); using serial execution\n",
+                       strerror(errno));
+        }
+    }
+
+    for (size_t i = journal.count; i-- > 0; ) {
+        const JournalEntry *entry = &journal.entries[i];
+        if (entry->type == JOURNAL_RECORD_RUN) {
+            continue;
+        }
+
+        int rc = undo_open_base(&run, entry->base);
+        if (rc == 0) {
+            switch (entry->type) {
+            case JOURNAL_RECORD_MOVE: rc = undo_move(&run, i); break;
+            case JOURNAL_RECORD_DROP:
+            case JOURNAL_RECORD_LINK: rc = undo_duplicate(&run, entry); break;
+            default:                  rc = undo_mkdir(&run, entry); break;
+            }
+        }
+        if (rc != 0) {
+            run.result = 1;
+            if (run.base_fd >= 0) {
+                break; /* the ring failed */
+            }
+        }
+    }
+
+    if (run.use_ring) {
+        if (undo_flush(&run, true) != 0) {
+            run.result = 1;
+        }
+        uring_close(&run.ring);
+    }
+    if (run.base_fd >= 0) {
+        close(run.base_fd);
+    }
+    journal_reader_free(&journal);
+    return run.result;
+}
+
+#else /* _WIN32 */
+
+int organizer_undo(const OrganizerConfig *config, const char *journal_path)
+{
+    (void)config;
+    logger_log(LOG_LEVEL_ERROR, "Undo is not supported on this platform: '%s'\n", journal_path);
+    return 1;
+}
+
+#endif
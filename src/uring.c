@@ -0,0 +1,430 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       uring.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    io_uring implementation using the raw io_uring_setup/enter/register
+    system calls and the ring layout from <linux/io_uring.h>.
+
+ Usage:
+    See uring.h.
+
+ Notes:
+    - Ring indices are shared with the kernel and accessed with GCC/Clang
+      __atomic builtins (acquire on loads, release on stores).
+    - Supported opcodes are checked with IORING_REGISTER_PROBE at setup time.
+
+==========================================================================================================
+*/
+
+#define _DEFAULT_SOURCE /* syscall(), MAP_POPULATE */
+
+#include "uring.h"
+
+#include <errno.h>
+#include <string.h>
+
+#if defined(__linux__) && !defined(ORGANIZER_NO_IO_URING)
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return (int)syscall(SYS_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                              unsigned flags)
+{
+    return (int)syscall(SYS_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+    return (int)syscall(SYS_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static int supports_required_ops(int fd)
+{
+    static const unsigned char REQUIRED[] = {
+        IORING_OP_RENAMEAT, IORING_OP_MKDIRAT, IORING_OP_STATX,
+        IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE,
+    };
+    const unsigned nr_ops = 256;
+
+    struct io_uring_probe *probe =
+        calloc(1, sizeof(*probe) + nr_ops * sizeof(struct io_uring_probe_op));
+    if (!probe) {
+        return 0;
+    }
+
+    int ok = sys_io_uring_register(fd, IORING_REGISTER_PROBE, probe, nr_ops) == 0;
+    for (size_t i = 0; ok && i < sizeof(REQUIRED); ++i) {
+        unsigned op = REQUIRED[i];
+        ok = op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    free(probe);
+    return ok;
+}
+
+int uring_open(Uring *ring, unsigned queue_depth)
+{
+    struct io_uring_params params;
+
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+    memset(&params, 0, sizeof(params));
+
+    if (queue_depth == 0) {
+        queue_depth = URING_DEFAULT_QUEUE_DEPTH;
+    }
+
+    int fd = sys_io_uring_setup(queue_depth, &params);
+    if (fd < 0) {
+        return -1;
+    }
+    ring->fd = fd;
+
+    if (!supports_required_ops(fd)) {
+        uring_close(ring);
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+
+    ring->entries = params.sq_entries;
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_ring_size > ring->sq_ring_size) {
+            ring->sq_ring_size = ring->cq_ring_size;
+        }
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        ring->sq_ring = NULL;
+        uring_close(ring);
+        return -1;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            ring->cq_ring = NULL;
+            uring_close(ring);
+            return -1;
+        }
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        uring_close(ring);
+        return -1;
+    }
+
+    char *sq = ring->sq_ring;
+    ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->sq_local_tail = *ring->sq_tail;
+
+    char *cq = ring->cq_ring;
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = cq + params.cq_off.cqes;
+    return 0;
+}
+
+void uring_close(Uring *ring)
+{
+    if (ring->sqes) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ring && ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring) {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+unsigned uring_space(const Uring *ring)
+{
+    /* Never hold more operations than the completion side can absorb. */
+    return ring->entries - ring->inflight;
+}
+
+static struct io_uring_sqe *next_sqe(Uring *ring)
+{
+    if (uring_space(ring) == 0) {
+        return NULL;
+    }
+
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (ring->sq_local_tail - head >= ring->entries) {
+        return NULL;
+    }
+
+    unsigned index = ring->sq_local_tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &((struct io_uring_sqe *)ring->sqes)[index];
+    ring->sq_array[index] = index;
+    ring->sq_local_tail++;
+    ring->inflight++;
+
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int uring_prep_renameat(Uring *ring, int old_dfd, const char *old_path,
+                        int new_dfd, const char *new_path,
+                        unsigned flags, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = next_sqe(ring);
+    if (!sqe) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_RENAMEAT;
+    sqe->fd = old_dfd;
+    sqe->addr = (uint64_t)(uintptr_t)old_path;
+    sqe->len = (unsigned)new_dfd;
+    sqe->addr2 = (uint64_t)(uintptr_t)new_path;
+    sqe->rename_flags = flags;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+int uring_prep_mkdirat(Uring *ring, int dfd, const char *path,
+                       unsigned mode, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = next_sqe(ring);
+    if (!sqe) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_MKDIRAT;
+    sqe->fd = dfd;
+    sqe->addr = (uint64_t)(uintptr_t)path;
+    sqe->len = mode;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+int uring_prep_statx(Uring *ring, int dfd, const char *path, int flags,
+                     unsigned mask, void *statx_buf, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = next_sqe(ring);
+    if (!sqe) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_STATX;
+    sqe->fd = dfd;
+    sqe->addr = (uint64_t)(uintptr_t)path;
+    sqe->len = mask;
+    sqe->off = (uint64_t)(uintptr_t)statx_buf;
+    sqe->statx_flags = (unsigned)flags;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+int uring_prep_openat(Uring *ring, int dfd, const char *path, int flags,
+                      unsigned mode, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = next_sqe(ring);
+    if (!sqe) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = dfd;
+    sqe->addr = (uint64_t)(uintptr_t)path;
+    sqe->len = mode;
+    sqe->open_flags = (unsigned)flags;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+int uring_prep_read(Uring *ring, int fd, void *buf, unsigned len,
+                    uint64_t offset, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = next_sqe(ring);
+    if (!sqe) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+int uring_prep_close(Uring *ring, int fd, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = next_sqe(ring);
+    if (!sqe) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fd;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+int uring_submit_and_wait(Uring *ring, unsigned wait_nr)
+{
+    unsigned to_submit = ring->sq_local_tail - *ring->sq_tail;
+    __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+
+    if (wait_nr > ring->inflight) {
+        wait_nr = ring->inflight;
+    }
+
+    while (to_submit > 0 || wait_nr > 0) {
+        int rc = sys_io_uring_enter(ring->fd, to_submit, wait_nr,
+                                    wait_nr ? IORING_ENTER_GETEVENTS : 0);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        to_submit -= (unsigned)rc <= to_submit ? (unsigned)rc : to_submit;
+        if (to_submit == 0) {
+            break; /* the kernel only returns once min_complete is met */
+        }
+    }
+    return 0;
+}
+
+unsigned uring_reap(Uring *ring, UringCompletion *out, unsigned max)
+{
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    unsigned count = 0;
+
+    while (head != tail && count < max) {
+        const struct io_uring_cqe *cqe =
+            &((const struct io_uring_cqe *)ring->cqes)[head & *ring->cq_mask];
+        out[count].user_data = cqe->user_data;
+        out[count].res = cqe->res;
+        ++count;
+        ++head;
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    ring->inflight -= count;
+    return count;
+}
+
+#else /* no io_uring */
+
+int uring_open(Uring *ring, unsigned queue_depth)
+{
+    (void)queue_depth;
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+    errno = ENOSYS;
+    return -1;
+}
+
+void uring_close(Uring *ring)
+{
+    ring->fd = -1;
+}
+
+unsigned uring_space(const Uring *ring)
+{
+    (void)ring;
+    return 0;
+}
+
+int uring_prep_renameat(Uring *ring, int old_dfd, const char *old_path,
+                        int new_dfd, const char *new_path,
+                        unsigned flags, uint64_t user_data)
+{
+    (void)ring; (void)old_dfd; (void)old_path; (void)new_dfd;
+    (void)new_path; (void)flags; (void)user_data;
+    return -1;
+}
+
+int uring_prep_mkdirat(Uring *ring, int dfd, const char *path,
+                       unsigned mode, uint64_t user_data)
+{
+    (void)ring; (void)dfd; (void)path; (void)mode; (void)user_data;
+    return -1;
+}
+
+int uring_prep_statx(Uring *ring, int dfd, const char *path, int flags,
+                     unsigned mask, void *statx_buf, uint64_t user_data)
+{
+    (void)ring; (void)dfd; (void)path; (void)flags;
+    (void)mask; (void)statx_buf; (void)user_data;
+    return -1;
+}
+
+int uring_prep_openat(Uring *ring, int dfd, const char *path, int flags,
+                      unsigned mode, uint64_t user_data)
+{
+    (void)ring; (void)dfd; (void)path; (void)flags; (void)mode; (void)user_data;
+    return -1;
+}
+
+int uring_prep_read(Uring *ring, int fd, void *buf, unsigned len,
+                    uint64_t offset, uint64_t user_data)
+{
+    (void)ring; (void)fd; (void)buf; (void)len; (void)offset; (void)user_data;
+    return -1;
+}
+
+int uring_prep_close(Uring *ring, int fd, uint64_t user_data)
+{
+    (void)ring; (void)fd; (void)user_data;
+    return -1;
+}
+
+int uring_submit_and_wait(Uring *ring, unsigned wait_nr)
+{
+    (void)ring; (void)wait_nr;
+    errno = ENOSYS;
+    return -1;
+}
+
+unsigned uring_reap(Uring *ring, UringCompletion *out, unsigned max)
+{
+    (void)ring; (void)out; (void)max;
+    return 0;
+}
+
+#endif
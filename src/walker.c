@@ -0,0 +1,412 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       walker.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Work-stealing tree walker. Each worker owns a deque of relative directory
+    paths: it pushes and pops at the tail (depth-first, which keeps queues
+    short) and, when empty, steals from the head of another worker's deque
+    (breadth-first, which hands out large subtrees).
+
+ Usage:
+    See walker.h.
+
+ Notes:
+    - 'pending' counts directories queued or being visited; the walk is over
+      when it drops to zero.
+    - Directories are opened with O_NOFOLLOW relative to the root descriptor.
+    - With options->reads set, opening a directory and each batch read are
+      timed; the callback's own time is not included.
+
+==========================================================================================================
+*/
+
+#define _POSIX_C_SOURCE 200809L /* openat, fstatat, O_NOFOLLOW, O_DIRECTORY, clock_gettime */
+
+#include "walker.h"
+#include "logger.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Per-worker deque of relative directory paths. */
+typedef struct {
+    PoolMutex lock;
+    char **items;
+    unsigned *depths;
+    size_t head;      /* index of the oldest item */
+    size_t count;
+    size_t capacity;  /* power of two */
+} WalkQueue;
+
+/* (st_dev, st_ino) of a visited directory. */
+typedef struct {
+    uint64_t dev;
+    uint64_t ino;
+    bool used;
+} DirIdentity;
+
+typedef struct {
+    const WalkOptions *options;
+    WalkQueue *queues;
+    unsigned workers;
+    unsigned long pending;  /* accessed with __atomic builtins */
+    int failed;             /* accessed with __atomic builtins */
+
+    PoolMutex visited_lock;
+    DirIdentity *visited;
+    size_t visited_count;
+    size_t visited_capacity; /* power of two */
+} Walk;
+
+static int queue_push(WalkQueue *queue, char *path, unsigned depth)
+{
+    pool_mutex_lock(&queue->lock);
+
+    if (queue->count == queue->capacity) {
+        size_t new_capacity = queue->capacity ? queue->capacity * 2 : 64;
+        char **items = malloc(new_capacity * sizeof(*items));
+        unsigned *depths = malloc(new_capacity * sizeof(*depths));
+        if (!items || !depths) {
+            free(items);
+            free(depths);
+            pool_mutex_unlock(&queue->lock);
+            return -1;
+        }
+        for (size_t i = 0; i < queue->count; ++i) {
+            size_t from = (queue->head + i) & (queue->capacity - 1);
+            items[i] = queue->items[from];
+            depths[i] = queue->depths[from];
+        }
+        free(queue->items);
+        free(queue->depths);
+        queue->items = items;
+        queue->depths = depths;
+        queue->head = 0;
+        queue->capacity = new_capacity;
+    }
+
+    size_t slot = (queue->head + queue->count) & (queue->capacity - 1);
+    queue->items[slot] = path;
+    queue->depths[slot] = depth;
+    queue->count++;
+
+    pool_mutex_unlock(&queue->lock);
+    return 0;
+}
+
+/* Take the newest item (owner) or the oldest one (thief). */
+static char *queue_take(WalkQueue *queue, bool steal, unsigned *depth)
+{
+    char *path = NULL;
+
+    pool_mutex_lock(&queue->lock);
+    if (queue->count > 0) {
+        size_t slot;
+        if (steal) {
+            slot = queue->head;
+            queue->head = (queue->head + 1) & (queue->capacity - 1);
+        } else {
+            slot = (queue->head + queue->count - 1) & (queue->capacity - 1);
+        }
+        queue->count--;
+        path = queue->items[slot];
+        *depth = queue->depths[slot];
+    }
+    pool_mutex_unlock(&queue->lock);
+
+    return path;
+}
+
+static size_t hash_identity(uint64_t dev, uint64_t ino)
+{
+    uint64_t h = (ino ^ (dev << 32) ^ (dev >> 32)) * UINT64_C(0x9e3779b97f4a7c15);
+    return (size_t)(h ^ (h >> 29));
+}
+
+/* Record a directory; returns 1 if it is new, 0 if already visited, -1 on OOM. */
+static int mark_visited(Walk *walk, uint64_t dev, uint64_t ino)
+{
+    int result = 1;
+    pool_mutex_lock(&walk->visited_lock);
+
+    if ((walk->visited_count + 1) * 2 > walk->visited_capacity) {
+        size_t new_capacity = walk->visited_capacity ? walk->visited_capacity * 2 : 256;
+        DirIdentity *slots = calloc(new_capacity, sizeof(*slots));
+        if (!slots) {
+            pool_mutex_unlock(&walk->visited_lock);
+            return -1;
+        }
+        for (size_t i = 0; i < walk->visited_capacity; ++i) {
+            const DirIdentity *old = &walk->visited[i];
+            if (!old->used) {
+                continue;
+            }
+            size_t j = hash_identity(old->dev, old->ino) & (new_capacity - 1);
+            while (slots[j].used) {
+                j = (j + 1) & (new_capacity - 1);
+            }
+            slots[j] = *old;
+        }
+        free(walk->visited);
+        walk->visited = slots;
+        walk->visited_capacity = new_capacity;
+    }
+
+    size_t mask = walk->visited_capacity - 1;
+    size_t i = hash_identity(dev, ino) & mask;
+    while (walk->visited[i].used) {
+        if (walk->visited[i].dev == dev && walk->visited[i].ino == ino) {
+            result = 0;
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    if (result == 1) {
+        walk->visited[i].dev = dev;
+        walk->visited[i].ino = ino;
+        walk->visited[i].used = true;
+        walk->visited_count++;
+    }
+
+    pool_mutex_unlock(&walk->visited_lock);
+    return result;
+}
+
+static void set_failed(Walk *walk)
+{
+    __atomic_store_n(&walk->failed, 1, __ATOMIC_RELAXED);
+}
+
+static int is_directory_entry(int dir_fd, const ScanEntry *entry)
+{
+    if (entry->type == SCAN_TYPE_DIRECTORY) {
+        return 1;
+    }
+    if (entry->type != SCAN_TYPE_UNKNOWN) {
+        return 0; /* symlinks included: never followed */
+    }
+
+    struct stat st;
+    return fstatat(dir_fd, entry->name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+}
+
+static char *join_relative(const char *parent, const char *name)
+{
+    size_t parent_len = strlen(parent);
+    size_t name_len = strlen(name);
+    char *path = malloc(parent_len + name_len + 2);
+    if (!path) {
+        return NULL;
+    }
+    if (parent_len > 0) {
+        memcpy(path, parent, parent_len);
+        path[parent_len++] = '/';
+    }
+    memcpy(path + parent_len, name, name_len + 1);
+    return path;
+}
+
+/* Start of a timed directory read, or 0 when reads are not timed. */
+static uint64_t read_start(const WalkOptions *options)
+{
+    if (!options->reads) {
+        return 0;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void read_done(const WalkOptions *options, uint64_t start)
+{
+    if (options->reads) {
+        __atomic_add_fetch(options->read_ns, read_start(options) - start, __ATOMIC_RELAXED);
+        __atomic_add_fetch(options->reads, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/* Visit one directory: stream its entries and queue its subdirectories. */
+static void visit_directory(Walk *walk, unsigned worker, char *rel_path, unsigned depth)
+{
+    const WalkOptions *options = walk->options;
+    const char *shown = rel_path[0] ? rel_path : ".";
+
+    uint64_t start = read_start(options);
+    int fd = rel_path[0]
+             ? openat(options->root_fd, rel_path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)
+             : openat(options->root_fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        logger_log(LOG_LEVEL_WARN, "Skipping directory '%s/%s': %s\n",
+                   options->root_path, shown, strerror(errno));
+        set_failed(walk);
+        return;
+    }
+
+    struct stat st;
+    int fresh = fstat(fd, &st) == 0 ? mark_visited(walk, (uint64_t)st.st_dev, (uint64_t)st.st_ino) : -1;
+    if (fresh <= 0) {
+        if (fresh == 0) {
+            logger_log(LOG_LEVEL_DEBUG, "Skipping already visited directory '%s/%s'\n",
+                       options->root_path, shown);
+        } else {
+            set_failed(walk);
+        }
+        close(fd);
+        return;
+    }
+
+    DirScanner scanner;
+    int opened = dir_scanner_open(&scanner, fd, NULL, options->scan_buffer_size);
+    read_done(options, start);
+    if (opened != 0) {
+        logger_log(LOG_LEVEL_WARN, "Skipping directory '%s/%s': %s\n",
+                   options->root_path, shown, strerror(errno));
+        set_failed(walk);
+        close(fd);
+        return;
+    }
+
+    WalkDir dir = { fd, rel_path, depth };
+    const ScanEntry *batch;
+    long count;
+
+    for (;;) {
+        start = read_start(options);
+        count = dir_scanner_next_batch(&scanner, &batch);
+        read_done(options, start);
+        if (count == 0) {
+            break;
+        }
+        if (count < 0) {
+            logger_log(LOG_LEVEL_ERROR, "Failed to read directory '%s/%s': %s\n",
+                       options->root_path, shown, strerror(errno));
+            set_failed(walk);
+            break;
+        }
+
+        /* Queue subdirectories before the callback moves anything around. */
+        for (long i = 0; i < count; ++i) {
+            if (!is_directory_entry(fd, &batch[i])) {
+                continue;
+            }
+            if (options->descend && !options->descend(options->ctx, &dir, batch[i].name)) {
+                continue;
+            }
+
+            char *child = join_relative(rel_path, batch[i].name);
+            __atomic_add_fetch(&walk->pending, 1, __ATOMIC_RELAXED);
+            if (!child || queue_push(&walk->queues[worker], child, depth + 1) != 0) {
+                free(child);
+                __atomic_sub_fetch(&walk->pending, 1, __ATOMIC_RELAXED);
+                logger_log(LOG_LEVEL_ERROR, "Out of memory while walking '%s'\n",
+                           options->root_path);
+                set_failed(walk);
+            }
+        }
+
+        if (options->on_batch(options->ctx, worker, &dir, batch, count) != 0) {
+            set_failed(walk);
+        }
+    }
+
+    dir_scanner_close(&scanner);
+    close(fd);
+}
+
+static void walk_task(void *arg, unsigned worker, unsigned workers)
+{
+    Walk *walk = arg;
+
+    for (;;) {
+        unsigned depth = 0;
+        char *path = queue_take(&walk->queues[worker], false, &depth);
+
+        for (unsigned k = 1; !path && k < workers; ++k) {
+            path = queue_take(&walk->queues[(worker + k) % workers], true, &depth);
+        }
+
+        if (!path) {
+            if (__atomic_load_n(&walk->pending, __ATOMIC_ACQUIRE) == 0) {
+                return;
+            }
+            sched_yield(); /* someone is still producing work */
+            continue;
+        }
+
+        visit_directory(walk, worker, path, depth);
+        free(path);
+        __atomic_sub_fetch(&walk->pending, 1, __ATOMIC_RELEASE);
+    }
+}
+
+int walker_run(const WalkOptions *options, ThreadPool *pool)
+{
+    Walk walk;
+    memset(&walk, 0, sizeof(walk));
+    walk.options = options;
+    walk.workers = pool ? thread_pool_size(pool) : 1;
+    walk.queues = calloc(walk.workers, sizeof(*walk.queues));
+    char *root = calloc(1, 1); /* "" */
+
+    if (!walk.queues || !root) {
+        free(walk.queues);
+        free(root);
+        logger_log(LOG_LEVEL_ERROR, "Out of memory while walking '%s'\n", options->root_path);
+        return 1;
+    }
+
+    pool_mutex_init(&walk.visited_lock);
+    for (unsigned w = 0; w < walk.workers; ++w) {
+        pool_mutex_init(&walk.queues[w].lock);
+    }
+
+    walk.pending = 1;
+    queue_push(&walk.queues[0], root, 0);
+
+    if (pool) {
+        thread_pool_run(pool, walk_task, &walk);
+    } else {
+        walk_task(&walk, 0, 1);
+    }
+
+    for (unsigned w = 0; w < walk.workers; ++w) {
+        free(walk.queues[w].items);
+        free(walk.queues[w].depths);
+        pool_mutex_destroy(&walk.queues[w].lock);
+    }
+    free(walk.queues);
+    free(walk.visited);
+    pool_mutex_destroy(&walk.visited_lock);
+    return walk.failed;
+}
+
+#else /* _WIN32 */
+
+int walker_run(const WalkOptions *options, ThreadPool *pool)
+{
+    (void)pool;
+    logger_log(LOG_LEVEL_ERROR, "Recursive walks are not supported on this platform: '%s'\n",
+               options->root_path);
+    errno = ENOSYS;
+    return 1;
+}
+
+#endif
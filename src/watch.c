@@ -0,0 +1,164 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       watch.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-14
+ Updated:    2026-10-14
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    inotify implementation of the directory watch used by watch mode.
+
+ Usage:
+    See watch.h.
+
+ Notes:
+    - Events are read in large chunks and handed out one by one, so a burst
+      of arrivals costs few read() calls.
+    - IN_IGNORED (watch removed), events without a name and removals of
+      non-directories are dropped.
+
+==========================================================================================================
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "watch.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#define WATCH_BUFFER_SIZE ((size_t)64 * 1024)
+
+int dir_watch_open(DirWatch *watch)
+{
+    watch->pos = 0;
+    watch->len = 0;
+    watch->buffer = malloc(WATCH_BUFFER_SIZE);
+    if (!watch->buffer) {
+        return -1;
+    }
+
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->fd < 0) {
+        free(watch->buffer);
+        watch->buffer = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int dir_watch_add(DirWatch *watch, const char *path, WatchMode mode)
+{
+    uint32_t mask = IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    if (mode == WATCH_FILES_LANDED) {
+        mask |= IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM;
+    } else {
+        mask |= IN_CREATE;
+    }
+    return inotify_add_watch(watch->fd, path, mask);
+}
+
+int dir_watch_next(DirWatch *watch, int timeout_ms, WatchEvent *event)
+{
+    for (;;) {
+        while (watch->pos < watch->len) {
+            const struct inotify_event *raw =
+                (const struct inotify_event *)(void *)(watch->buffer + watch->pos);
+            watch->pos += sizeof(*raw) + raw->len;
+
+            event->wd = raw->wd;
+            event->name = NULL;
+            if (raw->mask & IN_Q_OVERFLOW) {
+                event->kind = WATCH_EVENT_OVERFLOW;
+                return 1;
+            }
+            if (raw->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                event->kind = WATCH_EVENT_GONE;
+                return 1;
+            }
+            if ((raw->mask & IN_IGNORED) || raw->len == 0) {
+                continue;
+            }
+            event->kind = WATCH_EVENT_NAME;
+            if (raw->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                if (!(raw->mask & IN_ISDIR)) {
+                    continue; /* mostly our own moves out of the directory */
+                }
+                event->kind = WATCH_EVENT_REMOVED;
+            }
+            event->name = raw->name;
+            return 1;
+        }
+
+        ssize_t n = read(watch->fd, watch->buffer, WATCH_BUFFER_SIZE);
+        if (n > 0) {
+            watch->pos = 0;
+            watch->len = (size_t)n;
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            return -1;
+        }
+
+        struct pollfd pfd = { watch->fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready <= 0) {
+            return ready; /* 0 on timeout, -1 with errno (EINTR) */
+        }
+    }
+}
+
+void dir_watch_close(DirWatch *watch)
+{
+    if (watch->fd >= 0) {
+        close(watch->fd);
+        watch->fd = -1;
+    }
+    free(watch->buffer);
+    watch->buffer = NULL;
+}
+
+#else /* !__linux__ */
+
+int dir_watch_open(DirWatch *watch)
+{
+    watch->fd = -1;
+    watch->buffer = NULL;
+    errno = ENOSYS;
+    return -1;
+}
+
+int dir_watch_add(DirWatch *watch, const char *path, WatchMode mode)
+{
+    (void)watch;
+    (void)path;
+    (void)mode;
+    errno = ENOSYS;
+    return -1;
+}
+
+int dir_watch_next(DirWatch *watch, int timeout_ms, WatchEvent *event)
+{
+    (void)watch;
+    (void)timeout_ms;
+    (void)event;
+    errno = ENOSYS;
+    return -1;
+}
+
+void dir_watch_close(DirWatch *watch)
+{
+    (void)watch;
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       test_collision.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-15
+ Updated:    2026-10-15
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Regression checks for collision renaming: a taken name gets the next
+    free numeric suffix, within one plan as well as against the disk, and
+    a name another program creates after the names were read (here,
+    between organizer_plan() and organizer_execute()) is never overwritten.
+
+ Usage:
+    make check
+
+==========================================================================================================
+*/
+
+#define _XOPEN_SOURCE 700 /* mkdtemp, nftw */
+
+#include "logger.h"
+#include "organizer.h"
+#include "test_util.h"
+
+/* A name on disk and the same name twice in one plan (recursive run). */
+static void suffixes(unsigned jobs)
+{
+    char root[TEST_ROOT_SIZE];
+    if (test_tree_create(root) != 0) {
+        return;
+    }
+    test_mkdir(root, "Images");
+    test_mkdir(root, "sub");
+    test_write_file(root, "Images/a.jpg", "on disk");
+    test_write_file(root, "a.jpg", "top");
+    test_write_file(root, "sub/a.jpg", "nested");
+
+    OrganizerConfig config;
+    memset(&config, 0, sizeof(config));
+    config.target_dir = root;
+    config.recursive = true;
+    config.jobs = jobs;
+    CHECK(organizer_run(&config) == 0);
+
+    CHECK(test_file_is(root, "Images/a.jpg", "on disk"));
+    CHECK(test_exists(root, "Images/a_1.jpg"));
+    CHECK(test_exists(root, "Images/a_2.jpg"));
+    CHECK(!test_exists(root, "Images/a_3.jpg"));
+    CHECK(!test_exists(root, "a.jpg") && !test_exists(root, "sub/a.jpg"));
+    test_tree_remove(root);
+}
+
+/* The name set is older than the folder: a file that appeared since must survive. */
+static void appeared_since(OrganizerBackend backend, unsigned jobs)
+{
+    char root[TEST_ROOT_SIZE];
+    if (test_tree_create(root) != 0) {
+        return;
+    }
+    test_mkdir(root, "Images");
+    test_write_file(root, "b.jpg", "ours");
+
+    OrganizerConfig config;
+    memset(&config, 0, sizeof(config));
+    config.target_dir = root;
+    config.backend = backend;
+    config.jobs = jobs;
+    OrganizerPlan plan;
+    CHECK(organizer_plan(&config, &plan) == 0);
+
+    /* Another program drops b.jpg into the folder between planning and executing. */
+    test_write_file(root, "Images/b.jpg", "theirs");
+    CHECK(organizer_execute(&config, &plan) == 0);
+    organizer_plan_free(&plan);
+
+    CHECK(test_file_is(root, "Images/b.jpg", "theirs"));
+    CHECK(test_file_is(root, "Images/b_1.jpg", "ours"));
+    CHECK(!test_exists(root, "b.jpg"));
+    test_tree_remove(root);
+}
+
+int main(void)
+{
+    logger_set_level(LOG_LEVEL_ERROR);
+
+    suffixes(1);
+    suffixes(4);
+    appeared_since(ORGANIZER_BACKEND_SERIAL, 1);
+    appeared_since(ORGANIZER_BACKEND_SERIAL, 4);
+    appeared_since(ORGANIZER_BACKEND_URING, 1);
+    return test_summary("test_collision");
+}
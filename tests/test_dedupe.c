@@ -0,0 +1,124 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       test_dedupe.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-15
+ Updated:    2026-10-15
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Regression checks for dedupe_compare_batch(): several candidates that
+    collided with the same kept name must each be compared against that
+    kept file, not against the candidate listed before them.
+
+ Usage:
+    make check
+
+==========================================================================================================
+*/
+
+#define _POSIX_C_SOURCE 200809L /* mkdtemp, openat, utimensat */
+
+#include "dedupe.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                    \
+        }                                                                  \
+    } while (0)
+
+static int write_file(int dir_fd, const char *name, const char *content)
+{
+    int fd = openat(dir_fd, name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    size_t len = strlen(content);
+    int rc = write(fd, content, len) == (ssize_t)len ? 0 : -1;
+    close(fd);
+    return rc;
+}
+
+/*
+ * Images/p.jpg holds 'kept'; p.jpg and s/p.jpg both collide with it and
+ * hold 'first' and 'second'. Compare both pairs in one batch.
+ */
+static void compare_two_candidates(const char *kept, const char *first, const char *second,
+                                   DedupeResult expect_first, DedupeResult expect_second)
+{
+    char root[] = "/tmp/test_dedupe_XXXXXX";
+    if (!mkdtemp(root)) {
+        perror("mkdtemp");
+        failures++;
+        return;
+    }
+
+    int base_fd = open(root, O_RDONLY | O_DIRECTORY);
+    int images_fd = -1;
+    if (base_fd >= 0 && mkdirat(base_fd, "Images", 0755) == 0 && mkdirat(base_fd, "s", 0755) == 0) {
+        images_fd = openat(base_fd, "Images", O_RDONLY | O_DIRECTORY);
+    }
+    if (images_fd < 0 || write_file(images_fd, "p.jpg", kept) != 0 ||
+        write_file(base_fd, "p.jpg", first) != 0 || write_file(base_fd, "s/p.jpg", second) != 0) {
+        perror("setup");
+        failures++;
+    } else {
+        /* An old kept file, so its mtime cannot be mistaken for a candidate's. */
+        struct timespec old[2] = { { 1577836800, 0 }, { 1577836800, 0 } };
+        utimensat(images_fd, "p.jpg", old, 0);
+
+        DedupePair pairs[2] = {
+            { images_fd, "p.jpg", base_fd, "p.jpg", DEDUPE_FAILED, 0, 0 },
+            { images_fd, "p.jpg", base_fd, "s/p.jpg", DEDUPE_FAILED, 0, 0 },
+        };
+        dedupe_compare_batch(pairs, 2, 1);
+
+        CHECK(pairs[0].result == expect_first);
+        CHECK(pairs[1].result == expect_second);
+        for (int i = 0; i < 2; ++i) {
+            CHECK(pairs[i].kept_size == strlen(kept));
+            CHECK(pairs[i].kept_mtime_ns == INT64_C(1577836800) * 1000000000);
+        }
+    }
+
+    unlinkat(base_fd, "s/p.jpg", 0);
+    unlinkat(base_fd, "p.jpg", 0);
+    unlinkat(base_fd, "Images/p.jpg", 0);
+    unlinkat(base_fd, "s", AT_REMOVEDIR);
+    unlinkat(base_fd, "Images", AT_REMOVEDIR);
+    if (images_fd >= 0) {
+        close(images_fd);
+    }
+    if (base_fd >= 0) {
+        close(base_fd);
+    }
+    rmdir(root);
+}
+
+int main(void)
+{
+    /* Two candidates equal to each other but not to the kept file. */
+    compare_two_candidates("aaaa", "bbbb", "bbbb", DEDUPE_DIFFERENT, DEDUPE_DIFFERENT);
+    /* The second candidate is a real duplicate, the first is not. */
+    compare_two_candidates("same", "diff", "same", DEDUPE_DIFFERENT, DEDUPE_IDENTICAL);
+
+    if (failures > 0) {
+        fprintf(stderr, "test_dedupe: %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("test_dedupe: ok\n");
+    return 0;
+}
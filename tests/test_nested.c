@@ -0,0 +1,97 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       test_nested.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-15
+ Updated:    2026-10-15
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Regression checks for nested rule categories ("Video/Large"): the
+    folder and its parent are created, and files land in both, with the
+    serial and io_uring backends, single- and multi-threaded, and through
+    organizer_plan() + organizer_execute().
+
+ Usage:
+    make check
+
+==========================================================================================================
+*/
+
+#define _XOPEN_SOURCE 700 /* mkdtemp, nftw */
+
+#include "logger.h"
+#include "organizer.h"
+#include "rules.h"
+#include "test_util.h"
+
+static void organize_nested(OrganizerBackend backend, unsigned jobs, bool plan_first)
+{
+    char root[TEST_ROOT_SIZE];
+    char rules_path[4096];
+    char target[4096];
+    if (test_tree_create(root) != 0) {
+        return;
+    }
+    test_mkdir(root, "d");
+    test_write_file(root, "rules", "Video/Large: .mp4 size>10\n");
+    test_write_file(root, "d/large.mp4", "more than ten bytes");
+    test_write_file(root, "d/small.mp4", "tiny");
+    test_path(rules_path, sizeof(rules_path), root, "rules");
+    test_path(target, sizeof(target), root, "d");
+
+    RuleSet rules;
+    if (rules_load(&rules, rules_path, false) != 0) {
+        CHECK(!"rules load");
+        test_tree_remove(root);
+        return;
+    }
+
+    OrganizerConfig config;
+    memset(&config, 0, sizeof(config));
+    config.target_dir = target;
+    config.backend = backend;
+    config.jobs = jobs;
+    config.rules = &rules;
+
+    int rc;
+    if (plan_first) {
+        OrganizerPlan plan;
+        rc = organizer_plan(&config, &plan);
+        if (rc == 0) {
+            rc = organizer_execute(&config, &plan);
+        }
+        organizer_plan_free(&plan);
+    } else {
+        rc = organizer_run(&config);
+    }
+
+    CHECK(rc == 0);
+    CHECK(test_file_is(root, "d/Video/Large/large.mp4", "more than ten bytes"));
+    CHECK(test_file_is(root, "d/Video/small.mp4", "tiny"));
+    CHECK(!test_exists(root, "d/large.mp4"));
+    if (test_failures > 0) {
+        fprintf(stderr, "  (backend %d, %u jobs%s)\n", (int)backend, jobs,
+                plan_first ? ", plan + execute" : "");
+    }
+
+    rules_free(&rules);
+    test_tree_remove(root);
+}
+
+int main(void)
+{
+    logger_set_level(LOG_LEVEL_ERROR);
+
+    const OrganizerBackend backends[] = { ORGANIZER_BACKEND_SERIAL, ORGANIZER_BACKEND_URING };
+    const unsigned jobs[] = { 1, 2, 4 };
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); ++b) {
+        for (size_t j = 0; j < sizeof(jobs) / sizeof(jobs[0]); ++j) {
+            organize_nested(backends[b], jobs[j], false);
+            organize_nested(backends[b], jobs[j], true);
+        }
+    }
+    return test_summary("test_nested");
+}
@@ -0,0 +1,153 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       test_resume.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-15
+ Updated:    2026-10-15
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Regression checks for --checkpoint/--resume. An interrupted run is
+    staged through the journal and checkpoint APIs: it created Images,
+    journaled one move and made a second one the journal never saw. The
+    resumed run must finish the work without overwriting either file and
+    leave a finished checkpoint, so a second resume is an ordinary run.
+
+ Usage:
+    make check
+
+==========================================================================================================
+*/
+
+#define _XOPEN_SOURCE 700 /* mkdtemp, nftw, realpath */
+
+#include "checkpoint.h"
+#include "journal.h"
+#include "logger.h"
+#include "organizer.h"
+#include "test_util.h"
+
+#include <limits.h>
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+/* What a run killed after a few moves leaves behind. */
+static int stage_interrupted_run(const char *root, const char *target,
+                                 const char *journal_path, const char *checkpoint_path)
+{
+    char absolute[PATH_MAX];
+    char from[4096];
+    char to[4096];
+    if (!realpath(target, absolute)) {
+        return -1;
+    }
+
+    Journal journal;
+    if (journal_open(&journal, journal_path) != 0 || journal_flush(&journal) != 0) {
+        return -1;
+    }
+    uint64_t run_offset = journal_size(&journal);
+    if (journal_begin_run(&journal, absolute) != 0) {
+        journal_close(&journal);
+        return -1;
+    }
+
+    test_mkdir(root, "d/Images");
+    journal_record_mkdir(&journal, "Images");
+    test_path(from, sizeof(from), root, "d/a.jpg");
+    test_path(to, sizeof(to), root, "d/Images/a.jpg");
+    int rc = rename(from, to);
+    journal_record_move(&journal, "", "a.jpg", "Images", "a.jpg");
+    /* Moved after the journal's last write: only the disk knows. */
+    test_path(from, sizeof(from), root, "d/b.jpg");
+    test_path(to, sizeof(to), root, "d/Images/b.jpg");
+    rc |= rename(from, to);
+    rc |= journal_close(&journal);
+
+    struct stat target_st;
+    struct stat journal_st;
+    Checkpoint checkpoint;
+    if (rc != 0 || stat(target, &target_st) != 0 || stat(journal_path, &journal_st) != 0 ||
+        checkpoint_open(&checkpoint, checkpoint_path) != 0) {
+        return -1;
+    }
+    rc = checkpoint_begin(&checkpoint, &target_st, &journal_st, run_offset, 1);
+    checkpoint_close(&checkpoint); /* never finished */
+    return rc;
+}
+
+static CheckpointStatus checkpoint_status(const char *path)
+{
+    Checkpoint checkpoint;
+    if (checkpoint_open(&checkpoint, path) != 0) {
+        return CHECKPOINT_EMPTY;
+    }
+    CheckpointStatus status = (CheckpointStatus)checkpoint.previous.status;
+    checkpoint_close(&checkpoint);
+    return status;
+}
+
+static void resume(OrganizerBackend backend, unsigned jobs)
+{
+    char root[TEST_ROOT_SIZE];
+    char target[4096];
+    char journal[4096];
+    char checkpoint[4096];
+    if (test_tree_create(root) != 0) {
+        return;
+    }
+    test_mkdir(root, "d");
+    test_write_file(root, "d/a.jpg", "first a");
+    test_write_file(root, "d/b.jpg", "first b");
+    test_path(target, sizeof(target), root, "d");
+    test_path(journal, sizeof(journal), root, "moves.journal");
+    test_path(checkpoint, sizeof(checkpoint), root, "run.ckpt");
+
+    CHECK(stage_interrupted_run(root, target, journal, checkpoint) == 0);
+    CHECK(checkpoint_status(checkpoint) == CHECKPOINT_RUNNING);
+
+    /* Left for the resumed run: a new b.jpg, whose name is taken on disk, and c.jpg. */
+    test_write_file(root, "d/b.jpg", "second b");
+    test_write_file(root, "d/c.jpg", "c");
+
+    OrganizerConfig config;
+    memset(&config, 0, sizeof(config));
+    config.target_dir = target;
+    config.journal_path = journal;
+    config.checkpoint_path = checkpoint;
+    config.resume = true;
+    config.backend = backend;
+    config.jobs = jobs;
+    CHECK(organizer_run(&config) == 0);
+
+    CHECK(test_file_is(root, "d/Images/a.jpg", "first a"));
+    CHECK(test_file_is(root, "d/Images/b.jpg", "first b"));
+    CHECK(test_file_is(root, "d/Images/b_1.jpg", "second b"));
+    CHECK(test_file_is(root, "d/Images/c.jpg", "c"));
+    CHECK(!test_exists(root, "d/b.jpg") && !test_exists(root, "d/c.jpg"));
+    CHECK(checkpoint_status(checkpoint) == CHECKPOINT_DONE);
+
+    /* Nothing left to resume: an ordinary run that reads Images from disk. */
+    test_write_file(root, "d/c.jpg", "second c");
+    CHECK(organizer_run(&config) == 0);
+    CHECK(test_file_is(root, "d/Images/c_1.jpg", "second c"));
+    CHECK(test_file_is(root, "d/Images/c.jpg", "c"));
+    if (test_failures > 0) {
+        fprintf(stderr, "  (backend %d, %u jobs)\n", (int)backend, jobs);
+    }
+    test_tree_remove(root);
+}
+
+int main(void)
+{
+    logger_set_level(LOG_LEVEL_ERROR);
+
+    resume(ORGANIZER_BACKEND_SERIAL, 1);
+    resume(ORGANIZER_BACKEND_SERIAL, 4);
+    resume(ORGANIZER_BACKEND_URING, 1);
+    return test_summary("test_resume");
+}
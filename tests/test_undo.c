@@ -0,0 +1,127 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       test_undo.c
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-15
+ Updated:    2026-10-15
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Regression checks for the journal and organizer_undo(): every move of
+    every recorded run is reverted, renamed collisions included, folders
+    the runs created are removed once empty, files that were there before
+    are left alone, and duplicates removed by --dedupe come back.
+
+ Usage:
+    make check
+
+==========================================================================================================
+*/
+
+#define _XOPEN_SOURCE 700 /* mkdtemp, nftw */
+
+#include "logger.h"
+#include "organizer.h"
+#include "test_util.h"
+
+static void config_for(OrganizerConfig *config, const char *target, const char *journal)
+{
+    memset(config, 0, sizeof(*config));
+    config->target_dir = target;
+    config->journal_path = journal;
+}
+
+/* Two recursive runs into one journal, reverted together. */
+static void undo_runs(OrganizerBackend backend, unsigned jobs)
+{
+    char root[TEST_ROOT_SIZE];
+    char target[4096];
+    char journal[4096];
+    if (test_tree_create(root) != 0) {
+        return;
+    }
+    test_mkdir(root, "d");
+    test_mkdir(root, "d/Images");
+    test_mkdir(root, "d/sub");
+    test_write_file(root, "d/Images/a.jpg", "was there");
+    test_write_file(root, "d/a.jpg", "top a");
+    test_write_file(root, "d/notes.txt", "notes");
+    test_write_file(root, "d/sub/a.jpg", "sub a");
+    test_path(target, sizeof(target), root, "d");
+    test_path(journal, sizeof(journal), root, "moves.journal");
+
+    OrganizerConfig config;
+    config_for(&config, target, journal);
+    config.recursive = true;
+    config.backend = backend;
+    config.jobs = jobs;
+    CHECK(organizer_run(&config) == 0);
+    CHECK(test_file_is(root, "d/Images/a_1.jpg", NULL));
+    CHECK(test_file_is(root, "d/Images/a_2.jpg", NULL));
+    CHECK(test_file_is(root, "d/Documents/notes.txt", "notes"));
+
+    /* A second run, appended to the same journal. */
+    test_write_file(root, "d/song.mp3", "song");
+    CHECK(organizer_run(&config) == 0);
+    CHECK(test_file_is(root, "d/Audio/song.mp3", "song"));
+
+    CHECK(organizer_undo(&config, journal) == 0);
+    CHECK(test_file_is(root, "d/a.jpg", "top a"));
+    CHECK(test_file_is(root, "d/sub/a.jpg", "sub a"));
+    CHECK(test_file_is(root, "d/notes.txt", "notes"));
+    CHECK(test_file_is(root, "d/song.mp3", "song"));
+    CHECK(test_file_is(root, "d/Images/a.jpg", "was there"));
+    CHECK(!test_exists(root, "d/Images/a_1.jpg") && !test_exists(root, "d/Images/a_2.jpg"));
+    CHECK(!test_exists(root, "d/Documents"));
+    CHECK(!test_exists(root, "d/Audio"));
+    if (test_failures > 0) {
+        fprintf(stderr, "  (backend %d, %u jobs)\n", (int)backend, jobs);
+    }
+    test_tree_remove(root);
+}
+
+/* A duplicate dropped by --dedupe is restored with its own content. */
+static void undo_dedupe(OrganizerDedupe mode)
+{
+    char root[TEST_ROOT_SIZE];
+    char target[4096];
+    char journal[4096];
+    if (test_tree_create(root) != 0) {
+        return;
+    }
+    test_mkdir(root, "d");
+    test_mkdir(root, "d/Images");
+    test_write_file(root, "d/Images/p.jpg", "same");
+    test_write_file(root, "d/p.jpg", "same");
+    test_path(target, sizeof(target), root, "d");
+    test_path(journal, sizeof(journal), root, "moves.journal");
+
+    OrganizerConfig config;
+    config_for(&config, target, journal);
+    config.dedupe = mode;
+    CHECK(organizer_run(&config) == 0);
+    CHECK(!test_exists(root, "d/p.jpg"));
+    /* Dropped, or kept as a second name of the file already there. */
+    CHECK(mode == ORGANIZER_DEDUPE_DROP ? !test_exists(root, "d/Images/p_1.jpg")
+                                        : test_file_is(root, "d/Images/p_1.jpg", "same"));
+
+    CHECK(organizer_undo(&config, journal) == 0);
+    CHECK(test_file_is(root, "d/p.jpg", "same"));
+    CHECK(test_file_is(root, "d/Images/p.jpg", "same"));
+    CHECK(!test_exists(root, "d/Images/p_1.jpg"));
+    test_tree_remove(root);
+}
+
+int main(void)
+{
+    logger_set_level(LOG_LEVEL_ERROR);
+
+    undo_runs(ORGANIZER_BACKEND_SERIAL, 1);
+    undo_runs(ORGANIZER_BACKEND_SERIAL, 4);
+    undo_runs(ORGANIZER_BACKEND_URING, 1);
+    undo_dedupe(ORGANIZER_DEDUPE_DROP);
+    undo_dedupe(ORGANIZER_DEDUPE_LINK);
+    return test_summary("test_undo");
+}
@@ -0,0 +1,139 @@
+/*
+==========================================================================================================
+ Project:    File Organizer Tool
+ File:       test_util.h
+ Author:     Mobin Yousefi (GitHub: github.com/mobinyousefi-cs)
+ Created:    2026-10-15
+ Updated:    2026-10-15
+ License:    MIT License (see LICENSE file for details)
+==========================================================================================================
+
+ Description:
+    Helpers shared by the regression checks: a CHECK() that counts
+    failures, and scratch trees under /tmp addressed by relative paths.
+
+ Usage:
+    char root[TEST_ROOT_SIZE];
+    if (test_tree_create(root) == 0) {
+        test_write_file(root, "a.jpg", "data");
+        CHECK(test_exists(root, "Images/a.jpg"));
+        test_tree_remove(root);
+    }
+    return test_summary("test_name");
+
+ Notes:
+    - Include after defining _XOPEN_SOURCE 700 (mkdtemp, nftw).
+
+==========================================================================================================
+*/
+
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <ftw.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_ROOT_SIZE 64
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                               \
+        }                                                                  \
+    } while (0)
+
+/* Create an empty scratch directory; 'root' receives its path. */
+static inline int test_tree_create(char root[TEST_ROOT_SIZE])
+{
+    snprintf(root, TEST_ROOT_SIZE, "/tmp/file_organizer_test_XXXXXX");
+    if (!mkdtemp(root)) {
+        perror("mkdtemp");
+        test_failures++;
+        return -1;
+    }
+    return 0;
+}
+
+static inline void test_path(char *buffer, size_t size, const char *root, const char *rel)
+{
+    snprintf(buffer, size, "%s/%s", root, rel);
+}
+
+static inline int test_mkdir(const char *root, const char *rel)
+{
+    char path[4096];
+    test_path(path, sizeof(path), root, rel);
+    return mkdir(path, 0755);
+}
+
+static inline int test_write_file(const char *root, const char *rel, const char *content)
+{
+    char path[4096];
+    test_path(path, sizeof(path), root, rel);
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        perror(path);
+        test_failures++;
+        return -1;
+    }
+    fputs(content, file);
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+/* Whether 'rel' exists and holds exactly 'content' (NULL: any content). */
+static inline bool test_file_is(const char *root, const char *rel, const char *content)
+{
+    char path[4096];
+    char data[256];
+    test_path(path, sizeof(path), root, rel);
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    size_t len = fread(data, 1, sizeof(data) - 1, file);
+    fclose(file);
+    data[len] = '\0';
+    return content == NULL || strcmp(data, content) == 0;
+}
+
+static inline bool test_exists(const char *root, const char *rel)
+{
+    char path[4096];
+    struct stat st;
+    test_path(path, sizeof(path), root, rel);
+    return lstat(path, &st) == 0;
+}
+
+static inline int test_remove_entry(const char *path, const struct stat *st, int flag,
+                                    struct FTW *ftw)
+{
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+static inline void test_tree_remove(const char *root)
+{
+    nftw(root, test_remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static inline int test_summary(const char *name)
+{
+    if (test_failures > 0) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, test_failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+#endif /* TEST_UTIL_H */